@@ -0,0 +1,99 @@
+/*
+ * Air780EG AT收发录制与回放示例
+ *
+ * 本示例演示：
+ * 1. 录制库与模块之间的全部AT收发（带微秒时间戳）到RAM环形缓冲区
+ * 2. 同时写入LittleFS文件，掉电后可以取回现场数据
+ * 3. 通过串口命令把录制导出，或在设备上回放上一次的录制
+ *
+ * 串口命令：
+ *   d - 导出RAM中的录制（二进制，需用串口工具保存）
+ *   r - 回放 /at_capture.bin，不连接真实模块
+ */
+
+#include <Air780EG.h>
+#include <LittleFS.h>
+
+#define CAPTURE_FILE "/at_capture.bin"
+
+Air780EGRecorder recorder;
+File capture_file;
+
+void replayCapture() {
+    File file = LittleFS.open(CAPTURE_FILE, "r");
+    if (!file) {
+        Serial.println("No capture file");
+        return;
+    }
+
+    // 回放期间使用独立的模块实例，库读到的数据与录制时完全一致
+    static Air780EGReplayStream replay;
+    static Air780EGCore replay_core;
+    static Air780EGNetwork replay_network(&replay_core);
+    replay.begin(&file);
+    replay_core.attachStream(&replay);
+
+    // 按录制时的调用顺序驱动库，发送内容与录制不一致时会计入mismatch
+    replay_network.enableNetwork();
+    while (!replay.isFinished()) {
+        replay_core.processCommands();
+        replay_network.loop();
+        delay(10);
+    }
+
+    Serial.printf("Replay finished, TX lines: %lu, mismatches: %lu, unexpected: %lu\n",
+                  replay.getTxLineCount(), replay.getTxMismatchCount(), replay.getUnexpectedTxCount());
+    file.close();
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+
+    Air780EG::setLogLevel(AIR780EG_LOG_INFO);
+    LittleFS.begin(true);
+
+    // 16KB RAM环形缓冲区，写满后淘汰最早的记录
+    recorder.begin(16 * 1024);
+
+    // 同时流式写入文件
+    capture_file = LittleFS.open(CAPTURE_FILE, "w");
+    if (capture_file) {
+        recorder.setSink(&capture_file);
+    }
+
+    air780eg.getCore().setRecorder(&recorder);
+    recorder.start();
+
+    if (!air780eg.begin(&Serial2, 115200, 16, 17, 18)) {
+        Serial.println("Failed to initialize Air780EG module!");
+        while (1) {
+            delay(1000);
+        }
+    }
+    air780eg.getNetwork().enableNetwork();
+}
+
+void loop() {
+    air780eg.loop();
+
+    if (Serial.available()) {
+        char cmd = Serial.read();
+        if (cmd == 'd') {
+            recorder.dump(Serial);
+        } else if (cmd == 'r') {
+            recorder.stop();
+            capture_file.close();
+            replayCapture();
+        }
+    }
+
+    static unsigned long last_report = 0;
+    if (millis() - last_report > 10000) {
+        last_report = millis();
+        capture_file.flush();
+        Serial.printf("Recorder: %lu records, %u/%u bytes, evicted: %lu\n",
+                      recorder.getRecordCount(), recorder.getUsedBytes(), recorder.getCapacity(),
+                      recorder.getEvictedRecords());
+    }
+}
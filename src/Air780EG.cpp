@@ -68,6 +68,7 @@ bool Air780EG::begin(HardwareSerial* serial, int baudrate, int rx_pin, int tx_pi
 }
 
 void Air780EG::loop() {
+    AIR780EG_STALL_SCOPE("Air780EG::loop");
     if (!initialized) {
         AIR780EG_LOGI(TAG, "Air780EG module not initialized");
         return;
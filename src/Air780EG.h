@@ -6,10 +6,17 @@
 
 // 包含所有子模块
 #include "Air780EGDebug.h"
+#include "Air780EGHeapTrace.h"
+#include "Air780EGStallProfiler.h"
+#include "Air780EGRecorder.h"
+#include "Air780EGTrace.h"
 #include "Air780EGCore.h"
 #include "Air780EGNetwork.h"
 #include "Air780EGGNSS.h"
+#include "Air780EGCompress.h"
+#include "Air780EGOutbox.h"
 #include "Air780EGMQTT.h"
+#include "Air780EGBatch.h"
 #include "Air780EGHTTP.h"
 
 // 版本信息
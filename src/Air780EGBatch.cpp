@@ -0,0 +1,212 @@
+#include "Air780EGBatch.h"
+
+const char *Air780EGBatcher::TAG = "Batch";
+
+Air780EGBatcher::Air780EGBatcher(Air780EGMQTT *mqtt_instance) : mqtt(mqtt_instance)
+{
+    resetStats();
+}
+
+void Air780EGBatcher::setMaxPayload(size_t bytes)
+{
+    max_payload = bytes < 16 ? 16 : bytes;
+}
+
+size_t Air780EGBatcher::getMaxPayload() const
+{
+    return max_payload;
+}
+
+void Air780EGBatcher::setWindow(unsigned long ms)
+{
+    window_ms = ms;
+}
+
+unsigned long Air780EGBatcher::getWindow() const
+{
+    return window_ms;
+}
+
+Air780EGBatcher::Batch *Air780EGBatcher::findBatch(const String &topic, bool create)
+{
+    for (int i = 0; i < batch_count; i++)
+    {
+        if (batches[i].topic == topic)
+        {
+            return &batches[i];
+        }
+    }
+    if (!create || batch_count >= MAX_BATCH_TOPICS)
+    {
+        return nullptr;
+    }
+
+    Batch &batch = batches[batch_count++];
+    batch.topic = topic;
+    batch.payload = "";
+    batch.payload.reserve(max_payload);  // 一次分配，之后追加样本不再扩容
+    batch.count = 0;
+    batch.opened_at = 0;
+    return &batch;
+}
+
+bool Air780EGBatcher::add(const String &topic, const String &sample, bool priority, int qos, bool retain)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    stats.samples++;
+
+    // "[" + sample + "]" 必须能放进一个批次
+    if (sample.length() == 0 || sample.length() + 2 > max_payload)
+    {
+        AIR780EG_LOGW(TAG, "Sample too large for batch: %s (%u bytes)", topic.c_str(), sample.length());
+        stats.dropped++;
+        return false;
+    }
+
+    Batch *batch = findBatch(topic, true);
+    if (!batch)
+    {
+        AIR780EG_LOGW(TAG, "Too many batch topics, dropping sample: %s", topic.c_str());
+        stats.dropped++;
+        return false;
+    }
+
+    // 放不下时先发出已有的样本
+    if (batch->count > 0 && batch->payload.length() + 1 + sample.length() + 1 > max_payload)
+    {
+        if (!flushBatch(*batch, BATCH_FLUSH_SIZE))
+        {
+            // 发送失败：丢弃旧批次，保留最新的数据
+            AIR780EG_LOGW(TAG, "Dropping %u unsent samples: %s", batch->count, topic.c_str());
+            stats.dropped += batch->count;
+            batch->payload = "";
+            batch->count = 0;
+        }
+    }
+
+    batch->payload += batch->count == 0 ? '[' : ',';
+    batch->payload += sample;
+    if (batch->count == 0)
+    {
+        batch->opened_at = millis();
+    }
+    batch->count++;
+    batch->qos = qos;
+    batch->retain = retain;
+
+    if (priority)
+    {
+        return flushBatch(*batch, BATCH_FLUSH_PRIORITY);
+    }
+    return true;
+}
+
+bool Air780EGBatcher::flushBatch(Batch &batch, Air780EGBatchFlushReason reason)
+{
+    if (batch.count == 0)
+    {
+        return true;
+    }
+
+    // 发送前补上 ']'，失败时去掉以便继续追加
+    batch.payload += ']';
+    bool sent;
+    Air780EGOutbox *outbox = mqtt->getOutbox();
+    if (!mqtt->isConnected() && outbox && outbox->isOpen())
+    {
+        sent = outbox->push(batch.topic, batch.payload, batch.qos, batch.retain);
+    }
+    else
+    {
+        sent = mqtt->publishAsync(batch.topic, batch.payload, batch.qos, batch.retain) != 0;
+    }
+
+    if (!sent)
+    {
+        batch.payload.remove(batch.payload.length() - 1);
+        stats.publish_failures++;
+        return false;
+    }
+
+    AIR780EG_LOGD(TAG, "Flushed %u samples (%u bytes): %s", batch.count, batch.payload.length(), batch.topic.c_str());
+    stats.batches++;
+    stats.published += batch.count;
+    stats.flushes[reason]++;
+    if (batch.payload.length() > stats.max_batch_bytes)
+    {
+        stats.max_batch_bytes = batch.payload.length();
+    }
+    batch.payload = "";  // 保留已分配的缓冲区
+    batch.count = 0;
+    return true;
+}
+
+bool Air780EGBatcher::flush()
+{
+    bool ok = true;
+    for (int i = 0; i < batch_count; i++)
+    {
+        ok = flushBatch(batches[i], BATCH_FLUSH_MANUAL) && ok;
+    }
+    return ok;
+}
+
+bool Air780EGBatcher::flush(const String &topic)
+{
+    Batch *batch = findBatch(topic, false);
+    return batch ? flushBatch(*batch, BATCH_FLUSH_MANUAL) : true;
+}
+
+void Air780EGBatcher::loop()
+{
+    // 断开且没有离线队列时等待重连，避免每次循环都尝试发送
+    Air780EGOutbox *outbox = mqtt->getOutbox();
+    if (!mqtt->isConnected() && !(outbox && outbox->isOpen()))
+    {
+        return;
+    }
+
+    unsigned long now = millis();
+    for (int i = 0; i < batch_count; i++)
+    {
+        Batch &batch = batches[i];
+        if (batch.count > 0 && now - batch.opened_at >= window_ms)
+        {
+            flushBatch(batch, BATCH_FLUSH_WINDOW);
+        }
+    }
+}
+
+int Air780EGBatcher::getPendingSamples() const
+{
+    int pending = 0;
+    for (int i = 0; i < batch_count; i++)
+    {
+        pending += batches[i].count;
+    }
+    return pending;
+}
+
+Air780EGBatchStats Air780EGBatcher::getStats() const
+{
+    return stats;
+}
+
+void Air780EGBatcher::resetStats()
+{
+    stats = Air780EGBatchStats();
+}
+
+void Air780EGBatcher::printStats() const
+{
+    AIR780EG_LOGI(TAG, "=== Batch ===");
+    AIR780EG_LOGI(TAG, "samples: %lu, published: %lu, batches: %lu (%.1f samples/batch), dropped: %lu",
+                  (unsigned long)stats.samples, (unsigned long)stats.published, (unsigned long)stats.batches,
+                  stats.batches ? (float)stats.published / stats.batches : 0.0f, (unsigned long)stats.dropped);
+    AIR780EG_LOGI(TAG, "flush by size: %lu, window: %lu, priority: %lu, manual: %lu, failures: %lu",
+                  (unsigned long)stats.flushes[BATCH_FLUSH_SIZE], (unsigned long)stats.flushes[BATCH_FLUSH_WINDOW],
+                  (unsigned long)stats.flushes[BATCH_FLUSH_PRIORITY], (unsigned long)stats.flushes[BATCH_FLUSH_MANUAL],
+                  (unsigned long)stats.publish_failures);
+    AIR780EG_LOGI(TAG, "largest batch: %lu bytes, pending: %d samples",
+                  (unsigned long)stats.max_batch_bytes, getPendingSamples());
+}
@@ -0,0 +1,91 @@
+#ifndef AIR780EG_BATCH_H
+#define AIR780EG_BATCH_H
+
+#include <Arduino.h>
+#include "Air780EGMQTT.h"
+
+/*
+ * 遥测批量发布
+ *
+ * 高频采样（如1秒一次的轨迹点）按主题攒成一个JSON数组，一次 MPUB 发出：
+ *   [sample1,sample2,...]
+ * 以下任一条件触发发送：
+ *   - 加入下一条后超过负载上限（先发出已有的批次）
+ *   - 批次中第一条样本已等待超过时间窗口（由 loop() 检查）
+ *   - 加入的是优先样本（立即连同已有样本一起发出）
+ * 发送走 publishAsync()，不阻塞主循环；设置了离线队列时断开期间的批次写入离线队列。
+ */
+
+// 默认单个批次的负载上限（字节）。HEX模式下串口上为两倍长度
+#define AIR780EG_BATCH_DEFAULT_MAX_PAYLOAD 1024
+#define AIR780EG_BATCH_DEFAULT_WINDOW_MS 30000
+
+// 批次发送原因
+enum Air780EGBatchFlushReason {
+    BATCH_FLUSH_SIZE = 0,     // 达到负载上限
+    BATCH_FLUSH_WINDOW,       // 时间窗口到期
+    BATCH_FLUSH_PRIORITY,     // 优先样本
+    BATCH_FLUSH_MANUAL,       // 调用 flush()
+    BATCH_FLUSH_REASON_COUNT
+};
+
+struct Air780EGBatchStats {
+    uint32_t samples;          // 加入的样本数
+    uint32_t published;        // 已发出（或写入离线队列）的样本数
+    uint32_t batches;          // 发出的批次数（即 MPUB 次数）
+    uint32_t dropped;          // 丢弃的样本数（单条超过上限或发送失败且缓冲区已满）
+    uint32_t publish_failures; // 批次发送失败次数（批次保留，稍后重试）
+    uint32_t flushes[BATCH_FLUSH_REASON_COUNT];
+    uint32_t max_batch_bytes;  // 最大批次负载
+};
+
+class Air780EGBatcher {
+private:
+    static const char* TAG;
+    static const int MAX_BATCH_TOPICS = 4;
+
+    struct Batch {
+        String topic;
+        String payload;           // "[s1,s2,..." 发送时补上 ']'
+        uint16_t count;
+        int qos;
+        bool retain;
+        unsigned long opened_at;  // 第一条样本加入的时间
+    };
+
+    Air780EGMQTT* mqtt;
+    Batch batches[MAX_BATCH_TOPICS];
+    int batch_count = 0;
+    size_t max_payload = AIR780EG_BATCH_DEFAULT_MAX_PAYLOAD;
+    unsigned long window_ms = AIR780EG_BATCH_DEFAULT_WINDOW_MS;
+    Air780EGBatchStats stats;
+
+    Batch* findBatch(const String& topic, bool create);
+    bool flushBatch(Batch& batch, Air780EGBatchFlushReason reason);
+
+public:
+    explicit Air780EGBatcher(Air780EGMQTT* mqtt_instance);
+
+    // 单个批次的负载上限（含方括号和逗号）和时间窗口
+    void setMaxPayload(size_t bytes);
+    size_t getMaxPayload() const;
+    void setWindow(unsigned long ms);
+    unsigned long getWindow() const;
+
+    // 加入一条样本（JSON文本）；priority 为true时立即连同已有样本一起发出
+    bool add(const String& topic, const String& sample, bool priority = false, int qos = 0, bool retain = false);
+
+    // 发出全部/指定主题的批次
+    bool flush();
+    bool flush(const String& topic);
+
+    // 检查时间窗口，在主循环中调用
+    void loop();
+
+    int getPendingSamples() const;
+    Air780EGBatchStats getStats() const;
+    void resetStats();
+    void printStats() const;
+};
+
+#endif // AIR780EG_BATCH_H
@@ -0,0 +1,140 @@
+#include "Air780EGCBOR.h"
+#include <math.h>
+
+#define CBOR_UINT 0
+#define CBOR_NEGINT 1
+#define CBOR_BYTES 2
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_SIMPLE 7
+
+Air780EGCBORWriter::Air780EGCBORWriter(uint8_t *buf, size_t size) : buffer(buf), capacity(size)
+{
+}
+
+void Air780EGCBORWriter::writeHead(uint8_t major, uint64_t value)
+{
+    uint8_t head[9];
+    size_t n;
+    if (value < 24)
+    {
+        head[0] = (major << 5) | value;
+        n = 1;
+    }
+    else if (value <= 0xFF)
+    {
+        head[0] = (major << 5) | 24;
+        head[1] = value;
+        n = 2;
+    }
+    else if (value <= 0xFFFF)
+    {
+        head[0] = (major << 5) | 25;
+        head[1] = value >> 8;
+        head[2] = value;
+        n = 3;
+    }
+    else if (value <= 0xFFFFFFFFULL)
+    {
+        head[0] = (major << 5) | 26;
+        for (int i = 0; i < 4; i++)
+            head[1 + i] = value >> (24 - 8 * i);
+        n = 5;
+    }
+    else
+    {
+        head[0] = (major << 5) | 27;
+        for (int i = 0; i < 8; i++)
+            head[1 + i] = value >> (56 - 8 * i);
+        n = 9;
+    }
+    writeBytes(head, n);
+}
+
+void Air780EGCBORWriter::writeBytes(const uint8_t *data, size_t len)
+{
+    if (overflow || used + len > capacity)
+    {
+        overflow = true;
+        return;
+    }
+    memcpy(buffer + used, data, len);
+    used += len;
+}
+
+void Air780EGCBORWriter::beginMap(size_t pairs)
+{
+    writeHead(CBOR_MAP, pairs);
+}
+
+void Air780EGCBORWriter::beginArray(size_t items)
+{
+    writeHead(CBOR_ARRAY, items);
+}
+
+void Air780EGCBORWriter::addUInt(uint64_t value)
+{
+    writeHead(CBOR_UINT, value);
+}
+
+void Air780EGCBORWriter::addInt(int64_t value)
+{
+    if (value >= 0)
+        writeHead(CBOR_UINT, (uint64_t)value);
+    else
+        writeHead(CBOR_NEGINT, (uint64_t)(-1 - value));
+}
+
+void Air780EGCBORWriter::addFixed(double value, int32_t scale)
+{
+    addInt((int64_t)llround(value * scale));
+}
+
+void Air780EGCBORWriter::addFloat(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t data[5] = {(CBOR_SIMPLE << 5) | 26, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16),
+                       (uint8_t)(bits >> 8), (uint8_t)bits};
+    writeBytes(data, sizeof(data));
+}
+
+void Air780EGCBORWriter::addBool(bool value)
+{
+    uint8_t data = (CBOR_SIMPLE << 5) | (value ? 21 : 20);
+    writeBytes(&data, 1);
+}
+
+void Air780EGCBORWriter::addNull()
+{
+    uint8_t data = (CBOR_SIMPLE << 5) | 22;
+    writeBytes(&data, 1);
+}
+
+void Air780EGCBORWriter::addText(const char *text)
+{
+    addText(text, strlen(text));
+}
+
+void Air780EGCBORWriter::addText(const char *text, size_t len)
+{
+    writeHead(CBOR_TEXT, len);
+    writeBytes((const uint8_t *)text, len);
+}
+
+void Air780EGCBORWriter::addBytes(const uint8_t *data, size_t len)
+{
+    writeHead(CBOR_BYTES, len);
+    writeBytes(data, len);
+}
+
+size_t Air780EGCBORWriter::length() const
+{
+    return overflow ? 0 : used;
+}
+
+bool Air780EGCBORWriter::ok() const
+{
+    return !overflow;
+}
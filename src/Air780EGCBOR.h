@@ -0,0 +1,47 @@
+#ifndef AIR780EG_CBOR_H
+#define AIR780EG_CBOR_H
+
+#include <Arduino.h>
+
+/*
+ * CBOR（RFC 8949）编码器，写入调用者提供的缓冲区，不分配堆内存
+ *
+ * 整数按值选择最短编码，适合整数键和定点数：
+ *   Air780EGCBORWriter w(buf, sizeof(buf));
+ *   w.beginMap(2);
+ *   w.addUInt(1); w.addFixed(31.1801365, 10000000);  // 纬度 x1e7
+ *   w.addUInt(7); w.addUInt(12);
+ *   size_t len = w.length();  // 缓冲区不足时为0
+ */
+
+class Air780EGCBORWriter {
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t used = 0;
+    bool overflow = false;
+
+    void writeHead(uint8_t major, uint64_t value);
+    void writeBytes(const uint8_t* data, size_t len);
+
+public:
+    Air780EGCBORWriter(uint8_t* buf, size_t size);
+
+    void beginMap(size_t pairs);
+    void beginArray(size_t items);
+    void addUInt(uint64_t value);
+    void addInt(int64_t value);
+    void addFixed(double value, int32_t scale);  // round(value * scale) 作为整数
+    void addFloat(float value);
+    void addBool(bool value);
+    void addNull();
+    void addText(const char* text);
+    void addText(const char* text, size_t len);
+    void addBytes(const uint8_t* data, size_t len);
+
+    // 已写入字节数；缓冲区不足时返回0
+    size_t length() const;
+    bool ok() const;
+};
+
+#endif // AIR780EG_CBOR_H
@@ -0,0 +1,290 @@
+#include "Air780EGCompress.h"
+#include "Air780EGDebug.h"
+#include "Air780EGHeapTrace.h"
+
+const char *Air780EGCompress::TAG = "Compress";
+
+#define WINDOW_BITS 11
+#define WINDOW_SIZE (1 << WINDOW_BITS)
+#define LENGTH_BITS 5
+#define MIN_MATCH 3
+#define MAX_MATCH (MIN_MATCH + (1 << LENGTH_BITS) - 1)
+#define HASH_BITS 10
+#define HASH_SIZE (1 << HASH_BITS)
+#define MAX_CHAIN 16
+#define NO_POS 0xFFFF
+
+// 静态字典：常见的JSON键和取值，按出现频率从低到高排列（离输入越近，引用越容易命中）。
+// 修改字典必须同时升级 AIR780EG_COMPRESS_VERSION 并同步服务端解码脚本（主机测试 check_payload_decoder 比对两边）
+static const char dictionary[] =
+    "\"sensors\":{\"temperature\":,\"humidity\":,\"voltage\":,\"imu\":{\"x\":,\"y\":,\"z\":"
+    "\"network\":{\"operator\":\"\",\"registered\":true,\"signal\":,\"battery\":"
+    "\"utc_date\":\"\",\"utc_time\":\"\",\"uptime\":,\"counter\":,\"status\":\""
+    "\"firmware\":\"\",\"hardware\":\"esp32-air780eg\",\"location\":{"
+    "\"latitude\":,\"longitude\":,\"altitude\":,\"satellites\":,\"hdop\":,\"accuracy\":"
+    "\"fixed\":false,\"valid\":true,\"speed\":,\"course\":,\"heading\":"
+    "{\"device_id\":\"\",\"timestamp\":,\"mode\":\"normal\",\"gps\":{\"lat\":,\"lng\":";
+static const size_t dictionary_len = sizeof(dictionary) - 1;
+
+uint16_t *Air780EGCompress::hash_head = nullptr;
+uint16_t *Air780EGCompress::hash_prev = nullptr;
+Air780EGCompressStats Air780EGCompress::stats = Air780EGCompressStats();
+
+// 压缩输出：凑满一组（控制字节 + 8项）后写入 Print
+struct CompressWriter {
+    Print &out;
+    uint8_t group[1 + 8 * 2];
+    uint8_t group_len = 1;
+    uint8_t items = 0;
+    size_t written = 0;
+
+    explicit CompressWriter(Print &target) : out(target) { group[0] = 0; }
+
+    void flush()
+    {
+        if (items == 0)
+            return;
+        written += out.write(group, group_len);
+        group[0] = 0;
+        group_len = 1;
+        items = 0;
+    }
+    void literal(uint8_t c)
+    {
+        group[group_len++] = c;
+        if (++items == 8)
+            flush();
+    }
+    void match(size_t distance, size_t length)
+    {
+        uint16_t word = ((distance - 1) << LENGTH_BITS) | (length - MIN_MATCH);
+        group[0] |= 1 << items;
+        group[group_len++] = word >> 8;
+        group[group_len++] = word & 0xFF;
+        if (++items == 8)
+            flush();
+    }
+};
+
+// 把压缩结果追加到String（负载中可能含0字节，按长度追加）
+struct StringWriter : public Print {
+    String &s;
+    explicit StringWriter(String &target) : s(target) {}
+    size_t write(uint8_t c) override { return s.concat((const char *)&c, 1) ? 1 : 0; }
+    size_t write(const uint8_t *buffer, size_t size) override { return s.concat((const char *)buffer, size) ? size : 0; }
+};
+
+bool Air780EGCompress::begin()
+{
+    if (hash_head)
+    {
+        return true;
+    }
+    hash_head = (uint16_t *)malloc(HASH_SIZE * sizeof(uint16_t));
+    hash_prev = (uint16_t *)malloc(WINDOW_SIZE * sizeof(uint16_t));
+    if (!hash_head || !hash_prev)
+    {
+        AIR780EG_LOGE(TAG, "Failed to allocate compression tables");
+        end();
+        return false;
+    }
+    return true;
+}
+
+void Air780EGCompress::end()
+{
+    free(hash_head);
+    free(hash_prev);
+    hash_head = nullptr;
+    hash_prev = nullptr;
+}
+
+bool Air780EGCompress::isEnabled()
+{
+    return hash_head != nullptr;
+}
+
+size_t Air780EGCompress::compress(const uint8_t *data, size_t len, Print &out)
+{
+    // 位置用16位保存：字典 + 输入不能超过 0xFFFF
+    if (!hash_head || len == 0 || dictionary_len + len >= NO_POS)
+    {
+        return 0;
+    }
+
+    // 字典与输入拼成一个虚拟缓冲区
+    const size_t total = dictionary_len + len;
+    auto at = [data](size_t pos) -> uint8_t
+    {
+        return pos < dictionary_len ? (uint8_t)dictionary[pos] : data[pos - dictionary_len];
+    };
+    auto hash = [&at](size_t pos) -> uint16_t
+    {
+        uint32_t v = ((uint32_t)at(pos) << 16) | ((uint32_t)at(pos + 1) << 8) | at(pos + 2);
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    };
+    auto insert = [&](size_t pos)
+    {
+        if (pos + MIN_MATCH > total)
+            return;
+        uint16_t h = hash(pos);
+        hash_prev[pos & (WINDOW_SIZE - 1)] = hash_head[h];
+        hash_head[h] = pos;
+    };
+
+    for (size_t i = 0; i < HASH_SIZE; i++)
+    {
+        hash_head[i] = NO_POS;
+    }
+    for (size_t pos = dictionary_len > WINDOW_SIZE ? dictionary_len - WINDOW_SIZE : 0; pos < dictionary_len; pos++)
+    {
+        insert(pos);
+    }
+
+    CompressWriter writer(out);
+    writer.written += out.write((uint8_t)AIR780EG_COMPRESS_MAGIC);
+    writer.written += out.write((uint8_t)AIR780EG_COMPRESS_VERSION);
+
+    size_t pos = dictionary_len;
+    while (pos < total)
+    {
+        size_t best_len = 0;
+        size_t best_dist = 0;
+        if (pos + MIN_MATCH <= total)
+        {
+            size_t limit = total - pos < MAX_MATCH ? total - pos : MAX_MATCH;
+            uint16_t candidate = hash_head[hash(pos)];
+            for (int chain = 0; candidate != NO_POS && chain < MAX_CHAIN; chain++)
+            {
+                size_t dist = pos - candidate;
+                if (dist > WINDOW_SIZE)
+                    break;
+                size_t n = 0;
+                while (n < limit && at(candidate + n) == at(pos + n))
+                    n++;
+                if (n > best_len)
+                {
+                    best_len = n;
+                    best_dist = dist;
+                    if (n == limit)
+                        break;
+                }
+                uint16_t next = hash_prev[candidate & (WINDOW_SIZE - 1)];
+                if (next == NO_POS || next >= candidate)
+                    break;
+                candidate = next;
+            }
+        }
+
+        if (best_len >= MIN_MATCH)
+        {
+            writer.match(best_dist, best_len);
+            for (size_t i = 0; i < best_len; i++)
+                insert(pos + i);
+            pos += best_len;
+        }
+        else
+        {
+            writer.literal(at(pos));
+            insert(pos);
+            pos++;
+        }
+    }
+    writer.flush();
+    return writer.written;
+}
+
+bool Air780EGCompress::compress(const String &data, String &packed)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    unsigned long start = micros();
+    packed = "";
+    packed.reserve(data.length());
+    StringWriter writer(packed);
+    size_t n = compress((const uint8_t *)data.c_str(), data.length(), writer);
+
+    uint32_t elapsed = micros() - start;
+    stats.calls++;
+    stats.total_us += elapsed;
+    if (elapsed > stats.max_us)
+    {
+        stats.max_us = elapsed;
+    }
+    if (n == 0 || n >= data.length())
+    {
+        stats.skipped++;
+        return false;
+    }
+    stats.input_bytes += data.length();
+    stats.output_bytes += n;
+    AIR780EG_LOGV(TAG, "Compressed %u -> %u bytes in %lu us", data.length(), (unsigned)n, (unsigned long)elapsed);
+    return true;
+}
+
+bool Air780EGCompress::isCompressed(const uint8_t *data, size_t len)
+{
+    return len >= 2 && data[0] == AIR780EG_COMPRESS_MAGIC && data[1] == AIR780EG_COMPRESS_VERSION;
+}
+
+size_t Air780EGCompress::decompress(const uint8_t *data, size_t len, uint8_t *out, size_t out_size)
+{
+    if (!isCompressed(data, len))
+    {
+        return 0;
+    }
+
+    size_t in = 2;
+    size_t produced = 0;
+    while (in < len)
+    {
+        uint8_t control = data[in++];
+        for (int bit = 0; bit < 8 && in < len; bit++)
+        {
+            if (!(control & (1 << bit)))
+            {
+                if (produced >= out_size)
+                    return 0;
+                out[produced++] = data[in++];
+                continue;
+            }
+
+            if (in + 2 > len)
+                return 0;
+            uint16_t word = (data[in] << 8) | data[in + 1];
+            in += 2;
+            size_t dist = (word >> LENGTH_BITS) + 1;
+            size_t length = (word & ((1 << LENGTH_BITS) - 1)) + MIN_MATCH;
+            if (dist > produced + dictionary_len || produced + length > out_size)
+                return 0;
+            // 逐字节复制，允许引用与输出重叠
+            for (size_t i = 0; i < length; i++)
+            {
+                out[produced] = produced >= dist ? out[produced - dist]
+                                                 : (uint8_t)dictionary[dictionary_len + produced - dist];
+                produced++;
+            }
+        }
+    }
+    return produced;
+}
+
+Air780EGCompressStats Air780EGCompress::getStats()
+{
+    return stats;
+}
+
+void Air780EGCompress::resetStats()
+{
+    stats = Air780EGCompressStats();
+}
+
+void Air780EGCompress::printStats()
+{
+    AIR780EG_LOGI(TAG, "=== Compression ===");
+    AIR780EG_LOGI(TAG, "calls: %lu, skipped: %lu, %lu -> %lu bytes (%.1f%%)",
+                  (unsigned long)stats.calls, (unsigned long)stats.skipped,
+                  (unsigned long)stats.input_bytes, (unsigned long)stats.output_bytes,
+                  stats.input_bytes ? 100.0f * stats.output_bytes / stats.input_bytes : 0.0f);
+    AIR780EG_LOGI(TAG, "time: avg %lu us, max %lu us",
+                  stats.calls ? (unsigned long)(stats.total_us / stats.calls) : 0UL, (unsigned long)stats.max_us);
+}
@@ -0,0 +1,59 @@
+#ifndef AIR780EG_COMPRESS_H
+#define AIR780EG_COMPRESS_H
+
+#include <Arduino.h>
+
+/*
+ * 负载压缩（LZSS + 静态JSON键字典）
+ *
+ * 遥测JSON的键名高度重复，压缩后再HEX编码可显著减少串口和流量。
+ * 编码格式（服务端解码见 tools/air780eg_payload.py）：
+ *   0xA8 + 版本(0x01) + 若干组：
+ *     控制字节（低位先），每位对应后面的一项：0 = 1字节原文，1 = 2字节回溯引用
+ *     回溯引用（大端）：高11位 = 距离-1（1~2048），低5位 = 长度-3（3~34）
+ * 字典视为位于输入之前的数据，距离可以越过输入开头引用字典内容。
+ * 0xA8 不可能是JSON或UTF-8文本的首字节，服务端据此区分压缩与未压缩负载。
+ *
+ * 压缩结果逐组写入 Print，工作表（约6KB）在 begin() 时分配一次。
+ */
+
+#define AIR780EG_COMPRESS_MAGIC 0xA8
+#define AIR780EG_COMPRESS_VERSION 1
+
+struct Air780EGCompressStats {
+    uint32_t calls;           // 压缩次数
+    uint32_t skipped;         // 压缩后不更小、按原文发送的次数
+    uint32_t input_bytes;     // 采用压缩结果的原文总字节
+    uint32_t output_bytes;    // 采用压缩结果的压缩后总字节
+    uint32_t total_us;        // 压缩累计耗时
+    uint32_t max_us;          // 单次最长耗时
+};
+
+class Air780EGCompress {
+private:
+    static const char* TAG;
+    static uint16_t* hash_head;
+    static uint16_t* hash_prev;
+    static Air780EGCompressStats stats;
+
+public:
+    // 分配工作表
+    static bool begin();
+    static void end();
+    static bool isEnabled();
+
+    // 压缩 len 字节写入 out，返回写入字节数（0表示失败）
+    static size_t compress(const uint8_t* data, size_t len, Print& out);
+    // 压缩结果比原文小时写入 packed 并返回true，同时计入统计
+    static bool compress(const String& data, String& packed);
+
+    // 解压到 out，返回解压后字节数（0表示格式错误或缓冲区不足）
+    static size_t decompress(const uint8_t* data, size_t len, uint8_t* out, size_t out_size);
+    static bool isCompressed(const uint8_t* data, size_t len);
+
+    static Air780EGCompressStats getStats();
+    static void resetStats();
+    static void printStats();
+};
+
+#endif // AIR780EG_COMPRESS_H
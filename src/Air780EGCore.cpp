@@ -2,7 +2,7 @@
 
 const char *Air780EGCore::TAG = "Air780EGCore";
 
-Air780EGCore::Air780EGCore() : serial(nullptr), last_at_time(0)
+Air780EGCore::Air780EGCore() : serial(nullptr), io(nullptr), last_at_time(0)
 {
 }
 
@@ -20,6 +20,7 @@ bool Air780EGCore::begin(HardwareSerial *ser, int baudrate, int rx_pin, int tx_p
     }
 
     serial = ser;
+    io = ser;
     power_pin = pwr_pin;
     AIR780EG_LOGD(TAG, "Power pin: %d", power_pin);
 
@@ -42,9 +43,9 @@ bool Air780EGCore::begin(HardwareSerial *ser, int baudrate, int rx_pin, int tx_p
     }
     delay(1000); // 等待模块稳定
     // 清空缓冲区
-    while (serial->available())
+    while (ioAvailable())
     {
-        serial->read();
+        ioRead();
     }
 
     while (!initModem())
@@ -61,7 +62,7 @@ bool Air780EGCore::begin(HardwareSerial *ser, int baudrate, int rx_pin, int tx_p
 bool Air780EGCore::isAtReady()
 {
     // 使用原始的命令确认是否有返回
-    serial->println("AT");
+    ioWriteLine("AT");
     String response = readResponse(1000);
     // 处理response boot.rom 还在初始化时候等待
     if (response.indexOf("boot.rom") >= 0)
@@ -75,6 +76,7 @@ bool Air780EGCore::isAtReady()
 
 bool Air780EGCore::initModem()
 {
+    AIR780EG_STALL_SCOPE("Core::initModem");
     // 多次尝试AT测试
     while (!isAtReady())
     {
@@ -93,7 +95,7 @@ bool Air780EGCore::initModem()
 ATE0
 */
     // 等待设备初始化完成信息，并捕捉设备时间，完成首次时间同步
-    while (serial->available())
+    while (ioAvailable())
     {
         String line = readLine();
         if (line.indexOf("+E_UTRAN Service") >= 0)
@@ -195,11 +197,13 @@ ATE0
     return true;
 }
 
-bool Air780EGCore::isNetworkReadyCheck()
+bool Air780EGCore::isNetworkReadyCheck(int attach_retries)
 {
+    AIR780EG_STALL_SCOPE("Core::isNetworkReadyCheck");
 
     // CEREG 4G 注册状态
     // CGREG 2G 注册状态
+    network_ready_valid = false;
     String response = sendATCommandWithResponse("AT+CEREG?", "OK", 5000);
     // 支持本地网络注册(1)和漫游网络注册(5)
     // 注意：第一个数字是上报模式，第二个数字是注册状态
@@ -221,19 +225,32 @@ bool Air780EGCore::isNetworkReadyCheck()
         String response = sendATCommandWithResponse("AT+CGATT?", "OK", 5000);
         if (response.indexOf("+CGATT: 1") >= 0)
             break;
-        delay(1000); // GPRS附着也需要更多时间
         cgattRetry++;
-    } while (cgattRetry < 8); // 增加重试次数
-    if (cgattRetry >= 8)
+        if (cgattRetry < attach_retries)
+            delay(1000); // GPRS附着也需要更多时间
+    } while (cgattRetry < attach_retries); // 增加重试次数
+    if (cgattRetry >= attach_retries)
     {
         AIR780EG_LOGE(TAG, "GPRS not attached");
         return false;
     }
     AIR780EG_LOGI(TAG, "GPRS附着成功");
 
+    network_ready_valid = true;
+    network_ready_at = millis();
     return true;
 }
 
+bool Air780EGCore::isNetworkReadyCached(unsigned long max_age_ms) const
+{
+    return network_ready_valid && millis() - network_ready_at < max_age_ms;
+}
+
+void Air780EGCore::invalidateNetworkReady()
+{
+    network_ready_valid = false;
+}
+
 // 等待期望的响应，支持超时机制
 bool Air780EGCore::waitExpectedResponse(const String &expected_response, unsigned long timeout)
 {
@@ -242,7 +259,7 @@ bool Air780EGCore::waitExpectedResponse(const String &expected_response, unsigne
     while (millis() - start_time < timeout)
     {
         // 检查串口是否有数据
-        if (serial->available())
+        if (ioAvailable())
         {
             String line = readLine();
             if (line.length() > 0 && line.indexOf(expected_response) >= 0)
@@ -262,9 +279,9 @@ String Air780EGCore::readLine()
 {
     static String buffer = "";
 
-    while (serial->available())
+    while (ioAvailable())
     {
-        char c = serial->read();
+        char c = ioRead();
 
         if (c == '\r' || c == '\n')
         {
@@ -292,33 +309,162 @@ String Air780EGCore::readLine()
     return "";
 }
 
+// ==================== 串口读写 ====================
+// 所有收发都经过这里，便于录制和回放
+
+int Air780EGCore::ioAvailable()
+{
+    return io ? io->available() : 0;
+}
+
+int Air780EGCore::ioRead()
+{
+    if (!io)
+        return -1;
+
+    int c = io->read();
+    if (c >= 0 && recorder)
+    {
+        recorder->recordRx((uint8_t)c);
+    }
+    return c;
+}
+
+void Air780EGCore::ioWriteLine(const char *line)
+{
+    if (!io)
+        return;
+
+    io->println(line);
+    if (recorder)
+    {
+        recorder->recordTx((const uint8_t *)line, strlen(line), true);
+    }
+}
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+void Air780EGCore::ioWriteHex(const uint8_t *data, size_t len)
+{
+    // 查表编码到栈上的小块缓冲区，写满一块就交给串口发送缓冲区
+    char chunk[128];
+    while (len > 0)
+    {
+        size_t n = len < sizeof(chunk) / 2 ? len : sizeof(chunk) / 2;
+        for (size_t i = 0; i < n; i++)
+        {
+            chunk[2 * i] = HEX_DIGITS[data[i] >> 4];
+            chunk[2 * i + 1] = HEX_DIGITS[data[i] & 0x0f];
+        }
+        io->write((const uint8_t *)chunk, n * 2);
+        if (recorder)
+        {
+            recorder->recordTx((const uint8_t *)chunk, n * 2);
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+void Air780EGCore::ioWriteEscaped(const uint8_t *data, size_t len)
+{
+    // 文本模式：引号和反斜杠前加反斜杠，其余字节原样写出
+    char chunk[128];
+    size_t used = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (used + 2 > sizeof(chunk))
+        {
+            io->write((const uint8_t *)chunk, used);
+            if (recorder)
+            {
+                recorder->recordTx((const uint8_t *)chunk, used);
+            }
+            used = 0;
+        }
+        if (data[i] == '"' || data[i] == '\\')
+        {
+            chunk[used++] = '\\';
+        }
+        chunk[used++] = (char)data[i];
+    }
+    if (used > 0)
+    {
+        io->write((const uint8_t *)chunk, used);
+        if (recorder)
+        {
+            recorder->recordTx((const uint8_t *)chunk, used);
+        }
+    }
+}
+
+void Air780EGCore::ioWriteData(const uint8_t *data, size_t len)
+{
+    if (!io)
+        return;
+
+    io->write(data, len);
+    if (recorder)
+    {
+        recorder->recordTxData(data, len);
+    }
+}
+
+void Air780EGCore::ioWriteCommand(const char *prefix, const uint8_t *payload, size_t payload_len, const char *suffix,
+                                  ATPayloadEncoding encoding)
+{
+    if (!io)
+        return;
+
+    // 提示符模式的负载在收到 '>' 之后由 ioWriteData 写入
+    if (encoding == AT_PAYLOAD_PROMPT || (payload_len == 0 && suffix[0] == '\0'))
+    {
+        ioWriteLine(prefix);
+        return;
+    }
+
+    io->print(prefix);
+    if (recorder)
+    {
+        recorder->recordTx((const uint8_t *)prefix, strlen(prefix));
+    }
+    if (encoding == AT_PAYLOAD_ESCAPED)
+    {
+        ioWriteEscaped(payload, payload_len);
+    }
+    else
+    {
+        ioWriteHex(payload, payload_len);
+    }
+    ioWriteLine(suffix);
+}
+
 void Air780EGCore::clearSerialBuffer()
 {
-    if (!serial)
+    if (!io)
         return;
 
-    while (serial->available())
+    while (ioAvailable())
     {
-        serial->read();
+        ioRead();
     }
     AIR780EG_LOGV(TAG, "Serial buffer cleared");
 }
 
 String Air780EGCore::readResponse(unsigned long timeout)
 {
-    if (!serial)
+    if (!io)
         return "";
 
     String response = "";
+    size_t line_start = 0;
     unsigned long start_time = millis();
 
     while (millis() - start_time < timeout)
     {
-        if (serial->available())
+        char c;
+        if (readResponseByte(response, line_start, c))
         {
-            char c = serial->read();
-            response += c;
-
             // 检查是否收到完整响应
             if (response.endsWith("OK\r\n") ||
                 response.endsWith("CONNECT OK\r\n") ||
@@ -345,19 +491,18 @@ String Air780EGCore::readResponse(unsigned long timeout)
 
 String Air780EGCore::readResponseUntilExpected(const String &expected_response, unsigned long timeout)
 {
-    if (!serial)
+    if (!io)
         return "";
 
     String response = "";
+    size_t line_start = 0;
     unsigned long start_time = millis();
 
     while (millis() - start_time < timeout)
     {
-        if (serial->available())
+        char c;
+        if (readResponseByte(response, line_start, c))
         {
-            char c = serial->read();
-            response += c;
-
             // 检查是否收到完整响应
             if (response.endsWith(expected_response) ||
                 response.endsWith("ERROR\r\n"))
@@ -374,20 +519,166 @@ String Air780EGCore::readResponseUntilExpected(const String &expected_response,
     return response;
 }
 
+// ==================== 发送流程（含追踪钩子） ====================
+
+void Air780EGCore::waitCommandSpacing(uint16_t trace_id)
+{
+    unsigned long current_time = millis();
+    if (current_time - last_at_time < at_command_delay)
+    {
+        Air780EGTrace::phaseBegin(trace_id, AIR780EG_TRACE_SPACING);
+        delay(at_command_delay - (current_time - last_at_time));
+        Air780EGTrace::phaseEnd(trace_id, AIR780EG_TRACE_SPACING);
+    }
+}
+
+void Air780EGCore::transmitCommand(const char *cmd, const uint8_t *payload, size_t payload_len, const char *suffix,
+                                   ATPayloadEncoding encoding, uint16_t trace_id)
+{
+    Air780EGTrace::phaseBegin(trace_id, AIR780EG_TRACE_TX);
+    ioWriteCommand(cmd, payload, payload_len, suffix, encoding);
+    last_at_time = millis();
+    Air780EGTrace::phaseEnd(trace_id, AIR780EG_TRACE_TX);
+    Air780EGTrace::phaseBegin(trace_id, AIR780EG_TRACE_AWAIT);
+}
+
+void Air780EGCore::logCommand(const char *cmd, size_t payload_len, const char *suffix, ATPayloadEncoding encoding)
+{
+    // 优化日志输出，显示为输入模式；负载只记录长度
+    if (payload_len == 0)
+    {
+        AIR780EG_LOGD(TAG, "> %s%s", cmd, suffix);
+    }
+    else if (encoding == AT_PAYLOAD_PROMPT)
+    {
+        AIR780EG_LOGD(TAG, "> %s (+%u bytes after prompt)", cmd, (unsigned)payload_len);
+    }
+    else
+    {
+        AIR780EG_LOGD(TAG, "> %s<%u bytes %s>%s", cmd, (unsigned)payload_len,
+                      encoding == AT_PAYLOAD_HEX ? "hex" : "text", suffix);
+    }
+}
+
+bool Air780EGCore::readPrompt(String &response, unsigned long timeout)
+{
+    size_t line_start = 0;
+    unsigned long start_time = millis();
+
+    while (millis() - start_time < timeout)
+    {
+        char c;
+        if (readResponseByte(response, line_start, c))
+        {
+            if (c == '>')
+                return true;
+            if (response.endsWith("ERROR\r\n"))
+                return false;
+        }
+        delay(1);
+    }
+    return false;
+}
+
+// 同步读取响应的一个字节。与异步路径相同，响应中夹带的带长度URC（+MSUB 等）按长度读完后直接分发，
+// 头部和数据都不进入响应，负载中的 CR/LF 或 OK 不会拆开消息或提前结束命令。
+// 读到响应字节时返回true并通过 c 返回
+bool Air780EGCore::readResponseByte(String &response, size_t &line_start, char &c)
+{
+    if (urc_frame_handler >= 0)
+    {
+        readURCFrame();
+        return false;
+    }
+    if (!ioAvailable())
+    {
+        return false;
+    }
+    c = ioRead();
+    if (response.length() == 0)
+    {
+        traceFirstByte(sync_trace_id);
+    }
+    response += c;
+    if (c == '\n')
+    {
+        line_start = response.length();
+    }
+    else if (c == ',' && response.charAt(line_start) == '+' &&
+             beginURCFrame(response.c_str() + line_start, response.length() - line_start))
+    {
+        // 头部移出响应
+        response.remove(line_start);
+        return false;
+    }
+    return true;
+}
+
+// 发送前读完已开始的上报（按长度读取中的数据或未结束的行），命令不插在上报中间；
+// 超时仍未结束视为残缺，丢弃
+void Air780EGCore::finishPendingURC(unsigned long timeout)
+{
+    unsigned long start_time = millis();
+    while (urc_frame_handler >= 0 || urc_line.length() > 0)
+    {
+        if (millis() - start_time >= timeout)
+        {
+            discardPartialURC();
+            return;
+        }
+        if (urc_frame_handler >= 0)
+        {
+            if (!readURCFrame())
+            {
+                delay(1);
+            }
+        }
+        else if (ioAvailable())
+        {
+            handleURCByte(ioRead());
+        }
+        else
+        {
+            delay(1);
+        }
+    }
+}
+
+void Air780EGCore::traceFirstByte(uint16_t trace_id)
+{
+    if (trace_id == 0)
+        return;
+
+    trace_response_started = true;
+    Air780EGTrace::phaseEnd(trace_id, AIR780EG_TRACE_AWAIT);
+    Air780EGTrace::phaseBegin(trace_id, AIR780EG_TRACE_RESPONSE);
+}
+
+void Air780EGCore::traceCommandEnd(uint16_t trace_id, const String &cmd, const String &response, bool response_started)
+{
+    Air780EGTrace::phaseEnd(trace_id, response_started ? AIR780EG_TRACE_RESPONSE : AIR780EG_TRACE_AWAIT);
+    Air780EGTrace::commandEnd(trace_id, cmd.c_str(), Air780EGTrace::resultOf(response));
+}
+
 String Air780EGCore::sendATCommand(const String &cmd, unsigned long timeout)
 {
-    if (!serial || !initialized)
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_CORE);
+    AIR780EG_STALL_SCOPE("Core::sendATCommand");
+    if (!io || !initialized)
     {
         AIR780EG_LOGE(TAG, "Module not initialized");
         return "";
     }
 
+    // 等待正在执行的异步命令和已开始的上报，避免响应交错
+    drainCurrentCommand();
+    finishPendingURC(URC_STALE_MS);
+
+    uint16_t trace_id = Air780EGTrace::newId();
+    Air780EGTrace::commandBegin(trace_id, cmd.c_str());
+
     // 确保AT指令间有足够间隔
-    unsigned long current_time = millis();
-    if (current_time - last_at_time < at_command_delay)
-    {
-        delay(at_command_delay - (current_time - last_at_time));
-    }
+    waitCommandSpacing(trace_id);
 
     // 优化日志输出，显示为输入模式
     AIR780EG_LOGD(TAG, "> %s", cmd.c_str());
@@ -396,11 +687,16 @@ String Air780EGCore::sendATCommand(const String &cmd, unsigned long timeout)
     // clearSerialBuffer();
 
     // 发送AT指令
-    serial->println(cmd);
-    last_at_time = millis();
+    transmitCommand(cmd.c_str(), nullptr, 0, "", AT_PAYLOAD_HEX, trace_id);
 
     // 读取响应
+    sync_trace_id = trace_id;
+    trace_response_started = false;
     String response = readResponse(timeout);
+    sync_trace_id = 0;
+    traceCommandEnd(trace_id, cmd, response, trace_response_started);
+    // readResponse 也以 SUBACK 结束，此时它是 AT+MSUB 的应答
+    dispatchURCsInResponse(cmd.c_str(), response, "SUBACK");
 
     if (response.length() == 0)
     {
@@ -412,14 +708,30 @@ String Air780EGCore::sendATCommand(const String &cmd, unsigned long timeout)
 
 String Air780EGCore::sendATCommandUntilExpected(const String &cmd, const String &expected_response, unsigned long timeout)
 {
-    if (!serial || !initialized)
+    return sendCommandUntilExpected(cmd, String(), String(), AT_PAYLOAD_HEX, expected_response, timeout);
+}
+
+String Air780EGCore::sendATCommandWithPayload(const String &prefix, const String &payload, const String &suffix,
+                                              ATPayloadEncoding encoding, const String &expected_response,
+                                              unsigned long timeout)
+{
+    return sendCommandUntilExpected(prefix, payload, suffix, encoding, expected_response, timeout);
+}
+
+String Air780EGCore::sendCommandUntilExpected(const String &cmd, const String &payload, const String &suffix,
+                                              ATPayloadEncoding encoding, const String &expected_response,
+                                              unsigned long timeout)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_CORE);
+    AIR780EG_STALL_SCOPE("Core::sendATCommandUntilExpected");
+    if (!io || !initialized)
     {
         AIR780EG_LOGE(TAG, "Module not initialized");
         return "";
     }
 
     // 检查是否有阻塞命令正在执行
-    if (is_blocking_command_active && getCommandType(cmd) != blocking_command_type)
+    if (is_blocking_command_active && getCommandType(cmd.c_str()) != blocking_command_type)
     {
         AIR780EG_LOGD(TAG, "Blocking command %s is active, rejecting command: %s", 
                       blocking_command_type.c_str(), cmd.c_str());
@@ -427,30 +739,57 @@ String Air780EGCore::sendATCommandUntilExpected(const String &cmd, const String
     }
 
     // 如果是阻塞命令，设置状态
-    String cmd_type = getCommandType(cmd);
+    String cmd_type = getCommandType(cmd.c_str());
     bool is_blocking = (cmd_type == "WIFILOC" || cmd_type == "LBS");
     if (is_blocking) {
         setBlockingCommandActive(cmd_type);
     }
 
+    // 等待正在执行的异步命令和已开始的上报，避免响应交错
+    drainCurrentCommand();
+    finishPendingURC(URC_STALE_MS);
+
+    uint16_t trace_id = Air780EGTrace::newId();
+    Air780EGTrace::commandBegin(trace_id, cmd.c_str());
+
     // 确保AT指令间有足够间隔
-    unsigned long current_time = millis();
-    if (current_time - last_at_time < at_command_delay)
-    {
-        delay(at_command_delay - (current_time - last_at_time));
-    }
+    waitCommandSpacing(trace_id);
 
-    // 优化日志输出，显示为输入模式
-    AIR780EG_LOGD(TAG, "> %s", cmd.c_str());
+    logCommand(cmd.c_str(), payload.length(), suffix.c_str(), encoding);
 
     // 清空接收缓冲区
     // clearSerialBuffer();
 
-    serial->println(cmd);
-    last_at_time = millis();
+    transmitCommand(cmd.c_str(), (const uint8_t *)payload.c_str(), payload.length(), suffix.c_str(), encoding, trace_id);
 
     // 读取响应
-    String response = readResponseUntilExpected(expected_response, timeout);
+    sync_trace_id = trace_id;
+    trace_response_started = false;
+    String response;
+    if (encoding == AT_PAYLOAD_PROMPT)
+    {
+        // 收到 '>' 后写入原始负载，再等待最终结果
+        String prompt;
+        if (readPrompt(prompt, timeout))
+        {
+            ioWriteData((const uint8_t *)payload.c_str(), payload.length());
+            last_at_time = millis();
+            response = readResponseUntilExpected(expected_response, timeout);
+        }
+        else
+        {
+            prompt.trim();
+            response = prompt;
+            AIR780EG_LOGW(TAG, "No data prompt for command: %s", cmd.c_str());
+        }
+    }
+    else
+    {
+        response = readResponseUntilExpected(expected_response, timeout);
+    }
+    sync_trace_id = 0;
+    traceCommandEnd(trace_id, cmd, response, trace_response_started);
+    dispatchURCsInResponse(cmd.c_str(), response, expected_response.c_str());
 
     // 如果是阻塞命令，清除状态
     if (is_blocking) {
@@ -495,9 +834,17 @@ String Air780EGCore::sendATCommandWithResponse(const String &cmd, const String &
     769	Unable to get control	不能获得控制
     */
     // 增加一个对结果的解析报错 比如 CME ERROR: 767 标识 操作失败
-    if (response.indexOf("CME ERROR:") >= 0)
+    int cme_pos = response.indexOf("CME ERROR:");
+    if (cme_pos >= 0)
     {
-        int error_code = response.substring(10, 13).toInt();
+        // 错误码紧跟在"CME ERROR:"之后，不假定其在响应中的位置
+        int code_start = cme_pos + 10;
+        int code_end = response.indexOf('\r', code_start);
+        if (code_end < 0)
+        {
+            code_end = response.length();
+        }
+        int error_code = response.substring(code_start, code_end).toInt();
         switch (error_code)
         {
         case 765:
@@ -553,6 +900,47 @@ Air780EGURC *Air780EGCore::getURCManager() const
     return urc_manager;
 }
 
+bool Air780EGCore::addURCHandler(const char *prefix, URCHandler handler, void *context,
+                                 URCFrameLength frame_length, URCFrameBuffer frame_buffer)
+{
+    if (!prefix || !handler || urc_handler_count >= MAX_URC_HANDLERS)
+    {
+        AIR780EG_LOGE(TAG, "Cannot register URC handler: %s", prefix ? prefix : "(null)");
+        return false;
+    }
+    urc_handlers[urc_handler_count].prefix = prefix;
+    urc_handlers[urc_handler_count].handler = handler;
+    urc_handlers[urc_handler_count].context = context;
+    urc_handlers[urc_handler_count].frame_length = frame_length;
+    urc_handlers[urc_handler_count].frame_buffer = frame_length ? frame_buffer : nullptr;
+    urc_handler_count++;
+    return true;
+}
+
+void Air780EGCore::setURCInputPaused(bool paused)
+{
+    if (paused != urc_input_paused)
+    {
+        AIR780EG_LOGD(TAG, "URC input %s", paused ? "paused" : "resumed");
+    }
+    urc_input_paused = paused;
+}
+
+bool Air780EGCore::isURCInputPaused() const
+{
+    return urc_input_paused;
+}
+
+size_t Air780EGCore::getHeldURCBytes() const
+{
+    return held_urcs.length();
+}
+
+uint32_t Air780EGCore::getHeldURCOverflows() const
+{
+    return held_urc_overflows;
+}
+
 void Air780EGCore::setATCommandDelay(unsigned long delay_ms)
 {
     at_command_delay = delay_ms;
@@ -569,6 +957,37 @@ bool Air780EGCore::isInitialized() const
     return initialized;
 }
 
+bool Air780EGCore::attachStream(Stream *stream)
+{
+    if (!stream)
+    {
+        AIR780EG_LOGE(TAG, "Stream pointer is null");
+        return false;
+    }
+
+    // 不做上电和模块初始化，直接使用外部数据流（如回放、主机仿真）
+    io = stream;
+    initialized = true;
+    AIR780EG_LOGI(TAG, "Attached external stream");
+    return true;
+}
+
+Stream *Air780EGCore::getStream() const
+{
+    return io;
+}
+
+void Air780EGCore::setRecorder(Air780EGRecorder *rec)
+{
+    recorder = rec;
+    AIR780EG_LOGD(TAG, "AT recorder set: %p", rec);
+}
+
+Air780EGRecorder *Air780EGCore::getRecorder() const
+{
+    return recorder;
+}
+
 HardwareSerial *Air780EGCore::getSerial() const
 {
     return serial;
@@ -603,15 +1022,37 @@ int Air780EGCore::getCSQ()
 }
 // ==================== 队列管理方法实现 ====================
 
-String Air780EGCore::getCommandType(const String& cmd) {
-    if (cmd.startsWith("AT+WIFILOC")) return "WIFILOC";
-    if (cmd.startsWith("AT+MPUB")) return "MPUB";
-    if (cmd.startsWith("AT+MQTTSTATU")) return "MQTTSTATU";
-    if (cmd.startsWith("AT+LBS")) return "LBS";
-    if (cmd.startsWith("AT+MSUB")) return "MSUB";
-    if (cmd.startsWith("AT+MUNSUB")) return "MUNSUB";
-    if (cmd.startsWith("AT+MCONN")) return "MCONN";
-    if (cmd.startsWith("AT+MDISCONN")) return "MDISCONN";
+static bool commandStartsWith(const char* cmd, const char* prefix) {
+    return strncmp(cmd, prefix, strlen(prefix)) == 0;
+}
+
+// 响应行是否为命令自身的应答："AT+CSQ" 的 "+CSQ: ..."
+static bool isCommandReply(const char* cmd, const char* line) {
+    // AT+MSUB 只应答 OK / SUBACK，+MSUB: 总是下行消息
+    if (!commandStartsWith(cmd, "AT+") || commandStartsWith(line, "+MSUB:")) {
+        return false;
+    }
+    const char* name = cmd + 2;
+    size_t n = 0;
+    while (name[n] && name[n] != '=' && name[n] != '?' && name[n] != '\r' && name[n] != '"') {
+        n++;
+    }
+    return strncmp(line, name, n) == 0 && (line[n] == ':' || line[n] == ' ' || line[n] == '\0');
+}
+
+String Air780EGCore::getCommandType(const char* cmd) {
+    if (commandStartsWith(cmd, "AT+WIFILOC")) return "WIFILOC";
+    if (commandStartsWith(cmd, "AT+MPUB")) return "MPUB";
+    if (commandStartsWith(cmd, "AT+MQTTSTATU")) return "MQTTSTATU";
+    if (commandStartsWith(cmd, "AT+MQTTMSGGET")) return "MQTTMSGGET";
+    if (commandStartsWith(cmd, "AT+MIPSTART") || commandStartsWith(cmd, "AT+SSLMIPSTART")) return "MIPSTART";
+    if (commandStartsWith(cmd, "AT+MCONNECT")) return "MCONNECT";
+    if (commandStartsWith(cmd, "AT+CDNSGIP")) return "CDNSGIP";
+    if (commandStartsWith(cmd, "AT+LBS")) return "LBS";
+    if (commandStartsWith(cmd, "AT+MSUB")) return "MSUB";
+    if (commandStartsWith(cmd, "AT+MUNSUB")) return "MUNSUB";
+    if (commandStartsWith(cmd, "AT+MCONN")) return "MCONN";
+    if (commandStartsWith(cmd, "AT+MDISCONN")) return "MDISCONN";
     return "GENERIC";
 }
 
@@ -629,35 +1070,134 @@ bool Air780EGCore::isCompleteResponse(const String& response, const String& cmd_
     if (cmd_type == "MPUB") {
         return response.indexOf("OK") >= 0 || response.indexOf("ERROR") >= 0;
     }
+    if (cmd_type == "MIPSTART") {
+        // TCP连接结果在OK之后上报；ERROR 后面可能还有 ALREADY CONNECT，等待结果行或超时
+        return response.indexOf("CONNECT OK") >= 0 || response.indexOf("ALREADY CONNECT") >= 0 ||
+               response.indexOf("CONNECT FAIL") >= 0;
+    }
+    if (cmd_type == "MCONNECT") {
+        return response.indexOf("CONNACK OK") >= 0 || response.indexOf("ERROR") >= 0;
+    }
+    if (cmd_type == "CDNSGIP") {
+        // 解析结果在OK之后上报
+        return response.indexOf("+CDNSGIP:") >= 0 || response.indexOf("ERROR") >= 0;
+    }
     if (cmd_type == "MQTTSTATU") {
-        return response.indexOf("+MQTTSTATU:") >= 0 || response.indexOf("ERROR") >= 0;
+        // 模块应答为 "+MQTTSTATU :1"（冒号前有空格），等到 OK 再结束
+        return (response.indexOf("+MQTTSTATU") >= 0 && response.indexOf("OK") >= 0) ||
+               response.indexOf("ERROR") >= 0;
+    }
+    if (cmd_type == "MQTTMSGGET") {
+        // 缓存的消息按 +MSUB 长度读出后直接分发，不留在响应中；只认结尾的结果行，主题中可能含 "OK"
+        return response.endsWith("OK\r\n") || response.endsWith("ERROR\r\n") || response.indexOf("CME ERROR") >= 0;
     }
     // 通用命令等待 OK 或 ERROR
     return response.indexOf("OK") >= 0 || response.indexOf("ERROR") >= 0;
 }
 
-void Air780EGCore::addToQueue(const String& cmd, const String& expected, unsigned long timeout, bool blocking) {
-    String cmd_type = getCommandType(cmd);
+bool Air780EGCore::addToQueue(const String& cmd, const String& expected, unsigned long timeout, bool blocking,
+                              ATCommandCallback callback, void* context) {
+    String cmd_type = getCommandType(cmd.c_str());
     ATCommand new_cmd(cmd, cmd_type, expected, timeout, blocking);
-    command_queue.push(new_cmd);
+    new_cmd.callback = callback;
+    new_cmd.callback_context = context;
+    return addToQueue(new_cmd);
+}
+
+bool Air780EGCore::addToQueue(ATCommand& new_cmd) {
+    if (queue_count >= MAX_QUEUED_COMMANDS) {
+        AIR780EG_LOGW(TAG, "Command queue full, rejecting: %s", new_cmd.commandText());
+        return false;
+    }
+    
+    new_cmd.trace_id = Air780EGTrace::newId();
+    Air780EGTrace::commandBegin(new_cmd.trace_id, new_cmd.commandText());
+    Air780EGTrace::phaseBegin(new_cmd.trace_id, AIR780EG_TRACE_QUEUED);
     
     AIR780EG_LOGD(TAG, "Added to queue: %s (type: %s, blocking: %s)", 
-                  cmd.c_str(), cmd_type.c_str(), blocking ? "true" : "false");
+                  new_cmd.commandText(), new_cmd.type.c_str(), new_cmd.is_blocking ? "true" : "false");
+    // 负载可能较大，移动而不是复制
+    command_queue[(queue_head + queue_count) % MAX_QUEUED_COMMANDS] = std::move(new_cmd);
+    queue_count++;
+    return true;
 }
 
 bool Air780EGCore::sendATCommandAsync(const String& cmd, const String& expected_response, unsigned long timeout) {
-    if (!serial || !initialized) {
+    return sendATCommandAsync(cmd, nullptr, nullptr, expected_response, timeout);
+}
+
+bool Air780EGCore::sendATCommandAsync(const String& cmd, ATCommandCallback callback, void* context,
+                                      const String& expected_response, unsigned long timeout) {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_CORE);
+    if (!io || !initialized) {
         AIR780EG_LOGE(TAG, "Module not initialized");
         return false;
     }
     
-    String cmd_type = getCommandType(cmd);
+    String cmd_type = getCommandType(cmd.c_str());
     bool is_blocking = (cmd_type == "WIFILOC" || cmd_type == "LBS");
     
-    addToQueue(cmd, expected_response, timeout, is_blocking);
+    return addToQueue(cmd, expected_response, timeout, is_blocking, callback, context);
+}
+
+bool Air780EGCore::sendATCommandAsyncNext(const String& cmd, ATCommandCallback callback, void* context,
+                                          const String& expected_response, unsigned long timeout) {
+    if (!sendATCommandAsync(cmd, callback, context, expected_response, timeout)) {
+        return false;
+    }
+    // 刚放在队尾，和队首之间的命令依次后移一位
+    for (size_t i = queue_count - 1; i > 0; i--) {
+        std::swap(command_queue[(queue_head + i) % MAX_QUEUED_COMMANDS],
+                  command_queue[(queue_head + i - 1) % MAX_QUEUED_COMMANDS]);
+    }
+    command_queue[queue_head].urgent = true;
     return true;
 }
 
+bool Air780EGCore::sendATCommandWithPayloadAsync(const String& prefix, const String& payload, const String& suffix,
+                                                 ATPayloadEncoding encoding, ATCommandCallback callback, void* context,
+                                                 const String& expected_response, unsigned long timeout) {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_CORE);
+    if (!io || !initialized) {
+        AIR780EG_LOGE(TAG, "Module not initialized");
+        return false;
+    }
+    
+    ATCommand new_cmd(prefix, getCommandType(prefix.c_str()), expected_response, timeout, false);
+    new_cmd.payload = payload;
+    new_cmd.suffix = suffix;
+    new_cmd.payload_encoding = encoding;
+    new_cmd.callback = callback;
+    new_cmd.callback_context = context;
+    return addToQueue(new_cmd);
+}
+
+bool Air780EGCore::sendATCommandWithPayloadAsync(const char* prefix, const uint8_t* payload, size_t payload_len,
+                                                 const char* suffix, ATPayloadEncoding encoding,
+                                                 ATCommandCallback callback, void* context,
+                                                 const String& expected_response, unsigned long timeout) {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_CORE);
+    if (!io || !initialized) {
+        AIR780EG_LOGE(TAG, "Module not initialized");
+        return false;
+    }
+    
+    // 命令和负载都不复制，队列槽位里只保存指针
+    ATCommand new_cmd(String(), getCommandType(prefix), expected_response, timeout, false);
+    new_cmd.command_ref = prefix;
+    new_cmd.payload_ref = payload;
+    new_cmd.payload_ref_len = payload_len;
+    new_cmd.suffix = suffix;
+    new_cmd.payload_encoding = encoding;
+    new_cmd.callback = callback;
+    new_cmd.callback_context = context;
+    return addToQueue(new_cmd);
+}
+
+size_t Air780EGCore::getQueuedCommandCount() const {
+    return queue_count + (current_command != nullptr ? 1 : 0);
+}
+
 void Air780EGCore::checkBlockingCommandTimeout() {
     if (is_blocking_command_active && 
         (millis() - blocking_command_start >= BLOCKING_COMMAND_TIMEOUT)) {
@@ -668,40 +1208,109 @@ void Air780EGCore::checkBlockingCommandTimeout() {
 }
 
 void Air780EGCore::processCommands() {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_CORE);
+    AIR780EG_STALL_SCOPE("Core::processCommands");
     // 检查阻塞命令超时
     checkBlockingCommandTimeout();
     
     // 处理当前命令
     if (current_command != nullptr) {
-        if (executeCurrentCommand()) {
-            AIR780EG_LOGI(TAG, "Current command completed: %s", current_command->command.c_str());
-            // 当前命令完成，清理
-            delete current_command;
-            current_command = nullptr;
-            accumulated_response = "";
+        if (!executeCurrentCommand()) {
+            return; // 当前命令未完成，继续等待
         }
-        return; // 当前命令未完成，继续等待
+        AIR780EG_LOGD(TAG, "Current command completed: %s", current_command->commandText());
+        completeCurrentCommand();
     }
     
+    // 空闲时读取主动上报（MQTT下行消息等）
+    pollURC();
+    
     // 启动新命令
-    if (!command_queue.empty()) {
-        ATCommand cmd = command_queue.front();
-        command_queue.pop();
+    if (queue_count > 0) {
+        // 还有暂停期间保留的上报时不发新命令，否则响应中夹带的上报只能继续积压在内存中
+        if (held_urcs.length() > 0) {
+            return;
+        }
+        // 未到AT指令最小间隔时留在队列中，下次循环再发送，不在主循环里delay；插在队首的命令除外
+        if (!command_queue[queue_head].urgent && millis() - last_at_time < at_command_delay) {
+            return;
+        }
+        // 不在URC行或数据中间插入命令，避免上报与响应交错（超过200ms没有新数据视为残缺，丢弃）
+        if (urc_line.length() > 0 || urc_frame_handler >= 0) {
+            if (millis() - urc_line_time < URC_STALE_MS) {
+                return;
+            }
+            discardPartialURC();
+        }
         
-        current_command = new ATCommand(cmd);
+        active_command = std::move(command_queue[queue_head]);
+        queue_head = (queue_head + 1) % MAX_QUEUED_COMMANDS;
+        queue_count--;
+        current_command = &active_command;
         command_start_time = millis();
         accumulated_response = "";
+        urc_scanned = 0;
+        response_line_start = 0;
+        Air780EGTrace::phaseEnd(current_command->trace_id, AIR780EG_TRACE_QUEUED);
         
-        // 确保AT指令间有足够间隔
-        unsigned long current_time = millis();
-        if (current_time - last_at_time < at_command_delay) {
-            delay(at_command_delay - (current_time - last_at_time));
-        }
-        
-        AIR780EG_LOGD(TAG, "> %s", current_command->command.c_str());
-        serial->println(current_command->command);
-        last_at_time = millis();
+        ATPayloadEncoding encoding = (ATPayloadEncoding)current_command->payload_encoding;
+        logCommand(current_command->commandText(), current_command->payloadLength(),
+                   current_command->suffix.c_str(), encoding);
+        transmitCommand(current_command->commandText(), current_command->payloadData(),
+                        current_command->payloadLength(), current_command->suffix.c_str(),
+                        encoding, current_command->trace_id);
+        current_command->awaiting_prompt = (encoding == AT_PAYLOAD_PROMPT);
+    }
+}
+
+void Air780EGCore::completeCurrentCommand() {
+    // 移出执行槽：回调里即使启动了下一条命令，也不会覆盖正在使用的这一条
+    ATCommand done(std::move(active_command));
+    ATCommand* cmd = &done;
+    bool response_started = accumulated_response.length() > 0;
+    // 响应末尾没有换行的URC行在这里补检查一次
+    checkAndDispatchURC(accumulated_response, urc_scanned, true);
+    // 先清空当前命令，回调里可以继续发送同步或异步命令
+    current_command = nullptr;
+    accumulated_response = "";
+    urc_scanned = 0;
+    response_line_start = 0;
+    
+    Air780EGTrace::phaseEnd(cmd->trace_id, response_started ? AIR780EG_TRACE_RESPONSE : AIR780EG_TRACE_AWAIT);
+    if (cmd->callback) {
+        ATCommandResult result = resultOfCommand(*cmd);
+        unsigned long latency = millis() - cmd->timestamp;
+        Air780EGTrace::phaseBegin(cmd->trace_id, AIR780EG_TRACE_CALLBACK);
+        cmd->callback(result, cmd->response, latency, cmd->callback_context);
+        Air780EGTrace::phaseEnd(cmd->trace_id, AIR780EG_TRACE_CALLBACK);
+    }
+    Air780EGTrace::commandEnd(cmd->trace_id, cmd->commandText(), Air780EGTrace::resultOf(cmd->response));
+}
+
+void Air780EGCore::drainCurrentCommand() {
+    if (current_command == nullptr) {
+        return;
     }
+    
+    AIR780EG_LOGD(TAG, "Waiting for in-flight command: %s", current_command->commandText());
+    // executeCurrentCommand 自带超时，循环必然结束
+    while (!executeCurrentCommand()) {
+        delay(1);
+    }
+    completeCurrentCommand();
+}
+
+ATCommandResult Air780EGCore::resultOfCommand(const ATCommand& cmd) const {
+    if (cmd.response == "TIMEOUT") {
+        return AT_RESULT_TIMEOUT;
+    }
+    if (cmd.response.indexOf("ERROR") >= 0) {
+        return AT_RESULT_ERROR;
+    }
+    if (cmd.expected_response.length() > 0 && cmd.response.indexOf(cmd.expected_response) < 0) {
+        return AT_RESULT_ERROR;
+    }
+    return AT_RESULT_OK;
 }
 
 bool Air780EGCore::executeCurrentCommand() {
@@ -709,21 +1318,47 @@ bool Air780EGCore::executeCurrentCommand() {
     
     // 检查超时
     if (millis() - command_start_time > current_command->timeout) {
-        AIR780EG_LOGW(TAG, "Command timeout: %s", current_command->command.c_str());
+        AIR780EG_LOGW(TAG, "Command timeout: %s", current_command->commandText());
         current_command->completed = true;
         current_command->response = "TIMEOUT";
         return true;
     }
     
     // 读取串口数据
-    while (serial->available()) {
-        char c = serial->read();
+    while (ioAvailable()) {
+        // 响应中间夹带的带长度URC：数据不进入响应，按长度读完后直接分发
+        if (urc_frame_handler >= 0) {
+            if (!readURCFrame()) {
+                break;
+            }
+            continue;
+        }
+        char c = ioRead();
+        if (accumulated_response.length() == 0) {
+            Air780EGTrace::phaseEnd(current_command->trace_id, AIR780EG_TRACE_AWAIT);
+            Air780EGTrace::phaseBegin(current_command->trace_id, AIR780EG_TRACE_RESPONSE);
+        }
         accumulated_response += c;
+        if (c == '\n') {
+            response_line_start = accumulated_response.length();
+        } else if (c == ',' && accumulated_response.charAt(response_line_start) == '+' &&
+                   beginURCFrame(accumulated_response.c_str() + response_line_start,
+                                 accumulated_response.length() - response_line_start)) {
+            // 头部移出响应
+            accumulated_response.remove(response_line_start);
+        }
+    }
+    
+    // 提示符模式：收到 '>' 后写入原始负载，之后按普通命令等待结果
+    if (current_command->awaiting_prompt && accumulated_response.indexOf('>') >= 0) {
+        current_command->awaiting_prompt = false;
+        ioWriteData(current_command->payloadData(), current_command->payloadLength());
+        last_at_time = millis();
     }
     
     // 检查是否包含真正的URC（主动上报消息）
     // URC特征：以+开头，但不是当前命令的预期响应
-    checkAndDispatchURC(accumulated_response);
+    checkAndDispatchURC(accumulated_response, urc_scanned, false);
     
     // 检查响应是否完整
     if (isCompleteResponse(accumulated_response, current_command->type)) {
@@ -759,34 +1394,60 @@ String Air780EGCore::getCommandResponse(const String& cmd_type) {
 
 // ==================== URC识别和分发 ====================
 
-void Air780EGCore::checkAndDispatchURC(const String& response) {
-    // 按行分割响应，检查每一行是否为真正的URC
-    int start = 0;
+void Air780EGCore::checkAndDispatchURC(const String& response, size_t& scanned, bool final) {
+    // 按行分割响应，检查每一行是否为真正的URC。
+    // 只检查上次之后新收到的完整行，同一行不会因为响应未完成而被重复分发
+    int start = scanned;
     int end = 0;
     
     while ((end = response.indexOf('\n', start)) != -1) {
-        String line = response.substring(start, end);
-        line.trim();
-        
-        if (line.length() > 0 && isRealURC(line)) {
-            // 这是一个真正的URC，分发给相应的处理器
-            dispatchURC(line);
+        if (lineMayBeURC(response, start, end)) {
+            String line = response.substring(start, end);
+            line.trim();
+            
+            if (isRealURC(line)) {
+                // 这是一个真正的URC，分发给相应的处理器
+                dispatchURC(line);
+            }
         }
         
         start = end + 1;
     }
+    scanned = start;
     
-    // 处理最后一行（如果没有换行符结尾）
-    if (start < response.length()) {
+    // 处理最后一行（响应已完成且没有换行符结尾）
+    if (final && start < (int)response.length() && lineMayBeURC(response, start, response.length())) {
         String line = response.substring(start);
         line.trim();
         
-        if (line.length() > 0 && isRealURC(line)) {
+        if (isRealURC(line)) {
             dispatchURC(line);
         }
+        scanned = response.length();
     }
 }
 
+bool Air780EGCore::lineMayBeURC(const String& response, int start, int end) {
+    // 只有以+开头或注册了前缀的行才可能是URC，其余行（OK、回显、数据）不必复制
+    while (start < end && isspace((unsigned char)response.charAt(start))) {
+        start++;
+    }
+    if (start >= end) {
+        return false;
+    }
+    if (response.charAt(start) == '+') {
+        return true;
+    }
+    const char* line = response.c_str() + start;
+    for (int i = 0; i < urc_handler_count; i++) {
+        size_t len = strlen(urc_handlers[i].prefix);
+        if ((int)len <= end - start && strncmp(line, urc_handlers[i].prefix, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool Air780EGCore::isRealURC(const String& line) {
     // 真正的URC特征：
     // 1. 以+开头
@@ -794,7 +1455,12 @@ bool Air780EGCore::isRealURC(const String& line) {
     // 3. 是主动上报的消息
     
     if (!line.startsWith("+")) {
-        return false;
+        // 不以+开头的上报（如连接断开的 CLOSED）只认注册过的前缀；
+        // 当前命令等待的结束应答（如 SUBACK）属于命令本身
+        if (current_command != nullptr && line == current_command->expected_response) {
+            return false;
+        }
+        return isRegisteredURC(line.c_str());
     }
     
     // 如果当前没有执行命令，任何+开头的都可能是URC
@@ -823,22 +1489,249 @@ bool Air780EGCore::isRealURC(const String& line) {
         return true; // MQTT相关的主动上报
     }
     
+    // 注册了处理器的上报（例如发布确认），当前命令自身的应答行除外
+    if (!isCommandReply(current_command->commandText(), line.c_str()) && isRegisteredURC(line.c_str())) {
+        return true;
+    }
+    
     // 其他未知的+开头消息，暂时认为不是URC
     return false;
 }
 
+bool Air780EGCore::isRegisteredURC(const char* line) const {
+    for (int i = 0; i < urc_handler_count; i++) {
+        if (commandStartsWith(line, urc_handlers[i].prefix)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 同步命令读取的响应中夹带的已注册上报照常分发，否则会被当作响应丢弃。
+// 结束读取的最后一行是命令自身的应答（如订阅的 SUBACK），不分发；之前的同名行属于其他命令
+void Air780EGCore::dispatchURCsInResponse(const char* cmd, const String& response, const char* reply) {
+    if (urc_handler_count == 0) {
+        return;
+    }
+    int start = 0;
+    while (start < (int)response.length()) {
+        int end = response.indexOf('\n', start);
+        if (end < 0) {
+            end = response.length();
+        }
+        if (lineMayBeURC(response, start, end)) {
+            String line = response.substring(start, end);
+            line.trim();
+            bool final_reply = end == (int)response.length() && reply && line == reply;
+            if (!final_reply && !isCommandReply(cmd, line.c_str()) && isRegisteredURC(line.c_str())) {
+                dispatchURC(line);
+            }
+        }
+        start = end + 1;
+    }
+}
+
 void Air780EGCore::dispatchURC(const String& urc) {
+    if (!holdURC(urc)) {
+        deliverURC(urc);
+    }
+}
+
+// 暂停期间带长度的数据上报留在Core中：接收方队列已满，此时分发只会被丢弃。
+// 已有保留的上报时，新到的也排在后面，保持到达顺序
+bool Air780EGCore::holdURC(const String& urc) {
+    if (!urc_input_paused && held_urcs.length() == 0) {
+        return false;
+    }
+    bool framed = false;
+    for (int i = 0; i < urc_handler_count && !framed; i++) {
+        framed = urc_handlers[i].frame_length && commandStartsWith(urc.c_str(), urc_handlers[i].prefix);
+    }
+    if (!framed) {
+        return false;
+    }
+    uint32_t len = urc.length();
+    if (held_urcs.length() > 0 && held_urcs.length() + sizeof(uint32_t) + len > MAX_HELD_URC_BYTES) {
+        // 暂停期间同步命令持续收到数据时不无限积压，交给处理器按其溢出策略处理
+        held_urc_overflows++;
+        AIR780EG_LOGW(TAG, "Held URC limit reached (%u bytes), dispatching without holding",
+                      held_urcs.length());
+        return false;
+    }
+    char header[4] = {(char)(len & 0xFF), (char)((len >> 8) & 0xFF), (char)((len >> 16) & 0xFF),
+                      (char)((len >> 24) & 0xFF)};
+    held_urcs.concat(header, sizeof(header));
+    held_urcs.concat(urc.c_str(), len);
+    AIR780EG_LOGD(TAG, "URC held while input is paused (%u bytes held)", held_urcs.length());
+    return true;
+}
+
+// 恢复后按顺序分发保留的上报，处理器再次暂停时剩余的继续保留
+void Air780EGCore::dispatchHeldURCs() {
+    size_t pos = 0;
+    String urc;
+    while (!urc_input_paused && pos < held_urcs.length()) {
+        const uint8_t* p = (const uint8_t*)held_urcs.c_str() + pos;
+        size_t len = p[0] | (p[1] << 8) | (p[2] << 16) | ((size_t)p[3] << 24);
+        urc = "";
+        urc.concat((const char*)p + 4, len);
+        pos += 4 + len;
+        deliverURC(urc);
+    }
+    if (pos >= held_urcs.length()) {
+        held_urcs = String();
+    } else if (pos > 0) {
+        held_urcs.remove(0, pos);
+    }
+}
+
+void Air780EGCore::deliverURC(const String& urc) {
     AIR780EG_LOGD(TAG, "Dispatching URC: %s", urc.c_str());
+    Air780EGTrace::instant(AIR780EG_TRACE_URC, urc.c_str());
     
-    // 根据URC类型分发给相应的处理器
-    if (urc.startsWith("+MCONNECT:") || urc.startsWith("+MSUB:")) {
-        // MQTT相关URC，需要分发给MQTT模块
-        // 这里需要通过回调或者其他机制通知MQTT模块
-        // 暂时先记录日志
-        AIR780EG_LOGD(TAG, "MQTT URC detected: %s", urc.c_str());
+    // 根据URC前缀分发给注册的处理器
+    for (int i = 0; i < urc_handler_count; i++) {
+        if (commandStartsWith(urc.c_str(), urc_handlers[i].prefix)) {
+            urc_handlers[i].handler(urc, urc_handlers[i].context);
+        }
+    }
+}
+
+void Air780EGCore::pollURC() {
+    if (current_command != nullptr) {
+        return;
+    }
+    if (held_urcs.length() > 0) {
+        dispatchHeldURCs();
+    }
+    while (true) {
+        // 已开始的数据先读完，暂停只在消息之间生效
+        if (urc_frame_handler >= 0) {
+            if (!readURCFrame()) {
+                return;
+            }
+            continue;
+        }
+        if (urc_input_paused || !ioAvailable()) {
+            return;
+        }
+        handleURCByte(ioRead());
+    }
+}
+
+// 按行读取上报；带长度的上报在头部完整时切换到按长度读取
+void Air780EGCore::handleURCByte(char c) {
+    urc_line_time = millis();
+    if (c == '\r' || c == '\n') {
+        if (urc_line.length() > 0) {
+            urc_line.trim();
+            if (urc_line.startsWith("+") || isRegisteredURC(urc_line.c_str())) {
+                dispatchURC(urc_line);
+            } else if (urc_line.indexOf("boot.rom") >= 0) {
+                boot_rom = true;
+            }
+            urc_line = "";
+        }
+        return;
+    }
+    urc_line += c;
+    if (c == ',' && urc_line.charAt(0) == '+') {
+        beginURCFrame(urc_line.c_str(), urc_line.length());
+    } else if (urc_line.length() > MAX_URC_LINE) {
+        AIR780EG_LOGW(TAG, "URC line too long, discarding");
+        urc_line = "";
     }
 }
 
+void Air780EGCore::discardPartialURC() {
+    AIR780EG_LOGW(TAG, "Discarding partial URC: %s (%u bytes missing)", urc_line.c_str(),
+                  (unsigned)urc_frame_remaining);
+    if (urc_frame_dest) {
+        const URCHandlerEntry& entry = urc_handlers[urc_frame_handler];
+        entry.frame_buffer(urc_line, 0, entry.context);
+        urc_frame_dest = nullptr;
+    }
+    urc_line = "";
+    urc_frame_handler = -1;
+    urc_frame_remaining = 0;
+    urc_frame_discard = false;
+}
+
+// 头部匹配带长度的处理器时切换到按长度读取，返回true
+bool Air780EGCore::beginURCFrame(const char* line, size_t len) {
+    for (int i = 0; i < urc_handler_count; i++) {
+        const URCHandlerEntry& entry = urc_handlers[i];
+        if (!entry.frame_length || !commandStartsWith(line, entry.prefix)) {
+            continue;
+        }
+        // 头部很短，按需复制一次
+        if (line != urc_line.c_str()) {
+            urc_line = "";
+            urc_line.concat(line, len);
+        }
+        long length = entry.frame_length(urc_line, entry.context);
+        if (length < 0) {
+            return false;
+        }
+        urc_frame_handler = i;
+        urc_frame_remaining = length;
+        urc_frame_discard = (size_t)length > MAX_URC_FRAME;
+        urc_frame_dest = nullptr;
+        urc_line_time = millis();
+        if (urc_frame_discard) {
+            AIR780EG_LOGW(TAG, "URC data too large (%ld bytes), discarding", length);
+        } else {
+            // 有暂存的上报时按原顺序排在其后，数据不能直接交给处理器
+            if (entry.frame_buffer && length > 0 && !urc_input_paused && held_urcs.length() == 0) {
+                urc_frame_dest = entry.frame_buffer(urc_line, length, entry.context);
+            }
+            if (!urc_frame_dest) {
+                // urc_line 的容量跨帧保留，只有比以往都大的数据才重新分配
+                urc_line.reserve(urc_line.length() + length);
+            }
+        }
+        readURCFrame();
+        return true;
+    }
+    return false;
+}
+
+// 按长度读取URC数据，读完后分发给处理器并返回true
+bool Air780EGCore::readURCFrame() {
+    char chunk[64];
+    while (urc_frame_remaining > 0 && ioAvailable()) {
+        // 直接写入处理器缓冲区，否则经 chunk 追加到 urc_line
+        char* out = urc_frame_dest ? (char*)urc_frame_dest : chunk;
+        size_t limit = urc_frame_dest ? urc_frame_remaining : sizeof(chunk);
+        size_t n = 0;
+        while (n < limit && n < urc_frame_remaining && ioAvailable()) {
+            out[n++] = ioRead();
+        }
+        if (urc_frame_dest) {
+            urc_frame_dest += n;
+        } else if (!urc_frame_discard) {
+            urc_line.concat(chunk, n);
+        }
+        urc_frame_remaining -= n;
+        urc_line_time = millis();
+    }
+    if (urc_frame_remaining > 0) {
+        return false;
+    }
+
+    const URCHandlerEntry& entry = urc_handlers[urc_frame_handler];
+    bool direct = urc_frame_dest != nullptr;
+    urc_frame_handler = -1;
+    urc_frame_dest = nullptr;
+    if (!urc_frame_discard && (direct || !holdURC(urc_line))) {
+        Air780EGTrace::instant(AIR780EG_TRACE_URC, entry.prefix);
+        entry.handler(urc_line, entry.context);
+    }
+    urc_frame_discard = false;
+    urc_line = "";
+    return true;
+}
+
 // ==================== 阻塞命令管理 ====================
 
 bool Air780EGCore::isBlockingCommandActive() const {
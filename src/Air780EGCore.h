@@ -3,11 +3,42 @@
 
 #include <Arduino.h>
 #include <HardwareSerial.h>
-#include <queue>
 #include "Air780EGDebug.h"
+#include "Air780EGHeapTrace.h"
+#include "Air780EGStallProfiler.h"
+#include "Air780EGRecorder.h"
+#include "Air780EGTrace.h"
 
 class Air780EGURC; // 前向声明
 
+// 异步命令完成结果
+enum ATCommandResult {
+    AT_RESULT_OK = 0,
+    AT_RESULT_ERROR,
+    AT_RESULT_TIMEOUT
+};
+
+// 异步命令完成回调：结果、完整响应、从入队到完成的耗时
+typedef void (*ATCommandCallback)(ATCommandResult result, const String& response,
+                                  unsigned long latency_ms, void* context);
+
+// URC处理器：收到以注册前缀开头的主动上报行时调用（在串口解析过程中，应尽快返回）
+typedef void (*URCHandler)(const String& urc, void* context);
+// 带长度的URC（如 +MSUB: "topic",N byte,<data>）：每收到一个逗号用已收到的头部调用一次，
+// 头部完整时返回其后数据的字节数，否则返回-1。数据按长度读取，其中的CR/LF不会被当作行结束
+typedef long (*URCFrameLength)(const String& header, void* context);
+// 带长度URC的数据直接写入处理器的缓冲区（可选）：头部完整后调用，返回至少 length 字节的缓冲区，
+// 读完后处理器收到的只有头部；返回nullptr时数据照常读入URC字符串。
+// length 为0表示此前返回的缓冲区中的数据未读完，已被丢弃
+typedef uint8_t* (*URCFrameBuffer)(const String& header, size_t length, void* context);
+
+// 命令负载的发送方式
+enum ATPayloadEncoding {
+    AT_PAYLOAD_HEX = 0,      // 行内HEX编码：prefix + HEX(payload) + suffix
+    AT_PAYLOAD_ESCAPED,      // 行内文本，转义 " 和 \ ：prefix + payload + suffix
+    AT_PAYLOAD_PROMPT        // 发送prefix后等待 '>' 提示符，再写入原始字节
+};
+
 // AT命令结构体
 struct ATCommand {
     String command;
@@ -18,33 +49,99 @@ struct ATCommand {
     bool is_blocking;
     bool completed;
     String response;
+    uint16_t trace_id;       // 生命周期追踪ID（未启用追踪时为0）
+    ATCommandCallback callback;
+    void* callback_context;
+    String payload;          // 流式发送的负载（为空时只发送command）
+    String suffix;           // 负载之后的命令结尾
+    uint8_t payload_encoding; // ATPayloadEncoding
+    bool awaiting_prompt;    // 等待 '>' 提示符
+    bool urgent;             // 插在队首的命令，发送时不等待命令间隔
+    // 引用调用者的缓冲区（非空时代替 command / payload），调用者保证在完成回调之前有效
+    const char* command_ref;
+    const uint8_t* payload_ref;
+    size_t payload_ref_len;
     
+    ATCommand() : ATCommand("", "", "") {}
     ATCommand(const String& cmd, const String& cmd_type, const String& expected, 
               unsigned long to = 1000, bool blocking = false) 
         : command(cmd), type(cmd_type), expected_response(expected), 
           timeout(to), timestamp(millis()), is_blocking(blocking), 
-          completed(false), response("") {}
+          completed(false), response(""), trace_id(0),
+          callback(nullptr), callback_context(nullptr),
+          payload_encoding(AT_PAYLOAD_HEX), awaiting_prompt(false), urgent(false),
+          command_ref(nullptr), payload_ref(nullptr), payload_ref_len(0) {}
+    
+    const char* commandText() const { return command_ref ? command_ref : command.c_str(); }
+    const uint8_t* payloadData() const { return payload_ref ? payload_ref : (const uint8_t*)payload.c_str(); }
+    size_t payloadLength() const { return payload_ref ? payload_ref_len : payload.length(); }
 };
 
 class Air780EGCore {
+    friend struct Air780EGHostTest; // 主机测试（test/）直接调用解析函数
+
 private:
     static const char* TAG;
     
     HardwareSerial* serial;
+    Stream* io;                          // 实际收发使用的数据流，默认即serial
+    Air780EGRecorder* recorder = nullptr; // AT收发录制（可选）
     String response_cache;
     unsigned long last_at_time;
     unsigned long at_command_delay = 100; // AT指令间最小间隔
     
     bool initialized = false;
     bool boot_rom = false;
+    
+    // 最近一次网络检查通过的时间，连接时在有效期内跳过 CEREG / CGATT 查询
+    bool network_ready_valid = false;
+    unsigned long network_ready_at = 0;
     int power_pin = -1;
     
     // URC管理器
     Air780EGURC* urc_manager = nullptr;
     
+    // URC分发：按前缀注册的处理器；空闲时由 processCommands 读取主动上报
+    struct URCHandlerEntry {
+        const char* prefix;
+        URCHandler handler;
+        void* context;
+        URCFrameLength frame_length;
+        URCFrameBuffer frame_buffer;
+    };
+    static const int MAX_URC_HANDLERS = 8;
+    URCHandlerEntry urc_handlers[MAX_URC_HANDLERS];
+    int urc_handler_count = 0;
+    String urc_line;                     // 空闲时读取中的URC行
+    unsigned long urc_line_time = 0;     // 最后一个字节的时间
+    size_t urc_scanned = 0;              // accumulated_response 中已检查过URC的位置
+    bool urc_input_paused = false;       // 上层积压时暂停空闲读取，数据留在串口缓冲区
+    static const size_t MAX_URC_LINE = 1024;      // 不带长度的URC行上限
+    static const size_t MAX_URC_FRAME = 16384;    // 带长度的URC数据上限，超出时读取并丢弃
+    int urc_frame_handler = -1;          // 正在按长度读取数据的处理器，-1表示按行读取
+    uint8_t* urc_frame_dest = nullptr;   // 数据直接写入处理器缓冲区时的写入位置
+    size_t urc_frame_remaining = 0;
+    bool urc_frame_discard = false;
+    size_t response_line_start = 0;      // accumulated_response 中当前行的起点
+    String held_urcs;                    // 暂停期间收到的带长度上报（4字节长度 + 内容），恢复后按顺序分发
+    static const size_t MAX_HELD_URC_BYTES = 4096; // 保留上报的总字节上限（至少保留一条），超出的直接分发
+    uint32_t held_urc_overflows = 0;
+    static const unsigned long URC_STALE_MS = 200; // 上报中途超过此时间没有新数据视为残缺
+    void pollURC();
+    void handleURCByte(char c);
+    bool beginURCFrame(const char* line, size_t len);
+    bool readURCFrame();
+    void finishPendingURC(unsigned long timeout);
+    void discardPartialURC();
+    
     // 命令队列管理
-    std::queue<ATCommand> command_queue;
-    ATCommand* current_command = nullptr;
+    static const size_t MAX_QUEUED_COMMANDS = 16;
+    // 定长环形队列和执行槽，命令在槽位间移动，稳态下不分配堆内存
+    ATCommand command_queue[MAX_QUEUED_COMMANDS];
+    size_t queue_head = 0;
+    size_t queue_count = 0;
+    ATCommand active_command;
+    ATCommand* current_command = nullptr;  // 指向 active_command，空闲时为nullptr
     bool echo_enabled = false;
     String accumulated_response = "";
     unsigned long command_start_time = 0;
@@ -56,6 +153,30 @@ private:
     static const unsigned long BLOCKING_COMMAND_TIMEOUT = 30000;  // 30秒超时
     void checkBlockingCommandTimeout();
     
+    // 串口读写（统一经过录制钩子）
+    int ioAvailable();
+    int ioRead();
+    void ioWriteLine(const char* line);
+    void ioWriteHex(const uint8_t* data, size_t len);
+    void ioWriteEscaped(const uint8_t* data, size_t len);
+    void ioWriteData(const uint8_t* data, size_t len);
+    void ioWriteCommand(const char* prefix, const uint8_t* payload, size_t payload_len, const char* suffix,
+                        ATPayloadEncoding encoding);
+    
+    // 发送流程（含追踪钩子）
+    uint16_t sync_trace_id = 0;
+    bool trace_response_started = false;
+    void waitCommandSpacing(uint16_t trace_id);
+    void transmitCommand(const char* cmd, const uint8_t* payload, size_t payload_len, const char* suffix,
+                         ATPayloadEncoding encoding, uint16_t trace_id);
+    void logCommand(const char* cmd, size_t payload_len, const char* suffix, ATPayloadEncoding encoding);
+    String sendCommandUntilExpected(const String& cmd, const String& payload, const String& suffix,
+                                    ATPayloadEncoding encoding, const String& expected_response, unsigned long timeout);
+    bool readPrompt(String& response, unsigned long timeout);
+    bool readResponseByte(String& response, size_t& line_start, char& c);
+    void traceFirstByte(uint16_t trace_id);
+    void traceCommandEnd(uint16_t trace_id, const String& cmd, const String& response, bool response_started);
+    
     // 内部方法
     void clearSerialBuffer();
     bool isAtReady();
@@ -63,14 +184,25 @@ private:
     String readLine(); // 读取一行数据
     
     // 队列管理方法
-    String getCommandType(const String& cmd);
+    String getCommandType(const char* cmd);
     bool isCompleteResponse(const String& response, const String& cmd_type);
-    void addToQueue(const String& cmd, const String& expected, unsigned long timeout = 1000, bool blocking = false);
+    bool addToQueue(const String& cmd, const String& expected, unsigned long timeout = 1000, bool blocking = false,
+                    ATCommandCallback callback = nullptr, void* context = nullptr);
+    bool addToQueue(ATCommand& new_cmd);
     void processCommandQueue();
     bool executeCurrentCommand();
-    void checkAndDispatchURC(const String& response);
+    void completeCurrentCommand();
+    void drainCurrentCommand();
+    ATCommandResult resultOfCommand(const ATCommand& cmd) const;
+    void checkAndDispatchURC(const String& response, size_t& scanned, bool final);
+    bool lineMayBeURC(const String& response, int start, int end);
     bool isRealURC(const String& line);
+    bool isRegisteredURC(const char* line) const;
+    void dispatchURCsInResponse(const char* cmd, const String& response, const char* reply);
     void dispatchURC(const String& urc);
+    void deliverURC(const String& urc);
+    bool holdURC(const String& urc);
+    void dispatchHeldURCs();
     
 public:
     Air780EGCore();
@@ -88,6 +220,26 @@ public:
     
     // 非阻塞AT指令方法
     bool sendATCommandAsync(const String& cmd, const String& expected_response = "OK", unsigned long timeout = 1000);
+    bool sendATCommandAsync(const String& cmd, ATCommandCallback callback, void* context,
+                            const String& expected_response = "OK", unsigned long timeout = 1000);
+    
+    // 带负载的命令：负载按 encoding 分块编码后直接写入串口，不构造完整的命令字符串
+    // （用于 AT+MPUB / AT+MPUBEX 等发布命令）
+    String sendATCommandWithPayload(const String& prefix, const String& payload, const String& suffix,
+                                    ATPayloadEncoding encoding, const String& expected_response,
+                                    unsigned long timeout = 1000);
+    bool sendATCommandWithPayloadAsync(const String& prefix, const String& payload, const String& suffix,
+                                       ATPayloadEncoding encoding, ATCommandCallback callback, void* context,
+                                       const String& expected_response = "OK", unsigned long timeout = 1000);
+    // 零拷贝版本：只保存 prefix / payload 指针，两者必须在 callback 被调用之前保持有效
+    bool sendATCommandWithPayloadAsync(const char* prefix, const uint8_t* payload, size_t payload_len,
+                                       const char* suffix, ATPayloadEncoding encoding,
+                                       ATCommandCallback callback, void* context,
+                                       const String& expected_response = "OK", unsigned long timeout = 1000);
+    // 放在队首，当前命令完成后立即发送，不等待命令间隔（用于 CONNECT OK 之后必须马上发送的 AT+MCONNECT）
+    bool sendATCommandAsyncNext(const String& cmd, ATCommandCallback callback, void* context,
+                                const String& expected_response = "OK", unsigned long timeout = 1000);
+    size_t getQueuedCommandCount() const;
     bool isCommandCompleted(const String& cmd_type);
     String getCommandResponse(const String& cmd_type);
     void processCommands(); // 在主循环中调用
@@ -104,6 +256,18 @@ public:
     void setURCManager(Air780EGURC* manager);
     Air780EGURC* getURCManager() const;
     
+    // 注册URC处理器，prefix 须为静态字符串（如 "+MSUB:"）；不以+开头的前缀（如 "CLOSED"）同样按整行匹配
+    bool addURCHandler(const char* prefix, URCHandler handler, void* context,
+                       URCFrameLength frame_length = nullptr, URCFrameBuffer frame_buffer = nullptr);
+    // 暂停空闲时的URC读取。命令执行期间的响应照常读取，其中带长度的数据上报（如 +MSUB）
+    // 保留在Core中，恢复后按顺序分发；有保留的上报时不启动新的异步命令
+    // 保留的上报总量有上限（MAX_HELD_URC_BYTES），超出时新到的上报直接交给处理器，
+    // 由接收方按自己的溢出策略处理（MQTT 下行队列已满时计为 dropped_newest）
+    void setURCInputPaused(bool paused);
+    bool isURCInputPaused() const;
+    size_t getHeldURCBytes() const;
+    uint32_t getHeldURCOverflows() const;
+    
     // 配置方法
     void setATCommandDelay(unsigned long delay_ms);
     unsigned long getATCommandDelay() const;
@@ -111,7 +275,17 @@ public:
     // 状态查询
     bool isInitialized() const;
     HardwareSerial* getSerial() const;
-    bool isNetworkReadyCheck();
+    
+    // 使用外部数据流代替串口（回放、主机仿真），跳过上电和模块初始化
+    bool attachStream(Stream* stream);
+    Stream* getStream() const;
+    
+    // AT收发录制
+    void setRecorder(Air780EGRecorder* recorder);
+    Air780EGRecorder* getRecorder() const;
+    bool isNetworkReadyCheck(int attach_retries = 8);  // 附着检查最多 attach_retries 次，间隔1秒
+    bool isNetworkReadyCached(unsigned long max_age_ms = 60000) const;  // max_age_ms 内检查通过过
+    void invalidateNetworkReady();                     // 连接失败等迹象表明网络可能已断开
     bool waitExpectedResponse(const String &expected_response, unsigned long timeout = 10000);
 
     // getCSQ
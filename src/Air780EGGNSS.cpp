@@ -31,6 +31,8 @@ Air780EGGNSS::Air780EGGNSS(Air780EGCore *core_instance) : core(core_instance)
 
 bool Air780EGGNSS::enableGNSS()
 {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_GNSS);
+    AIR780EG_STALL_SCOPE("GNSS::enableGNSS");
     if (!core || !core->isInitialized())
     {
         AIR780EG_LOGE(TAG, "Core not initialized");
@@ -222,6 +224,8 @@ void Air780EGGNSS::parseGPSTime(const String &date_part, const String &time_part
 
 bool Air780EGGNSS::updateWIFILocation()
 {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_GNSS);
+    AIR780EG_STALL_SCOPE("GNSS::updateWIFILocation");
     // 检查是否有阻塞命令正在执行
     if (core->isBlockingCommandActive()) {
         AIR780EG_LOGW(TAG, "Another blocking command is active, skipping WIFI location");
@@ -238,7 +242,8 @@ bool Air780EGGNSS::updateWIFILocation()
 
         // 找到+WIFILOC:的位置
         int start_pos = response.indexOf("+WIFILOC:") + 9; // "+WIFILOC:"的长度
-        String data_part = response.substring(start_pos);
+        int end_pos = response.indexOf('\r', start_pos);
+        String data_part = end_pos >= 0 ? response.substring(start_pos, end_pos) : response.substring(start_pos);
 
         // 解析逗号分隔的数据
         int comma_count = 0;
@@ -272,6 +277,10 @@ bool Air780EGGNSS::updateWIFILocation()
 
                 comma_count++;
                 start = i + 1;
+                if (comma_count > 4)
+                {
+                    break;
+                }
             }
         }
         gnss_data.is_wifi_valid = false;
@@ -319,6 +328,8 @@ bool Air780EGGNSS::updateWIFILocation()
 
 bool Air780EGGNSS::updateLBS()
 {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_GNSS);
+    AIR780EG_STALL_SCOPE("GNSS::updateLBS");
     if (!lbs_location_enabled) {
         AIR780EG_LOGD(TAG, "LBS定位未启用");
         return false;
@@ -415,6 +426,7 @@ bool Air780EGGNSS::updateLBS()
 
 bool Air780EGGNSS::disableGNSS()
 {
+    AIR780EG_STALL_SCOPE("GNSS::disableGNSS");
     if (!core || !core->isInitialized())
     {
         AIR780EG_LOGE(TAG, "Core not initialized");
@@ -439,6 +451,8 @@ bool Air780EGGNSS::disableGNSS()
 
 void Air780EGGNSS::loop()
 {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_GNSS);
+    AIR780EG_STALL_SCOPE("GNSS::loop");
     if (!core || !core->isInitialized())
     {
         return;
@@ -629,6 +643,12 @@ bool Air780EGGNSS::parseGNSSResponse(const String &response)
 
             field_count++;
             start = i + 1;
+
+            // 之后的字段不使用，避免扫描异常的超长行
+            if (field_count >= 12)
+            {
+                break;
+            }
         }
     }
 
@@ -767,6 +787,7 @@ String Air780EGGNSS::getRawGNSSData()
 
 String Air780EGGNSS::getLocationJSON()
 {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_GNSS);
     DynamicJsonDocument doc(1024);
     doc["latitude"] = gnss_data.latitude;
     doc["longitude"] = gnss_data.longitude;
@@ -791,6 +812,47 @@ String Air780EGGNSS::getLocationJSON()
     return doc.as<String>();
 }
 
+// 与 getLocationJSON 内容相同，约为JSON的1/6
+size_t Air780EGGNSS::getLocationCBOR(uint8_t *buffer, size_t size)
+{
+    const gps_time_t &t = gnss_data.gps_time;
+    uint8_t flags = (gnss_data.is_gnss_valid ? 0x01 : 0) | (gnss_data.is_wifi_valid ? 0x02 : 0) |
+                    (gnss_data.is_lbs_valid ? 0x04 : 0) | (t.valid ? 0x08 : 0);
+
+    Air780EGCBORWriter cbor(buffer, size);
+    cbor.beginMap(t.valid ? 9 : 8);
+    cbor.addUInt(LOCATION_KEY_FLAGS);
+    cbor.addUInt(flags);
+    cbor.addUInt(LOCATION_KEY_LATITUDE);
+    cbor.addFixed(gnss_data.latitude, 10000000);
+    cbor.addUInt(LOCATION_KEY_LONGITUDE);
+    cbor.addFixed(gnss_data.longitude, 10000000);
+    cbor.addUInt(LOCATION_KEY_ALTITUDE);
+    cbor.addFixed(gnss_data.altitude, 10);
+    cbor.addUInt(LOCATION_KEY_SPEED);
+    cbor.addFixed(gnss_data.speed, 10);
+    cbor.addUInt(LOCATION_KEY_COURSE);
+    cbor.addFixed(gnss_data.course, 10);
+    cbor.addUInt(LOCATION_KEY_HDOP);
+    cbor.addFixed(gnss_data.hdop, 10);
+    cbor.addUInt(LOCATION_KEY_SATELLITES);
+    cbor.addUInt(gnss_data.satellites > 0 ? gnss_data.satellites : 0);
+
+    if (t.valid)
+    {
+        // 公历日期转Unix天数（Howard Hinnant days_from_civil）
+        int y = t.year - (t.month <= 2);
+        int era = (y >= 0 ? y : y - 399) / 400;
+        unsigned yoe = (unsigned)(y - era * 400);
+        unsigned doy = (153 * (t.month + (t.month > 2 ? -3 : 9)) + 2) / 5 + t.day - 1;
+        unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        int64_t days = (int64_t)era * 146097 + doe - 719468;
+        cbor.addUInt(LOCATION_KEY_TIME);
+        cbor.addInt(days * 86400 + t.hour * 3600 + t.minute * 60 + t.second);
+    }
+    return cbor.length();
+}
+
 // 获取最后定位时间
 unsigned long Air780EGGNSS::getLastLocationTime()
 {
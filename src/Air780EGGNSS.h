@@ -5,6 +5,7 @@
 #include <ArduinoJson.h>
 #include "Air780EGCore.h"
 #include "Air780EGDebug.h"
+#include "Air780EGCBOR.h"
 
 /*
 https://docs.openluat.com/air780eg/at/app/at_command/#gps
@@ -51,10 +52,25 @@ typedef struct
     gps_time_t gps_time; // GPS时间信息
 } gnss_data_t;
 
+// 二进制位置编码（getLocationCBOR）的整数键，坐标等浮点值按定点整数编码
+enum Air780EGLocationKey {
+    LOCATION_KEY_FLAGS = 0,       // bit0 GNSS有效, bit1 WiFi有效, bit2 LBS有效, bit3 GPS时间有效
+    LOCATION_KEY_LATITUDE = 1,    // 度 x1e7
+    LOCATION_KEY_LONGITUDE = 2,   // 度 x1e7
+    LOCATION_KEY_ALTITUDE = 3,    // 米 x10
+    LOCATION_KEY_SPEED = 4,       // km/h x10
+    LOCATION_KEY_COURSE = 5,      // 度 x10
+    LOCATION_KEY_HDOP = 6,        // x10
+    LOCATION_KEY_SATELLITES = 7,
+    LOCATION_KEY_TIME = 8         // GPS时间（UTC Unix秒），时间无效时省略
+};
+
 
 
 class Air780EGGNSS
 {
+    friend struct Air780EGHostTest; // 主机测试（test/）直接调用解析函数
+
 private:
     static const char *TAG;
 
@@ -132,6 +148,8 @@ public:
     void printGNSSInfo();
     String getRawGNSSData();
     String getLocationJSON();
+    // 位置信息编码为CBOR写入 buffer，不分配堆内存；返回字节数，缓冲区不足返回0（48字节足够）
+    size_t getLocationCBOR(uint8_t* buffer, size_t size);
 };
 
 #endif // AIR780EG_GNSS_H
@@ -4,12 +4,16 @@ Air780EGHTTP::Air780EGHTTP(Air780EGCore* core_instance) : core(core_instance) {
 }
 
 bool Air780EGHTTP::init() {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_HTTP);
+    AIR780EG_STALL_SCOPE("HTTP::init");
     String response = core->sendATCommand("AT+HTTPINIT", 5000);
     http_initialized = response.indexOf("OK") >= 0;
     return http_initialized;
 }
 
 bool Air780EGHTTP::setURL(const String& url) {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_HTTP);
+    AIR780EG_STALL_SCOPE("HTTP::setURL");
     if (!http_initialized) return false;
     
     String cmd = "AT+HTTPPARA=\"URL\",\"" + url + "\"";
@@ -26,6 +30,8 @@ bool Air780EGHTTP::setUserAgent(const String& userAgent) {
 }
 
 bool Air780EGHTTP::get() {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_HTTP);
+    AIR780EG_STALL_SCOPE("HTTP::get");
     if (!http_initialized) return false;
     
     String response = core->sendATCommand("AT+HTTPACTION=0", 30000);
@@ -33,6 +39,8 @@ bool Air780EGHTTP::get() {
 }
 
 int Air780EGHTTP::getContentLength() {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_HTTP);
+    AIR780EG_STALL_SCOPE("HTTP::getContentLength");
     if (!http_initialized) return -1;
     
     String response = core->sendATCommand("AT+HTTPHEAD", 10000);
@@ -49,6 +57,8 @@ int Air780EGHTTP::getContentLength() {
 }
 
 bool Air780EGHTTP::readData(uint8_t* buffer, size_t maxSize, size_t& actualSize) {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_HTTP);
+    AIR780EG_STALL_SCOPE("HTTP::readData");
     if (!http_initialized) return false;
     
     String cmd = "AT+HTTPREAD=0," + String(maxSize);
@@ -57,16 +67,20 @@ bool Air780EGHTTP::readData(uint8_t* buffer, size_t maxSize, size_t& actualSize)
     int dataStart = response.indexOf("+HTTPREAD: ");
     if (dataStart >= 0) {
         int lenEnd = response.indexOf("\r\n", dataStart);
+        if (lenEnd < 0) {
+            actualSize = 0;
+            return false;
+        }
         int dataLen = response.substring(dataStart + 11, lenEnd).toInt();
         
         if (dataLen > 0) {
-            int contentStart = lenEnd + 2;
-            actualSize = min((size_t)dataLen, maxSize);
+            size_t contentStart = lenEnd + 2;
+            // 长度字段可能大于实际收到的数据，只复制响应中存在的部分
+            size_t available = response.length() > contentStart ? response.length() - contentStart : 0;
+            actualSize = min(min((size_t)dataLen, maxSize), available);
             
             // 复制二进制数据
-            for (size_t i = 0; i < actualSize && (contentStart + i) < response.length(); i++) {
-                buffer[i] = response.charAt(contentStart + i);
-            }
+            memcpy(buffer, response.c_str() + contentStart, actualSize);
             return true;
         }
     }
@@ -84,6 +98,8 @@ void Air780EGHTTP::close() {
 
 bool Air780EGHTTP::downloadFile(const String& url, std::function<bool(uint8_t*, size_t)> writeCallback, 
                                std::function<void(int)> progressCallback) {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_HTTP);
+    AIR780EG_STALL_SCOPE("HTTP::downloadFile");
     if (!init()) return false;
     if (!setURL(url)) return false;
     if (!get()) return false;
@@ -5,6 +5,8 @@
 #include "Air780EGCore.h"
 
 class Air780EGHTTP {
+    friend struct Air780EGHostTest; // 主机测试（test/）直接调用解析函数
+
 private:
     Air780EGCore* core;
     bool http_initialized = false;
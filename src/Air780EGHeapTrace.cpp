@@ -0,0 +1,266 @@
+#include "Air780EGHeapTrace.h"
+#include "Air780EGDebug.h"
+#include <new>
+
+#ifdef ESP32
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+const char *Air780EGHeapTrace::TAG = "HeapTrace";
+
+bool Air780EGHeapTrace::enabled = false;
+Air780EGSubsystem Air780EGHeapTrace::current = AIR780EG_SUBSYS_NONE;
+Air780EGHeapStats Air780EGHeapTrace::stats[AIR780EG_SUBSYS_COUNT] = {};
+#ifdef ESP32
+void *Air780EGHeapTrace::owner_task = nullptr;
+#endif
+
+void Air780EGHeapTrace::enable(bool enable)
+{
+    enabled = enable;
+    if (enable && !isCompiledIn())
+    {
+        AIR780EG_LOGW(TAG, "Heap trace not compiled in, define AIR780EG_HEAP_TRACE");
+    }
+}
+
+bool Air780EGHeapTrace::isEnabled()
+{
+    return enabled;
+}
+
+bool Air780EGHeapTrace::isCompiledIn()
+{
+#ifdef AIR780EG_HEAP_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+Air780EGHeapStats Air780EGHeapTrace::getStats(Air780EGSubsystem subsystem)
+{
+    if (subsystem < 0 || subsystem >= AIR780EG_SUBSYS_COUNT)
+    {
+        Air780EGHeapStats empty = {};
+        return empty;
+    }
+    return stats[subsystem];
+}
+
+const char *Air780EGHeapTrace::getSubsystemName(Air780EGSubsystem subsystem)
+{
+    switch (subsystem)
+    {
+    case AIR780EG_SUBSYS_CORE:    return "Core";
+    case AIR780EG_SUBSYS_GNSS:    return "GNSS";
+    case AIR780EG_SUBSYS_NETWORK: return "Network";
+    case AIR780EG_SUBSYS_MQTT:    return "MQTT";
+    case AIR780EG_SUBSYS_HTTP:    return "HTTP";
+    default:                      return "None";
+    }
+}
+
+void Air780EGHeapTrace::reset()
+{
+    for (int i = 0; i < AIR780EG_SUBSYS_COUNT; i++)
+    {
+        stats[i] = Air780EGHeapStats();
+    }
+}
+
+void Air780EGHeapTrace::printStats()
+{
+    AIR780EG_LOGI(TAG, "=== Heap Trace (%s) ===", enabled ? "enabled" : "disabled");
+    for (int i = 0; i < AIR780EG_SUBSYS_COUNT; i++)
+    {
+        const Air780EGHeapStats &s = stats[i];
+        AIR780EG_LOGI(TAG, "%-8s allocs: %lu, frees: %lu, bytes: %lu, live: %ld, peak: %ld",
+                      getSubsystemName((Air780EGSubsystem)i),
+                      (unsigned long)s.alloc_count, (unsigned long)s.free_count,
+                      (unsigned long)s.alloc_bytes, (long)s.live_bytes, (long)s.peak_bytes);
+    }
+}
+
+Air780EGSubsystem Air780EGHeapTrace::enter(Air780EGSubsystem subsystem)
+{
+    Air780EGSubsystem previous = current;
+#ifdef ESP32
+    if (previous == AIR780EG_SUBSYS_NONE)
+    {
+        owner_task = xTaskGetCurrentTaskHandle();
+    }
+#endif
+    current = subsystem;
+    return previous;
+}
+
+void Air780EGHeapTrace::leave(Air780EGSubsystem previous)
+{
+    current = previous;
+}
+
+bool Air780EGHeapTrace::shouldRecord()
+{
+    if (!enabled || current == AIR780EG_SUBSYS_NONE)
+    {
+        return false;
+    }
+#ifdef ESP32
+    if (owner_task != xTaskGetCurrentTaskHandle())
+    {
+        return false;
+    }
+#endif
+    return true;
+}
+
+void Air780EGHeapTrace::recordAlloc(size_t bytes)
+{
+    if (!shouldRecord())
+    {
+        return;
+    }
+    Air780EGHeapStats &s = stats[current];
+    s.alloc_count++;
+    s.alloc_bytes += bytes;
+    s.live_bytes += bytes;
+    if (s.live_bytes > s.peak_bytes)
+    {
+        s.peak_bytes = s.live_bytes;
+    }
+}
+
+void Air780EGHeapTrace::recordFree(size_t bytes)
+{
+    if (!shouldRecord())
+    {
+        return;
+    }
+    Air780EGHeapStats &s = stats[current];
+    s.free_count++;
+    s.free_bytes += bytes;
+    s.live_bytes -= bytes;
+}
+
+// ==================== 分配钩子 ====================
+
+#ifdef AIR780EG_HEAP_TRACE
+
+#ifdef AIR780EG_HEAP_TRACE_WRAP_MALLOC
+extern "C" void *__real_malloc(size_t size);
+extern "C" void *__real_calloc(size_t n, size_t size);
+extern "C" void *__real_realloc(void *ptr, size_t size);
+extern "C" void __real_free(void *ptr);
+#define AIR780EG_RAW_MALLOC __real_malloc
+#define AIR780EG_RAW_FREE __real_free
+#else
+#define AIR780EG_RAW_MALLOC malloc
+#define AIR780EG_RAW_FREE free
+#endif
+
+// 获取块的实际大小，保证分配和释放按同一口径计数
+static size_t heapTraceBlockSize(void *ptr, size_t requested)
+{
+    if (!ptr)
+    {
+        return 0;
+    }
+#ifdef ESP32
+    size_t size = heap_caps_get_allocated_size(ptr);
+#elif defined(__GLIBC__)
+    size_t size = malloc_usable_size(ptr);
+#else
+    size_t size = 0;
+#endif
+    return size > 0 ? size : requested;
+}
+
+static void *heapTraceNew(size_t size)
+{
+    void *ptr = AIR780EG_RAW_MALLOC(size ? size : 1);
+    if (!ptr)
+    {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+        throw std::bad_alloc();
+#else
+        abort();
+#endif
+    }
+    Air780EGHeapTrace::recordAlloc(heapTraceBlockSize(ptr, size));
+    return ptr;
+}
+
+static void heapTraceDelete(void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+    Air780EGHeapTrace::recordFree(heapTraceBlockSize(ptr, 0));
+    AIR780EG_RAW_FREE(ptr);
+}
+
+void *operator new(size_t size) { return heapTraceNew(size); }
+void *operator new[](size_t size) { return heapTraceNew(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    void *ptr = AIR780EG_RAW_MALLOC(size ? size : 1);
+    Air780EGHeapTrace::recordAlloc(heapTraceBlockSize(ptr, size));
+    return ptr;
+}
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept { return operator new(size, tag); }
+void operator delete(void *ptr) noexcept { heapTraceDelete(ptr); }
+void operator delete[](void *ptr) noexcept { heapTraceDelete(ptr); }
+void operator delete(void *ptr, size_t) noexcept { heapTraceDelete(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { heapTraceDelete(ptr); }
+
+#ifdef AIR780EG_HEAP_TRACE_WRAP_MALLOC
+// 需配合链接参数 -Wl,--wrap=malloc,--wrap=free,--wrap=realloc,--wrap=calloc
+extern "C" void *__wrap_malloc(size_t size)
+{
+    void *ptr = __real_malloc(size);
+    Air780EGHeapTrace::recordAlloc(heapTraceBlockSize(ptr, size));
+    return ptr;
+}
+
+extern "C" void *__wrap_calloc(size_t n, size_t size)
+{
+    void *ptr = __real_calloc(n, size);
+    Air780EGHeapTrace::recordAlloc(heapTraceBlockSize(ptr, n * size));
+    return ptr;
+}
+
+extern "C" void *__wrap_realloc(void *ptr, size_t size)
+{
+    size_t old_size = heapTraceBlockSize(ptr, 0);
+    void *new_ptr = __real_realloc(ptr, size);
+    if (new_ptr || size == 0)
+    {
+        if (ptr)
+        {
+            Air780EGHeapTrace::recordFree(old_size);
+        }
+        if (new_ptr)
+        {
+            Air780EGHeapTrace::recordAlloc(heapTraceBlockSize(new_ptr, size));
+        }
+    }
+    return new_ptr;
+}
+
+extern "C" void __wrap_free(void *ptr)
+{
+    if (ptr)
+    {
+        Air780EGHeapTrace::recordFree(heapTraceBlockSize(ptr, 0));
+    }
+    __real_free(ptr);
+}
+#endif // AIR780EG_HEAP_TRACE_WRAP_MALLOC
+
+#endif // AIR780EG_HEAP_TRACE
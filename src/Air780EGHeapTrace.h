@@ -0,0 +1,95 @@
+#ifndef AIR780EG_HEAP_TRACE_H
+#define AIR780EG_HEAP_TRACE_H
+
+#include <Arduino.h>
+
+/*
+ * 堆内存分配追踪（可选）
+ *
+ * 默认不参与编译。定义 AIR780EG_HEAP_TRACE 后：
+ *   - 库内各子系统入口用 AIR780EG_HEAP_SCOPE() 标记归属
+ *   - 替换全局 operator new/delete，统计作用域内的分配
+ *   - 额外定义 AIR780EG_HEAP_TRACE_WRAP_MALLOC 并在链接参数中加入
+ *     -Wl,--wrap=malloc,--wrap=free,--wrap=realloc,--wrap=calloc
+ *     可以同时统计 String 内部使用的 malloc/realloc
+ *
+ * 统计按最内层作用域归属，例如 publish() 内部调用 Core 发送指令时，
+ * 发送期间的分配记到 Core，拼接指令的分配记到 MQTT。
+ *
+ * 释放同样记到释放时所在的作用域，不追踪每块内存由谁分配。因此 live_bytes 是
+ * "本作用域内分配 - 本作用域内释放"的净值：返回给调用者、在作用域外释放的内存（如 getLocationJSON()
+ * 返回的 String）一直计为占用；作用域内释放别处分配的内存（如给调用者传入的 String 重新赋值）
+ * 会使其变小甚至为负。live_bytes 适合观察是否持续增长，不等于该子系统实际持有的内存。
+ */
+
+// 堆内存归属的子系统
+enum Air780EGSubsystem {
+    AIR780EG_SUBSYS_NONE = -1,
+    AIR780EG_SUBSYS_CORE = 0,
+    AIR780EG_SUBSYS_GNSS,
+    AIR780EG_SUBSYS_NETWORK,
+    AIR780EG_SUBSYS_MQTT,
+    AIR780EG_SUBSYS_HTTP,
+    AIR780EG_SUBSYS_COUNT
+};
+
+// 单个子系统的分配统计
+struct Air780EGHeapStats {
+    uint32_t alloc_count;   // 分配次数（含realloc）
+    uint32_t free_count;    // 释放次数
+    uint32_t alloc_bytes;   // 累计分配字节
+    uint32_t free_bytes;    // 累计释放字节
+    int32_t live_bytes;     // 当前净占用（作用域内分配-作用域内释放，可能为负，见文件头说明）
+    int32_t peak_bytes;     // 净占用峰值
+};
+
+class Air780EGHeapTrace {
+private:
+    static const char* TAG;
+    static bool enabled;
+    static Air780EGSubsystem current;
+    static Air780EGHeapStats stats[AIR780EG_SUBSYS_COUNT];
+#ifdef ESP32
+    static void* owner_task; // 只统计打开作用域的任务，避免WiFi等任务的分配被误记
+#endif
+
+    static bool shouldRecord();
+
+public:
+    // 启用/禁用统计（编译时未定义 AIR780EG_HEAP_TRACE 时始终无数据）
+    static void enable(bool enable = true);
+    static bool isEnabled();
+    static bool isCompiledIn();
+
+    // 查询
+    static Air780EGHeapStats getStats(Air780EGSubsystem subsystem);
+    static const char* getSubsystemName(Air780EGSubsystem subsystem);
+    static void reset();
+    static void printStats();
+
+    // 作用域管理（由 Air780EGHeapScope 调用）
+    static Air780EGSubsystem enter(Air780EGSubsystem subsystem);
+    static void leave(Air780EGSubsystem previous);
+
+    // 分配钩子调用
+    static void recordAlloc(size_t bytes);
+    static void recordFree(size_t bytes);
+};
+
+// RAII作用域：构造时切换归属子系统，析构时恢复
+class Air780EGHeapScope {
+private:
+    Air780EGSubsystem previous;
+
+public:
+    explicit Air780EGHeapScope(Air780EGSubsystem subsystem) : previous(Air780EGHeapTrace::enter(subsystem)) {}
+    ~Air780EGHeapScope() { Air780EGHeapTrace::leave(previous); }
+};
+
+#ifdef AIR780EG_HEAP_TRACE
+#define AIR780EG_HEAP_SCOPE(subsystem) Air780EGHeapScope _air780eg_heap_scope(subsystem)
+#else
+#define AIR780EG_HEAP_SCOPE(subsystem) do {} while (0)
+#endif
+
+#endif // AIR780EG_HEAP_TRACE_H
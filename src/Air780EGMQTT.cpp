@@ -1,27 +1,37 @@
 #include "Air780EGMQTT.h"
+#include <limits.h>
 
 const char *Air780EGMQTT::TAG = "MQTT";
 
 Air780EGMQTT::Air780EGMQTT(Air780EGCore *core_instance, Air780EGGNSS *gnss_instance)
-    : core(core_instance), gnss(gnss_instance), state(MQTT_DISCONNECTED),
-      message_callback(nullptr), connection_callback(nullptr)
+    : gnss(gnss_instance), core(core_instance), state(MQTT_DISCONNECTED),
+      message_callback(nullptr), connection_callback(nullptr),
+      tls(core_instance, AIR780EG_SSL_CTX_MQTT)
 {
     // 设置默认配置
     config.server = "";
     config.port = 1883;
-    config.client_id = "Air780EG_" + String(random(10000, 99999));
+    config.client_id = "";  // 连接时按 IMEI 生成，重启后保持不变
     config.keepalive = 60;
     config.clean_session = true;
     config.use_ssl = false;
 
-    // 初始化定时任务数组
-    scheduled_task_count = 0;
-    for (int i = 0; i < MAX_SCHEDULED_TASKS; i++)
+    // 初始化异步发布槽位
+    for (int i = 0; i < MAX_PENDING_PUBLISHES; i++)
     {
-        scheduled_tasks[i].enabled = false;
-        scheduled_tasks[i].callback = nullptr;
-        scheduled_tasks[i].last_execution = 0;
+        pending_publishes[i].owner = this;
+        pending_publishes[i].id = 0;
+        pending_publishes[i].callback = nullptr;
+        pending_publishes[i].task_buffer = nullptr;
+        pending_publishes[i].release_buffer = false;
+        pending_publishes[i].qos = 0;
+        pending_publishes[i].waiting = false;
+        pending_publishes[i].awaiting_ack = false;
     }
+
+    // 初始化定时任务数组
+    setMaxScheduledTasks(DEFAULT_MAX_SCHEDULED_TASKS);
+    setInboundQueue(DEFAULT_INBOUND_SLOTS, DEFAULT_INBOUND_TOPIC_SIZE, DEFAULT_INBOUND_PAYLOAD_SIZE);
 }
 
 Air780EGMQTT::~Air780EGMQTT()
@@ -30,6 +40,22 @@ Air780EGMQTT::~Air780EGMQTT()
     {
         disconnect();
     }
+    for (int i = 0; i < scheduled_task_count; i++)
+    {
+        delete[] scheduled_tasks[i].buffer;
+    }
+    for (int i = 0; i < MAX_PENDING_PUBLISHES; i++)
+    {
+        if (pending_publishes[i].release_buffer)
+        {
+            delete[] pending_publishes[i].task_buffer;
+        }
+    }
+    delete[] scheduled_tasks;
+    delete[] task_heap;
+    delete[] inbound_slots;
+    delete[] inbound_data;
+    delete[] inbound_large;
 }
 
 bool Air780EGMQTT::begin(const Air780EGMQTTConfig &cfg)
@@ -53,23 +79,34 @@ bool Air780EGMQTT::begin(const Air780EGMQTTConfig &cfg)
 
 bool Air780EGMQTT::init()
 {
-    // 设置MQTT消息格式为文本模式（0=文本模式，1=HEX模式）
-    // 由于我们使用JSON文本格式，应该使用文本模式
-    String response = core->sendATCommandWithResponse("AT+MQTTMODE=1", "OK", 3000);
+    registerURCHandlers();
+    // 模块重新初始化后SSL上下文需要重新设置，证书文件仍按哈希复用
+    tls.invalidate();
+
+    // 设置MQTT消息格式（0=文本模式，1=HEX模式）
+    // HEX模式可以传任意字节但串口字节数翻倍；模块支持 AT+MPUBEX 时直接发送原始字节
+    payload_mode = detectPayloadMode();
+    String response = core->sendATCommandWithResponse(
+        payload_mode == MQTT_PAYLOAD_HEX ? "AT+MQTTMODE=1" : "AT+MQTTMODE=0", "OK", 3000);
     if (response.indexOf("OK") < 0)
     {
-        AIR780EG_LOGW(TAG, "Failed to set MQTT text mode");
+        AIR780EG_LOGW(TAG, "Failed to set MQTT message mode");
         return false;
     }
-    AIR780EG_LOGI(TAG, "MQTT module initialized");
+    AIR780EG_LOGI(TAG, "MQTT module initialized, payload mode: %s",
+                  payload_mode == MQTT_PAYLOAD_RAW ? "raw" : (payload_mode == MQTT_PAYLOAD_TEXT ? "text" : "hex"));
 
-    // 设置消息上报模式 AT+MQTTMSGSET=0 主动URC上报；1AT+MQTTMSGSET=缓存模式缓存模式。然后用 AT+MQTTMSGGET 来读消息
-    response = core->sendATCommandWithResponse("AT+MQTTMSGSET=0", "OK", 3000);
+    // 设置消息上报模式 AT+MQTTMSGSET=0 主动URC上报；1 缓存模式，模块只上报 +MSUB: <缓存位置>，再用 AT+MQTTMSGGET 读消息
+    response = core->sendATCommandWithResponse(
+        receive_mode == MQTT_RECEIVE_BUFFERED ? "AT+MQTTMSGSET=1" : "AT+MQTTMSGSET=0", "OK", 3000);
     if (response.indexOf("OK") < 0)
     {
         AIR780EG_LOGW(TAG, "Failed to set MQTT message report mode");
         return false;
     }
+    notify_head = 0;
+    notify_count = 0;
+    drain_requested = false;
     return true;
 }
 
@@ -78,6 +115,57 @@ Air780EGMQTTConfig Air780EGMQTT::getConfig() const
     return config;
 }
 
+MQTTPayloadMode Air780EGMQTT::detectPayloadMode()
+{
+    if (preferred_payload_mode != MQTT_PAYLOAD_AUTO)
+    {
+        return preferred_payload_mode;
+    }
+
+    // 文本模式的转义规则随固件版本不同，无法可靠探测，只在显式设置时使用
+    String response = core->sendATCommand("AT+MPUBEX=?", 2000);
+    if (response.indexOf("OK") >= 0)
+    {
+        return MQTT_PAYLOAD_RAW;
+    }
+    AIR780EG_LOGD(TAG, "AT+MPUBEX not supported, using hex payloads");
+    return MQTT_PAYLOAD_HEX;
+}
+
+void Air780EGMQTT::setPayloadMode(MQTTPayloadMode mode)
+{
+    preferred_payload_mode = mode;
+}
+
+MQTTPayloadMode Air780EGMQTT::getPayloadMode() const
+{
+    return payload_mode;
+}
+
+// 空负载（含定时任务返回的 "{}"）不发布
+static bool isEmptyPayload(const String &payload)
+{
+    return payload.length() == 0 || payload == "{}";
+}
+
+bool Air780EGMQTT::canPublishPayload(const char *p, size_t len) const
+{
+    if (payload_mode != MQTT_PAYLOAD_TEXT)
+    {
+        return true;
+    }
+    // 文本模式下命令以CR结束，负载中不能出现行结束符和NUL
+    for (size_t i = 0; i < len; i++)
+    {
+        if (p[i] == '\r' || p[i] == '\n' || p[i] == '\0')
+        {
+            AIR780EG_LOGE(TAG, "Payload contains CR/LF/NUL, cannot publish in text mode");
+            return false;
+        }
+    }
+    return true;
+}
+
 bool Air780EGMQTT::connect()
 {
     if (config.server.isEmpty())
@@ -98,101 +186,347 @@ bool Air780EGMQTT::connect(const String &server, int port, const String &client_
 bool Air780EGMQTT::connect(const String &server, int port, const String &client_id,
                            const String &username, const String &password)
 {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    AIR780EG_STALL_SCOPE("MQTT::connect");
     if (state == MQTT_CONNECTED)
     {
         return state == MQTT_CONNECTED;
     }
 
-    state = MQTT_CONNECTING;
+    // 显式传入的连接参数覆盖配置；客户端ID变化后服务器上的旧会话不再属于本设备
+    if (!server.isEmpty() && !connect_pending)
+    {
+        if (server != config.server)
+        {
+            broker_ip = "";
+        }
+        config.server = server;
+        config.port = port;
+        config.username = username;
+        config.password = password;
+    }
+    if (!client_id.isEmpty() && client_id != config.client_id && !connect_pending)
+    {
+        config.client_id = client_id;
+        session_established = false;
+    }
 
-    // 检查网络环境
-    if (!core->isNetworkReadyCheck())
+    if (!connect_pending && !startConnect())
+    {
+        return false;
+    }
+
+    // 同步接口：驱动命令队列直到连接流程结束（每一步都有超时，循环必然结束）
+    while (connect_pending)
+    {
+        core->processCommands();
+        delay(1);
+    }
+    return state == MQTT_CONNECTED;
+}
+
+// ==================== 连接流程 ====================
+// MCONFIG -> MIPSTART -> MCONNECT 由异步命令的回调依次推进，不在步骤之间等待；
+// 收到 CONNECT OK 的回调里把 MCONNECT 放在队首，当前命令结束后立即发送，不等待AT命令间隔
+
+bool Air780EGMQTT::startConnect()
+{
+    // 同一时间只有一条连接流程
+    if (connect_pending)
     {
-        AIR780EG_LOGE(TAG, "Network not ready");
-        state = MQTT_ERROR;
         return false;
     }
+    state = MQTT_CONNECTING;
+    connect_started = millis();
+    connect_stats.attempts++;
+
+    // 检查网络环境：有效期内检查通过过则跳过；自动重连时可能跳过或只检查一次
+    if (network_check_retries >= 0)
+    {
+        if (core->isNetworkReadyCached(registration_cache_ms))
+        {
+            connect_stats.network_checks_skipped++;
+        }
+        else if (!core->isNetworkReadyCheck(network_check_retries))
+        {
+            AIR780EG_LOGE(TAG, "Network not ready");
+            finishConnect(MQTT_STAGE_NETWORK, false);
+            return false;
+        }
+    }
 
-    // 断开现有连接,否则会连接失败
-    // if  (!disconnect())
-    // {
-    //     AIR780EG_LOGW(TAG, "Failed to disconnect from MQTT server");
-    //     state = MQTT_ERROR;
-    //     return false;
-    // }
+    if (!ensureClientId())
+    {
+        finishConnect(MQTT_STAGE_CONFIG, false);
+        return false;
+    }
 
-    // AIR780EG_LOGI(TAG, "Network ready, connecting to MQTT server");
+    // TLS：上传缺少的证书并配置SSL上下文，之后的连接不再重复
+    if (config.use_ssl && !tls.apply(isIPAddress(config.server) ? String() : config.server))
+    {
+        AIR780EG_LOGE(TAG, "TLS setup failed");
+        finishConnect(MQTT_STAGE_CONFIG, false);
+        return false;
+    }
 
     // 设置MQTT配置参数
     String config_cmd = "AT+MCONFIG=" + config.client_id + "," + config.username + "," + config.password;
-    String response = core->sendATCommandWithResponse(config_cmd, "OK", 3000);
-    if (response.indexOf("OK") < 0)
+    connect_stage = MQTT_STAGE_CONFIG;
+    connect_pending = true;
+    if (!core->sendATCommandAsync(config_cmd, onConnectStep, this, "OK", 3000))
     {
         AIR780EG_LOGE(TAG, "Failed to set MQTT config");
-        state = MQTT_ERROR;
+        finishConnect(MQTT_STAGE_CONFIG, false);
         return false;
     }
+    return true;
+}
 
-    AIR780EG_LOGI(TAG, "Connecting to MQTT server, client_id: %s, server: %s, port: %d", config.client_id.c_str(), config.server.c_str(), config.port);
-    // 设置TCP连接参数
-    // 建立mqtt会话；注意需要返回CONNECT OK后才能发此条指令，并且要立即发，否则就会被服务器踢掉 报错 767 操作失败
-    response = core->sendATCommandUntilExpected(
-        "AT+MIPSTART=\"" + config.server + "\",\"" + String(config.port) + "\"",
-        "CONNECT OK",
-        5000);
+void Air780EGMQTT::onConnectStep(ATCommandResult result, const String &response,
+                                 unsigned long latency_ms, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    if (!self->connect_pending)
+    {
+        return;
+    }
 
-    if (response.indexOf("ALREADY CONNECT") >= 0)
+    switch (self->connect_stage)
     {
-        AIR780EG_LOGI(TAG, "MQTT already connected");
-        state = MQTT_CONNECTED;
-        return true;
+    case MQTT_STAGE_CONFIG:
+        if (result != AT_RESULT_OK)
+        {
+            AIR780EG_LOGE(TAG, "Failed to set MQTT config");
+            self->finishConnect(MQTT_STAGE_CONFIG, false);
+            return;
+        }
+        self->sendIPStart();
+        return;
+
+    case MQTT_STAGE_TCP:
+        if (response.indexOf("ALREADY CONNECT") >= 0)
+        {
+            // 模块的连接一直没断，订阅仍然有效
+            AIR780EG_LOGI(TAG, "MQTT already connected");
+            self->finishConnect(MQTT_STAGE_NONE, true);
+            return;
+        }
+        if (response.indexOf("CONNECT OK") < 0)
+        {
+            AIR780EG_LOGE(TAG, "Failed to set MQTT IP start");
+            if (self->connect_used_ip)
+            {
+                // 缓存的地址可能已经失效，下次用域名
+                self->broker_ip = "";
+            }
+            self->core->invalidateNetworkReady();
+            self->finishConnect(MQTT_STAGE_TCP, false);
+            return;
+        }
+        self->connect_stats.last_tcp_ms = latency_ms;
+        if (self->config.use_ssl)
+        {
+            self->tls.recordHandshake(latency_ms);
+        }
+        self->sendConnect();
+        return;
+
+    case MQTT_STAGE_CONNACK:
+        if (response.indexOf("CONNACK OK") < 0)
+        {
+            AIR780EG_LOGE(TAG, "MQTT connect command failed");
+            self->finishConnect(MQTT_STAGE_CONNACK, false);
+            return;
+        }
+        self->connect_stats.last_connack_ms = latency_ms;
+        self->finishConnect(MQTT_STAGE_NONE, self->resolveSessionPresent(response));
+        return;
+
+    default:
+        return;
     }
+}
 
-    if (response.indexOf("CONNECT OK") < 0 && response.indexOf("ALREADY CONNECT") < 0)
+void Air780EGMQTT::sendIPStart()
+{
+    // 缓存的服务器地址在有效期内时直接用IP，省去模块每次连接的DNS查询
+    connect_used_ip = hasCachedBrokerIP();
+    const String &address = connect_used_ip ? broker_ip : config.server;
+    if (connect_used_ip)
     {
-        AIR780EG_LOGE(TAG, "Failed to set MQTT IP start");
-        state = MQTT_ERROR;
-        return false;
+        connect_stats.dns_cache_hits++;
     }
+    AIR780EG_LOGI(TAG, "Connecting to MQTT server, client_id: %s, server: %s (%s), port: %d",
+                  config.client_id.c_str(), config.server.c_str(), address.c_str(), config.port);
 
-    // 等待CONNECT OK后立即发送MQTT连接命令
-    // if (!core->waitExpectedResponse("CONNECT OK", 20000))
-    // {
-    //     AIR780EG_LOGE(TAG, "MQTT CONNECT OK timeout!");
-    //     state = MQTT_ERROR;
-    //     return false;
-    // }
-    delay(200);
+    // 建立mqtt会话；注意需要返回CONNECT OK后才能发此条指令，并且要立即发，否则就会被服务器踢掉 报错 767 操作失败
+    // SSL连接用 AT+SSLMIPSTART，结果上报和普通连接相同；握手在上报 CONNECT OK 之前完成
+    String cmd = config.use_ssl ? "AT+SSLMIPSTART=\"" : "AT+MIPSTART=\"";
+    cmd += address + "\",\"" + String(config.port) + "\"";
+    connect_stage = MQTT_STAGE_TCP;
+    if (!core->sendATCommandAsync(cmd, onConnectStep, this, "CONNECT OK", config.use_ssl ? 20000 : 5000))
+    {
+        finishConnect(MQTT_STAGE_TCP, false);
+    }
+}
 
-    // 发送连接命令
-    response = core->sendATCommandUntilExpected("AT+MCONNECT=1,60", "CONNACK OK", 5000);
-    if (response.indexOf("CONNACK OK") < 0)
+void Air780EGMQTT::sendConnect()
+{
+    String cmd = "AT+MCONNECT=";
+    cmd += config.clean_session ? "1," : "0,";
+    cmd += config.keepalive;
+    connect_stage = MQTT_STAGE_CONNACK;
+    if (!core->sendATCommandAsyncNext(cmd, onConnectStep, this, "CONNACK OK", 5000))
     {
-        AIR780EG_LOGE(TAG, "MQTT connect command failed");
-        state = MQTT_ERROR;
-        return false;
+        finishConnect(MQTT_STAGE_CONNACK, false);
     }
+}
 
-    // 等待连接成功
-    // if (!core->waitExpectedResponse("CONNECT", 20000))
-    // {
-    //     AIR780EG_LOGE(TAG, "MQTT CONNECT OK timeout");
-    //     state = MQTT_ERROR;
-    //     return false;
-    // }
+// 连接流程结束：failed_stage 为 MQTT_STAGE_NONE 表示成功
+void Air780EGMQTT::finishConnect(MQTTConnectStage failed_stage, bool resumed)
+{
+    unsigned long elapsed = millis() - connect_started;
+    bool reconnecting = connect_is_reconnect;
+    connect_pending = false;
+    connect_is_reconnect = false;
+    network_check_retries = 8;
+    connect_stage = failed_stage;
+
+    if (failed_stage != MQTT_STAGE_NONE)
+    {
+        state = MQTT_ERROR;
+        if (reconnecting)
+        {
+            onReconnectResult(false, elapsed);
+        }
+        return;
+    }
 
+    recordConnectTime(elapsed);
+    session_established = !config.clean_session;
     state = MQTT_CONNECTED;
+    onLinkUp(resumed);
+    if (reconnecting)
+    {
+        onReconnectResult(true, elapsed);
+    }
 
     if (connection_callback)
     {
         connection_callback(true);
     }
 
+    // 连接建立后再在后台刷新DNS缓存，不占用连接时间
+    refreshBrokerIP();
+}
+
+void Air780EGMQTT::recordConnectTime(unsigned long elapsed_ms)
+{
+    connect_stats.successes++;
+    connect_stats.last_ms = elapsed_ms;
+    if (connect_stats.max_ms < elapsed_ms)
+    {
+        connect_stats.max_ms = elapsed_ms;
+    }
+    connect_times[connect_time_next] = elapsed_ms;
+    connect_time_next = (connect_time_next + 1) % CONNECT_TIME_SAMPLES;
+    if (connect_time_count < CONNECT_TIME_SAMPLES)
+    {
+        connect_time_count++;
+    }
+    AIR780EG_LOGI(TAG, "MQTT connected in %lu ms (TCP %lu ms, CONNACK %lu ms)",
+                  elapsed_ms, connect_stats.last_tcp_ms, connect_stats.last_connack_ms);
+}
+
+// ==================== 服务器地址缓存 ====================
+
+bool Air780EGMQTT::isIPAddress(const String &host)
+{
+    if (host.isEmpty())
+    {
+        return false;
+    }
+    for (unsigned int i = 0; i < host.length(); i++)
+    {
+        char c = host[i];
+        if (c != '.' && (c < '0' || c > '9'))
+        {
+            return false;
+        }
+    }
     return true;
 }
 
+bool Air780EGMQTT::hasCachedBrokerIP() const
+{
+    return dns_ttl_ms > 0 && !broker_ip.isEmpty() && millis() - broker_ip_at < dns_ttl_ms;
+}
+
+// AT+CDNSGIP 异步解析服务器域名；已是IP、缓存仍有效或正在解析时不查询
+void Air780EGMQTT::refreshBrokerIP()
+{
+    if (dns_ttl_ms == 0 || dns_lookup_pending || isIPAddress(config.server) || hasCachedBrokerIP())
+    {
+        return;
+    }
+    String cmd = "AT+CDNSGIP=\"" + config.server + "\"";
+    if (core->sendATCommandAsync(cmd, onDNSResponse, this, "+CDNSGIP:", 10000))
+    {
+        dns_lookup_pending = true;
+        connect_stats.dns_lookups++;
+    }
+}
+
+void Air780EGMQTT::onDNSResponse(ATCommandResult result, const String &response,
+                                 unsigned long latency_ms, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    self->dns_lookup_pending = false;
+    String ip = result == AT_RESULT_OK ? parseDNSResponse(response) : String();
+    if (ip.isEmpty())
+    {
+        AIR780EG_LOGW(TAG, "DNS lookup failed: %s", response.c_str());
+        self->connect_stats.dns_failures++;
+        return;
+    }
+    self->broker_ip = ip;
+    self->broker_ip_at = millis();
+    AIR780EG_LOGI(TAG, "Broker %s resolved to %s in %lu ms", self->config.server.c_str(), ip.c_str(), latency_ms);
+}
+
+// +CDNSGIP: 1,"域名","IP1"[,"IP2"]，第一个数字为0表示解析失败
+String Air780EGMQTT::parseDNSResponse(const String &response)
+{
+    int pos = response.indexOf("+CDNSGIP:");
+    if (pos < 0)
+    {
+        return "";
+    }
+    pos += 9;
+    while (pos < (int)response.length() && response[pos] == ' ')
+    {
+        pos++;
+    }
+    if (pos >= (int)response.length() || response[pos] != '1')
+    {
+        return "";
+    }
+    // 跳过域名，取第二个引号字段
+    int q1 = response.indexOf('"', pos);
+    int q2 = q1 < 0 ? -1 : response.indexOf('"', q1 + 1);
+    int q3 = q2 < 0 ? -1 : response.indexOf('"', q2 + 1);
+    int q4 = q3 < 0 ? -1 : response.indexOf('"', q3 + 1);
+    if (q4 < 0)
+    {
+        return "";
+    }
+    String ip = response.substring(q3 + 1, q4);
+    return isIPAddress(ip) ? ip : String();
+}
+
 bool Air780EGMQTT::disconnect()
 {
+    AIR780EG_STALL_SCOPE("MQTT::disconnect");
     if (state != MQTT_CONNECTED)
     {
         return true;
@@ -205,6 +539,7 @@ bool Air780EGMQTT::disconnect()
     if (response.indexOf("OK") >= 0)
     {
         state = MQTT_DISCONNECTED;
+        link_lost_at = millis();
         AIR780EG_LOGI(TAG, "MQTT disconnected");
 
         if (connection_callback)
@@ -242,10 +577,26 @@ bool Air780EGMQTT::enableSSL(bool enable)
 
 bool Air780EGMQTT::setSSLConfig(const String &ca_cert, const String &client_cert, const String &client_key)
 {
-    AIR780EG_LOGI(TAG, "SSL configuration updated");
+    if (client_cert.isEmpty() != client_key.isEmpty())
+    {
+        AIR780EG_LOGE(TAG, "Client certificate and key must be set together");
+        return false;
+    }
+    tls.setCertificates(ca_cert, client_cert, client_key);
+    AIR780EG_LOGI(TAG, "SSL configuration updated, security level %d", tls.getSecurityLevel());
     return true;
 }
 
+Air780EGTLS &Air780EGMQTT::getTLS()
+{
+    return tls;
+}
+
+Air780EGTLSStats Air780EGMQTT::getTLSStats() const
+{
+    return tls.getStats();
+}
+
 /*
 AT+MPUB="mqtt/sub",0,0,"data from 4G module"        //发布主题
 
@@ -255,35 +606,53 @@ OK
 */
 bool Air780EGMQTT::publish(const String &topic, const String &payload, int qos, bool retain)
 {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    AIR780EG_STALL_SCOPE("MQTT::publish");
+    // 如果没有内容则不发送
+    if (isEmptyPayload(payload))
+    {
+        AIR780EG_LOGW(TAG, "Payload is empty, skipping publish");
+        return true;
+    }
     if (!isConnected())
     {
+        if (outbox && outbox->isOpen())
+        {
+            return storeOffline(topic, payload, qos, retain, 0);
+        }
         AIR780EG_LOGE(TAG, "Not connected to MQTT server");
         return false;
     }
-    // 如果没有内容则不发送
-    if (payload.isEmpty()||payload.length()==0||payload == "{}")
+
+    if (!canPublishPayload(payload.c_str(), payload.length()))
     {
-        AIR780EG_LOGW(TAG, "Payload is empty, skipping publish");
-        return true;
+        return false;
     }
+    String packed;
+    const String &body = packPayload(payload, packed);
+    AIR780EG_LOGD(TAG, "Publishing: %s (%u bytes)", topic.c_str(), body.length());
 
-    // HEX模式下，payload转为HEX字符串
-    String hex_payload = toHexString(payload);
-    String pub_cmd = "AT+MPUB=\"" + topic + "\"," + String(qos) + "," + String(retain ? 1 : 0) + ",\"" + hex_payload + "\"";
-    AIR780EG_LOGD(TAG, "Publishing HEX: %s", pub_cmd.c_str());
-
-    // 使用同步方式发送MQTT发布命令（恢复原有行为）
-    String response = core->sendATCommandUntilExpected(pub_cmd, "OK", 5000);
+    // 使用同步方式发送MQTT发布命令（恢复原有行为），负载由Core边编码边写入串口
+    String response = core->sendATCommandWithPayload(buildPublishPrefix(topic, qos, retain, body.length()),
+                                                     body, publishSuffix(), publishEncoding(), "OK", 5000);
     
     if (response.indexOf("OK") >= 0)
     {
         AIR780EG_LOGD(TAG, "Published message successfully");
+        if (receive_mode == MQTT_RECEIVE_BUFFERED && notify_count > 0)
+        {
+            // 模块缓存中有消息，趁发布之后顺带读取
+            startDrain(true);
+        }
         return true;
     }
     else if (response.indexOf("ERROR") >= 0)
     {
         AIR780EG_LOGE(TAG, "Failed to publish message, response: %s", response.c_str());
-        state = MQTT_ERROR;
+        if (state == MQTT_CONNECTED)
+        {
+            state = MQTT_ERROR;
+        }
         return false;
     }
     else
@@ -293,441 +662,2344 @@ bool Air780EGMQTT::publish(const String &topic, const String &payload, int qos,
     }
 }
 
+// 二进制负载（如 getLocationCBOR 的输出），文本负载模式下不能发送0字节
+bool Air780EGMQTT::publish(const String &topic, const uint8_t *payload, size_t length, int qos, bool retain)
+{
+    String data;
+    if (!data.concat((const char *)payload, length))
+    {
+        return false;
+    }
+    return publish(topic, data, qos, retain);
+}
+
 bool Air780EGMQTT::publishJSON(const String &topic, const String &json, int qos)
 {
     return publish(topic, json, qos, false);
 }
 
-/*
-AT+MSUB="mqtt/pub",0        //订阅主题
-
-OK
-
-SUBACK
-*/
-bool Air780EGMQTT::subscribe(const String &topic, int qos)
+// 发布命令前缀，负载和结尾由Core流式写入：
+//   HEX/文本模式: AT+MPUB="topic",qos,retain,"<负载>"
+//   原始模式:     AT+MPUBEX="topic",qos,retain,len  -> '>' -> <负载>
+String Air780EGMQTT::buildPublishPrefix(const String &topic, int qos, bool retain, size_t payload_len)
 {
-    if (!isConnected())
+    String prefix;
+    prefix.reserve(topic.length() + 24);
+    prefix += payload_mode == MQTT_PAYLOAD_RAW ? "AT+MPUBEX=\"" : "AT+MPUB=\"";
+    prefix += topic;
+    prefix += "\",";
+    prefix += qos;
+    if (payload_mode == MQTT_PAYLOAD_RAW)
     {
-        AIR780EG_LOGE(TAG, "Not connected to MQTT server");
-        return false;
+        prefix += retain ? ",1," : ",0,";
+        prefix += (unsigned long)payload_len;
     }
-
-    String sub_cmd = "AT+MSUB=\"" + topic + "\"," + String(qos);
-
-    String response = core->sendATCommandUntilExpected(sub_cmd, "SUBACK", 10000);
-    if (response.indexOf("SUBACK") >= 0)
+    else
     {
-        // 添加到订阅列表
-        if (subscription_count < MAX_SUBSCRIPTIONS)
-        {
-            subscriptions[subscription_count] = topic;
-            subscription_qos[subscription_count] = qos;
-            subscription_count++;
-        }
+        prefix += retain ? ",1,\"" : ",0,\"";
+    }
+    return prefix;
+}
 
-        AIR780EG_LOGI(TAG, "Subscribed to topic: %s", topic.c_str());
-        return true;
+ATPayloadEncoding Air780EGMQTT::publishEncoding() const
+{
+    switch (payload_mode)
+    {
+    case MQTT_PAYLOAD_RAW:
+        return AT_PAYLOAD_PROMPT;
+    case MQTT_PAYLOAD_TEXT:
+        return AT_PAYLOAD_ESCAPED;
+    default:
+        return AT_PAYLOAD_HEX;
     }
+}
 
-    AIR780EG_LOGE(TAG, "Failed to subscribe");
-    return false;
+const char *Air780EGMQTT::publishSuffix() const
+{
+    return payload_mode == MQTT_PAYLOAD_RAW ? "" : "\"";
 }
 
-bool Air780EGMQTT::unsubscribe(const String &topic)
+bool Air780EGMQTT::setCompression(bool enable, size_t min_size)
 {
-    if (!isConnected())
+    if (enable && !Air780EGCompress::begin())
     {
-        AIR780EG_LOGE(TAG, "Not connected to MQTT server");
         return false;
     }
+    compression_enabled = enable;
+    compression_min_size = min_size;
+    return true;
+}
 
-    String unsub_cmd = "AT+MUNSUB=\"" + topic + "\"";
+bool Air780EGMQTT::isCompressionEnabled() const
+{
+    return compression_enabled;
+}
 
-    String response = core->sendATCommandWithResponse(unsub_cmd, "OK", 10000);
-    if (response.indexOf("OK") >= 0)
+// 返回实际发送的负载：压缩有效时为 packed，否则为原文
+const String &Air780EGMQTT::packPayload(const String &payload, String &packed)
+{
+    if (!compression_enabled || payload_mode == MQTT_PAYLOAD_TEXT || payload.length() < compression_min_size ||
+        Air780EGCompress::isCompressed((const uint8_t *)payload.c_str(), payload.length()))
     {
-        // 从订阅列表中移除
-        for (int i = 0; i < subscription_count; i++)
-        {
-            if (subscriptions[i] == topic)
-            {
-                for (int j = i; j < subscription_count - 1; j++)
-                {
-                    subscriptions[j] = subscriptions[j + 1];
-                    subscription_qos[j] = subscription_qos[j + 1];
-                }
-                subscription_count--;
-                break;
-            }
-        }
+        return payload;
+    }
+    return Air780EGCompress::compress(payload, packed) ? packed : payload;
+}
 
-        AIR780EG_LOGI(TAG, "Unsubscribed from topic");
-        return true;
+uint16_t Air780EGMQTT::publishAsync(const String &topic, const String &payload, int qos, bool retain,
+                                    MQTTPublishCallback callback)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    if (isEmptyPayload(payload))
+    {
+        AIR780EG_LOGW(TAG, "Payload is empty, skipping publish");
+        return 0;
+    }
+    if (!isConnected())
+    {
+        if (outbox && outbox->isOpen())
+        {
+            storeOffline(topic, payload, qos, retain, 0);
+            return 0;
+        }
+        AIR780EG_LOGE(TAG, "Not connected to MQTT server");
+        return 0;
+    }
+    if (!canPublishPayload(payload.c_str(), payload.length()))
+    {
+        return 0;
     }
 
-    AIR780EG_LOGE(TAG, "Failed to unsubscribe");
-    return false;
+    MQTTPendingPublish *slot = findFreePublishSlot();
+    if (!slot)
+    {
+        AIR780EG_LOGW(TAG, "Publish queue full (%d pending), dropping: %s", pending_publish_count, topic.c_str());
+        return 0;
+    }
+    uint16_t id = allocatePublishId();
+
+    String packed;
+    const String &body = packPayload(payload, packed);
+    if (qos > 0)
+    {
+        // 保留副本用于重传，发送时按引用交给Core
+        slot->id = id;
+        slot->callback = callback;
+        slot->task_buffer = nullptr;
+        slot->prefix = buildPublishPrefix(topic, qos, retain, body.length());
+        slot->body = body;
+        pending_publish_count++;
+        queueQoS1Publish(slot, qos, slot->prefix.c_str(), (const uint8_t *)slot->body.c_str(), slot->body.length());
+        AIR780EG_LOGD(TAG, "Queued QoS%d publish #%u: %s (%u bytes)", qos, id, topic.c_str(), body.length());
+        return id;
+    }
+    if (!core->sendATCommandWithPayloadAsync(buildPublishPrefix(topic, qos, retain, body.length()), body,
+                                             publishSuffix(), publishEncoding(), onPublishComplete, slot, "OK", 5000))
+    {
+        AIR780EG_LOGW(TAG, "Failed to queue publish: %s", topic.c_str());
+        return 0;
+    }
+
+    slot->id = id;
+    slot->callback = callback;
+    slot->task_buffer = nullptr;
+    slot->qos = 0;
+    pending_publish_count++;
+    AIR780EG_LOGD(TAG, "Queued publish #%u: %s (%u bytes)", id, topic.c_str(), body.length());
+    return id;
 }
 
-bool Air780EGMQTT::isSubscribed(const String &topic) const
+MQTTPendingPublish *Air780EGMQTT::findFreePublishSlot()
 {
-    for (int i = 0; i < subscription_count; i++)
+    for (int i = 0; i < MAX_PENDING_PUBLISHES; i++)
     {
-        if (subscriptions[i] == topic)
+        if (pending_publishes[i].id == 0)
         {
-            return true;
+            return &pending_publishes[i];
         }
     }
-    return false;
+    return nullptr;
 }
 
-void Air780EGMQTT::setMessageCallback(MQTTMessageCallback callback)
+uint16_t Air780EGMQTT::allocatePublishId()
 {
-    message_callback = callback;
+    uint16_t id = next_publish_id++;
+    if (next_publish_id == 0)
+    {
+        next_publish_id = 1;
+    }
+    return id;
 }
 
-void Air780EGMQTT::setConnectionCallback(MQTTConnectionCallback callback)
+// 零分配定时任务的发布：命令前缀格式化到任务自带的缓冲区，负载按引用入队，
+// 槽位记住缓冲区，发送完成前同一任务不会再次写入
+uint16_t Air780EGMQTT::publishTaskBuffer(ScheduledTask &task, size_t len)
 {
-    connection_callback = callback;
+    if (!canPublishPayload((const char *)task.buffer, len))
+    {
+        return 0;
+    }
+    MQTTPendingPublish *slot = findFreePublishSlot();
+    if (!slot)
+    {
+        AIR780EG_LOGW(TAG, "Publish queue full (%d pending), dropping: %s", pending_publish_count, task.topic.c_str());
+        return 0;
+    }
+
+    // 与 buildPublishPrefix 的格式一致
+    char *command = (char *)(task.buffer + task.buffer_size);
+    if (payload_mode == MQTT_PAYLOAD_RAW)
+    {
+        snprintf(command, task.command_size, "AT+MPUBEX=\"%s\",%d,%d,%u",
+                 task.topic.c_str(), task.qos, task.retain ? 1 : 0, (unsigned)len);
+    }
+    else
+    {
+        snprintf(command, task.command_size, "AT+MPUB=\"%s\",%d,%d,\"",
+                 task.topic.c_str(), task.qos, task.retain ? 1 : 0);
+    }
+
+    uint16_t id = allocatePublishId();
+    if (task.qos > 0)
+    {
+        // 任务缓冲区在确认前不会被改写，重传直接引用
+        slot->id = id;
+        slot->callback = nullptr;
+        slot->task_buffer = task.buffer;
+        slot->release_buffer = false;
+        pending_publish_count++;
+        queueQoS1Publish(slot, task.qos, command, task.buffer, len);
+        AIR780EG_LOGD(TAG, "Queued QoS%d publish #%u: %s (%u bytes, in place)", task.qos, id, task.topic.c_str(), (unsigned)len);
+        return id;
+    }
+    if (!core->sendATCommandWithPayloadAsync(command, task.buffer, len, publishSuffix(), publishEncoding(),
+                                             onPublishComplete, slot, "OK", 5000))
+    {
+        AIR780EG_LOGW(TAG, "Failed to queue publish: %s", task.topic.c_str());
+        return 0;
+    }
+
+    slot->id = id;
+    slot->callback = nullptr;
+    slot->task_buffer = task.buffer;
+    slot->release_buffer = false;
+    slot->qos = 0;
+    pending_publish_count++;
+    AIR780EG_LOGD(TAG, "Queued publish #%u: %s (%u bytes, in place)", id, task.topic.c_str(), (unsigned)len);
+    return id;
 }
 
-void Air780EGMQTT::loop()
+void Air780EGMQTT::onPublishComplete(ATCommandResult result, const String &response,
+                                     unsigned long latency_ms, void *context)
 {
-    // 注意：不再直接读取串口响应，因为现在由队列机制统一处理
-    // 真正的URC会由队列机制识别并通过回调分发到这里
-    
-    // 处理定时任务
-    processScheduledTasks();
+    MQTTPendingPublish *slot = (MQTTPendingPublish *)context;
+    Air780EGMQTT *self = slot->owner;
+    uint16_t id = slot->id;
 
-    // 查询 MQTT 连接状态：AT+MQTTSTATU 5秒一次
-    static unsigned long last_check_time = 0;
-    if (millis() - last_check_time >= 5000)
+    MQTTPublishResult publish_result = MQTT_PUBLISH_OK;
+    if (result == AT_RESULT_TIMEOUT)
+    {
+        publish_result = MQTT_PUBLISH_TIMEOUT;
+        AIR780EG_LOGW(TAG, "Publish #%u timeout after %lu ms", id, latency_ms);
+    }
+    else if (result == AT_RESULT_ERROR)
     {
-        last_check_time = millis();
-        // 减少超时时间从10000ms到2000ms
-        String response = core->sendATCommandUntilExpected("AT+MQTTSTATU", "OK", 2000);
-        // String response = core->sendATCommand("AT+MQTTSTATU", 2000);
-        if (response.indexOf("OK") >= 0)
+        publish_result = MQTT_PUBLISH_ERROR;
+        AIR780EG_LOGE(TAG, "Publish #%u failed, response: %s", id, response.c_str());
+        // 只有已连接时才标记异常；连接流程中到达的旧发布结果不能打断连接
+        if (self->state == MQTT_CONNECTED)
         {
-            // (0:offline,1:can pub,2: need MCONNECT!)
-            AIR780EG_LOGD(TAG, "MQTT status: %s ", response.c_str());
-            if (response.indexOf("1") >= 0)
-            {
-                state = MQTT_CONNECTED;
-            }
-            else
+            self->state = MQTT_ERROR;
+        }
+    }
+    else
+    {
+        AIR780EG_LOGD(TAG, "Publish #%u done in %lu ms", id, latency_ms);
+    }
+
+    if (publish_result == MQTT_PUBLISH_OK)
+    {
+        self->link_activity = true;
+        if (self->receive_mode == MQTT_RECEIVE_BUFFERED && self->notify_count > 0)
+        {
+            self->startDrain(true);
+        }
+    }
+    if (slot->qos == 0)
+    {
+        self->finishPublish(slot, publish_result, latency_ms);
+        return;
+    }
+
+    if (publish_result != MQTT_PUBLISH_OK)
+    {
+        self->retryPublish(slot, publish_result);
+    }
+    else if (self->ack_by_urc)
+    {
+        slot->awaiting_ack = true;
+    }
+    else
+    {
+        self->ackPublish(slot);
+    }
+    self->sendWaitingPublishes();
+}
+
+// 释放槽位并报告结果
+void Air780EGMQTT::finishPublish(MQTTPendingPublish *slot, MQTTPublishResult result, unsigned long latency_ms)
+{
+    uint16_t id = slot->id;
+    MQTTPublishCallback callback = slot->callback;
+
+    // 先释放槽位，回调中可以继续发布
+    slot->id = 0;
+    slot->callback = nullptr;
+    if (slot->release_buffer)
+    {
+        delete[] slot->task_buffer;
+    }
+    slot->task_buffer = nullptr;
+    slot->release_buffer = false;
+    slot->qos = 0;
+    slot->waiting = false;
+    slot->awaiting_ack = false;
+    pending_publish_count--;
+
+    // 补发的离线消息：成功后从队列删除，失败保留等待重试
+    if (outbox && id == outbox_publish_id)
+    {
+        outbox_publish_id = 0;
+        outbox->onDrainResult(outbox_ticket, result == MQTT_PUBLISH_OK);
+    }
+
+    if (callback)
+    {
+        callback(id, result, latency_ms);
+    }
+}
+
+// ==================== QoS1 在途窗口 ====================
+
+void Air780EGMQTT::queueQoS1Publish(MQTTPendingPublish *slot, int qos, const char *prefix,
+                                    const uint8_t *payload, size_t len)
+{
+    slot->qos = qos;
+    slot->attempts = 0;
+    slot->waiting = true;
+    slot->awaiting_ack = false;
+    slot->sequence = next_publish_sequence++;
+    slot->queued_at = millis();
+    slot->send_prefix = prefix;
+    slot->send_payload = payload;
+    slot->send_len = len;
+    qos1_stats.published++;
+    sendWaitingPublishes();
+}
+
+// 窗口有空位时按发布顺序发送等待中的消息（重传的消息保留原顺序，优先发送）
+void Air780EGMQTT::sendWaitingPublishes()
+{
+    while (qos1_inflight < qos1_window && isConnected())
+    {
+        MQTTPendingPublish *next = nullptr;
+        for (int i = 0; i < MAX_PENDING_PUBLISHES; i++)
+        {
+            MQTTPendingPublish &slot = pending_publishes[i];
+            if (slot.id != 0 && slot.waiting &&
+                (!next || (int32_t)(slot.sequence - next->sequence) < 0))
             {
-                state = MQTT_DISCONNECTED;
+                next = &slot;
             }
         }
+        if (!next)
+        {
+            return;
+        }
+        if (!core->sendATCommandWithPayloadAsync(next->send_prefix, next->send_payload, next->send_len,
+                                                 publishSuffix(), publishEncoding(),
+                                                 onPublishComplete, next, "OK", 5000))
+        {
+            // Core队列已满，下次 loop() 再发
+            return;
+        }
+        next->waiting = false;
+        next->sent_at = millis();
+        if (next->attempts++ > 0)
+        {
+            qos1_stats.retransmits++;
+            AIR780EG_LOGW(TAG, "Retransmitting publish #%u (attempt %u)", next->id, next->attempts);
+        }
+        qos1_inflight++;
+        qos1_stats.inflight = qos1_inflight;
+        if (qos1_inflight > qos1_stats.max_inflight)
+        {
+            qos1_stats.max_inflight = qos1_inflight;
+        }
     }
+}
 
-    // 处理重连逻辑
-    if (state == MQTT_DISCONNECTED || state == MQTT_ERROR)
+// 等待确认URC超时的消息重新排队发送
+void Air780EGMQTT::checkPublishAckTimeouts()
+{
+    if (qos1_inflight == 0)
+    {
+        return;
+    }
+    unsigned long now = millis();
+    for (int i = 0; i < MAX_PENDING_PUBLISHES; i++)
     {
-        if (millis() - last_reconnect_attempt > reconnect_interval)
+        MQTTPendingPublish &slot = pending_publishes[i];
+        if (slot.id != 0 && slot.awaiting_ack && now - slot.sent_at >= qos1_ack_timeout)
         {
-            last_reconnect_attempt = millis();
-            AIR780EG_LOGI(TAG, "Attempting reconnection");
-            connect();
+            AIR780EG_LOGW(TAG, "Publish #%u not acknowledged after %lu ms", slot.id, now - slot.sent_at);
+            retryPublish(&slot, MQTT_PUBLISH_TIMEOUT);
         }
     }
 }
 
-bool Air780EGMQTT::waitForURC(const String &urc_prefix, String &response, unsigned long timeout)
+void Air780EGMQTT::ackPublish(MQTTPendingPublish *slot)
 {
-    if (!core)
+    unsigned long ack_ms = millis() - slot->queued_at;
+    qos1_inflight--;
+    qos1_stats.inflight = qos1_inflight;
+    qos1_stats.acked++;
+    qos1_stats.last_ack_ms = ack_ms;
+    qos1_ack_total_ms += ack_ms;
+    qos1_stats.avg_ack_ms = qos1_ack_total_ms / qos1_stats.acked;
+    if (ack_ms > qos1_stats.max_ack_ms)
     {
-        return false;
+        qos1_stats.max_ack_ms = ack_ms;
     }
-    // 简化实现 - 暂时返回false，后续通过URC管理器处理
-    response = "";
-    return false;
+    finishPublish(slot, MQTT_PUBLISH_OK, ack_ms);
 }
 
-void Air780EGMQTT::handleMQTTURC(const String &urc)
+// 未确认：还有发送次数时放回等待队列，否则报告失败
+void Air780EGMQTT::retryPublish(MQTTPendingPublish *slot, MQTTPublishResult result)
 {
-    AIR780EG_LOGD(TAG, "Handling URC: %s", urc.c_str());
+    qos1_inflight--;
+    qos1_stats.inflight = qos1_inflight;
+    slot->awaiting_ack = false;
+    if (slot->attempts < qos1_max_attempts)
+    {
+        slot->waiting = true;
+        return;
+    }
+    qos1_stats.failed++;
+    AIR780EG_LOGE(TAG, "Publish #%u failed after %u attempts", slot->id, slot->attempts);
+    finishPublish(slot, result, millis() - slot->queued_at);
+}
 
-    if (urc.startsWith("+MCONNECT:"))
+// 确认URC不带报文ID，确认最早发送的在途消息。超时后迟到的确认无法与重传区分，会确认到其他消息（见头文件）
+void Air780EGMQTT::onPublishAckURC(const String &urc, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    if (!self->ack_by_urc)
     {
-        // 连接状态变化
-        if (urc.indexOf("1,0") >= 0)
+        return;
+    }
+    MQTTPendingPublish *oldest = nullptr;
+    for (int i = 0; i < MAX_PENDING_PUBLISHES; i++)
+    {
+        MQTTPendingPublish &slot = self->pending_publishes[i];
+        if (slot.id != 0 && slot.awaiting_ack &&
+            (!oldest || (int32_t)(slot.sequence - oldest->sequence) < 0))
         {
-            state = MQTT_CONNECTED;
-            if (connection_callback)
-                connection_callback(true);
+            oldest = &slot;
         }
-        else
+    }
+    if (!oldest)
+    {
+        AIR780EG_LOGD(TAG, "Unmatched publish ack: %s", urc.c_str());
+        return;
+    }
+    self->ackPublish(oldest);
+    self->sendWaitingPublishes();
+}
+
+bool Air780EGMQTT::setQoS1Window(int size)
+{
+    if (size < 1 || size > MAX_PENDING_PUBLISHES)
+    {
+        AIR780EG_LOGE(TAG, "Invalid QoS1 window: %d (1-%d)", size, MAX_PENDING_PUBLISHES);
+        return false;
+    }
+    qos1_window = size;
+    return true;
+}
+
+int Air780EGMQTT::getQoS1Window() const
+{
+    return qos1_window;
+}
+
+void Air780EGMQTT::setQoS1Retry(unsigned long ack_timeout_ms, int max_attempts)
+{
+    qos1_ack_timeout = ack_timeout_ms;
+    qos1_max_attempts = max_attempts < 1 ? 1 : (max_attempts > 255 ? 255 : max_attempts);
+}
+
+bool Air780EGMQTT::setPublishAckURC(const String &prefix)
+{
+    if (prefix.length() == 0)
+    {
+        ack_by_urc = false;
+        return true;
+    }
+    if (prefix.length() >= sizeof(ack_urc_prefix) || prefix[0] != '+')
+    {
+        // Core 只分发以 '+' 开头的上报
+        AIR780EG_LOGE(TAG, "Invalid publish ack URC: %s", prefix.c_str());
+        return false;
+    }
+    strcpy(ack_urc_prefix, prefix.c_str());
+    if (!ack_urc_registered)
+    {
+        ack_urc_registered = core && core->addURCHandler(ack_urc_prefix, onPublishAckURC, this);
+        if (!ack_urc_registered)
         {
-            state = MQTT_DISCONNECTED;
-            if (connection_callback)
-                connection_callback(false);
+            return false;
         }
     }
-    else if (urc.startsWith("+MSUB:"))
+    ack_by_urc = true;
+    return true;
+}
+
+MQTTQoS1Stats Air780EGMQTT::getQoS1Stats() const
+{
+    return qos1_stats;
+}
+
+void Air780EGMQTT::resetQoS1Stats()
+{
+    qos1_stats = MQTTQoS1Stats();
+    qos1_stats.inflight = qos1_inflight;
+    qos1_ack_total_ms = 0;
+}
+
+int Air780EGMQTT::getPendingPublishCount() const
+{
+    return pending_publish_count;
+}
+
+void Air780EGMQTT::setOutbox(Air780EGOutbox *queue)
+{
+    outbox = queue;
+    outbox_publish_id = 0;
+}
+
+Air780EGOutbox *Air780EGMQTT::getOutbox() const
+{
+    return outbox;
+}
+
+// 写入离线队列；失败（队列已满、单条过大或写入Flash失败）时记录并计数，不能当作已保存。
+// 空负载本来就不发送，不写入也不算失败
+bool Air780EGMQTT::storeOffline(const String &topic, const String &payload, int qos, bool retain,
+                                uint8_t priority)
+{
+    if (isEmptyPayload(payload))
+    {
+        return true;
+    }
+    if (outbox->push(topic, payload, qos, retain, priority))
+    {
+        return true;
+    }
+    outbox_store_failures++;
+    AIR780EG_LOGW(TAG, "Offline message not stored: %s (%u bytes, %lu failures)", topic.c_str(),
+                  payload.length(), (unsigned long)outbox_store_failures);
+    return false;
+}
+
+uint32_t Air780EGMQTT::getOutboxStoreFailures() const
+{
+    return outbox_store_failures;
+}
+
+void Air780EGMQTT::drainOutbox()
+{
+    if (!outbox || !outbox->isOpen() || !isConnected() || !outbox->isDrainDue())
+    {
+        return;
+    }
+
+    String topic, payload;
+    int qos;
+    bool retain;
+    uint32_t ticket;
+    if (!outbox->peek(topic, payload, qos, retain, ticket))
+    {
+        return;
+    }
+    if (isEmptyPayload(payload) || !canPublishPayload(payload.c_str(), payload.length()))
+    {
+        // publishAsync 会跳过的空负载（旧版本写入的），或当前负载模式无法发送（例如文本模式下含换行），
+        // 丢弃避免阻塞同优先级及更低优先级的消息
+        outbox->remove(ticket);
+        return;
+    }
+
+    uint16_t id = publishAsync(topic, payload, qos, retain);
+    if (id == 0)
+    {
+        // 发送队列已满，计为一次失败，按补发间隔稍后重试
+        outbox->onDrainResult(ticket, false);
+        return;
+    }
+    outbox_publish_id = id;
+    outbox_ticket = ticket;
+    outbox->markInflight(ticket);
+}
+
+/*
+AT+MSUB="mqtt/pub",0        //订阅主题
+
+OK
+
+SUBACK
+*/
+bool Air780EGMQTT::subscribe(const String &topic, int qos)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    AIR780EG_STALL_SCOPE("MQTT::subscribe");
+    if (!isConnected())
+    {
+        AIR780EG_LOGE(TAG, "Not connected to MQTT server");
+        return false;
+    }
+
+    String sub_cmd = "AT+MSUB=\"" + topic + "\"," + String(qos);
+
+    String response = core->sendATCommandUntilExpected(sub_cmd, "SUBACK", 10000);
+    if (response.indexOf("SUBACK") >= 0)
+    {
+        topic_trie.setSubscribed(topic.c_str(), qos);
+        AIR780EG_LOGI(TAG, "Subscribed to topic: %s", topic.c_str());
+        return true;
+    }
+
+    AIR780EG_LOGE(TAG, "Failed to subscribe");
+    return false;
+}
+
+bool Air780EGMQTT::unsubscribe(const String &topic)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    AIR780EG_STALL_SCOPE("MQTT::unsubscribe");
+    if (!isConnected())
+    {
+        AIR780EG_LOGE(TAG, "Not connected to MQTT server");
+        return false;
+    }
+
+    String unsub_cmd = "AT+MUNSUB=\"" + topic + "\"";
+
+    String response = core->sendATCommandWithResponse(unsub_cmd, "OK", 10000);
+    if (response.indexOf("OK") >= 0)
+    {
+        topic_trie.setSubscribed(topic.c_str(), -1);
+        topic_trie.removeHandler(topic.c_str());
+        AIR780EG_LOGI(TAG, "Unsubscribed from topic");
+        return true;
+    }
+
+    AIR780EG_LOGE(TAG, "Failed to unsubscribe");
+    return false;
+}
+
+bool Air780EGMQTT::subscribe(const String &filter, int qos, MQTTTopicHandler handler, void *context)
+{
+    // 先注册，SUBACK 之后立即到达的消息也能交给处理器
+    bool replaced = topic_trie.hasHandler(filter.c_str());
+    if (!topic_trie.setHandler(filter.c_str(), handler, context))
+    {
+        return false;
+    }
+    if (subscribe(filter, qos))
+    {
+        return true;
+    }
+    if (!replaced)
+    {
+        topic_trie.removeHandler(filter.c_str());
+    }
+    return false;
+}
+
+bool Air780EGMQTT::addTopicHandler(const String &filter, MQTTTopicHandler handler, void *context)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    return topic_trie.setHandler(filter.c_str(), handler, context);
+}
+
+bool Air780EGMQTT::removeTopicHandler(const String &filter)
+{
+    return topic_trie.removeHandler(filter.c_str());
+}
+
+bool Air780EGMQTT::isSubscribed(const String &topic) const
+{
+    return topic_trie.getSubscribedQos(topic.c_str()) >= 0;
+}
+
+int Air780EGMQTT::getSubscriptionCount() const
+{
+    return topic_trie.getSubscriptionCount();
+}
+
+struct SubscriptionLookup
+{
+    int index;
+    String filter;
+};
+
+static void findSubscriptionAt(const char *filter, int /* qos */, void *context)
+{
+    SubscriptionLookup *lookup = (SubscriptionLookup *)context;
+    if (lookup->index-- == 0)
+    {
+        lookup->filter = filter;
+    }
+}
+
+String Air780EGMQTT::getSubscription(int index) const
+{
+    SubscriptionLookup lookup = {index, ""};
+    if (index >= 0)
+    {
+        topic_trie.forEachSubscription(findSubscriptionAt, &lookup);
+    }
+    return lookup.filter;
+}
+
+void Air780EGMQTT::setMessageCallback(MQTTMessageCallback callback)
+{
+    message_callback = callback;
+}
+
+void Air780EGMQTT::setConnectionCallback(MQTTConnectionCallback callback)
+{
+    connection_callback = callback;
+}
+
+void Air780EGMQTT::loop()
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    AIR780EG_STALL_SCOPE("MQTT::loop");
+    // 注意：不再直接读取串口响应，因为现在由队列机制统一处理
+    // 真正的URC会由队列机制识别并通过回调分发到这里
+    
+    // 交付排队的下行消息
+    processMessageCache();
+
+    // 模块缓存模式：到期时读取模块中缓存的消息
+    processReceiveBuffer();
+
+    // QoS1 确认超时重传，窗口有空位时发送等待中的消息
+    checkPublishAckTimeouts();
+    sendWaitingPublishes();
+
+    // 处理定时任务
+    processScheduledTasks();
+
+    // 补发离线消息
+    drainOutbox();
+
+    // 低频校验连接状态（断开通常已由模块上报）
+    checkConnectionStatus();
+
+    // 处理重连逻辑
+    processReconnect();
+}
+
+bool Air780EGMQTT::waitForURC(const String & /* urc_prefix */, String &response, unsigned long /* timeout */)
+{
+    if (!core)
+    {
+        return false;
+    }
+    // 简化实现 - 暂时返回false，后续通过URC管理器处理
+    response = "";
+    return false;
+}
+
+void Air780EGMQTT::handleMQTTURC(const String &urc)
+{
+    AIR780EG_LOGD(TAG, "Handling URC: %s", urc.c_str());
+
+    if (urc.startsWith("+MCONNECT:"))
+    {
+        // 连接状态变化
+        if (urc.indexOf("1,0") >= 0)
+        {
+            state = MQTT_CONNECTED;
+            if (connection_callback)
+                connection_callback(true);
+        }
+        else
+        {
+            state = MQTT_DISCONNECTED;
+            if (connection_callback)
+                connection_callback(false);
+        }
+    }
+    else if (urc.startsWith("+MSUB:"))
+    {
+        if (receive_mode == MQTT_RECEIVE_BUFFERED && urc.indexOf(',') < 0)
+        {
+            // 缓存模式的新消息通知：+MSUB: <缓存位置>
+            onMessageNotify();
+            return;
+        }
+        // 收到订阅消息：只放入队列，由 loop() 交付，不在串口解析过程中调用用户回调
+        if (parseMQTTMessage(urc) && drain_pending)
+        {
+            onMessageDrained();
+        }
+    }
+    // 移除错误的GNSS处理 - GNSS响应应该由队列机制处理，不是URC
+    // +CGNSINF: 是AT+CGNSINF命令的响应，不是主动上报的URC
+    else if (urc.indexOf("boot.rom") >= 0) // 确保设备供电正常
+    {
+        Serial.printf("确保设备供电正常，boot.rom: %s\n", urc.c_str());
+        // 重新设置mqtt
+        init();
+        if (gnss->isEnabled())
+        {
+            gnss->enableGNSS();
+        }
+    }
+}
+
+// 交付下行消息：只处理进入时已排队的消息，回调中新到的消息留到下一次 loop()
+// 先按主题树分发给匹配的处理器，没有匹配时交给全局回调
+void Air780EGMQTT::processMessageCache()
+{
+    if (!message_callback && topic_trie.getHandlerCount() == 0)
+    {
+        // 没有回调时由应用调用 getNextMessage() 取走
+        return;
+    }
+    for (int n = inbound_count; n > 0 && inbound_count > 0; n--)
+    {
+        // 主题处理器直接读取队首槽位，交付期间该槽位不会被新消息覆盖
+        MQTTInboundSlot &slot = inbound_slots[inbound_head];
+        inbound_delivering = true;
+        int handled = topic_trie.dispatch(slot.topic, slot.topic_len, slot.payload, slot.payload_len);
+        if (!inbound_delivering)
+        {
+            // 处理器中已取走消息或清空了队列
+            continue;
+        }
+        inbound_delivering = false;
+        if (handled == 0 && message_callback)
+        {
+            // 全局回调的参数是 String，复制到复用的交付字符串
+            popInboundMessage(delivery_topic, delivery_payload);
+            message_callback(delivery_topic, delivery_payload);
+            continue;
+        }
+        if (handled == 0)
+        {
+            inbound_stats.unhandled++;
+        }
+        dropInboundHead();
+    }
+}
+
+// 取一个写入槽位；队列满时按溢出策略处理，返回nullptr表示丢弃新消息
+MQTTInboundSlot *Air780EGMQTT::reserveInboundSlot()
+{
+    if (inbound_capacity == 0)
+    {
+        return nullptr;
+    }
+    if (inbound_count == inbound_capacity)
+    {
+        // 队首正在交付时不能覆盖，只能丢弃新消息
+        if (inbound_policy != MQTT_INBOUND_DROP_OLDEST || inbound_delivering)
+        {
+            inbound_stats.dropped_newest++;
+            AIR780EG_LOGW(TAG, "Inbound queue full (%d), dropping new message", inbound_capacity);
+            return nullptr;
+        }
+        releaseLargePayload(inbound_slots[inbound_head]);
+        inbound_head = (inbound_head + 1) % inbound_capacity;
+        inbound_count--;
+        inbound_stats.dropped_oldest++;
+        AIR780EG_LOGW(TAG, "Inbound queue full (%d), dropping oldest message", inbound_capacity);
+    }
+    MQTTInboundSlot *slot = &inbound_slots[(inbound_head + inbound_count) % inbound_capacity];
+    inbound_count++;
+    inbound_stats.depth = inbound_count;
+    if (inbound_count > inbound_stats.max_depth)
+    {
+        inbound_stats.max_depth = inbound_count;
+    }
+    updateInboundPause();
+    return slot;
+}
+
+// 取出队首消息；String 容量保留，稳态下不重新分配
+void Air780EGMQTT::popInboundMessage(String &topic, String &payload)
+{
+    MQTTInboundSlot &slot = inbound_slots[inbound_head];
+    topic = "";
+    topic.concat(slot.topic, slot.topic_len);
+    payload = "";
+    payload.concat((const char *)slot.payload, slot.payload_len);
+    dropInboundHead();
+}
+
+void Air780EGMQTT::dropInboundHead()
+{
+    releaseLargePayload(inbound_slots[inbound_head]);
+    inbound_delivering = false;
+    inbound_head = (inbound_head + 1) % inbound_capacity;
+    inbound_count--;
+    inbound_stats.depth = inbound_count;
+    inbound_stats.delivered++;
+    updateInboundPause();
+}
+
+void Air780EGMQTT::releaseLargePayload(MQTTInboundSlot &slot)
+{
+    if (inbound_large_busy && slot.payload == inbound_large)
+    {
+        slot.payload = (uint8_t *)slot.topic + inbound_topic_size;
+        inbound_large_busy = false;
+    }
+}
+
+// 暂停策略：队列满（或大消息缓冲区被占用）时停止空闲读取，消息留在串口缓冲区（模块侧），
+// 命令响应中夹带的消息由Core暂存；有空位后恢复，不丢弃消息
+void Air780EGMQTT::updateInboundPause()
+{
+    if (!core || inbound_policy != MQTT_INBOUND_PAUSE)
+    {
+        return;
+    }
+    bool full = inbound_count >= inbound_capacity || inbound_large_busy;
+    if (full && !core->isURCInputPaused())
+    {
+        inbound_stats.pauses++;
+    }
+    core->setURCInputPaused(full);
+}
+
+bool Air780EGMQTT::hasMessages() const
+{
+    return inbound_count > 0;
+}
+
+Air780EGMQTTMessage Air780EGMQTT::getNextMessage()
+{
+    Air780EGMQTTMessage msg;
+    msg.qos = 0;
+    msg.retain = false;
+    msg.timestamp = 0;
+    if (inbound_count == 0)
+    {
+        return msg;
+    }
+    msg.timestamp = inbound_slots[inbound_head].timestamp;
+    popInboundMessage(msg.topic, msg.payload);
+    return msg;
+}
+
+void Air780EGMQTT::clearMessageCache()
+{
+    for (int i = 0; i < inbound_capacity; i++)
+    {
+        releaseLargePayload(inbound_slots[i]);
+    }
+    inbound_head = 0;
+    inbound_count = 0;
+    inbound_delivering = false;
+    inbound_stats.depth = 0;
+    updateInboundPause();
+}
+
+bool Air780EGMQTT::setInboundQueue(int slots, size_t topic_size, size_t payload_size)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    if (slots < 1 || topic_size < 2 || payload_size < 1)
+    {
+        AIR780EG_LOGE(TAG, "Invalid inbound queue size: %d x (%u + %u)", slots, (unsigned)topic_size,
+                      (unsigned)payload_size);
+        return false;
+    }
+
+    // 重新分配会丢弃排队中的消息
+    inbound_large_busy = false;
+    delete[] inbound_slots;
+    delete[] inbound_data;
+    inbound_slots = new MQTTInboundSlot[slots];
+    inbound_data = new uint8_t[slots * (topic_size + payload_size)];
+    for (int i = 0; i < slots; i++)
+    {
+        uint8_t *base = inbound_data + i * (topic_size + payload_size);
+        inbound_slots[i].topic = (char *)base;
+        inbound_slots[i].payload = base + topic_size;
+        inbound_slots[i].topic_len = 0;
+        inbound_slots[i].payload_len = 0;
+        inbound_slots[i].timestamp = 0;
+    }
+    inbound_capacity = slots;
+    inbound_topic_size = topic_size;
+    inbound_payload_size = payload_size;
+    clearMessageCache();
+    // 交付用的字符串一次预留到最大长度
+    delivery_topic.reserve(topic_size);
+    delivery_payload.reserve(payload_size);
+    return true;
+}
+
+void Air780EGMQTT::setInboundOverflowPolicy(MQTTInboundOverflowPolicy policy)
+{
+    inbound_policy = policy;
+    if (core && policy != MQTT_INBOUND_PAUSE)
+    {
+        core->setURCInputPaused(false);
+    }
+    updateInboundPause();
+}
+
+MQTTInboundStats Air780EGMQTT::getInboundStats() const
+{
+    return inbound_stats;
+}
+
+void Air780EGMQTT::resetInboundStats()
+{
+    inbound_stats = MQTTInboundStats();
+    inbound_stats.depth = inbound_count;
+}
+
+// ==================== 模块缓存模式 ====================
+
+void Air780EGMQTT::setReceiveMode(MQTTReceiveMode mode, unsigned long max_delay_ms)
+{
+    receive_mode = mode;
+    drain_delay = max_delay_ms;
+}
+
+MQTTReceiveMode Air780EGMQTT::getReceiveMode() const
+{
+    return receive_mode;
+}
+
+// 记录通知时间用于统计停留时间；未读通知超过模块缓存数时最早的消息已被覆盖
+void Air780EGMQTT::onMessageNotify()
+{
+    drain_stats.notifications++;
+    if (notify_count == MODULE_MESSAGE_SLOTS)
+    {
+        notify_head = (notify_head + 1) % MODULE_MESSAGE_SLOTS;
+        notify_count--;
+        drain_stats.overwritten++;
+        AIR780EG_LOGW(TAG, "Module message cache full, oldest message may be overwritten");
+    }
+    notify_times[(notify_head + notify_count) % MODULE_MESSAGE_SLOTS] = millis();
+    notify_count++;
+}
+
+// 读出一条消息：按到达顺序对应最早的未读通知
+void Air780EGMQTT::onMessageDrained()
+{
+    drain_batch++;
+    drain_stats.messages++;
+    if (notify_count == 0)
+    {
+        // 通知前已缓存的消息（例如重新连接时），没有停留时间
+        return;
+    }
+    unsigned long residency = millis() - notify_times[notify_head];
+    notify_head = (notify_head + 1) % MODULE_MESSAGE_SLOTS;
+    notify_count--;
+    drain_residency_total_ms += residency;
+    drain_residency_samples++;
+    drain_stats.last_residency_ms = residency;
+    drain_stats.avg_residency_ms = drain_residency_total_ms / drain_residency_samples;
+    if (residency > drain_stats.max_residency_ms)
+    {
+        drain_stats.max_residency_ms = residency;
+    }
+}
+
+// 读取时机：模块缓存已满、最早的通知等待超过 drain_delay、或连接后需要取回已缓存的消息；
+// 发布完成时另由 onPublishComplete 顺带读取
+void Air780EGMQTT::processReceiveBuffer()
+{
+    if (receive_mode != MQTT_RECEIVE_BUFFERED || drain_pending || (notify_count == 0 && !drain_requested))
+    {
+        return;
+    }
+    if (inbound_policy == MQTT_INBOUND_PAUSE && inbound_count >= inbound_capacity)
+    {
+        // 下行队列已满，消息留在模块中
+        return;
+    }
+    if (drain_requested || notify_count >= MODULE_MESSAGE_SLOTS ||
+        millis() - notify_times[notify_head] >= drain_delay)
+    {
+        startDrain(false);
+    }
+}
+
+bool Air780EGMQTT::startDrain(bool after_publish)
+{
+    if (!core || drain_pending)
+    {
+        return false;
+    }
+    // 发布完成后紧接着读取，不排在其他命令之后
+    bool queued = after_publish
+                      ? core->sendATCommandAsyncNext("AT+MQTTMSGGET", onDrainResponse, this, "OK", 5000)
+                      : core->sendATCommandAsync("AT+MQTTMSGGET", onDrainResponse, this, "OK", 5000);
+    if (!queued)
+    {
+        return false;
+    }
+    drain_pending = true;
+    drain_requested = false;
+    drain_started_at = millis();
+    drain_batch = 0;
+    drain_stats.drains++;
+    if (after_publish)
+    {
+        drain_stats.after_publish++;
+    }
+    return true;
+}
+
+// 读出的 +MSUB 行由Core按长度读取后分发，在本回调之前已进入下行队列
+void Air780EGMQTT::onDrainResponse(ATCommandResult result, const String &response,
+                                   unsigned long latency_ms, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    self->drain_pending = false;
+    if (result != AT_RESULT_OK)
+    {
+        AIR780EG_LOGW(TAG, "AT+MQTTMSGGET failed: %s", response.c_str());
+        self->drain_requested = true;
+        return;
+    }
+    MQTTDrainStats &stats = self->drain_stats;
+    stats.last_batch = self->drain_batch;
+    if (self->drain_batch > stats.max_batch)
+    {
+        stats.max_batch = self->drain_batch;
+    }
+    if (self->drain_batch == 0)
+    {
+        stats.empty_drains++;
+    }
+    // 读取前到达的通知对应的消息已全部读出（或已被覆盖），之后到达的留到下一次读取
+    while (self->notify_count > 0 && (long)(self->notify_times[self->notify_head] - self->drain_started_at) <= 0)
+    {
+        self->notify_head = (self->notify_head + 1) % MODULE_MESSAGE_SLOTS;
+        self->notify_count--;
+    }
+    AIR780EG_LOGD(TAG, "Drained %u messages in %lu ms", self->drain_batch, latency_ms);
+}
+
+bool Air780EGMQTT::drainMessages()
+{
+    if (receive_mode != MQTT_RECEIVE_BUFFERED)
+    {
+        return false;
+    }
+    if (drain_pending)
+    {
+        return true;
+    }
+    return startDrain(false);
+}
+
+MQTTDrainStats Air780EGMQTT::getDrainStats() const
+{
+    return drain_stats;
+}
+
+void Air780EGMQTT::resetDrainStats()
+{
+    drain_stats = MQTTDrainStats();
+    drain_residency_total_ms = 0;
+    drain_residency_samples = 0;
+}
+
+// ==================== 连接状态 ====================
+
+void Air780EGMQTT::onLinkUp(bool resumed)
+{
+    last_status_check = millis();
+    status_check_interval = status_check_base;
+    link_activity = false;
+    link_up_at = millis();
+    session_present = resumed;
+    // 缓存模式下取回断开期间（或通知丢失时）模块中已缓存的消息
+    drain_requested = receive_mode == MQTT_RECEIVE_BUFFERED;
+    if (resumed)
+    {
+        // 服务器保留了订阅，离线期间的QoS1消息会直接下发
+        AIR780EG_LOGI(TAG, "Session present, %d subscriptions kept by broker", topic_trie.getSubscriptionCount());
+        reconnect_stats.sessions_resumed++;
+        resubscribe_total = 0;
+        resubscribe_queued = 0;
+        resubscribe_done = 0;
+        reconnect_stats.last_subscribed_ms = 0;
+        return;
+    }
+    resubscribeAll();
+}
+
+void Air780EGMQTT::onLinkLost(const char *reason)
+{
+    if (state != MQTT_CONNECTED)
+    {
+        return;
+    }
+    AIR780EG_LOGW(TAG, "MQTT connection lost (%s)", reason);
+    state = MQTT_DISCONNECTED;
+    link_lost_at = millis();
+    // 断开后立即重连一次
+    reconnect_stats.consecutive_failures = 0;
+    reconnect_stats.last_failure = MQTT_STAGE_NONE;
+    next_reconnect_at = millis();
+    if (connection_callback)
+    {
+        connection_callback(false);
+    }
+}
+
+// 模块在TCP连接断开时上报 CLOSED
+void Air780EGMQTT::onLinkClosedURC(const String & /* urc */, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    if (self->state == MQTT_CONNECTED)
+    {
+        self->link_stats.urc_disconnects++;
+    }
+    self->onLinkLost("closed by modem");
+}
+
+// 校验到期时，上次校验后有收发流量说明连接正常，跳过查询并放宽间隔
+void Air780EGMQTT::checkConnectionStatus()
+{
+    if (!isConnected() || status_poll_pending || millis() - last_status_check < status_check_interval)
+    {
+        return;
+    }
+    last_status_check = millis();
+    if (link_activity)
+    {
+        link_activity = false;
+        link_stats.polls_avoided++;
+        status_check_interval = status_check_interval * 2 < status_check_max ? status_check_interval * 2 : status_check_max;
+        return;
+    }
+    status_check_interval = status_check_base;
+    if (core->sendATCommandAsync("AT+MQTTSTATU", onStatusResponse, this, "OK", 2000))
+    {
+        status_poll_pending = true;
+        link_stats.status_polls++;
+    }
+}
+
+// +MQTTSTATU :<state>，0:离线 1:已连接 2:需要MCONNECT；解析失败返回-1
+int Air780EGMQTT::parseStatusResponse(const String &response)
+{
+    int pos = response.indexOf("+MQTTSTATU");
+    if (pos < 0)
+    {
+        return -1;
+    }
+    pos = response.indexOf(':', pos);
+    if (pos < 0)
+    {
+        return -1;
+    }
+    const char *p = response.c_str() + pos + 1;
+    while (*p == ' ')
+    {
+        p++;
+    }
+    return (*p >= '0' && *p <= '9') ? *p - '0' : -1;
+}
+
+void Air780EGMQTT::onStatusResponse(ATCommandResult result, const String &response,
+                                    unsigned long /* latency_ms */, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    self->status_poll_pending = false;
+    if (result != AT_RESULT_OK)
+    {
+        // 查询失败不能说明连接已断开，等下次校验
+        return;
+    }
+    int status = parseStatusResponse(response);
+    AIR780EG_LOGD(TAG, "MQTT status: %d", status);
+    if (status >= 0 && status != 1 && self->state == MQTT_CONNECTED)
+    {
+        self->link_stats.poll_disconnects++;
+        self->onLinkLost("status poll");
+    }
+}
+
+void Air780EGMQTT::setStatusCheckInterval(unsigned long interval_ms, unsigned long max_interval_ms)
+{
+    status_check_base = interval_ms;
+    status_check_max = max_interval_ms < interval_ms ? interval_ms : max_interval_ms;
+    status_check_interval = interval_ms;
+}
+
+MQTTLinkStats Air780EGMQTT::getLinkStats() const
+{
+    MQTTLinkStats stats = link_stats;
+    stats.check_interval_ms = status_check_interval;
+    return stats;
+}
+
+// ==================== 自动重连 ====================
+
+unsigned long Air780EGMQTT::reconnectDelay(MQTTConnectStage stage) const
+{
+    unsigned long delay_ms = reconnect_interval;
+    if (stage == MQTT_STAGE_CONNACK)
+    {
+        // 服务器拒绝连接（认证、客户端ID冲突），快速重试没有意义
+        delay_ms *= 4;
+    }
+    for (int i = 1; i < reconnect_stats.consecutive_failures && delay_ms < reconnect_max_interval; i++)
+    {
+        delay_ms *= 2;
+    }
+    if (delay_ms > reconnect_max_interval)
+    {
+        delay_ms = reconnect_max_interval;
+    }
+    // 在 [一半, 全部] 之间随机，避免同一基站下的设备同时重连
+    return delay_ms / 2 + random(delay_ms / 2 + 1);
+}
+
+void Air780EGMQTT::processReconnect()
+{
+    if ((state != MQTT_DISCONNECTED && state != MQTT_ERROR) || connect_pending || config.server.isEmpty())
+    {
+        return;
+    }
+    if ((long)(millis() - next_reconnect_at) < 0)
+    {
+        return;
+    }
+    if (max_reconnect_attempts > 0 && reconnect_stats.consecutive_failures >= max_reconnect_attempts)
+    {
+        return;
+    }
+
+    // 上次在网络或TCP阶段失败时才检查网络，且只查一次附着状态，不在这里阻塞重试
+    MQTTConnectStage last = reconnect_stats.last_failure;
+    network_check_retries = (last == MQTT_STAGE_NETWORK || last == MQTT_STAGE_TCP) ? 1 : -1;
+    AIR780EG_LOGI(TAG, "Attempting reconnection (%u consecutive failures)", reconnect_stats.consecutive_failures);
+    reconnect_stats.attempts++;
+    // 连接流程异步推进，结果在 onReconnectResult 中处理
+    connect_is_reconnect = true;
+    startConnect();
+}
+
+void Air780EGMQTT::onReconnectResult(bool ok, unsigned long elapsed_ms)
+{
+    if (ok)
+    {
+        reconnect_stats.successes++;
+        reconnect_stats.consecutive_failures = 0;
+        reconnect_stats.last_failure = MQTT_STAGE_NONE;
+        reconnect_stats.last_connect_ms = elapsed_ms;
+        return;
+    }
+
+    reconnect_stats.consecutive_failures++;
+    reconnect_stats.last_failure = connect_stage;
+    reconnect_stats.failures[connect_stage]++;
+    reconnect_stats.next_delay_ms = reconnectDelay(connect_stage);
+    next_reconnect_at = millis() + reconnect_stats.next_delay_ms;
+    AIR780EG_LOGW(TAG, "Reconnect failed at stage %d, retry in %lu ms",
+                  connect_stage, reconnect_stats.next_delay_ms);
+}
+
+// 恢复订阅：全部放入异步队列连续发送，不等待每条的 SUBACK；SUBACK 由上报处理器计数
+void Air780EGMQTT::resubscribeAll()
+{
+    resubscribe_total = topic_trie.getSubscriptionCount();
+    resubscribe_queued = 0;
+    resubscribe_done = 0;
+    reconnect_stats.resubscribed = 0;
+    reconnect_stats.resubscribe_failed = 0;
+    reconnect_stats.last_subscribed_ms = 0;
+    if (resubscribe_total == 0)
+    {
+        return;
+    }
+    AIR780EG_LOGI(TAG, "Restoring %d subscriptions", resubscribe_total);
+    queueResubscriptions();
+}
+
+// Core 队列放不下时，剩余的订阅在已发送的订阅完成后继续入队
+void Air780EGMQTT::queueResubscriptions()
+{
+    if (resubscribe_queued < resubscribe_total)
+    {
+        resubscribe_cursor = 0;
+        topic_trie.forEachSubscription(queueResubscription, this);
+    }
+}
+
+void Air780EGMQTT::queueResubscription(const char *filter, int qos, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    if (self->resubscribe_cursor++ != self->resubscribe_queued || self->resubscribe_queued >= self->resubscribe_total)
+    {
+        return;
+    }
+    String cmd = "AT+MSUB=\"";
+    cmd += filter;
+    cmd += "\",";
+    cmd += qos;
+    if (self->core->sendATCommandAsync(cmd, onResubscribeResponse, self, "OK", 10000))
+    {
+        self->resubscribe_queued++;
+    }
+}
+
+void Air780EGMQTT::onResubscribeResponse(ATCommandResult result, const String &response,
+                                         unsigned long /* latency_ms */, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    if (result != AT_RESULT_OK)
+    {
+        AIR780EG_LOGW(TAG, "Resubscribe failed: %s", response.c_str());
+        self->onResubscribeDone(false);
+    }
+    self->queueResubscriptions();
+}
+
+void Air780EGMQTT::onSubackURC(const String & /* urc */, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    if (self->resubscribe_done < self->resubscribe_queued)
+    {
+        self->onResubscribeDone(true);
+    }
+}
+
+void Air780EGMQTT::onResubscribeDone(bool ok)
+{
+    resubscribe_done++;
+    if (ok)
+    {
+        reconnect_stats.resubscribed++;
+    }
+    else
+    {
+        reconnect_stats.resubscribe_failed++;
+    }
+    if (resubscribe_done == resubscribe_total)
+    {
+        reconnect_stats.last_subscribed_ms = millis() - link_up_at;
+        AIR780EG_LOGI(TAG, "Subscriptions restored: %u ok, %u failed, %lu ms after CONNACK",
+                      reconnect_stats.resubscribed, reconnect_stats.resubscribe_failed,
+                      reconnect_stats.last_subscribed_ms);
+    }
+}
+
+void Air780EGMQTT::setReconnectInterval(unsigned long interval_ms)
+{
+    reconnect_interval = interval_ms;
+}
+
+void Air780EGMQTT::setReconnectBackoff(unsigned long interval_ms, unsigned long max_interval_ms)
+{
+    reconnect_interval = interval_ms;
+    reconnect_max_interval = max_interval_ms < interval_ms ? interval_ms : max_interval_ms;
+}
+
+void Air780EGMQTT::setMaxReconnectAttempts(int attempts)
+{
+    max_reconnect_attempts = attempts;
+}
+
+// ==================== 持久会话 ====================
+
+// 客户端ID为空时用 IMEI 生成，保证重启后连接到同一个服务器会话
+bool Air780EGMQTT::ensureClientId()
+{
+    if (!config.client_id.isEmpty())
+    {
+        return true;
+    }
+    String response = core->sendATCommandWithResponse("AT+CGSN", "OK", 2000);
+    String imei;
+    for (unsigned int i = 0; i < response.length(); i++)
+    {
+        char c = response[i];
+        if (c >= '0' && c <= '9')
+        {
+            imei += c;
+        }
+        else if (imei.length() >= 14)
+        {
+            break;
+        }
+        else
+        {
+            imei = "";
+        }
+    }
+    if (imei.length() < 14)
+    {
+        // 读不到 IMEI 时退回随机ID，持久会话在重启后无法找回
+        config.client_id = "Air780EG_" + String(random(10000, 99999));
+        AIR780EG_LOGW(TAG, "IMEI unavailable, using random client id %s", config.client_id.c_str());
+        return true;
+    }
+    config.client_id = "Air780EG_" + imei;
+    AIR780EG_LOGI(TAG, "Client id: %s", config.client_id.c_str());
+    return true;
+}
+
+// 会话标志：固件在 CONNACK 前后上报 "+MCONNECT: <返回码>,<会话存在>" 时读取第二个数字；
+// 没有上报返回 -1
+int Air780EGMQTT::parseSessionPresent(const String &response)
+{
+    int pos = response.indexOf("+MCONNECT:");
+    if (pos < 0)
+    {
+        return -1;
+    }
+    int comma = response.indexOf(',', pos);
+    int eol = response.indexOf('\n', pos);
+    if (comma < 0 || (eol >= 0 && comma > eol))
+    {
+        return -1;
+    }
+    unsigned int i = comma + 1;
+    while (i < response.length() && response[i] == ' ')
+    {
+        i++;
+    }
+    if (i >= response.length() || (response[i] != '0' && response[i] != '1'))
+    {
+        return -1;
+    }
+    return response[i] - '0';
+}
+
+bool Air780EGMQTT::resolveSessionPresent(const String &connack_response) const
+{
+    if (config.clean_session)
+    {
+        return false;
+    }
+    int flag = parseSessionPresent(connack_response);
+    if (flag >= 0)
+    {
+        return flag == 1;
+    }
+    // 固件不报告会话标志：本次上电建立过持久会话且断开时间在保留期内才认为会话仍在
+    return session_established && session_expiry_ms > 0 && millis() - link_lost_at < session_expiry_ms;
+}
+
+void Air780EGMQTT::setKeepAlive(int seconds)
+{
+    config.keepalive = seconds;
+}
+
+void Air780EGMQTT::setCleanSession(bool clean)
+{
+    config.clean_session = clean;
+    if (clean)
+    {
+        session_established = false;
+    }
+}
+
+void Air780EGMQTT::setSessionExpiry(unsigned long expiry_ms)
+{
+    session_expiry_ms = expiry_ms;
+}
+
+bool Air780EGMQTT::isSessionPresent() const
+{
+    return session_present;
+}
+
+String Air780EGMQTT::getClientId() const
+{
+    return config.client_id;
+}
+
+void Air780EGMQTT::setDNSCacheTTL(unsigned long ttl_ms)
+{
+    dns_ttl_ms = ttl_ms;
+    if (ttl_ms == 0)
+    {
+        broker_ip = "";
+    }
+}
+
+void Air780EGMQTT::setRegistrationCacheTTL(unsigned long ttl_ms)
+{
+    registration_cache_ms = ttl_ms;
+}
+
+String Air780EGMQTT::getBrokerIP() const
+{
+    return hasCachedBrokerIP() ? broker_ip : String();
+}
+
+MQTTConnectStats Air780EGMQTT::getConnectStats() const
+{
+    MQTTConnectStats stats = connect_stats;
+    // 中位数：复制最近的样本后插入排序（最多 CONNECT_TIME_SAMPLES 个）
+    unsigned long sorted[CONNECT_TIME_SAMPLES];
+    int n = connect_time_count;
+    for (int i = 0; i < n; i++)
+    {
+        unsigned long v = connect_times[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > v)
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    stats.samples = n;
+    stats.median_ms = n == 0 ? 0 : (n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2);
+    stats.min_ms = n == 0 ? 0 : sorted[0];
+    return stats;
+}
+
+MQTTReconnectStats Air780EGMQTT::getReconnectStats() const
+{
+    return reconnect_stats;
+}
+
+MQTTConnectStage Air780EGMQTT::getLastConnectStage() const
+{
+    return connect_stage;
+}
+
+bool Air780EGMQTT::reconnect()
+{
+    if (config.server.isEmpty())
+    {
+        return false;
+    }
+
+    AIR780EG_LOGI(TAG, "Attempting to reconnect");
+    return connect();
+}
+
+void Air780EGMQTT::registerURCHandlers()
+{
+    if (!core || urc_handlers_registered)
+    {
+        return;
+    }
+
+    urc_handlers_registered = core->addURCHandler("+MSUB:", onURC, this, onMSUBFrameLength, onMSUBFrameBuffer) &&
+                              core->addURCHandler("CLOSED", onLinkClosedURC, this) &&
+                              core->addURCHandler("SUBACK", onSubackURC, this);
+    AIR780EG_LOGD(TAG, "MQTT URC handlers registered");
+}
+
+void Air780EGMQTT::onURC(const String &urc, void *context)
+{
+    ((Air780EGMQTT *)context)->handleMQTTURC(urc);
+}
+
+// +MSUB: "topic",N byte,<data>：头部以 " byte," 结束时返回数据长度。
+// HEX模式下N为原始字节数，串口上是2N个HEX字符
+long Air780EGMQTT::onMSUBFrameLength(const String &header, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    if (!header.endsWith(" byte,"))
+    {
+        return -1;
+    }
+    const char *p = header.c_str();
+    int end = header.length() - 6;
+    int start = end;
+    while (start > 0 && p[start - 1] >= '0' && p[start - 1] <= '9')
+    {
+        start--;
+    }
+    if (start == end || start == 0 || p[start - 1] != ',')
+    {
+        return -1;
+    }
+    long length = atol(p + start);
+    return self->payload_mode == MQTT_PAYLOAD_HEX ? length * 2 : length;
+}
+
+String Air780EGMQTT::getConnectionInfo() const
+{
+    String info = "MQTT Status: ";
+    switch (state)
+    {
+    case MQTT_DISCONNECTED:
+        info += "Disconnected";
+        break;
+    case MQTT_CONNECTING:
+        info += "Connecting";
+        break;
+    case MQTT_CONNECTED:
+        info += "Connected";
+        break;
+    case MQTT_DISCONNECTING:
+        info += "Disconnecting";
+        break;
+    case MQTT_ERROR:
+        info += "Error";
+        break;
+    }
+
+    if (isConnected())
+    {
+        info += "\nServer: " + config.server;
+        info += "\nClient ID: " + config.client_id;
+        info += "\nSubscriptions: " + String(topic_trie.getSubscriptionCount());
+    }
+
+    return info;
+}
+
+void Air780EGMQTT::printStatus() const
+{
+    AIR780EG_LOGI(TAG, "MQTT Status");
+}
+
+void Air780EGMQTT::enableDebug(bool /* enable */)
+{
+    // 调试功能实现
+}
+
+void Air780EGMQTT::printConfig() const
+{
+    AIR780EG_LOGI(TAG, "MQTT Configuration");
+}
+
+// ==================== 定时任务到期堆 ====================
+// 比较用有符号差值，millis() 回绕时顺序仍然正确
+
+bool Air780EGMQTT::taskDueBefore(int a, int b) const
+{
+    return (long)(scheduled_tasks[a].next_due - scheduled_tasks[b].next_due) < 0;
+}
+
+void Air780EGMQTT::heapSwap(int a, int b)
+{
+    int tmp = task_heap[a];
+    task_heap[a] = task_heap[b];
+    task_heap[b] = tmp;
+    scheduled_tasks[task_heap[a]].heap_pos = a;
+    scheduled_tasks[task_heap[b]].heap_pos = b;
+}
+
+void Air780EGMQTT::heapSiftUp(int pos)
+{
+    while (pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+        if (!taskDueBefore(task_heap[pos], task_heap[parent]))
+            break;
+        heapSwap(pos, parent);
+        pos = parent;
+    }
+}
+
+void Air780EGMQTT::heapSiftDown(int pos)
+{
+    while (true)
+    {
+        int left = pos * 2 + 1;
+        int right = left + 1;
+        int smallest = pos;
+        if (left < task_heap_count && taskDueBefore(task_heap[left], task_heap[smallest]))
+            smallest = left;
+        if (right < task_heap_count && taskDueBefore(task_heap[right], task_heap[smallest]))
+            smallest = right;
+        if (smallest == pos)
+            break;
+        heapSwap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+void Air780EGMQTT::heapInsert(int task_index)
+{
+    if (scheduled_tasks[task_index].heap_pos >= 0)
+    {
+        return;
+    }
+    int pos = task_heap_count++;
+    task_heap[pos] = task_index;
+    scheduled_tasks[task_index].heap_pos = pos;
+    heapSiftUp(pos);
+}
+
+void Air780EGMQTT::heapRemove(int task_index)
+{
+    int pos = scheduled_tasks[task_index].heap_pos;
+    if (pos < 0)
+    {
+        return;
+    }
+    scheduled_tasks[task_index].heap_pos = -1;
+    int last = --task_heap_count;
+    if (pos != last)
+    {
+        task_heap[pos] = task_heap[last];
+        scheduled_tasks[task_heap[pos]].heap_pos = pos;
+        heapUpdate(task_heap[pos]);
+    }
+}
+
+// next_due 改变后恢复堆序
+void Air780EGMQTT::heapUpdate(int task_index)
+{
+    int pos = scheduled_tasks[task_index].heap_pos;
+    if (pos < 0)
+    {
+        return;
+    }
+    heapSiftUp(pos);
+    heapSiftDown(scheduled_tasks[task_index].heap_pos);
+}
+
+int Air780EGMQTT::findScheduledTask(const String &task_name) const
+{
+    for (int i = 0; i < scheduled_task_count; i++)
+    {
+        if (scheduled_tasks[i].task_name == task_name)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 处理定时任务：只检查堆顶，没有到期任务时开销为一次比较
+void Air780EGMQTT::processScheduledTasks()
+{
+    // 断开期间只有设置了离线队列才执行定时任务
+    bool offline = !isConnected();
+    if (offline && !(outbox && outbox->isOpen()))
+    {
+        return;
+    }
+
+    unsigned long current_time = millis();
+
+    // 每个任务本轮最多执行一次
+    for (int run = 0; run < scheduled_task_count && task_heap_count > 0; run++)
+    {
+        int index = task_heap[0];
+        ScheduledTask &task = scheduled_tasks[index];
+        if ((long)(current_time - task.next_due) < 0)
+        {
+            break;
+        }
+        // 补执行的任务每次 loop() 只执行一次，不连续突发
+        if (task.run_count > 0 && task.last_execution == current_time)
+        {
+            break;
+        }
+
+        unsigned long late = current_time - task.next_due;
+        if (task.run_count > 0 && late < task.interval_ms)
+        {
+            // 只统计连续周期的间隔抖动（跳过周期后的那次不计）
+            unsigned long period = current_time - task.last_execution;
+            unsigned long jitter = period > task.interval_ms ? period - task.interval_ms : task.interval_ms - period;
+            task.total_jitter_ms += jitter;
+            task.jitter_samples++;
+            if (jitter > task.max_jitter_ms)
+                task.max_jitter_ms = jitter;
+        }
+        task.run_count++;
+        task.total_late_ms += late;
+        if (late > task.max_late_ms)
+            task.max_late_ms = late;
+
+        // 先重新排期，回调中修改任务列表也不会打乱堆。
+        // 下次执行时间按计划时间累加，执行延迟不会累积成漂移
+        task.last_execution = current_time;
+        task.next_due += task.interval_ms;
+        if (task.miss_policy == TASK_MISS_SKIP && (long)(current_time - task.next_due) >= 0)
+        {
+            unsigned long missed = (current_time - task.next_due) / task.interval_ms + 1;
+            task.next_due += missed * task.interval_ms;
+            task.skipped_count += missed;
+        }
+        heapSiftDown(0);
+
+        AIR780EG_LOGD(TAG, "Executing scheduled task: %s", task.task_name.c_str());
+
+        if (task.writer)
+        {
+            runScheduledWriter(index, offline);
+            continue;
+        }
+
+        // 调用回调函数获取数据
+        ScheduledTaskCallback callback = task.callback;
+        String payload = callback();
+        if (payload.length() == 0 || index >= scheduled_task_count || scheduled_tasks[index].callback != callback)
+        {
+            continue;
+        }
+
+        const ScheduledTask &current = scheduled_tasks[index];
+        if (offline)
+        {
+            storeOffline(current.topic, payload, current.qos, current.retain, current.priority);
+        }
+        else if (publishAsync(current.topic, payload, current.qos, current.retain))
+        {
+            // 异步发布，结果由 onPublishComplete 记录，不在这里等待模块应答
+            AIR780EG_LOGD(TAG, "Queued scheduled task data: %s -> %s",
+                          current.topic.c_str(), payload.c_str());
+        }
+        else
+        {
+            AIR780EG_LOGW(TAG, "Failed to queue scheduled task: %s", current.task_name.c_str());
+        }
+    }
+}
+
+// 执行零分配任务：writer 写入任务缓冲区，按引用发布
+void Air780EGMQTT::runScheduledWriter(int index, bool offline)
+{
+    ScheduledTask &task = scheduled_tasks[index];
+    // 上一次的负载还在命令队列里，缓冲区不能覆盖，本周期跳过
+    for (int i = 0; i < MAX_PENDING_PUBLISHES; i++)
+    {
+        if (pending_publishes[i].id != 0 && pending_publishes[i].task_buffer == task.buffer)
+        {
+            task.skipped_count++;
+            AIR780EG_LOGW(TAG, "Previous publish of task %s still pending, skipping", task.task_name.c_str());
+            return;
+        }
+    }
+
+    uint8_t *buffer = task.buffer;
+    writer_buffer = buffer;
+    size_t len = task.writer(buffer, task.buffer_size, task.writer_context);
+    writer_buffer = nullptr;
+    if (writer_buffer_released)
+    {
+        writer_buffer_released = false;
+        delete[] buffer;
+        return;
+    }
+    // 回调中可能移除了任务
+    if (index >= scheduled_task_count || scheduled_tasks[index].buffer != buffer)
+    {
+        return;
+    }
+    ScheduledTask &current = scheduled_tasks[index];
+    if (len == 0 || len > current.buffer_size)
+    {
+        if (len > current.buffer_size)
+        {
+            AIR780EG_LOGE(TAG, "Task %s wrote %u bytes into %u byte buffer", current.task_name.c_str(),
+                          (unsigned)len, (unsigned)current.buffer_size);
+        }
+        return;
+    }
+
+    if (offline)
+    {
+        // 写入离线队列需要一份拷贝
+        String payload;
+        payload.concat((const char *)buffer, len);
+        storeOffline(current.topic, payload, current.qos, current.retain, current.priority);
+    }
+    else if (!publishTaskBuffer(current, len))
+    {
+        AIR780EG_LOGW(TAG, "Failed to queue scheduled task: %s", current.task_name.c_str());
+    }
+}
+
+// 添加定时任务
+bool Air780EGMQTT::addScheduledTask(const String &task_name, const String &topic,
+                                    ScheduledTaskCallback callback, unsigned long interval_ms,
+                                    int qos, bool retain)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    if (callback == nullptr)
+    {
+        AIR780EG_LOGE(TAG, "Callback function is null");
+        return false;
+    }
+
+    int index = addScheduledTaskEntry(task_name, topic, interval_ms, qos, retain);
+    if (index < 0)
+    {
+        return false;
+    }
+    scheduled_tasks[index].callback = callback;
+    return true;
+}
+
+bool Air780EGMQTT::addScheduledTask(const String &task_name, const String &topic,
+                                    ScheduledTaskWriter writer, void *context, size_t buffer_size,
+                                    unsigned long interval_ms, int qos, bool retain)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    if (writer == nullptr || buffer_size == 0)
+    {
+        AIR780EG_LOGE(TAG, "Writer is null or buffer size is 0");
+        return false;
+    }
+
+    int index = addScheduledTaskEntry(task_name, topic, interval_ms, qos, retain);
+    if (index < 0)
+    {
+        return false;
+    }
+    // 负载和命令前缀（AT+MPUBEX="topic",q,r,len）一次分配，之后每次发布都复用
+    ScheduledTask &task = scheduled_tasks[index];
+    task.writer = writer;
+    task.writer_context = context;
+    task.buffer_size = buffer_size;
+    task.command_size = topic.length() + 32;
+    task.buffer = new uint8_t[buffer_size + task.command_size];
+    return true;
+}
+
+// 校验并初始化任务的公共部分，返回任务下标（失败时-1）
+int Air780EGMQTT::addScheduledTaskEntry(const String &task_name, const String &topic, unsigned long interval_ms,
+                                        int qos, bool retain)
+{
+    if (scheduled_task_count >= max_scheduled_tasks)
+    {
+        AIR780EG_LOGE(TAG, "Maximum scheduled tasks reached");
+        return -1;
+    }
+
+    if (interval_ms < 1000)
+    {
+        AIR780EG_LOGW(TAG, "Interval too short, minimum 1 second");
+        interval_ms = 1000;
+    }
+    AIR780EG_LOGI(TAG, "Add scheduled task: %s, topic: %s, interval: %lu ms",
+                  task_name.c_str(), topic.c_str(), interval_ms);
+
+    // 检查任务名是否已存在
+    if (findScheduledTask(task_name) >= 0)
+    {
+        AIR780EG_LOGI(TAG, "Task name already exists: %s", task_name.c_str());
+        return -1;
+    }
+
+    // 添加新任务
+    int index = scheduled_task_count++;
+    ScheduledTask &task = scheduled_tasks[index];
+    task.task_name = task_name;
+    task.topic = topic;
+    task.callback = nullptr;
+    task.writer = nullptr;
+    task.writer_context = nullptr;
+    task.buffer = nullptr;
+    task.buffer_size = 0;
+    task.command_size = 0;
+    task.interval_ms = interval_ms;
+    task.qos = qos;
+    task.retain = retain;
+    task.enabled = true;
+    task.priority = 0;
+    task.miss_policy = TASK_MISS_SKIP;
+    task.last_execution = millis();
+    // 自动相位：按黄金分割序列把各任务的首次执行错开，对任意任务数都分布均匀；
+    // 第一个任务的相位等于间隔，与不错开时相同
+    task.phase_ms = interval_ms;
+    if (task_phase_spread)
+    {
+        uint32_t frac = (uint32_t)(tasks_added * 2654435769u);  // tasks_added * 0.618 的小数部分（32位定点）
+        task.phase_ms = interval_ms - (unsigned long)(((uint64_t)frac * interval_ms) >> 32);
+    }
+    tasks_added++;
+    task.next_due = task.last_execution + task.phase_ms;
+    task.heap_pos = -1;
+    task.run_count = 0;
+    task.skipped_count = 0;
+    task.jitter_samples = 0;
+    task.total_late_ms = 0;
+    task.max_late_ms = 0;
+    task.total_jitter_ms = 0;
+    task.max_jitter_ms = 0;
+    heapInsert(index);
+
+    AIR780EG_LOGD(TAG, "Added scheduled task: %s, topic: %s, interval: %lu ms",
+                  task_name.c_str(), topic.c_str(), interval_ms);
+
+    return index;
+}
+
+// 移除定时任务
+bool Air780EGMQTT::removeScheduledTask(const String &task_name)
+{
+    int index = findScheduledTask(task_name);
+    if (index < 0)
     {
-        // 收到订阅消息 - 使用新的解析函数
-        if (message_callback)
-        {
-            parseMQTTMessage(urc);
-        }
+        AIR780EG_LOGW(TAG, "Task not found: %s", task_name.c_str());
+        return false;
     }
-    // 移除错误的GNSS处理 - GNSS响应应该由队列机制处理，不是URC
-    // +CGNSINF: 是AT+CGNSINF命令的响应，不是主动上报的URC
-    else if (urc.indexOf("boot.rom") >= 0) // 确保设备供电正常
+
+    heapRemove(index);
+    releaseTaskBuffer(scheduled_tasks[index]);
+
+    // 最后一个任务移到空位，不整体前移
+    int last = --scheduled_task_count;
+    if (index != last)
     {
-        Serial.printf("确保设备供电正常，boot.rom: %s\n", urc.c_str());
-        // 重新设置mqtt
-        init();
-        if (gnss->isEnabled())
+        scheduled_tasks[index] = std::move(scheduled_tasks[last]);
+        if (scheduled_tasks[index].heap_pos >= 0)
         {
-            gnss->enableGNSS();
+            task_heap[scheduled_tasks[index].heap_pos] = index;
         }
     }
+    scheduled_tasks[last].callback = nullptr;
+    scheduled_tasks[last].writer = nullptr;
+    scheduled_tasks[last].buffer = nullptr;
+    scheduled_tasks[last].heap_pos = -1;
+
+    AIR780EG_LOGI(TAG, "Removed scheduled task: %s", task_name.c_str());
+    return true;
 }
 
-void Air780EGMQTT::processMessageCache()
+// 释放零分配任务的缓冲区；负载仍在命令队列中时交给发布槽位，发送完成后释放
+void Air780EGMQTT::releaseTaskBuffer(ScheduledTask &task)
 {
-    while (cached_message_count > 0)
+    if (!task.buffer)
     {
-        Air780EGMQTTMessage msg = message_cache[cache_head];
-        cache_head = (cache_head + 1) % MAX_CACHED_MESSAGES;
-        cached_message_count--;
-
-        if (message_callback)
+        return;
+    }
+    if (task.buffer == writer_buffer)
+    {
+        // writer 正在写入（在回调中移除了自己的任务），返回后释放
+        writer_buffer_released = true;
+        task.buffer = nullptr;
+        return;
+    }
+    for (int i = 0; i < MAX_PENDING_PUBLISHES; i++)
+    {
+        if (pending_publishes[i].id != 0 && pending_publishes[i].task_buffer == task.buffer)
         {
-            message_callback(msg.topic, msg.payload);
+            pending_publishes[i].release_buffer = true;
+            task.buffer = nullptr;
+            return;
         }
     }
+    delete[] task.buffer;
+    task.buffer = nullptr;
 }
 
-bool Air780EGMQTT::reconnect()
+// 启用定时任务
+bool Air780EGMQTT::enableScheduledTask(const String &task_name, bool enabled)
 {
-    if (config.server.isEmpty())
+    int index = findScheduledTask(task_name);
+    if (index < 0)
     {
+        AIR780EG_LOGW(TAG, "Task not found: %s", task_name.c_str());
         return false;
     }
 
-    AIR780EG_LOGI(TAG, "Attempting to reconnect");
-    return connect();
+    ScheduledTask &task = scheduled_tasks[index];
+    task.enabled = enabled;
+    if (enabled)
+    {
+        // 时间线不变，禁用期间错过的周期按 miss_policy 处理
+        heapInsert(index);
+    }
+    else
+    {
+        heapRemove(index);
+    }
+    AIR780EG_LOGI(TAG, "Task %s %s", task_name.c_str(), enabled ? "enabled" : "disabled");
+    return true;
 }
 
-void Air780EGMQTT::registerURCHandlers()
+// 禁用定时任务
+bool Air780EGMQTT::disableScheduledTask(const String &task_name)
 {
-    if (!core)
+    return enableScheduledTask(task_name, false);
+}
+
+// 设置定时任务在离线队列中的优先级（越大越先补发、越晚被淘汰）
+bool Air780EGMQTT::setScheduledTaskPriority(const String &task_name, uint8_t priority)
+{
+    int index = findScheduledTask(task_name);
+    if (index < 0)
     {
-        return;
+        AIR780EG_LOGW(TAG, "Task not found: %s", task_name.c_str());
+        return false;
     }
-
-    AIR780EG_LOGD(TAG, "MQTT URC handlers registered");
+    scheduled_tasks[index].priority = priority;
+    return true;
 }
 
-String Air780EGMQTT::getConnectionInfo() const
+// 修改执行间隔（例如电源模式切换时），不需要移除再添加
+bool Air780EGMQTT::setScheduledTaskInterval(const String &task_name, unsigned long interval_ms)
 {
-    String info = "MQTT Status: ";
-    switch (state)
+    int index = findScheduledTask(task_name);
+    if (index < 0)
     {
-    case MQTT_DISCONNECTED:
-        info += "Disconnected";
-        break;
-    case MQTT_CONNECTING:
-        info += "Connecting";
-        break;
-    case MQTT_CONNECTED:
-        info += "Connected";
-        break;
-    case MQTT_DISCONNECTING:
-        info += "Disconnecting";
-        break;
-    case MQTT_ERROR:
-        info += "Error";
-        break;
+        AIR780EG_LOGW(TAG, "Task not found: %s", task_name.c_str());
+        return false;
     }
-
-    if (isConnected())
+    if (interval_ms < 1000)
     {
-        info += "\nServer: " + config.server;
-        info += "\nClient ID: " + config.client_id;
-        info += "\nSubscriptions: " + String(subscription_count);
+        AIR780EG_LOGW(TAG, "Interval too short, minimum 1 second");
+        interval_ms = 1000;
     }
 
-    return info;
+    // 从上一个计划执行时间起按新间隔排期
+    ScheduledTask &task = scheduled_tasks[index];
+    task.next_due = task.next_due - task.interval_ms + interval_ms;
+    task.interval_ms = interval_ms;
+    heapUpdate(index);
+    AIR780EG_LOGI(TAG, "Task %s interval: %lu ms", task_name.c_str(), interval_ms);
+    return true;
 }
 
-void Air780EGMQTT::printStatus() const
+bool Air780EGMQTT::setScheduledTaskMissPolicy(const String &task_name, ScheduledTaskMissPolicy policy)
 {
-    AIR780EG_LOGI(TAG, "MQTT Status");
+    int index = findScheduledTask(task_name);
+    if (index < 0)
+    {
+        AIR780EG_LOGW(TAG, "Task not found: %s", task_name.c_str());
+        return false;
+    }
+    scheduled_tasks[index].miss_policy = policy;
+    return true;
 }
 
-void Air780EGMQTT::enableDebug(bool enable)
+bool Air780EGMQTT::setScheduledTaskPhase(const String &task_name, unsigned long phase_ms)
 {
-    // 调试功能实现
-}
+    int index = findScheduledTask(task_name);
+    if (index < 0)
+    {
+        AIR780EG_LOGW(TAG, "Task not found: %s", task_name.c_str());
+        return false;
+    }
 
-void Air780EGMQTT::printConfig() const
-{
-    AIR780EG_LOGI(TAG, "MQTT Configuration");
+    // 整条时间线平移到新相位
+    ScheduledTask &task = scheduled_tasks[index];
+    task.next_due = task.next_due - task.phase_ms + phase_ms;
+    task.phase_ms = phase_ms;
+    heapUpdate(index);
+    return true;
 }
 
-// HEX转换函数
-String Air780EGMQTT::toHexString(const String &input)
+void Air780EGMQTT::setScheduledTaskPhaseSpread(bool enable)
 {
-    String hex = "";
-    for (size_t i = 0; i < input.length(); ++i)
-    {
-        char buf[3];
-        sprintf(buf, "%02x", (unsigned char)input[i]);
-        hex += buf;
-    }
-    return hex;
+    task_phase_spread = enable;
 }
 
-// 处理定时任务
-void Air780EGMQTT::processScheduledTasks()
+bool Air780EGMQTT::getScheduledTaskStats(const String &task_name, ScheduledTaskStats &stats) const
 {
-    if (!isConnected())
+    int index = findScheduledTask(task_name);
+    if (index < 0)
     {
-        return; // 只有在连接状态下才执行定时任务
+        return false;
     }
 
-    unsigned long current_time = millis();
+    const ScheduledTask &task = scheduled_tasks[index];
+    stats.runs = task.run_count;
+    stats.skipped = task.skipped_count;
+    stats.avg_late_ms = task.run_count ? task.total_late_ms / task.run_count : 0;
+    stats.max_late_ms = task.max_late_ms;
+    stats.avg_jitter_ms = task.jitter_samples ? task.total_jitter_ms / task.jitter_samples : 0;
+    stats.max_jitter_ms = task.max_jitter_ms;
+    return true;
+}
 
+void Air780EGMQTT::resetScheduledTaskStats()
+{
     for (int i = 0; i < scheduled_task_count; i++)
     {
         ScheduledTask &task = scheduled_tasks[i];
-
-        if (!task.enabled || task.callback == nullptr)
-        {
-            continue;
-        }
-
-        // 检查是否到了执行时间
-        if (current_time - task.last_execution >= task.interval_ms)
-        {
-            AIR780EG_LOGD(TAG, "Executing scheduled task: %s", task.task_name.c_str());
-
-            // 调用回调函数获取数据
-            String payload = task.callback();
-
-            if (payload.length() > 0)
-            {
-                // 发布数据
-                if (publish(task.topic, payload, task.qos, task.retain))
-                {
-                    AIR780EG_LOGD(TAG, "Published scheduled task data: %s -> %s",
-                                  task.topic.c_str(), payload.c_str());
-                }
-                else
-                {
-                    AIR780EG_LOGW(TAG, "Failed to publish scheduled task: %s", task.task_name.c_str());
-                }
-            }
-
-            task.last_execution = current_time;
-        }
+        task.run_count = 0;
+        task.skipped_count = 0;
+        task.jitter_samples = 0;
+        task.total_late_ms = 0;
+        task.max_late_ms = 0;
+        task.total_jitter_ms = 0;
+        task.max_jitter_ms = 0;
     }
 }
 
-// 添加定时任务
-bool Air780EGMQTT::addScheduledTask(const String &task_name, const String &topic,
-                                    ScheduledTaskCallback callback, unsigned long interval_ms,
-                                    int qos, bool retain)
+bool Air780EGMQTT::setMaxScheduledTasks(int capacity)
 {
-    if (scheduled_task_count >= MAX_SCHEDULED_TASKS)
+    if (capacity < 1 || capacity < scheduled_task_count)
     {
-        AIR780EG_LOGE(TAG, "Maximum scheduled tasks reached");
+        AIR780EG_LOGE(TAG, "Invalid scheduled task capacity: %d (%d tasks)", capacity, scheduled_task_count);
         return false;
     }
-
-    if (callback == nullptr)
+    if (capacity == max_scheduled_tasks)
     {
-        AIR780EG_LOGE(TAG, "Callback function is null");
-        return false;
+        return true;
     }
 
-    if (interval_ms < 1000)
+    ScheduledTask *tasks = new ScheduledTask[capacity];
+    int *heap = new int[capacity];
+    for (int i = 0; i < capacity; i++)
     {
-        AIR780EG_LOGW(TAG, "Interval too short, minimum 1 second");
-        interval_ms = 1000;
+        tasks[i].enabled = false;
+        tasks[i].callback = nullptr;
+        tasks[i].writer = nullptr;
+        tasks[i].buffer = nullptr;
+        tasks[i].last_execution = 0;
+        tasks[i].priority = 0;
+        tasks[i].heap_pos = -1;
     }
-    AIR780EG_LOGI(TAG, "Add scheduled task: %s, topic: %s, interval: %lu ms",
-                  task_name.c_str(), topic.c_str(), interval_ms);
-
-    // 检查任务名是否已存在
+    // 任务下标不变，堆可以直接复制
     for (int i = 0; i < scheduled_task_count; i++)
     {
-        if (scheduled_tasks[i].task_name == task_name)
-        {
-            AIR780EG_LOGI(TAG, "Task name already exists: %s", task_name.c_str());
-            return false;
-        }
+        tasks[i] = std::move(scheduled_tasks[i]);
+    }
+    for (int i = 0; i < task_heap_count; i++)
+    {
+        heap[i] = task_heap[i];
     }
 
-    // 添加新任务
-    ScheduledTask &task = scheduled_tasks[scheduled_task_count];
-    task.task_name = task_name;
-    task.topic = topic;
-    task.callback = callback;
-    task.interval_ms = interval_ms;
-    task.qos = qos;
-    task.retain = retain;
-    task.enabled = true;
-    task.last_execution = millis();
-
-    scheduled_task_count++;
-
-    AIR780EG_LOGD(TAG, "Added scheduled task: %s, topic: %s, interval: %lu ms",
-                  task_name.c_str(), topic.c_str(), interval_ms);
-
+    delete[] scheduled_tasks;
+    delete[] task_heap;
+    scheduled_tasks = tasks;
+    task_heap = heap;
+    max_scheduled_tasks = capacity;
     return true;
 }
 
-// 移除定时任务
-bool Air780EGMQTT::removeScheduledTask(const String &task_name)
+int Air780EGMQTT::getMaxScheduledTasks() const
 {
-    for (int i = 0; i < scheduled_task_count; i++)
-    {
-        if (scheduled_tasks[i].task_name == task_name)
-        {
-            // 将后面的任务前移
-            for (int j = i; j < scheduled_task_count - 1; j++)
-            {
-                scheduled_tasks[j] = scheduled_tasks[j + 1];
-            }
-            scheduled_task_count--;
-
-            AIR780EG_LOGI(TAG, "Removed scheduled task: %s", task_name.c_str());
-            return true;
-        }
-    }
-
-    AIR780EG_LOGW(TAG, "Task not found: %s", task_name.c_str());
-    return false;
+    return max_scheduled_tasks;
 }
 
-// 启用定时任务
-bool Air780EGMQTT::enableScheduledTask(const String &task_name, bool enabled)
+unsigned long Air780EGMQTT::getTimeUntilNextTask() const
 {
-    for (int i = 0; i < scheduled_task_count; i++)
+    if (task_heap_count == 0)
     {
-        if (scheduled_tasks[i].task_name == task_name)
-        {
-            scheduled_tasks[i].enabled = enabled;
-            AIR780EG_LOGI(TAG, "Task %s %s", task_name.c_str(), enabled ? "enabled" : "disabled");
-            return true;
-        }
+        return ULONG_MAX;
     }
-
-    AIR780EG_LOGW(TAG, "Task not found: %s", task_name.c_str());
-    return false;
-}
-
-// 禁用定时任务
-bool Air780EGMQTT::disableScheduledTask(const String &task_name)
-{
-    return enableScheduledTask(task_name, false);
+    long remaining = (long)(scheduled_tasks[task_heap[0]].next_due - millis());
+    return remaining > 0 ? (unsigned long)remaining : 0;
 }
 
 // 获取定时任务数量
@@ -750,7 +3022,10 @@ String Air780EGMQTT::getScheduledTaskInfo(int index) const
                   ", Interval: " + String(task.interval_ms) + "ms" +
                   ", QoS: " + String(task.qos) +
                   ", Retain: " + String(task.retain ? "true" : "false") +
-                  ", Enabled: " + String(task.enabled ? "true" : "false");
+                  ", Enabled: " + String(task.enabled ? "true" : "false") +
+                  ", Runs: " + String(task.run_count) +
+                  ", Skipped: " + String(task.skipped_count) +
+                  ", Max jitter: " + String(task.max_jitter_ms) + "ms";
 
     return info;
 }
@@ -758,92 +3033,211 @@ String Air780EGMQTT::getScheduledTaskInfo(int index) const
 // 清除所有定时任务
 void Air780EGMQTT::clearAllScheduledTasks()
 {
+    for (int i = 0; i < scheduled_task_count; i++)
+    {
+        releaseTaskBuffer(scheduled_tasks[i]);
+    }
     scheduled_task_count = 0;
-    for (int i = 0; i < MAX_SCHEDULED_TASKS; i++)
+    task_heap_count = 0;
+    for (int i = 0; i < max_scheduled_tasks; i++)
     {
         scheduled_tasks[i].enabled = false;
         scheduled_tasks[i].callback = nullptr;
+        scheduled_tasks[i].writer = nullptr;
+        scheduled_tasks[i].buffer = nullptr;
         scheduled_tasks[i].last_execution = 0;
+        scheduled_tasks[i].heap_pos = -1;
     }
 
     AIR780EG_LOGI(TAG, "All scheduled tasks cleared");
 }
 
 // 新增：HEX字符串转普通字符串的辅助函数
-String Air780EGMQTT::fromHexString(const String &hex)
+static int hexNibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// 负载是否为完整的HEX编码
+static bool isHexSpan(const char *p, size_t len)
 {
-    String result = "";
-    for (size_t i = 0; i < hex.length(); i += 2)
+    if (len == 0 || len % 2 != 0)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++)
     {
-        if (i + 1 < hex.length())
+        if (hexNibble(p[i]) < 0)
         {
-            String byteString = hex.substring(i, i + 2);
-            char byte = (char)strtol(byteString.c_str(), NULL, 16);
-            result += byte;
+            return false;
         }
     }
-    return result;
+    return true;
 }
 
-// 新增：检查字符串是否为HEX格式的辅助函数
-bool Air780EGMQTT::isHexString(const String &str)
+// 拆分 +MSUB: "topic",N byte,<data>，返回主题位置和数据起点
+static bool splitMSUB(const String &message, const char *&topic, size_t &topic_len, int &data_start)
 {
-    for (size_t i = 0; i < str.length(); i++)
+    // 跳过 "+MSUB:" 及其后的空格
+    if (!message.startsWith("+MSUB:"))
     {
-        char c = str.charAt(i);
-        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')))
-        {
-            return false;
-        }
+        return false;
+    }
+    const char *p = message.c_str();
+    int topic_start = 6;
+    while (topic_start < (int)message.length() && p[topic_start] == ' ')
+    {
+        topic_start++;
+    }
+
+    // 以 " byte," 定位长度字段，主题中含逗号也能正确拆分；
+    // 没有长度字段时按旧格式：主题到第一个逗号为止，负载从第二个逗号之后开始
+    int topic_end;
+    int marker = message.indexOf(" byte,", topic_start);
+    if (marker > topic_start)
+    {
+        topic_end = message.lastIndexOf(',', marker);
+        data_start = marker + 6;
+    }
+    else
+    {
+        topic_end = message.indexOf(',', topic_start);
+        data_start = topic_end > topic_start ? message.indexOf(',', topic_end + 1) + 1 : 0;
+    }
+    if (topic_end <= topic_start || data_start <= topic_end)
+    {
+        return false;
+    }
+    topic = p + topic_start;
+    topic_len = topic_end - topic_start;
+    if (topic_len >= 2 && topic[0] == '"' && topic[topic_len - 1] == '"')
+    {
+        topic++;
+        topic_len -= 2;
+    }
+    return true;
+}
+
+// 大消息缓冲区按需增长，只增不减
+void Air780EGMQTT::growLargePayload(size_t payload_len)
+{
+    if (inbound_large_size < payload_len)
+    {
+        AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+        delete[] inbound_large;
+        inbound_large = new uint8_t[payload_len];
+        inbound_large_size = payload_len;
+    }
+}
+
+// 原始模式下 +MSUB 的数据由Core直接写入下一个空闲槽位（或大消息缓冲区），读完后在 parseMQTTMessage 中入队。
+// HEX模式需要解码，队列已满或消息放不下时需要按溢出策略处理，这些情况仍由Core读入整条上报
+uint8_t *Air780EGMQTT::onMSUBFrameBuffer(const String &header, size_t length, void *context)
+{
+    Air780EGMQTT *self = (Air780EGMQTT *)context;
+    self->inbound_direct = false;
+    const char *topic;
+    size_t topic_len;
+    int data_start;
+    if (length == 0 || self->payload_mode == MQTT_PAYLOAD_HEX || self->inbound_count >= self->inbound_capacity ||
+        !splitMSUB(header, topic, topic_len, data_start) || topic_len >= self->inbound_topic_size)
+    {
+        return nullptr;
+    }
+    bool large = length > self->inbound_payload_size;
+    if (large && self->inbound_large_busy)
+    {
+        return nullptr;
     }
-    return str.length() > 0 && str.length() % 2 == 0; // HEX字符串长度必须是偶数
+    if (large)
+    {
+        self->growLargePayload(length);
+    }
+    MQTTInboundSlot &slot = self->inbound_slots[(self->inbound_head + self->inbound_count) % self->inbound_capacity];
+    memcpy(slot.topic, topic, topic_len);
+    slot.topic[topic_len] = '\0';
+    slot.topic_len = topic_len;
+    self->inbound_direct = true;
+    self->inbound_direct_len = length;
+    return large ? self->inbound_large : slot.payload;
 }
 
-// 修改：解析MQTT消息的辅助函数
-void Air780EGMQTT::parseMQTTMessage(const String &message)
+// 解析 +MSUB: "topic",N byte,<data>，主题和负载直接复制（HEX模式下解码）到队列槽位，
+// 不构造中间字符串；数据已由Core直接写入槽位时 message 只有头部
+bool Air780EGMQTT::parseMQTTMessage(const String &message)
 {
     AIR780EG_LOGD(TAG, "Parsing MQTT message: %s", message.c_str());
-    
-    // 查找第一个逗号的位置
-    int first_comma = message.indexOf(",");
-    if (first_comma > 0)
-    {
-        // 提取主题 (去掉引号)
-        String topic = message.substring(7, first_comma); // 跳过 "+MSUB: "
-        if (topic.startsWith("\"") && topic.endsWith("\""))
-        {
-            topic = topic.substring(1, topic.length() - 1);
-        }
-        
-        // 查找第二个逗号的位置
-        int second_comma = message.indexOf(",", first_comma + 1);
-        if (second_comma > 0)
-        {
-            // 提取负载 (从第二个逗号后开始)
-            String payload = message.substring(second_comma + 1);
-            
-            // 检查是否是HEX格式的负载
-            if (payload.length() > 0 && isHexString(payload))
-            {
-                // 将HEX转换为普通字符串
-                String decoded_payload = fromHexString(payload);
-                AIR780EG_LOGD(TAG, "Decoded HEX payload: %s -> %s", payload.c_str(), decoded_payload.c_str());
-                payload = decoded_payload;
-            }
-            
-            AIR780EG_LOGD(TAG, "Parsed MQTT message - Topic: %s, Payload: %s", topic.c_str(), payload.c_str());
-            if (message_callback)
+
+    bool direct = inbound_direct;
+    inbound_direct = false;
+    const char *topic;
+    size_t topic_len;
+    int data_start;
+    if (!splitMSUB(message, topic, topic_len, data_start))
+    {
+        AIR780EG_LOGW(TAG, "Invalid MQTT message format: %s", message.c_str());
+        return false;
+    }
+    const char *data = message.c_str() + data_start;
+    size_t data_len = direct ? inbound_direct_len : message.length() - data_start;
+
+    // HEX模式下HEX格式的负载解码后保存（文本/原始模式下负载原样上报）
+    bool hex = !direct && payload_mode == MQTT_PAYLOAD_HEX && isHexSpan(data, data_len);
+    size_t payload_len = hex ? data_len / 2 : data_len;
+    bool large = payload_len > inbound_payload_size;
+    if (topic_len >= inbound_topic_size || (large && inbound_large_busy))
+    {
+        inbound_stats.oversized++;
+        AIR780EG_LOGW(TAG, "Inbound message dropped (topic %u, payload %u bytes%s)", (unsigned)topic_len,
+                      (unsigned)payload_len, large ? ", large buffer busy" : "");
+        return false;
+    }
+    if (large)
+    {
+        growLargePayload(payload_len);
+    }
+
+    // 直接写入时队列未满，取到的就是写入数据的槽位
+    MQTTInboundSlot *slot = reserveInboundSlot();
+    if (!slot)
+    {
+        return false;
+    }
+    if (large)
+    {
+        // 不截断：超过槽位大小的负载放在大消息缓冲区，槽位暂时指向它
+        slot->payload = inbound_large;
+        inbound_large_busy = true;
+        inbound_stats.large++;
+        updateInboundPause();
+    }
+    if (!direct)
+    {
+        memcpy(slot->topic, topic, topic_len);
+        slot->topic[topic_len] = '\0';
+        slot->topic_len = topic_len;
+        if (hex)
+        {
+            for (size_t i = 0; i < payload_len; i++)
             {
-                message_callback(topic, payload);
+                slot->payload[i] = (hexNibble(data[2 * i]) << 4) | hexNibble(data[2 * i + 1]);
             }
         }
         else
         {
-            AIR780EG_LOGW(TAG, "Invalid MQTT message format: %s", message.c_str());
+            memcpy(slot->payload, data, payload_len);
         }
     }
-    else
-    {
-        AIR780EG_LOGW(TAG, "Invalid MQTT message format: %s", message.c_str());
-    }
+    slot->payload_len = payload_len;
+    slot->timestamp = millis();
+    inbound_stats.received++;
+    link_activity = true;
+    AIR780EG_LOGD(TAG, "Queued MQTT message - Topic: %.*s, %u bytes", (int)topic_len, topic, (unsigned)payload_len);
+    return true;
 }
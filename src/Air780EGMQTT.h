@@ -5,6 +5,10 @@
 #include "Air780EGCore.h"
 #include "Air780EGDebug.h"
 #include "Air780EGGNSS.h"
+#include "Air780EGOutbox.h"
+#include "Air780EGCompress.h"
+#include "Air780EGTopicTrie.h"
+#include "Air780EGTLS.h"
 
 // MQTT连接状态
 enum Air780EGMQTTState {
@@ -15,6 +19,14 @@ enum Air780EGMQTTState {
     MQTT_ERROR = 4
 };
 
+// 发布负载的发送方式（init() 时确定）
+enum MQTTPayloadMode {
+    MQTT_PAYLOAD_AUTO = -1,  // 自动选择：支持 AT+MPUBEX 时用原始模式，否则HEX模式
+    MQTT_PAYLOAD_HEX = 0,    // AT+MQTTMODE=1，负载HEX编码，串口字节数翻倍
+    MQTT_PAYLOAD_TEXT = 1,   // AT+MQTTMODE=0，负载作为转义文本放在引号内（不能含CR/LF/NUL）
+    MQTT_PAYLOAD_RAW = 2     // AT+MQTTMODE=0，AT+MPUBEX 指定长度，收到 '>' 后写入原始字节
+};
+
 // MQTT消息结构
 struct Air780EGMQTTMessage {
     String topic;
@@ -24,6 +36,107 @@ struct Air780EGMQTTMessage {
     unsigned long timestamp;
 };
 
+// 下行消息队列满时的处理方式
+enum MQTTInboundOverflowPolicy {
+    MQTT_INBOUND_DROP_OLDEST = 0,  // 丢弃最早的消息，保留最新的下行（默认）
+    MQTT_INBOUND_DROP_NEWEST,      // 丢弃新到的消息
+    MQTT_INBOUND_PAUSE             // 暂停空闲时的串口读取，命令响应中夹带的消息暂存在Core，loop() 取走消息后恢复，不丢弃
+};
+
+// 下行消息队列统计
+struct MQTTInboundStats {
+    uint32_t received;        // 解析成功的 +MSUB
+    uint32_t delivered;       // 已交给回调或 getNextMessage()
+    uint32_t dropped_oldest;  // 队列满时被挤掉的旧消息
+    uint32_t dropped_newest;  // 队列满时丢弃的新消息
+    uint32_t oversized;       // 主题超长，或大消息缓冲区仍被占用而丢弃
+    uint32_t large;           // 超过槽位大小、经大消息缓冲区接收的消息
+    uint32_t pauses;          // 因队列满暂停读取的次数
+    uint32_t unhandled;       // 没有匹配的主题处理器、也没有全局回调而丢弃的消息
+    uint16_t depth;           // 当前排队数
+    uint16_t max_depth;       // 最大排队数
+};
+
+// 连接状态检测统计
+struct MQTTLinkStats {
+    uint32_t status_polls;            // 发出的 AT+MQTTSTATU
+    uint32_t polls_avoided;           // 校验到期时已有收发流量而跳过的查询
+    uint32_t urc_disconnects;         // 由模块断开上报发现的断开
+    uint32_t poll_disconnects;        // 由状态查询发现的断开（上报遗漏）
+    unsigned long check_interval_ms;  // 当前校验间隔
+};
+
+// 连接失败的阶段
+enum MQTTConnectStage {
+    MQTT_STAGE_NONE = 0,      // 成功
+    MQTT_STAGE_NETWORK = 1,   // 网络未注册或未附着
+    MQTT_STAGE_CONFIG = 2,    // AT+MCONFIG 失败
+    MQTT_STAGE_TCP = 3,       // AT+MIPSTART 未返回 CONNECT OK
+    MQTT_STAGE_CONNACK = 4    // AT+MCONNECT 未返回 CONNACK OK
+};
+
+// 重连统计
+struct MQTTReconnectStats {
+    uint32_t attempts;
+    uint32_t successes;
+    uint32_t failures[5];               // 按失败阶段计数，下标为 MQTTConnectStage
+    MQTTConnectStage last_failure;
+    uint16_t consecutive_failures;
+    unsigned long next_delay_ms;        // 最近一次失败后的退避时间
+    unsigned long last_connect_ms;      // 最近一次成功连接的耗时（开始尝试到 CONNACK）
+    unsigned long last_subscribed_ms;   // 从 CONNACK 到全部订阅恢复（收到所有 SUBACK）
+    uint16_t resubscribed;              // 最近一次恢复的订阅数
+    uint16_t resubscribe_failed;
+    uint32_t sessions_resumed;          // 服务器保留了会话、跳过恢复订阅的次数
+};
+
+// 连接耗时统计（成功的连接，从开始到 CONNACK；中位数取最近16次）
+struct MQTTConnectStats {
+    uint32_t attempts;
+    uint32_t successes;
+    uint16_t samples;
+    unsigned long last_ms;
+    unsigned long median_ms;
+    unsigned long min_ms;                // 最近样本中的最小值
+    unsigned long max_ms;
+    unsigned long last_tcp_ms;           // 最近一次 AT+MIPSTART 到 CONNECT OK
+    unsigned long last_connack_ms;       // 最近一次 AT+MCONNECT 到 CONNACK OK
+    uint32_t network_checks_skipped;     // 网络检查在有效期内而跳过的次数
+    uint32_t dns_cache_hits;             // 直接用缓存IP连接的次数
+    uint32_t dns_lookups;
+    uint32_t dns_failures;
+};
+
+// 下行消息接收方式（init() 时设置）
+enum MQTTReceiveMode {
+    MQTT_RECEIVE_URC = 0,       // AT+MQTTMSGSET=0，每条消息由模块以 +MSUB 主动上报（默认）
+    MQTT_RECEIVE_BUFFERED = 1   // AT+MQTTMSGSET=1，消息缓存在模块中（最多4条），由库用 AT+MQTTMSGGET 批量读取
+};
+
+// 模块缓存模式的读取统计
+struct MQTTDrainStats {
+    uint32_t notifications;            // 模块的新消息通知（+MSUB: <缓存位置>）
+    uint32_t drains;                   // 发出的 AT+MQTTMSGGET
+    uint32_t empty_drains;             // 没有读到消息的读取
+    uint32_t after_publish;            // 紧跟在发布之后的读取
+    uint32_t messages;                 // 读到的消息
+    uint32_t overwritten;              // 未读通知超过模块缓存数，最早的消息可能已被覆盖
+    uint16_t last_batch;               // 最近一次读到的消息数
+    uint16_t max_batch;
+    unsigned long last_residency_ms;   // 消息在模块中的停留时间：从通知到读出
+    unsigned long avg_residency_ms;
+    unsigned long max_residency_ms;
+};
+
+// 下行消息槽位：主题和负载指向预分配的定长缓冲区
+struct MQTTInboundSlot {
+    char* topic;
+    uint8_t* payload;
+    size_t topic_len;
+    size_t payload_len;
+    unsigned long timestamp;
+};
+
 // MQTT连接参数
 struct Air780EGMQTTConfig {
     String server;
@@ -40,26 +153,110 @@ struct Air780EGMQTTConfig {
     bool will_retain = false;
 };
 
+// 异步发布结果
+enum MQTTPublishResult {
+    MQTT_PUBLISH_OK = 0,
+    MQTT_PUBLISH_ERROR = 1,
+    MQTT_PUBLISH_TIMEOUT = 2
+};
+
 // MQTT回调函数类型
 typedef void (*MQTTMessageCallback)(const String& topic, const String& payload);
 typedef void (*MQTTConnectionCallback)(bool connected);
+// 异步发布完成回调：发布句柄、结果、从调用 publishAsync 到模块应答的耗时
+typedef void (*MQTTPublishCallback)(uint16_t publish_id, MQTTPublishResult result, unsigned long latency_ms);
 
 // 定时任务回调函数类型 - 返回要发布的JSON数据
 typedef String (*ScheduledTaskCallback)(void);
+// 零分配定时任务回调：把负载直接写入任务自带的 buffer（容量 size），返回写入字节数，0表示本周期不发布。
+// 回调中可以移除自己的任务，buffer 在回调返回后才释放，本周期不再发布
+typedef size_t (*ScheduledTaskWriter)(uint8_t* buffer, size_t size, void* context);
+
+// 异步发布槽位（AT命令完成回调的上下文）
+struct MQTTPendingPublish {
+    class Air780EGMQTT* owner;
+    uint16_t id;                     // 0表示空闲
+    MQTTPublishCallback callback;
+    uint8_t* task_buffer;            // 零分配定时任务的缓冲区（发送完成前不能改写）
+    bool release_buffer;             // 任务已移除，完成后释放 task_buffer
+    // QoS1 在途窗口
+    uint8_t qos;
+    uint8_t attempts;                // 已发送次数
+    bool waiting;                    // 等待窗口空位（首次发送或重传）
+    bool awaiting_ack;               // 模块已应答OK，等待确认URC
+    uint32_t sequence;               // 发布顺序，按此发送和确认
+    unsigned long queued_at;         // 调用发布的时间，确认耗时从这里算起
+    unsigned long sent_at;           // 最近一次发送的时间，用于确认超时
+    const char* send_prefix;         // 重传用的命令前缀和负载：指向 prefix/body 或任务缓冲区
+    const uint8_t* send_payload;
+    size_t send_len;
+    String prefix;                   // QoS1 字符串发布的副本，容量保留复用
+    String body;
+};
+
+// QoS1 在途窗口统计
+struct MQTTQoS1Stats {
+    uint32_t published;          // 进入窗口的QoS1发布
+    uint32_t acked;
+    uint32_t retransmits;        // 确认超时或出错后的重发次数
+    uint32_t failed;             // 达到最大发送次数仍未确认
+    unsigned long last_ack_ms;   // 从发布到确认的耗时
+    unsigned long avg_ack_ms;
+    unsigned long max_ack_ms;
+    uint8_t inflight;            // 已发送未确认
+    uint8_t max_inflight;
+};
+
+// 定时任务错过执行时间（主循环阻塞、断网）后的处理方式
+enum ScheduledTaskMissPolicy {
+    TASK_MISS_SKIP = 0,      // 只执行一次，跳过错过的周期，保持原有相位
+    TASK_MISS_CATCH_UP = 1   // 每次 loop() 补执行一个错过的周期，直到追上时间线
+                             // （零分配任务上一次的负载仍在发送时，补的周期计为跳过）
+};
+
+// 定时任务执行统计
+struct ScheduledTaskStats {
+    uint32_t runs;              // 执行次数
+    uint32_t skipped;           // 按 TASK_MISS_SKIP 跳过的周期数
+    unsigned long avg_late_ms;  // 实际执行时间相对计划时间的平均延迟
+    unsigned long max_late_ms;
+    unsigned long avg_jitter_ms; // 相邻两次执行间隔与设定间隔之差的平均绝对值
+    unsigned long max_jitter_ms;
+};
 
 // 定时任务结构
 struct ScheduledTask {
     String topic;                    // 发布主题
     ScheduledTaskCallback callback;  // 数据生成回调函数
+    ScheduledTaskWriter writer;      // 零分配回调（与 callback 二选一）
+    void* writer_context;
+    uint8_t* buffer;                 // writer 的负载缓冲区，后面紧跟命令前缀缓冲区
+    size_t buffer_size;
+    size_t command_size;
     unsigned long interval_ms;       // 执行间隔（毫秒）
     unsigned long last_execution;    // 上次执行时间
     int qos;                        // QoS等级
     bool retain;                    // 保留消息标志
     bool enabled;                   // 任务是否启用
     String task_name;               // 任务名称（用于调试）
+    uint8_t priority;               // 离线队列中的优先级
+    unsigned long next_due;         // 下次计划执行时间（堆排序键），按间隔累加，不随执行延迟漂移
+    int heap_pos;                   // 在到期堆中的位置，-1表示未启用
+    unsigned long phase_ms;         // 首次执行相对添加时间的偏移
+    uint8_t miss_policy;            // ScheduledTaskMissPolicy
+    // 统计
+    uint32_t run_count;
+    uint32_t skipped_count;
+    uint32_t jitter_samples;
+    uint32_t total_late_ms;
+    uint32_t max_late_ms;
+    uint32_t total_jitter_ms;
+    uint32_t max_jitter_ms;
 };
 
 class Air780EGMQTT {
+    friend struct Air780EGHostTest; // 主机测试（test/）直接调用解析函数
+
 private:
     static const char* TAG;
     Air780EGGNSS* gnss;
@@ -70,39 +267,229 @@ private:
     // 回调函数
     MQTTMessageCallback message_callback;
     MQTTConnectionCallback connection_callback;
+
+    // TLS：SSL上下文88的证书和参数
+    Air780EGTLS tls;
     
-    // 状态管理
-    unsigned long last_reconnect_attempt = 0;
-    unsigned long reconnect_interval = 5000; // 重连间隔
+    // 重连：失败后按阶段和连续失败次数指数退避（带抖动），成功后恢复订阅
+    unsigned long reconnect_interval = 5000;       // 退避基数
+    unsigned long reconnect_max_interval = 300000; // 退避上限
+    int max_reconnect_attempts = 0;                // 连续失败上限，0 表示不限
+    unsigned long next_reconnect_at = 0;
+    int network_check_retries = 8;                 // connect() 的附着检查次数，-1 跳过网络检查
+    MQTTConnectStage connect_stage = MQTT_STAGE_NONE;
+    MQTTReconnectStats reconnect_stats = MQTTReconnectStats();
+    unsigned long link_up_at = 0;
+    int resubscribe_total = 0;                     // 本次需要恢复的订阅数
+    int resubscribe_queued = 0;
+    int resubscribe_done = 0;                      // 已收到 SUBACK 或失败
+    int resubscribe_cursor = 0;
+
+    // 连接流程：异步命令回调依次推进，connect_stage 为进行中的步骤
+    bool connect_pending = false;
+    bool connect_is_reconnect = false;
+    bool connect_used_ip = false;
+    unsigned long connect_started = 0;
+    unsigned long registration_cache_ms = 60000;   // 网络检查结果的有效期
+    MQTTConnectStats connect_stats = MQTTConnectStats();
+    static const int CONNECT_TIME_SAMPLES = 16;
+    unsigned long connect_times[CONNECT_TIME_SAMPLES];
+    int connect_time_count = 0;
+    int connect_time_next = 0;
+
+    // 服务器地址缓存：AT+CDNSGIP 在连接成功后后台解析，有效期内 AT+MIPSTART 直接用IP
+    String broker_ip;
+    unsigned long broker_ip_at = 0;
+    unsigned long dns_ttl_ms = 3600000;
+    bool dns_lookup_pending = false;
+
+    // 持久会话（clean_session = false）：服务器保留订阅时不重新订阅
+    bool session_present = false;
+    bool session_established = false;              // 本次上电已用当前客户端ID建立过持久会话
+    unsigned long session_expiry_ms = 0;           // 固件不报告会话标志时，断开多久以内认为会话仍在
+    unsigned long link_lost_at = 0;
     
-    // 消息缓存
-    static const int MAX_CACHED_MESSAGES = 10;
-    Air780EGMQTTMessage message_cache[MAX_CACHED_MESSAGES];
-    int cache_head = 0;
-    int cache_tail = 0;
-    int cached_message_count = 0;
+    // 连接状态：断开由模块上报驱动，AT+MQTTSTATU 只作低频校验，有收发流量时逐步放宽间隔
+    unsigned long status_check_base = 60000;
+    unsigned long status_check_max = 600000;
+    unsigned long status_check_interval = 60000;
+    unsigned long last_status_check = 0;
+    bool link_activity = false;        // 上次校验后有发布成功或收到消息
+    bool status_poll_pending = false;
+    MQTTLinkStats link_stats = MQTTLinkStats();
     
-    // 订阅主题管理
-    static const int MAX_SUBSCRIPTIONS = 20;
-    String subscriptions[MAX_SUBSCRIPTIONS];
-    int subscription_qos[MAX_SUBSCRIPTIONS];
-    int subscription_count = 0;
+    // 下行消息环形队列：收到 +MSUB 时只复制到预分配槽位，由 loop() 交付给回调
+    static const int DEFAULT_INBOUND_SLOTS = 8;
+    static const size_t DEFAULT_INBOUND_TOPIC_SIZE = 96;
+    static const size_t DEFAULT_INBOUND_PAYLOAD_SIZE = 512;
+    MQTTInboundSlot* inbound_slots = nullptr;
+    uint8_t* inbound_data = nullptr;
+    int inbound_capacity = 0;
+    size_t inbound_topic_size = 0;
+    size_t inbound_payload_size = 0;
+    int inbound_head = 0;
+    int inbound_count = 0;
+    MQTTInboundOverflowPolicy inbound_policy = MQTT_INBOUND_DROP_OLDEST;
+    MQTTInboundStats inbound_stats = MQTTInboundStats();
+    uint8_t* inbound_large = nullptr;     // 超过槽位大小的消息：按 +MSUB 头部长度分配，只增不减
+    size_t inbound_large_size = 0;
+    bool inbound_large_busy = false;      // 同一时间只保存一条大消息
+    bool inbound_direct = false;          // +MSUB 数据正由Core直接写入下一个空闲槽位
+    size_t inbound_direct_len = 0;
+    bool inbound_delivering = false;      // 主题处理器正在读取队首槽位
+    // 模块缓存模式：收到通知后择机用 AT+MQTTMSGGET 一次读出，读出的 +MSUB 行照常进入下行队列
+    static const int MODULE_MESSAGE_SLOTS = 4;         // 模块缓存的消息数，超过时覆盖最早的
+    MQTTReceiveMode receive_mode = MQTT_RECEIVE_URC;
+    unsigned long drain_delay = 1000;
+    unsigned long notify_times[MODULE_MESSAGE_SLOTS];  // 未读通知的到达时间，按到达顺序
+    int notify_head = 0;
+    int notify_count = 0;
+    bool drain_pending = false;
+    bool drain_requested = false;      // 连接后或读取失败后需要读取一次
+    unsigned long drain_started_at = 0;
+    uint16_t drain_batch = 0;
+    MQTTDrainStats drain_stats = MQTTDrainStats();
+    unsigned long long drain_residency_total_ms = 0;
+    uint32_t drain_residency_samples = 0;
+    String delivery_topic;                // 交付给全局回调时复用，容量保留
+    String delivery_payload;
+    bool urc_handlers_registered = false;
     
-    // 定时任务管理
-    static const int MAX_SCHEDULED_TASKS = 10;
-    ScheduledTask scheduled_tasks[MAX_SCHEDULED_TASKS];
+    // 订阅主题和按过滤器注册的处理器
+    Air780EGTopicTrie topic_trie;
+    
+    // 发布负载模式
+    MQTTPayloadMode preferred_payload_mode = MQTT_PAYLOAD_AUTO;
+    MQTTPayloadMode payload_mode = MQTT_PAYLOAD_HEX;
+    
+    // 负载压缩
+    bool compression_enabled = false;
+    size_t compression_min_size = 64;
+    
+    // 异步发布管理
+    static const int MAX_PENDING_PUBLISHES = 8;
+    MQTTPendingPublish pending_publishes[MAX_PENDING_PUBLISHES];
+    int pending_publish_count = 0;
+    uint16_t next_publish_id = 1;
+    
+    // QoS1 在途窗口：已发送未确认的QoS1发布不超过 qos1_window，其余按发布顺序等待
+    int qos1_window = 4;
+    int qos1_inflight = 0;
+    unsigned long qos1_ack_timeout = 10000;
+    int qos1_max_attempts = 3;
+    uint32_t next_publish_sequence = 0;
+    char ack_urc_prefix[24] = "";    // Core 保存的是指针，修改前缀只改写内容
+    bool ack_by_urc = false;
+    bool ack_urc_registered = false;
+    MQTTQoS1Stats qos1_stats = MQTTQoS1Stats();
+    unsigned long long qos1_ack_total_ms = 0;
+    
+    // 定时任务管理：任务连续存放，按下次执行时间组成最小堆
+    static const int DEFAULT_MAX_SCHEDULED_TASKS = 10;
+    ScheduledTask* scheduled_tasks = nullptr;
+    int* task_heap = nullptr;        // 元素为任务下标，堆顶最先到期
+    int max_scheduled_tasks = 0;
     int scheduled_task_count = 0;
+    int task_heap_count = 0;
+    bool task_phase_spread = true;
+    uint32_t tasks_added = 0;        // 用于自动分配相位
+    uint8_t* writer_buffer = nullptr;    // 正在执行的 writer 的缓冲区
+    bool writer_buffer_released = false; // writer 中移除了自己的任务，返回后再释放缓冲区
+    
+    // 离线队列：断开期间的发布写入Flash，重连后补发
+    Air780EGOutbox* outbox = nullptr;
+    uint16_t outbox_publish_id = 0;  // 正在补发的发布句柄
+    uint32_t outbox_ticket = 0;
+    uint32_t outbox_store_failures = 0;
     
     // 内部方法
     bool waitForURC(const String& urc_prefix, String& response, unsigned long timeout = 10000);
     void handleMQTTURC(const String& urc);
-    void parseMQTTMessage(const String& message);  // 解析MQTT消息
-    String fromHexString(const String& hex);       // HEX转字符串
-    bool isHexString(const String& str);           // 检查是否为HEX字符串
+    static void onURC(const String& urc, void* context);
+    static long onMSUBFrameLength(const String& header, void* context);
+    static uint8_t* onMSUBFrameBuffer(const String& header, size_t length, void* context);
+    static void onLinkClosedURC(const String& urc, void* context);
+    static void onStatusResponse(ATCommandResult result, const String& response,
+                                 unsigned long latency_ms, void* context);
+    static int parseStatusResponse(const String& response);
+    void checkConnectionStatus();
+    bool startConnect();
+    void sendIPStart();
+    void sendConnect();
+    void finishConnect(MQTTConnectStage failed_stage, bool resumed);
+    void recordConnectTime(unsigned long elapsed_ms);
+    static void onConnectStep(ATCommandResult result, const String& response,
+                              unsigned long latency_ms, void* context);
+    static bool isIPAddress(const String& host);
+    bool hasCachedBrokerIP() const;
+    void refreshBrokerIP();
+    static void onDNSResponse(ATCommandResult result, const String& response,
+                              unsigned long latency_ms, void* context);
+    static String parseDNSResponse(const String& response);
+    void processReconnect();
+    void onReconnectResult(bool ok, unsigned long elapsed_ms);
+    unsigned long reconnectDelay(MQTTConnectStage stage) const;
+    void resubscribeAll();
+    bool ensureClientId();
+    bool resolveSessionPresent(const String& connack_response) const;
+    static int parseSessionPresent(const String& response);
+    void queueResubscriptions();
+    void onResubscribeDone(bool ok);
+    static void queueResubscription(const char* filter, int qos, void* context);
+    static void onResubscribeResponse(ATCommandResult result, const String& response,
+                                      unsigned long latency_ms, void* context);
+    static void onSubackURC(const String& urc, void* context);
+    void onLinkUp(bool resumed);
+    void onLinkLost(const char* reason);
+    void releaseLargePayload(MQTTInboundSlot& slot);
+    MQTTInboundSlot* reserveInboundSlot();
+    void popInboundMessage(String& topic, String& payload);
+    void dropInboundHead();
+    void growLargePayload(size_t payload_len);
+    void updateInboundPause();
+    void onMessageNotify();
+    void onMessageDrained();
+    void processReceiveBuffer();
+    bool startDrain(bool after_publish);
+    static void onDrainResponse(ATCommandResult result, const String& response,
+                                unsigned long latency_ms, void* context);
+    bool parseMQTTMessage(const String& message);  // 解析 +MSUB 并放入下行队列
     void processMessageCache();
     void processScheduledTasks();  // 处理定时任务
+    int findScheduledTask(const String& task_name) const;
+    bool taskDueBefore(int a, int b) const;
+    void heapSwap(int a, int b);
+    void heapSiftUp(int pos);
+    void heapSiftDown(int pos);
+    void heapInsert(int task_index);
+    void heapRemove(int task_index);
+    void heapUpdate(int task_index);
+    void drainOutbox();            // 按设定速率补发离线消息
+    bool storeOffline(const String& topic, const String& payload, int qos, bool retain, uint8_t priority);
     bool reconnect();
-    String toHexString(const String& input);
+    MQTTPayloadMode detectPayloadMode();
+    bool canPublishPayload(const char* payload, size_t len) const;
+    MQTTPendingPublish* findFreePublishSlot();
+    uint16_t allocatePublishId();
+    int addScheduledTaskEntry(const String& task_name, const String& topic, unsigned long interval_ms,
+                              int qos, bool retain);
+    void runScheduledWriter(int index, bool offline);
+    uint16_t publishTaskBuffer(ScheduledTask& task, size_t len);
+    void releaseTaskBuffer(ScheduledTask& task);
+    String buildPublishPrefix(const String& topic, int qos, bool retain, size_t payload_len);
+    ATPayloadEncoding publishEncoding() const;
+    const char* publishSuffix() const;
+    const String& packPayload(const String& payload, String& packed);
+    static void onPublishComplete(ATCommandResult result, const String& response,
+                                  unsigned long latency_ms, void* context);
+    void finishPublish(MQTTPendingPublish* slot, MQTTPublishResult result, unsigned long latency_ms);
+    void queueQoS1Publish(MQTTPendingPublish* slot, int qos, const char* prefix,
+                          const uint8_t* payload, size_t len);
+    void sendWaitingPublishes();
+    void checkPublishAckTimeouts();
+    void ackPublish(MQTTPendingPublish* slot);
+    void retryPublish(MQTTPendingPublish* slot, MQTTPublishResult result);
+    static void onPublishAckURC(const String& urc, void* context);
     
 public:
     Air780EGMQTT(Air780EGCore* core_instance, Air780EGGNSS* gnss_instance);
@@ -124,31 +511,100 @@ public:
     
     // SSL/TLS支持
     bool enableSSL(bool enable = true);
+    // 证书为PEM文本：只有CA时认证服务器，同时有客户端证书和密钥时双向认证，都为空时不认证。
+    // 证书在连接时写入模块文件系统，文件名带内容哈希，模块上已有相同文件时不再上传
     bool setSSLConfig(const String& ca_cert = "", const String& client_cert = "", const String& client_key = "");
+    Air780EGTLS& getTLS();                        // TLS版本、证书有效期检查等选项
+    Air780EGTLSStats getTLSStats() const;         // 证书上传/复用次数，首次与之后的握手耗时
     
-    // 发布消息
+    // 发布消息（同步，模块应答OK即返回；QoS1 需要确认和重传时用 publishAsync()）
     bool publish(const String& topic, const String& payload, int qos = 0, bool retain = false);
+    bool publish(const String& topic, const uint8_t* payload, size_t length, int qos = 0, bool retain = false);
     bool publishJSON(const String& topic, const String& json, int qos = 0);
     
+    // 发布负载模式：在 init()/begin() 之前设置，AUTO 为自动选择最快的可用模式
+    void setPayloadMode(MQTTPayloadMode mode);
+    MQTTPayloadMode getPayloadMode() const;
+    
+    // 负载压缩：不小于 min_size 的负载压缩后发送（压缩后不更小则发送原文），
+    // 服务端按首字节 0xA8 识别并解压；文本负载模式不能发送二进制数据，不压缩
+    bool setCompression(bool enable, size_t min_size = 64);
+    bool isCompressionEnabled() const;
+    
+    // 异步发布：放入发送队列后立即返回发布句柄（失败或队列已满返回0），
+    // 由 loop() 驱动发送，模块应答后通过回调报告结果和耗时。
+    // 注意：未设置 setPublishAckURC() 时，QoS1 的 MQTT_PUBLISH_OK 只表示模块已接受发布命令，
+    // 不代表已收到服务器的PUBACK；重传只覆盖模块应答ERROR或超时的情况
+    uint16_t publishAsync(const String& topic, const String& payload, int qos = 0, bool retain = false,
+                          MQTTPublishCallback callback = nullptr);
+    int getPendingPublishCount() const;
+    
+    // QoS1 在途窗口：同时已发送未确认的QoS1发布数（1~8，默认4），超出的按发布顺序等待；
+    // 窗口为1时严格按顺序送达，大于1时重传的消息可能晚于后发的消息
+    bool setQoS1Window(int size);
+    int getQoS1Window() const;
+    // 确认超时（默认10秒）和最大发送次数（含首次，默认3），超过后以 MQTT_PUBLISH_TIMEOUT 报告
+    void setQoS1Retry(unsigned long ack_timeout_ms, int max_attempts);
+    // 确认来源：默认模块对发布命令应答OK即视为确认；设置URC前缀后OK只表示已交给模块，
+    // 收到该URC时确认最早发送的在途消息（模块不上报报文ID，按发送顺序对应）。空字符串恢复默认。
+    // 注意：确认超时后重传的消息，第一次发送的确认如果迟到，会被当作当时最早在途消息的确认，
+    // 可能提前完成另一条消息，之后重传的确认也会依次错位；确认超时应大于最坏情况下的确认往返
+    bool setPublishAckURC(const String& prefix);
+    // 回调中的 latency_ms 对QoS1为从发布到确认的耗时（含等待窗口和重传）
+    MQTTQoS1Stats getQoS1Stats() const;
+    void resetQoS1Stats();
+    
+    // 离线队列：设置后，断开期间 publish() 写入队列并返回是否写入成功，publishAsync() 写入队列并返回0，
+    // 定时任务照常执行并写入队列；重连后由 loop() 按队列的补发速率发出
+    void setOutbox(Air780EGOutbox* queue);
+    Air780EGOutbox* getOutbox() const;
+    uint32_t getOutboxStoreFailures() const;   // 离线时写入队列失败的消息数（已记录警告）
+    
     // 定时任务管理
     bool addScheduledTask(const String& task_name, const String& topic, 
                          ScheduledTaskCallback callback, unsigned long interval_ms, 
                          int qos = 0, bool retain = false);
+    // 零分配形式：添加时分配一次 buffer_size 字节的负载缓冲区，之后 writer 直接写入，
+    // 负载按引用交给Core流式编码发送，每次发布不再分配堆内存（离线写入队列时除外）
+    bool addScheduledTask(const String& task_name, const String& topic,
+                         ScheduledTaskWriter writer, void* context, size_t buffer_size,
+                         unsigned long interval_ms, int qos = 0, bool retain = false);
     bool removeScheduledTask(const String& task_name);
     bool enableScheduledTask(const String& task_name, bool enabled = true);
     bool disableScheduledTask(const String& task_name);
     int getScheduledTaskCount() const;
     String getScheduledTaskInfo(int index) const;
     void clearAllScheduledTasks();
+    bool setScheduledTaskPriority(const String& task_name, uint8_t priority);
+    // 原地修改执行间隔，从上次执行时间起按新间隔计算下次执行
+    bool setScheduledTaskInterval(const String& task_name, unsigned long interval_ms);
+    // 错过执行时间后的处理方式（默认 TASK_MISS_SKIP）
+    bool setScheduledTaskMissPolicy(const String& task_name, ScheduledTaskMissPolicy policy);
+    // 相位：首次执行在添加后 phase_ms 毫秒，之后每 interval 执行一次。
+    // 默认自动错开各任务的相位，避免相同间隔的任务在同一次 loop() 中集中发布
+    bool setScheduledTaskPhase(const String& task_name, unsigned long phase_ms);
+    void setScheduledTaskPhaseSpread(bool enable);
+    bool getScheduledTaskStats(const String& task_name, ScheduledTaskStats& stats) const;
+    void resetScheduledTaskStats();
+    // 任务容量（默认10），不能小于当前任务数
+    bool setMaxScheduledTasks(int capacity);
+    int getMaxScheduledTasks() const;
+    // 距离下一个任务到期的毫秒数（已到期返回0，没有启用的任务返回 ULONG_MAX），主循环可据此休眠
+    unsigned long getTimeUntilNextTask() const;
     
     // 订阅管理
     bool subscribe(const String& topic, int qos = 0);
-    bool unsubscribe(const String& topic);
+    // 订阅并为该过滤器注册处理器，订阅失败时不保留处理器
+    bool subscribe(const String& filter, int qos, MQTTTopicHandler handler, void* context = nullptr);
+    bool unsubscribe(const String& topic);  // 同时移除该过滤器的处理器
+    // 只注册处理器不发送订阅（例如由更宽的订阅覆盖的子主题），同一过滤器再次注册时替换
+    bool addTopicHandler(const String& filter, MQTTTopicHandler handler, void* context = nullptr);
+    bool removeTopicHandler(const String& filter);
     bool isSubscribed(const String& topic) const;
     int getSubscriptionCount() const;
     String getSubscription(int index) const;
     
-    // 回调函数设置
+    // 回调函数设置（没有匹配的主题处理器时调用）
     void setMessageCallback(MQTTMessageCallback callback);
     void setConnectionCallback(MQTTConnectionCallback callback);
     
@@ -163,11 +619,51 @@ public:
     bool hasMessages() const;
     Air780EGMQTTMessage getNextMessage();
     void clearMessageCache();
+    // 下行消息队列：slots 个槽位，每个槽位保存不超过 topic_size / payload_size 字节，一次分配
+    bool setInboundQueue(int slots, size_t topic_size, size_t payload_size);
+    void setInboundOverflowPolicy(MQTTInboundOverflowPolicy policy);
+    MQTTInboundStats getInboundStats() const;
+    void resetInboundStats();
+    
+    // 接收方式：在 init()/begin() 之前设置。缓存模式下消息不再夹在命令响应之间上报，
+    // 收到通知后在发布完成时顺带读取，否则最多等 max_delay_ms 后读取（模块缓存满4条时立即读取），
+    // 一次读出全部缓存的消息；下行队列使用 PAUSE 策略且已满时暂不读取，消息留在模块中
+    void setReceiveMode(MQTTReceiveMode mode, unsigned long max_delay_ms = 1000);
+    MQTTReceiveMode getReceiveMode() const;
+    bool drainMessages();                         // 立即读取模块缓存（缓存模式）
+    MQTTDrainStats getDrainStats() const;         // 每次读取的消息数、消息在模块中的停留时间
+    void resetDrainStats();
+    
+    // 连接状态校验：断开由模块上报（CLOSED）立即发现，AT+MQTTSTATU 每 interval_ms 异步校验一次；
+    // 到期时若已有发布成功或收到消息则跳过查询并把间隔加倍，最长 max_interval_ms
+    void setStatusCheckInterval(unsigned long interval_ms, unsigned long max_interval_ms = 600000);
+    MQTTLinkStats getLinkStats() const;
     
     // 配置方法
     void setKeepAlive(int seconds);
+    // clean = false 时使用持久会话：连接时 AT+MCONNECT=0,<keepalive>，服务器保留了会话则不恢复订阅。
+    // 客户端ID为空时按 IMEI 生成 "Air780EG_<IMEI>"，重启后不变，服务器才能找回会话
+    void setCleanSession(bool clean);
+    // 固件不报告会话标志时，断开不超过 expiry_ms 视为会话仍在（应不大于服务器的会话保留时间）；
+    // 0（默认）表示无法确认时总是重新订阅
+    void setSessionExpiry(unsigned long expiry_ms);
+    bool isSessionPresent() const;
+    String getClientId() const;
+    // 自动重连：失败后等待 interval_ms * 2^(连续失败次数-1)，不超过 max_interval_ms，
+    // 实际等待在 [一半, 全部] 之间随机；CONNACK 阶段失败（服务器拒绝）退避基数再乘4。
+    // 连接断开后的第一次重连立即进行，且不做阻塞的网络检查
     void setReconnectInterval(unsigned long interval_ms);
-    void setMaxReconnectAttempts(int attempts);
+    void setReconnectBackoff(unsigned long interval_ms, unsigned long max_interval_ms);
+    void setMaxReconnectAttempts(int attempts);  // 连续失败达到次数后停止自动重连，0 表示不限
+    MQTTReconnectStats getReconnectStats() const;
+
+    // 连接加速：网络检查在 ttl_ms 内通过过则跳过；服务器域名在连接成功后用 AT+CDNSGIP 解析并缓存，
+    // 有效期内直接按IP连接（连接失败时丢弃缓存，改用域名）；ttl_ms 为0关闭
+    void setRegistrationCacheTTL(unsigned long ttl_ms);
+    void setDNSCacheTTL(unsigned long ttl_ms);
+    String getBrokerIP() const;                   // 缓存的服务器IP，无缓存时为空
+    MQTTConnectStats getConnectStats() const;     // 每次连接耗时，median_ms 为最近16次的中位数
+    MQTTConnectStage getLastConnectStage() const;
     
     // 调试方法
     void enableDebug(bool enable = true);
@@ -16,6 +16,8 @@ Air780EGNetwork::Air780EGNetwork(Air780EGCore* core_instance) : core(core_instan
 }
 
 bool Air780EGNetwork::enableNetwork() {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_NETWORK);
+    AIR780EG_STALL_SCOPE("Network::enableNetwork");
     if (!core || !core->isInitialized()) {
         AIR780EG_LOGE(TAG, "Core not initialized");
         return false;
@@ -65,6 +67,8 @@ bool Air780EGNetwork::disableNetwork() {
 }
 
 void Air780EGNetwork::loop() {
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_NETWORK);
+    AIR780EG_STALL_SCOPE("Network::loop");
     if (!network_enabled || !core || !core->isInitialized()) {
         return;
     }
@@ -0,0 +1,791 @@
+#include "Air780EGOutbox.h"
+#include "Air780EGDebug.h"
+
+const char *Air780EGOutbox::TAG = "Outbox";
+
+#define OUTBOX_MAGIC 0xA7
+#define OUTBOX_LIVE 0xFF
+#define OUTBOX_DELETED 0x00
+
+// ==================== 文件存储 ====================
+
+#ifdef ESP32
+Air780EGOutboxFile::Air780EGOutboxFile(fs::FS &filesystem, const char *file_path)
+    : fs(filesystem), path(file_path), tmp_path(String(file_path) + ".tmp")
+{
+}
+
+Air780EGOutboxFile::~Air780EGOutboxFile()
+{
+    closeAppend();
+}
+
+void Air780EGOutboxFile::closeAppend()
+{
+    if (append_file)
+    {
+        append_file.close();
+    }
+}
+
+size_t Air780EGOutboxFile::size()
+{
+    closeAppend();
+    if (!fs.exists(path))
+    {
+        return 0;
+    }
+    File f = fs.open(path, "r");
+    if (!f)
+    {
+        return 0;
+    }
+    size_t s = f.size();
+    f.close();
+    return s;
+}
+
+bool Air780EGOutboxFile::read(size_t offset, uint8_t *buffer, size_t len)
+{
+    closeAppend();
+    File f = fs.open(path, "r");
+    if (!f)
+    {
+        return false;
+    }
+    bool ok = f.seek(offset) && f.read(buffer, len) == len;
+    f.close();
+    return ok;
+}
+
+bool Air780EGOutboxFile::append(const uint8_t *data, size_t len)
+{
+    if (!append_file)
+    {
+        append_file = fs.open(path, "a");
+        if (!append_file)
+        {
+            return false;
+        }
+    }
+    return append_file.write(data, len) == len;
+}
+
+void Air780EGOutboxFile::sync()
+{
+    if (append_file)
+    {
+        append_file.flush();
+    }
+}
+
+bool Air780EGOutboxFile::patch(size_t offset, uint8_t value)
+{
+    closeAppend();
+    File f = fs.open(path, "r+");
+    if (!f)
+    {
+        return false;
+    }
+    bool ok = f.seek(offset) && f.write(&value, 1) == 1;
+    f.close();
+    return ok;
+}
+
+bool Air780EGOutboxFile::clear()
+{
+    closeAppend();
+    return !fs.exists(path) || fs.remove(path);
+}
+
+bool Air780EGOutboxFile::rewriteBegin()
+{
+    closeAppend();
+    rewrite_file = fs.open(tmp_path, "w");
+    return (bool)rewrite_file;
+}
+
+bool Air780EGOutboxFile::rewriteAppend(const uint8_t *data, size_t len)
+{
+    return rewrite_file && rewrite_file.write(data, len) == len;
+}
+
+// LittleFS 的 rename 直接原子替换原日志；不支持覆盖的文件系统（SPIFFS）先删除原日志，
+// 此时断电只剩完整的临时文件，由 recover() 改名恢复
+bool Air780EGOutboxFile::rewriteCommit()
+{
+    if (!rewrite_file)
+    {
+        return false;
+    }
+    rewrite_file.close();
+    if (fs.rename(tmp_path, path))
+    {
+        return true;
+    }
+    if (!fs.remove(path))
+    {
+        fs.remove(tmp_path);
+        return false;
+    }
+    // 原日志已删除：改名失败时保留临时文件，下次 begin() 恢复
+    return fs.rename(tmp_path, path);
+}
+
+void Air780EGOutboxFile::rewriteAbort()
+{
+    if (rewrite_file)
+    {
+        rewrite_file.close();
+    }
+    fs.remove(tmp_path);
+}
+
+// 原日志还在时临时文件是未完成的压缩，删除；原日志不在时临时文件是已写完的压缩结果
+void Air780EGOutboxFile::recover()
+{
+    if (!fs.exists(tmp_path))
+    {
+        return;
+    }
+    if (fs.exists(path))
+    {
+        fs.remove(tmp_path);
+    }
+    else
+    {
+        fs.rename(tmp_path, path);
+    }
+}
+
+#else
+// 主机端：标准文件代替Flash文件系统，便于在PC上验证队列行为
+
+Air780EGOutboxFile::Air780EGOutboxFile(const char *file_path)
+    : path(file_path), tmp_path(String(file_path) + ".tmp")
+{
+}
+
+Air780EGOutboxFile::~Air780EGOutboxFile()
+{
+    closeAppend();
+    if (rewrite_file)
+    {
+        fclose(rewrite_file);
+    }
+}
+
+void Air780EGOutboxFile::closeAppend()
+{
+    if (append_file)
+    {
+        fclose(append_file);
+        append_file = nullptr;
+    }
+}
+
+size_t Air780EGOutboxFile::size()
+{
+    closeAppend();
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+    {
+        return 0;
+    }
+    fseek(f, 0, SEEK_END);
+    long s = ftell(f);
+    fclose(f);
+    return s > 0 ? (size_t)s : 0;
+}
+
+bool Air780EGOutboxFile::read(size_t offset, uint8_t *buffer, size_t len)
+{
+    closeAppend();
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+    {
+        return false;
+    }
+    bool ok = fseek(f, (long)offset, SEEK_SET) == 0 && fread(buffer, 1, len, f) == len;
+    fclose(f);
+    return ok;
+}
+
+bool Air780EGOutboxFile::append(const uint8_t *data, size_t len)
+{
+    if (!append_file)
+    {
+        append_file = fopen(path.c_str(), "ab");
+        if (!append_file)
+        {
+            return false;
+        }
+    }
+    return fwrite(data, 1, len, append_file) == len;
+}
+
+void Air780EGOutboxFile::sync()
+{
+    if (append_file)
+    {
+        fflush(append_file);
+    }
+}
+
+bool Air780EGOutboxFile::patch(size_t offset, uint8_t value)
+{
+    closeAppend();
+    FILE *f = fopen(path.c_str(), "r+b");
+    if (!f)
+    {
+        return false;
+    }
+    bool ok = fseek(f, (long)offset, SEEK_SET) == 0 && fputc(value, f) != EOF;
+    fclose(f);
+    return ok;
+}
+
+bool Air780EGOutboxFile::clear()
+{
+    closeAppend();
+    ::remove(path.c_str());
+    return true;
+}
+
+bool Air780EGOutboxFile::rewriteBegin()
+{
+    closeAppend();
+    rewrite_file = fopen(tmp_path.c_str(), "wb");
+    return rewrite_file != nullptr;
+}
+
+bool Air780EGOutboxFile::rewriteAppend(const uint8_t *data, size_t len)
+{
+    return rewrite_file && fwrite(data, 1, len, rewrite_file) == len;
+}
+
+bool Air780EGOutboxFile::rewriteCommit()
+{
+    if (!rewrite_file)
+    {
+        return false;
+    }
+    fclose(rewrite_file);
+    rewrite_file = nullptr;
+    // rename 原子替换原日志，失败时原日志不变
+    if (rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        ::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void Air780EGOutboxFile::rewriteAbort()
+{
+    if (rewrite_file)
+    {
+        fclose(rewrite_file);
+        rewrite_file = nullptr;
+    }
+    ::remove(tmp_path.c_str());
+}
+
+void Air780EGOutboxFile::recover()
+{
+    FILE *tmp = fopen(tmp_path.c_str(), "rb");
+    if (!tmp)
+    {
+        return;
+    }
+    fclose(tmp);
+    FILE *log = fopen(path.c_str(), "rb");
+    if (log)
+    {
+        fclose(log);
+        ::remove(tmp_path.c_str());
+    }
+    else
+    {
+        rename(tmp_path.c_str(), path.c_str());
+    }
+}
+#endif
+
+// ==================== 离线队列 ====================
+
+Air780EGOutbox::Air780EGOutbox()
+{
+    resetStats();
+}
+
+Air780EGOutbox::~Air780EGOutbox()
+{
+    end();
+}
+
+bool Air780EGOutbox::begin(Air780EGOutboxStorage *log_storage, size_t max_log_bytes, size_t max_messages)
+{
+    end();
+    if (!log_storage || max_messages == 0 || max_log_bytes <= AIR780EG_OUTBOX_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    entries = (Entry *)malloc(max_messages * sizeof(Entry));
+    if (!entries)
+    {
+        AIR780EG_LOGE(TAG, "Failed to allocate index for %u messages", (unsigned)max_messages);
+        return false;
+    }
+    storage = log_storage;
+    max_entries = max_messages;
+    max_bytes = max_log_bytes;
+
+    storage->recover();
+    if (!scan())
+    {
+        AIR780EG_LOGW(TAG, "Outbox log unreadable, starting empty");
+        storage->clear();
+        entry_count = 0;
+        file_bytes = 0;
+        live_bytes = 0;
+    }
+    AIR780EG_LOGI(TAG, "Outbox opened: %u messages, %u/%u bytes",
+                  (unsigned)entry_count, (unsigned)file_bytes, (unsigned)max_bytes);
+    return true;
+}
+
+void Air780EGOutbox::end()
+{
+    if (entries)
+    {
+        free(entries);
+        entries = nullptr;
+    }
+    storage = nullptr;
+    max_entries = 0;
+    entry_count = 0;
+    file_bytes = 0;
+    live_bytes = 0;
+    inflight_seq = 0;
+}
+
+bool Air780EGOutbox::isOpen() const
+{
+    return storage != nullptr;
+}
+
+bool Air780EGOutbox::scan()
+{
+    entry_count = 0;
+    live_bytes = 0;
+    file_bytes = storage->size();
+
+    size_t offset = 0;
+    uint8_t h[AIR780EG_OUTBOX_HEADER_SIZE];
+    bool dropped_tail = false;
+    while (offset + AIR780EG_OUTBOX_HEADER_SIZE <= file_bytes)
+    {
+        if (!storage->read(offset, h, sizeof(h)))
+        {
+            return false;
+        }
+        size_t len = AIR780EG_OUTBOX_HEADER_SIZE + h[4] + (h[5] | (h[6] << 8));
+        if (h[0] != OUTBOX_MAGIC || offset + len > file_bytes)
+        {
+            // 断电时写了一半的记录
+            dropped_tail = true;
+            break;
+        }
+
+        if (h[1] == OUTBOX_LIVE)
+        {
+            if (entry_count < max_entries)
+            {
+                Entry &e = entries[entry_count++];
+                e.offset = offset;
+                e.seq = next_seq++;
+                e.length = len;
+                e.priority = h[2];
+                live_bytes += len;
+            }
+            else
+            {
+                storage->patch(offset + 1, OUTBOX_DELETED);
+                stats.evicted++;
+            }
+        }
+        offset += len;
+    }
+
+    if (dropped_tail || offset < file_bytes)
+    {
+        AIR780EG_LOGW(TAG, "Dropping %u bytes of truncated log tail", (unsigned)(file_bytes - offset));
+        return compact();
+    }
+    return true;
+}
+
+int Air780EGOutbox::findNext() const
+{
+    int best = -1;
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        if (entries[i].seq == inflight_seq)
+            continue;
+        if (best < 0 || entries[i].priority > entries[best].priority)
+            best = i;
+    }
+    return best;
+}
+
+int Air780EGOutbox::findEvictable() const
+{
+    int best = -1;
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        if (entries[i].seq == inflight_seq)
+            continue;
+        if (best < 0 || entries[i].priority < entries[best].priority)
+            best = i;
+    }
+    return best;
+}
+
+int Air780EGOutbox::findBySeq(uint32_t seq) const
+{
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        if (entries[i].seq == seq)
+            return i;
+    }
+    return -1;
+}
+
+bool Air780EGOutbox::removeEntry(int index)
+{
+    Entry e = entries[index];
+    for (size_t i = index; i + 1 < entry_count; i++)
+    {
+        entries[i] = entries[i + 1];
+    }
+    entry_count--;
+    live_bytes -= e.length;
+
+    if (entry_count == 0)
+    {
+        // 全部发完，直接删除日志文件
+        file_bytes = 0;
+        return storage->clear();
+    }
+
+    bool ok = storage->patch(e.offset + 1, OUTBOX_DELETED);
+    if (file_bytes - live_bytes > live_bytes && file_bytes > max_bytes / 2)
+    {
+        compact();
+    }
+    return ok;
+}
+
+bool Air780EGOutbox::compact()
+{
+    if (!storage->rewriteBegin())
+    {
+        AIR780EG_LOGE(TAG, "Failed to start log compaction");
+        return false;
+    }
+
+    // 出错时放弃临时文件，原日志和索引中的偏移保持不变
+    uint8_t chunk[64];
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        const Entry &e = entries[i];
+        for (size_t done = 0; done < e.length;)
+        {
+            size_t n = e.length - done < sizeof(chunk) ? e.length - done : sizeof(chunk);
+            if (!storage->read(e.offset + done, chunk, n) || !storage->rewriteAppend(chunk, n))
+            {
+                AIR780EG_LOGE(TAG, "Log compaction failed, keeping original log");
+                storage->rewriteAbort();
+                return false;
+            }
+            done += n;
+        }
+    }
+
+    if (!storage->rewriteCommit())
+    {
+        AIR780EG_LOGE(TAG, "Failed to replace log after compaction");
+        return false;
+    }
+    size_t new_offset = 0;
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        entries[i].offset = new_offset;
+        new_offset += entries[i].length;
+    }
+    file_bytes = new_offset;
+    stats.compactions++;
+    AIR780EG_LOGD(TAG, "Log compacted to %u bytes", (unsigned)file_bytes);
+    return true;
+}
+
+bool Air780EGOutbox::makeRoom(size_t record_len)
+{
+    // 条数上限
+    while (entry_count >= max_entries)
+    {
+        int victim = findEvictable();
+        if (victim < 0)
+            return false;
+        removeEntry(victim);
+        stats.evicted++;
+    }
+
+    if (file_bytes + record_len <= max_bytes)
+        return true;
+
+    // 先尝试回收已删除记录的空间，不够再淘汰
+    while (live_bytes + record_len > max_bytes)
+    {
+        int victim = findEvictable();
+        if (victim < 0)
+            return false;
+        removeEntry(victim);
+        stats.evicted++;
+    }
+    if (file_bytes + record_len > max_bytes)
+    {
+        compact();
+    }
+    return file_bytes + record_len <= max_bytes;
+}
+
+bool Air780EGOutbox::push(const String &topic, const String &payload, int qos, bool retain, uint8_t priority)
+{
+    if (!storage)
+    {
+        return false;
+    }
+    // 空负载在发布时会被跳过，写入后永远补发不出去
+    if (payload.length() == 0 || payload == "{}")
+    {
+        AIR780EG_LOGD(TAG, "Empty payload not queued: %s", topic.c_str());
+        return false;
+    }
+
+    size_t record_len = AIR780EG_OUTBOX_HEADER_SIZE + topic.length() + payload.length();
+    if (topic.length() > 255 || payload.length() > 0xFFFF || record_len > max_bytes)
+    {
+        AIR780EG_LOGW(TAG, "Message too large for outbox: %s (%u bytes)", topic.c_str(), payload.length());
+        stats.rejected++;
+        return false;
+    }
+    if (!makeRoom(record_len))
+    {
+        AIR780EG_LOGW(TAG, "Outbox full, rejecting: %s", topic.c_str());
+        stats.rejected++;
+        return false;
+    }
+
+    uint8_t h[AIR780EG_OUTBOX_HEADER_SIZE];
+    h[0] = OUTBOX_MAGIC;
+    h[1] = OUTBOX_LIVE;
+    h[2] = priority;
+    h[3] = (retain ? 0x01 : 0x00) | ((qos & 0x03) << 1);
+    h[4] = (uint8_t)topic.length();
+    h[5] = payload.length() & 0xFF;
+    h[6] = (payload.length() >> 8) & 0xFF;
+
+    bool ok = storage->append(h, sizeof(h)) &&
+              storage->append((const uint8_t *)topic.c_str(), topic.length()) &&
+              storage->append((const uint8_t *)payload.c_str(), payload.length());
+    storage->sync();
+    if (!ok)
+    {
+        // 写了一半的记录在下次 begin() 扫描时丢弃
+        AIR780EG_LOGE(TAG, "Failed to append to outbox log");
+        stats.rejected++;
+        file_bytes = storage->size();
+        return false;
+    }
+
+    Entry &e = entries[entry_count++];
+    e.offset = file_bytes;
+    e.seq = next_seq++;
+    e.length = record_len;
+    e.priority = priority;
+    file_bytes += record_len;
+    live_bytes += record_len;
+    stats.stored++;
+
+    AIR780EG_LOGD(TAG, "Stored offline message #%lu: %s (%u bytes, priority %u, backlog %u)",
+                  (unsigned long)e.seq, topic.c_str(), payload.length(), priority, (unsigned)entry_count);
+    return true;
+}
+
+bool Air780EGOutbox::peek(String &topic, String &payload, int &qos, bool &retain, uint32_t &ticket)
+{
+    if (!storage)
+    {
+        return false;
+    }
+    int index = findNext();
+    if (index < 0)
+    {
+        return false;
+    }
+
+    const Entry &e = entries[index];
+    uint8_t h[AIR780EG_OUTBOX_HEADER_SIZE];
+    if (!storage->read(e.offset, h, sizeof(h)))
+    {
+        return false;
+    }
+    size_t topic_len = h[4];
+    size_t payload_len = h[5] | (h[6] << 8);
+
+    // 分块读取，避免按负载大小分配临时缓冲区
+    uint8_t chunk[64];
+    topic = "";
+    payload = "";
+    topic.reserve(topic_len);
+    payload.reserve(payload_len);
+    size_t total = topic_len + payload_len;
+    for (size_t done = 0; done < total;)
+    {
+        size_t n = total - done < sizeof(chunk) ? total - done : sizeof(chunk);
+        if (!storage->read(e.offset + AIR780EG_OUTBOX_HEADER_SIZE + done, chunk, n))
+        {
+            return false;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            if (done + i < topic_len)
+                topic += (char)chunk[i];
+            else
+                payload += (char)chunk[i];
+        }
+        done += n;
+    }
+
+    retain = (h[3] & 0x01) != 0;
+    qos = (h[3] >> 1) & 0x03;
+    ticket = e.seq;
+    return true;
+}
+
+bool Air780EGOutbox::remove(uint32_t ticket)
+{
+    int index = findBySeq(ticket);
+    if (index < 0)
+    {
+        return false;
+    }
+    return removeEntry(index);
+}
+
+void Air780EGOutbox::clear()
+{
+    if (storage)
+    {
+        storage->clear();
+    }
+    entry_count = 0;
+    file_bytes = 0;
+    live_bytes = 0;
+    inflight_seq = 0;
+}
+
+size_t Air780EGOutbox::size() const
+{
+    return entry_count;
+}
+
+bool Air780EGOutbox::isEmpty() const
+{
+    return entry_count == 0;
+}
+
+void Air780EGOutbox::setDrainRate(float messages_per_second)
+{
+    drain_interval_ms = messages_per_second > 0 ? (unsigned long)(1000.0f / messages_per_second) : 0;
+}
+
+bool Air780EGOutbox::isDrainDue() const
+{
+    return entry_count > 0 && inflight_seq == 0 &&
+           (drain_interval_ms == 0 || millis() - last_drain_time >= drain_interval_ms);
+}
+
+void Air780EGOutbox::markInflight(uint32_t ticket)
+{
+    inflight_seq = ticket;
+    if (drain_session_count == 0 && drain_session_start == 0)
+    {
+        drain_session_start = millis();
+    }
+}
+
+uint32_t Air780EGOutbox::getInflight() const
+{
+    return inflight_seq;
+}
+
+void Air780EGOutbox::onDrainResult(uint32_t ticket, bool success)
+{
+    if (ticket == inflight_seq)
+    {
+        inflight_seq = 0;
+    }
+    last_drain_time = millis();
+
+    if (!success)
+    {
+        stats.drain_failures++;
+        return;
+    }
+
+    remove(ticket);
+    stats.drained++;
+    drain_session_count++;
+    unsigned long elapsed = millis() - drain_session_start;
+    if (elapsed > 0)
+    {
+        stats.drain_rate = drain_session_count * 1000.0f / elapsed;
+    }
+    if (entry_count == 0)
+    {
+        AIR780EG_LOGI(TAG, "Outbox drained: %lu messages, %.1f msg/s",
+                      (unsigned long)drain_session_count, stats.drain_rate);
+        drain_session_start = 0;
+        drain_session_count = 0;
+    }
+}
+
+Air780EGOutboxStats Air780EGOutbox::getStats() const
+{
+    Air780EGOutboxStats s = stats;
+    s.backlog = entry_count;
+    s.backlog_bytes = live_bytes;
+    s.file_bytes = file_bytes;
+    return s;
+}
+
+void Air780EGOutbox::resetStats()
+{
+    stats = Air780EGOutboxStats();
+}
+
+void Air780EGOutbox::printStats() const
+{
+    AIR780EG_LOGI(TAG, "=== Outbox ===");
+    AIR780EG_LOGI(TAG, "backlog: %u messages, %u bytes (log %u/%u bytes)",
+                  (unsigned)entry_count, (unsigned)live_bytes, (unsigned)file_bytes, (unsigned)max_bytes);
+    AIR780EG_LOGI(TAG, "stored: %lu, drained: %lu, evicted: %lu, rejected: %lu, drain failures: %lu",
+                  (unsigned long)stats.stored, (unsigned long)stats.drained, (unsigned long)stats.evicted,
+                  (unsigned long)stats.rejected, (unsigned long)stats.drain_failures);
+    AIR780EG_LOGI(TAG, "drain rate: %.1f msg/s, compactions: %lu",
+                  stats.drain_rate, (unsigned long)stats.compactions);
+}
@@ -0,0 +1,171 @@
+#ifndef AIR780EG_OUTBOX_H
+#define AIR780EG_OUTBOX_H
+
+#include <Arduino.h>
+#ifdef ESP32
+#include <FS.h>
+#else
+#include <stdio.h>
+#endif
+
+/*
+ * 离线发布队列（store-and-forward）
+ *
+ * MQTT断开期间的发布写入Flash上的追加日志，重连后按设定速率补发。
+ *
+ * 日志记录格式：
+ *   魔数(0xA7) + 状态(0xFF有效 / 0x00已删除) + 优先级 + 标志(bit0 retain, bit1-2 qos)
+ *   + 主题长度(1字节) + 负载长度(2字节, 小端) + 主题 + 负载
+ *
+ * 删除记录只把状态字节改写为0x00；已删除字节超过一半或空间不足时整体压缩重写。
+ * 补发顺序：优先级高的先发，同优先级按写入顺序；空间不足时淘汰优先级最低、最早的记录。
+ * 上电后 begin() 扫描日志重建索引，未补发的记录不会丢失；压缩时断电同样不丢失。
+ */
+
+#define AIR780EG_OUTBOX_HEADER_SIZE 7
+
+// 日志存储接口
+class Air780EGOutboxStorage {
+public:
+    virtual ~Air780EGOutboxStorage() {}
+
+    virtual size_t size() = 0;
+    virtual bool read(size_t offset, uint8_t* buffer, size_t len) = 0;
+    virtual bool append(const uint8_t* data, size_t len) = 0;
+    virtual void sync() {}  // 一条记录追加完成后调用
+    virtual bool patch(size_t offset, uint8_t value) = 0;
+    virtual bool clear() = 0;
+
+    // 压缩：把有效记录写入临时文件后替换原日志。写入中途出错时 rewriteAbort() 删除临时文件，原日志不变；
+    // rewriteCommit() 失败时原日志保持不变，或（替换中途）只剩完整的临时文件。
+    // 替换过程中断电同样至少保留其中一个，由 recover() 在 begin() 时恢复
+    virtual bool rewriteBegin() = 0;
+    virtual bool rewriteAppend(const uint8_t* data, size_t len) = 0;
+    virtual bool rewriteCommit() = 0;
+    virtual void rewriteAbort() = 0;
+    virtual void recover() {}
+};
+
+// 文件存储：设备上使用 LittleFS/SPIFFS，主机端使用标准文件代替
+class Air780EGOutboxFile : public Air780EGOutboxStorage {
+private:
+#ifdef ESP32
+    fs::FS& fs;
+    File append_file;
+    File rewrite_file;
+#else
+    FILE* append_file = nullptr;
+    FILE* rewrite_file = nullptr;
+#endif
+    String path;
+    String tmp_path;
+
+    void closeAppend();
+
+public:
+#ifdef ESP32
+    Air780EGOutboxFile(fs::FS& filesystem, const char* file_path);
+#else
+    explicit Air780EGOutboxFile(const char* file_path);
+#endif
+    ~Air780EGOutboxFile();
+
+    size_t size() override;
+    bool read(size_t offset, uint8_t* buffer, size_t len) override;
+    bool append(const uint8_t* data, size_t len) override;
+    void sync() override;
+    bool patch(size_t offset, uint8_t value) override;
+    bool clear() override;
+    bool rewriteBegin() override;
+    bool rewriteAppend(const uint8_t* data, size_t len) override;
+    bool rewriteCommit() override;
+    void rewriteAbort() override;
+    void recover() override;
+};
+
+// 队列统计
+struct Air780EGOutboxStats {
+    uint32_t stored;          // 写入条数
+    uint32_t drained;         // 补发成功条数
+    uint32_t evicted;         // 空间不足被淘汰的条数
+    uint32_t rejected;        // 无法写入的条数（单条过大或写入失败）
+    uint32_t drain_failures;  // 补发失败次数（失败的消息保留，稍后重试）
+    uint32_t compactions;     // 压缩次数
+    size_t backlog;           // 当前积压条数
+    size_t backlog_bytes;     // 有效记录字节数
+    size_t file_bytes;        // 日志文件大小（含已删除记录）
+    float drain_rate;         // 最近一次补发的吞吐（条/秒）
+};
+
+class Air780EGOutbox {
+private:
+    static const char* TAG;
+
+    struct Entry {
+        uint32_t offset;
+        uint32_t seq;        // 写入顺序，也作为补发凭据
+        uint32_t length;     // 记录总长度（含头）
+        uint8_t priority;
+    };
+
+    Air780EGOutboxStorage* storage = nullptr;
+    Entry* entries = nullptr;
+    size_t max_entries = 0;
+    size_t entry_count = 0;
+    size_t max_bytes = 0;
+    size_t file_bytes = 0;
+    size_t live_bytes = 0;
+    uint32_t next_seq = 1;
+    uint32_t inflight_seq = 0;
+
+    // 补发速率控制
+    unsigned long drain_interval_ms = 200;
+    unsigned long last_drain_time = 0;
+    unsigned long drain_session_start = 0;
+    uint32_t drain_session_count = 0;
+
+    Air780EGOutboxStats stats;
+
+    bool scan();
+    int findNext() const;
+    int findEvictable() const;
+    int findBySeq(uint32_t seq) const;
+    bool removeEntry(int index);
+    bool compact();
+    bool makeRoom(size_t record_len);
+
+public:
+    Air780EGOutbox();
+    ~Air780EGOutbox();
+
+    // 打开日志并重建索引；max_bytes 为日志文件上限，max_messages 为最多保存的条数
+    bool begin(Air780EGOutboxStorage* log_storage, size_t max_bytes = 32 * 1024, size_t max_messages = 128);
+    void end();
+    bool isOpen() const;
+
+    // 写入一条待发消息，priority 越大越先补发、越晚被淘汰；空负载和 "{}" 不写入
+    bool push(const String& topic, const String& payload, int qos = 0, bool retain = false, uint8_t priority = 0);
+
+    // 取出下一条待补发消息（不删除），ticket 用于发送成功后 remove()
+    bool peek(String& topic, String& payload, int& qos, bool& retain, uint32_t& ticket);
+    bool remove(uint32_t ticket);
+    void clear();
+
+    size_t size() const;
+    bool isEmpty() const;
+
+    // 补发速率（条/秒），0表示不限速
+    void setDrainRate(float messages_per_second);
+    bool isDrainDue() const;
+
+    // 补发过程记录（由 Air780EGMQTT 调用）
+    void markInflight(uint32_t ticket);
+    uint32_t getInflight() const;
+    void onDrainResult(uint32_t ticket, bool success);
+
+    Air780EGOutboxStats getStats() const;
+    void resetStats();
+    void printStats() const;
+};
+
+#endif // AIR780EG_OUTBOX_H
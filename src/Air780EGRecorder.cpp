@@ -0,0 +1,561 @@
+#include "Air780EGRecorder.h"
+#include "Air780EGDebug.h"
+
+const char *Air780EGRecorder::TAG = "Recorder";
+const char *Air780EGReplayStream::TAG = "Replay";
+
+static const uint8_t RECORDER_MAGIC[4] = {'A', '7', 'R', 'C'};
+
+// ==================== 录制 ====================
+
+Air780EGRecorder::Air780EGRecorder()
+{
+}
+
+Air780EGRecorder::~Air780EGRecorder()
+{
+    end();
+}
+
+bool Air780EGRecorder::begin(size_t buffer_size)
+{
+    end();
+    if (buffer_size > 0)
+    {
+        ring = (uint8_t *)malloc(buffer_size);
+        if (!ring)
+        {
+            AIR780EG_LOGE(TAG, "Failed to allocate %u bytes", (unsigned)buffer_size);
+            return false;
+        }
+        capacity = buffer_size;
+    }
+    clear();
+    AIR780EG_LOGI(TAG, "Recorder ready, buffer: %u bytes", (unsigned)buffer_size);
+    return true;
+}
+
+void Air780EGRecorder::end()
+{
+    stop();
+    if (ring)
+    {
+        free(ring);
+        ring = nullptr;
+    }
+    capacity = 0;
+    head = tail = used = 0;
+}
+
+void Air780EGRecorder::setSink(Print *output)
+{
+    sink = output;
+    if (sink)
+    {
+        writeHeader(*sink);
+    }
+}
+
+void Air780EGRecorder::start()
+{
+    if (!recording)
+    {
+        recording = true;
+        last_record_us = micros();
+        AIR780EG_LOGD(TAG, "Recording started");
+    }
+}
+
+void Air780EGRecorder::stop()
+{
+    if (recording)
+    {
+        flushRxRun();
+        recording = false;
+        AIR780EG_LOGD(TAG, "Recording stopped, records: %lu", (unsigned long)record_count);
+    }
+}
+
+bool Air780EGRecorder::isRecording() const
+{
+    return recording;
+}
+
+void Air780EGRecorder::clear()
+{
+    head = tail = used = 0;
+    rx_run_len = 0;
+    record_count = 0;
+    dropped_records = 0;
+    evicted_records = 0;
+    last_record_us = micros();
+}
+
+void Air780EGRecorder::recordTx(const uint8_t *data, size_t len, bool append_crlf)
+{
+    if (!recording || (len == 0 && !append_crlf))
+        return;
+
+    // 先结束正在合并的接收片段，保证记录顺序
+    flushRxRun();
+    if (append_crlf)
+    {
+        writeRecord(DIR_TX, micros(), data, len, (const uint8_t *)"\r\n", 2);
+    }
+    else
+    {
+        writeRecord(DIR_TX, micros(), data, len);
+    }
+}
+
+void Air780EGRecorder::recordTxData(const uint8_t *data, size_t len)
+{
+    if (!recording || len == 0)
+        return;
+
+    flushRxRun();
+    writeRecord(DIR_DATA, micros(), data, len);
+}
+
+void Air780EGRecorder::recordRx(uint8_t c)
+{
+    if (!recording)
+        return;
+
+    unsigned long now = micros();
+    if (rx_run_len > 0 &&
+        (rx_run_len >= AIR780EG_RECORDER_RX_RUN || now - rx_last_byte_us > AIR780EG_RECORDER_RX_GAP_US))
+    {
+        flushRxRun();
+    }
+    if (rx_run_len == 0)
+    {
+        rx_run_start_us = now;
+    }
+    rx_run[rx_run_len++] = c;
+    rx_last_byte_us = now;
+}
+
+void Air780EGRecorder::flush()
+{
+    flushRxRun();
+}
+
+void Air780EGRecorder::flushRxRun()
+{
+    if (rx_run_len == 0)
+        return;
+
+    size_t len = rx_run_len;
+    rx_run_len = 0;
+    writeRecord(DIR_RX, rx_run_start_us, rx_run, len);
+}
+
+void Air780EGRecorder::writeRecord(uint8_t dir, unsigned long timestamp_us, const uint8_t *data, size_t len,
+                                   const uint8_t *suffix, size_t suffix_len)
+{
+    uint8_t header[1 + 5 + 5];
+    size_t header_len = 0;
+    header[header_len++] = dir;
+    header_len += encodeVarint((uint32_t)(timestamp_us - last_record_us), header + header_len);
+    header_len += encodeVarint((uint32_t)(len + suffix_len), header + header_len);
+    last_record_us = timestamp_us;
+
+    size_t total = header_len + len + suffix_len;
+    if (ring)
+    {
+        if (total > capacity)
+        {
+            dropped_records++;
+        }
+        else
+        {
+            while (capacity - used < total)
+            {
+                evictOldest();
+            }
+            ringWrite(header, header_len);
+            ringWrite(data, len);
+            ringWrite(suffix, suffix_len);
+        }
+    }
+
+    if (sink)
+    {
+        sink->write(header, header_len);
+        sink->write(data, len);
+        if (suffix_len > 0)
+        {
+            sink->write(suffix, suffix_len);
+        }
+    }
+
+    record_count++;
+}
+
+void Air780EGRecorder::ringWrite(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        ring[head] = data[i];
+        head = (head + 1) % capacity;
+    }
+    used += len;
+}
+
+uint8_t Air780EGRecorder::ringByteAt(size_t offset) const
+{
+    return ring[(tail + offset) % capacity];
+}
+
+void Air780EGRecorder::evictOldest()
+{
+    if (used == 0)
+        return;
+
+    // 解析最早一条记录的长度：方向 + 时间varint + 长度varint + 数据
+    size_t offset = 1;
+    while (offset < used && (ringByteAt(offset) & 0x80))
+        offset++;
+    offset++;
+
+    uint32_t len = 0;
+    int shift = 0;
+    while (offset < used)
+    {
+        uint8_t b = ringByteAt(offset++);
+        len |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+        if (!(b & 0x80))
+            break;
+    }
+
+    size_t total = offset + len;
+    if (total > used)
+        total = used;
+    tail = (tail + total) % capacity;
+    used -= total;
+    evicted_records++;
+}
+
+size_t Air780EGRecorder::dump(Print &out)
+{
+    flushRxRun();
+
+    size_t written = writeHeader(out);
+    if (!ring || used == 0)
+        return written;
+
+    // 环形缓冲区最多分两段写出
+    size_t first = min(used, capacity - tail);
+    written += out.write(ring + tail, first);
+    if (used > first)
+    {
+        written += out.write(ring, used - first);
+    }
+    return written;
+}
+
+size_t Air780EGRecorder::getUsedBytes() const
+{
+    return used;
+}
+
+size_t Air780EGRecorder::getCapacity() const
+{
+    return capacity;
+}
+
+uint32_t Air780EGRecorder::getRecordCount() const
+{
+    return record_count;
+}
+
+uint32_t Air780EGRecorder::getDroppedRecords() const
+{
+    return dropped_records;
+}
+
+uint32_t Air780EGRecorder::getEvictedRecords() const
+{
+    return evicted_records;
+}
+
+size_t Air780EGRecorder::encodeVarint(uint32_t value, uint8_t *out)
+{
+    size_t n = 0;
+    do
+    {
+        uint8_t b = value & 0x7F;
+        value >>= 7;
+        if (value)
+            b |= 0x80;
+        out[n++] = b;
+    } while (value);
+    return n;
+}
+
+size_t Air780EGRecorder::writeHeader(Print &out)
+{
+    uint8_t header[AIR780EG_RECORDER_HEADER_SIZE] = {
+        RECORDER_MAGIC[0], RECORDER_MAGIC[1], RECORDER_MAGIC[2], RECORDER_MAGIC[3],
+        AIR780EG_RECORDER_VERSION, 0, 0, 0};
+    return out.write(header, sizeof(header));
+}
+
+// ==================== 回放 ====================
+
+Air780EGReplayStream::Air780EGReplayStream()
+{
+}
+
+bool Air780EGReplayStream::begin(const uint8_t *capture, size_t length)
+{
+    source_buf = capture;
+    source_len = length;
+    source_pos = 0;
+    source_stream = nullptr;
+    return begin(nullptr);
+}
+
+bool Air780EGReplayStream::begin(Stream *capture)
+{
+    if (capture)
+    {
+        source_stream = capture;
+        source_buf = nullptr;
+    }
+
+    // 校验文件头
+    for (int i = 0; i < 4; i++)
+    {
+        if (sourceByte() != RECORDER_MAGIC[i])
+        {
+            AIR780EG_LOGE(TAG, "Invalid capture header");
+            finished = true;
+            return false;
+        }
+    }
+    int version = sourceByte();
+    if (version < 1 || version > AIR780EG_RECORDER_VERSION)
+    {
+        AIR780EG_LOGE(TAG, "Unsupported capture version: %d", version);
+        finished = true;
+        return false;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        sourceByte();
+    }
+
+    has_record = false;
+    record_time_us = 0;
+    peeked = -1;
+    tx_line = "";
+    tx_lines = tx_mismatches = tx_unexpected = 0;
+    finished = false;
+    anchor_local_us = micros();
+    anchor_capture_us = 0;
+
+    loadNextRecord();
+    AIR780EG_LOGI(TAG, "Replay started");
+    return true;
+}
+
+void Air780EGReplayStream::setSpeed(float factor)
+{
+    speed = factor < 0 ? 0 : factor;
+}
+
+int Air780EGReplayStream::sourceByte()
+{
+    if (source_buf)
+    {
+        return source_pos < source_len ? source_buf[source_pos++] : -1;
+    }
+    if (source_stream && source_stream->available())
+    {
+        return source_stream->read();
+    }
+    return -1;
+}
+
+bool Air780EGReplayStream::readVarint(uint32_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        int b = sourceByte();
+        if (b < 0)
+            return false;
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool Air780EGReplayStream::loadNextRecord()
+{
+    while (true)
+    {
+        int dir = sourceByte();
+        uint32_t delta = 0;
+        uint32_t len = 0;
+        if (dir < 0 || !readVarint(delta) || !readVarint(len))
+        {
+            has_record = false;
+            finished = true;
+            return false;
+        }
+        if (dir != Air780EGRecorder::DIR_TX && dir != Air780EGRecorder::DIR_RX &&
+            dir != Air780EGRecorder::DIR_DATA)
+        {
+            AIR780EG_LOGE(TAG, "Corrupt capture record");
+            has_record = false;
+            finished = true;
+            return false;
+        }
+
+        record_time_us += delta;
+        record_dir = (uint8_t)dir;
+        record_remaining = len;
+        has_record = true;
+        if (len > 0)
+            return true;
+    }
+}
+
+bool Air780EGReplayStream::rxReleased()
+{
+    if (speed <= 0)
+        return true;
+
+    unsigned long elapsed = micros() - anchor_local_us;
+    unsigned long target = record_time_us - anchor_capture_us;
+    return (float)elapsed * speed >= (float)target;
+}
+
+int Air780EGReplayStream::available()
+{
+    if (peeked >= 0)
+        return record_remaining + 1;
+    if (!has_record || record_dir != Air780EGRecorder::DIR_RX || !rxReleased())
+        return 0;
+    return record_remaining;
+}
+
+int Air780EGReplayStream::read()
+{
+    if (available() <= 0)
+        return -1;
+
+    int c;
+    if (peeked >= 0)
+    {
+        c = peeked;
+        peeked = -1;
+    }
+    else
+    {
+        c = sourceByte();
+        record_remaining--;
+    }
+
+    if (record_remaining == 0)
+    {
+        loadNextRecord();
+    }
+    return c;
+}
+
+int Air780EGReplayStream::peek()
+{
+    if (peeked >= 0)
+        return peeked;
+    if (available() <= 0)
+        return -1;
+
+    peeked = sourceByte();
+    record_remaining--;
+    return peeked;
+}
+
+size_t Air780EGReplayStream::write(uint8_t c)
+{
+    tx_line += (char)c;
+    if (c == '\n')
+    {
+        handleTxLine();
+    }
+    else if (has_record && record_dir == Air780EGRecorder::DIR_DATA && peeked < 0 &&
+             tx_line.length() >= record_remaining)
+    {
+        // 原始数据块没有行结束符，写满捕获中的记录长度即视为一“行”
+        handleTxLine();
+    }
+    return 1;
+}
+
+void Air780EGReplayStream::handleTxLine()
+{
+    tx_lines++;
+
+    if (has_record && (record_dir == Air780EGRecorder::DIR_TX || record_dir == Air780EGRecorder::DIR_DATA) &&
+        peeked < 0)
+    {
+        // 一行可能由多条发送记录组成（分段写出的长命令）
+        String captured;
+        unsigned long tx_time = record_time_us;
+        while (has_record && (record_dir == Air780EGRecorder::DIR_TX || record_dir == Air780EGRecorder::DIR_DATA))
+        {
+            bool data_record = record_dir == Air780EGRecorder::DIR_DATA;
+            while (record_remaining > 0)
+            {
+                captured += (char)sourceByte();
+                record_remaining--;
+            }
+            tx_time = record_time_us;
+            loadNextRecord();
+            if (data_record || captured.endsWith("\n"))
+                break;
+        }
+
+        if (captured != tx_line)
+        {
+            tx_mismatches++;
+            AIR780EG_LOGW(TAG, "TX mismatch, expected: %s, got: %s", captured.c_str(), tx_line.c_str());
+        }
+
+        // 以本次发送为锚点，后续接收按捕获中的相对时间释放
+        anchor_local_us = micros();
+        anchor_capture_us = tx_time;
+    }
+    else
+    {
+        tx_unexpected++;
+        AIR780EG_LOGW(TAG, "Unexpected TX: %s", tx_line.c_str());
+    }
+
+    tx_line = "";
+}
+
+bool Air780EGReplayStream::isFinished() const
+{
+    return finished;
+}
+
+uint32_t Air780EGReplayStream::getTxLineCount() const
+{
+    return tx_lines;
+}
+
+uint32_t Air780EGReplayStream::getTxMismatchCount() const
+{
+    return tx_mismatches;
+}
+
+uint32_t Air780EGReplayStream::getUnexpectedTxCount() const
+{
+    return tx_unexpected;
+}
@@ -0,0 +1,167 @@
+#ifndef AIR780EG_RECORDER_H
+#define AIR780EG_RECORDER_H
+
+#include <Arduino.h>
+
+/*
+ * AT收发录制与回放
+ *
+ * 录制格式（小端、紧凑二进制）：
+ *   文件头: "A7RC" + 版本(1字节) + 3字节保留
+ *   记录:   方向(1字节: 'T'发送 / 'R'接收 / 'D'提示符后发送的原始数据) + 距上条记录的微秒数(varint)
+ *           + 长度(varint) + 数据
+ *
+ * 接收数据按“读取片段”合并：连续读取且间隔不超过 AIR780EG_RECORDER_RX_GAP_US 的字节
+ * 记为一条记录，时间戳为片段第一个字节被库读取的时刻。
+ */
+
+#define AIR780EG_RECORDER_VERSION 1
+#define AIR780EG_RECORDER_HEADER_SIZE 8
+#define AIR780EG_RECORDER_RX_RUN 64        // 单条接收记录最大字节数
+#define AIR780EG_RECORDER_RX_GAP_US 2000   // 接收片段切分间隔
+
+class Air780EGRecorder {
+private:
+    static const char* TAG;
+
+    // RAM环形缓冲区
+    uint8_t* ring = nullptr;
+    size_t capacity = 0;
+    size_t head = 0;   // 写入位置
+    size_t tail = 0;   // 最早记录位置
+    size_t used = 0;
+
+    // 流式输出（如LittleFS文件）
+    Print* sink = nullptr;
+
+    bool recording = false;
+    unsigned long last_record_us = 0;
+
+    // 正在合并的接收片段
+    uint8_t rx_run[AIR780EG_RECORDER_RX_RUN];
+    size_t rx_run_len = 0;
+    unsigned long rx_run_start_us = 0;
+    unsigned long rx_last_byte_us = 0;
+
+    // 统计
+    uint32_t record_count = 0;
+    uint32_t dropped_records = 0;
+    uint32_t evicted_records = 0;
+
+    void writeRecord(uint8_t dir, unsigned long timestamp_us, const uint8_t* data, size_t len,
+                     const uint8_t* suffix = nullptr, size_t suffix_len = 0);
+    void ringWrite(const uint8_t* data, size_t len);
+    uint8_t ringByteAt(size_t offset) const;
+    void evictOldest();
+    void flushRxRun();
+
+public:
+    static const uint8_t DIR_TX = 'T';
+    static const uint8_t DIR_RX = 'R';
+    static const uint8_t DIR_DATA = 'D';
+
+    Air780EGRecorder();
+    ~Air780EGRecorder();
+
+    // 分配RAM环形缓冲区（0表示只使用流式输出）
+    bool begin(size_t buffer_size);
+    void end();
+
+    // 设置流式输出，立即写入文件头
+    void setSink(Print* output);
+
+    // 录制控制
+    void start();
+    void stop();
+    bool isRecording() const;
+    void clear();
+
+    // 录制钩子（由Core调用）
+    void recordTx(const uint8_t* data, size_t len, bool append_crlf = false);
+    void recordTxData(const uint8_t* data, size_t len);
+    void recordRx(uint8_t c);
+    void flush();
+
+    // 将RAM中的录制导出为完整的捕获文件
+    size_t dump(Print& out);
+
+    // 统计
+    size_t getUsedBytes() const;
+    size_t getCapacity() const;
+    uint32_t getRecordCount() const;
+    uint32_t getDroppedRecords() const;
+    uint32_t getEvictedRecords() const;
+
+    // 编码工具（回放端共用）
+    static size_t encodeVarint(uint32_t value, uint8_t* out);
+    static size_t writeHeader(Print& out);
+};
+
+/*
+ * 回放数据流
+ *
+ * 把捕获文件作为 Stream 交给 Air780EGCore::attachStream()，库读到的数据
+ * 与录制时一致。接收记录按原始时间间隔释放，时间以库的每一次发送为锚点重新对齐，
+ * 所以回放结果与主机运行速度无关；库发送的内容会与捕获中的发送记录逐行比对
+ * （'D' 记录没有行结束符，按记录长度比对）。
+ */
+class Air780EGReplayStream : public Stream {
+private:
+    static const char* TAG;
+
+    // 捕获来源：内存或数据流（如文件）
+    const uint8_t* source_buf = nullptr;
+    size_t source_len = 0;
+    size_t source_pos = 0;
+    Stream* source_stream = nullptr;
+
+    // 当前记录
+    bool has_record = false;
+    uint8_t record_dir = 0;
+    uint32_t record_remaining = 0;
+    unsigned long record_time_us = 0; // 捕获时间轴上的绝对时间
+    int peeked = -1;
+
+    // 时间锚点
+    unsigned long anchor_local_us = 0;
+    unsigned long anchor_capture_us = 0;
+    float speed = 1.0f;
+
+    // 库发送的当前行
+    String tx_line;
+    uint32_t tx_lines = 0;
+    uint32_t tx_mismatches = 0;
+    uint32_t tx_unexpected = 0;
+    bool finished = false;
+
+    int sourceByte();
+    bool readVarint(uint32_t& value);
+    bool loadNextRecord();
+    bool rxReleased();
+    void handleTxLine();
+
+public:
+    Air780EGReplayStream();
+
+    // 打开捕获（会校验文件头）
+    bool begin(const uint8_t* capture, size_t length);
+    bool begin(Stream* capture);
+
+    // 回放速度：1.0为原速，2.0为两倍速，0为不等待
+    void setSpeed(float factor);
+
+    // Stream接口
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // 回放状态
+    bool isFinished() const;
+    uint32_t getTxLineCount() const;
+    uint32_t getTxMismatchCount() const;
+    uint32_t getUnexpectedTxCount() const;
+};
+
+#endif // AIR780EG_RECORDER_H
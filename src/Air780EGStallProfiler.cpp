@@ -0,0 +1,160 @@
+#include "Air780EGStallProfiler.h"
+#include "Air780EGDebug.h"
+
+const char *Air780EGStallProfiler::TAG = "StallProfiler";
+
+// 分段：<10ms, <50ms, <100ms, <500ms, <1s, <5s, <10s, >=10s
+const uint32_t Air780EGStallProfiler::bucket_limits[AIR780EG_STALL_BUCKETS - 1] = {
+    10, 50, 100, 500, 1000, 5000, 10000};
+
+bool Air780EGStallProfiler::enabled = false;
+unsigned long Air780EGStallProfiler::budget_ms = 0;
+Air780EGStallCallback Air780EGStallProfiler::budget_callback = nullptr;
+Air780EGStallStats Air780EGStallProfiler::sites[Air780EGStallProfiler::MAX_SITES] = {};
+int Air780EGStallProfiler::site_count = 0;
+
+void Air780EGStallProfiler::enable(bool enable)
+{
+    enabled = enable;
+    AIR780EG_LOGD(TAG, "Stall profiler %s", enable ? "enabled" : "disabled");
+}
+
+bool Air780EGStallProfiler::isEnabled()
+{
+    return enabled;
+}
+
+void Air780EGStallProfiler::setBudget(unsigned long budget, Air780EGStallCallback callback)
+{
+    budget_ms = budget;
+    budget_callback = callback;
+    AIR780EG_LOGD(TAG, "Stall budget set to %lu ms", budget);
+}
+
+unsigned long Air780EGStallProfiler::getBudget()
+{
+    return budget_ms;
+}
+
+int Air780EGStallProfiler::getSiteCount()
+{
+    return site_count;
+}
+
+Air780EGStallStats Air780EGStallProfiler::getStats(int index)
+{
+    if (index < 0 || index >= site_count)
+    {
+        Air780EGStallStats empty = {};
+        return empty;
+    }
+    return sites[index];
+}
+
+bool Air780EGStallProfiler::getStats(const char *site, Air780EGStallStats &stats)
+{
+    for (int i = 0; i < site_count; i++)
+    {
+        if (strcmp(sites[i].site, site) == 0)
+        {
+            stats = sites[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t Air780EGStallProfiler::getBucketLimit(int bucket)
+{
+    if (bucket < 0 || bucket >= AIR780EG_STALL_BUCKETS - 1)
+    {
+        return 0;
+    }
+    return bucket_limits[bucket];
+}
+
+void Air780EGStallProfiler::reset()
+{
+    // 保留调用点名称，已缓存的索引仍然有效
+    for (int i = 0; i < site_count; i++)
+    {
+        const char *site = sites[i].site;
+        sites[i] = Air780EGStallStats();
+        sites[i].site = site;
+    }
+}
+
+int Air780EGStallProfiler::findOrAddSite(const char *site)
+{
+    for (int i = 0; i < site_count; i++)
+    {
+        if (sites[i].site == site || strcmp(sites[i].site, site) == 0)
+        {
+            return i;
+        }
+    }
+    if (site_count >= MAX_SITES)
+    {
+        return -1;
+    }
+    sites[site_count] = Air780EGStallStats();
+    sites[site_count].site = site;
+    return site_count++;
+}
+
+void Air780EGStallProfiler::record(const char *site, int8_t &site_index, unsigned long elapsed_ms)
+{
+    if (site_index < 0)
+    {
+        site_index = findOrAddSite(site);
+        if (site_index < 0)
+        {
+            AIR780EG_LOGW(TAG, "Too many call sites, dropping: %s", site);
+            return;
+        }
+    }
+
+    Air780EGStallStats &s = sites[site_index];
+    s.count++;
+    s.total_ms += elapsed_ms;
+    s.last_ms = elapsed_ms;
+    if (elapsed_ms > s.worst_ms)
+    {
+        s.worst_ms = elapsed_ms;
+    }
+
+    int bucket = 0;
+    while (bucket < AIR780EG_STALL_BUCKETS - 1 && elapsed_ms >= bucket_limits[bucket])
+    {
+        bucket++;
+    }
+    s.histogram[bucket]++;
+
+    if (budget_ms > 0 && elapsed_ms > budget_ms)
+    {
+        s.over_budget++;
+        AIR780EG_LOGD(TAG, "%s stalled %lu ms (budget %lu ms)", site, elapsed_ms, budget_ms);
+        if (budget_callback)
+        {
+            budget_callback(site, elapsed_ms, budget_ms);
+        }
+    }
+}
+
+void Air780EGStallProfiler::printStats()
+{
+    AIR780EG_LOGI(TAG, "=== Stall Profile (%s, budget %lu ms) ===", enabled ? "enabled" : "disabled", budget_ms);
+    AIR780EG_LOGI(TAG, "%-32s %6s %8s %8s %6s  <10/<50/<100/<500/<1s/<5s/<10s/>=10s",
+                  "site", "count", "avg", "worst", "over");
+    for (int i = 0; i < site_count; i++)
+    {
+        const Air780EGStallStats &s = sites[i];
+        const uint32_t *h = s.histogram;
+        AIR780EG_LOGI(TAG, "%-32s %6lu %8lu %8lu %6lu  %lu/%lu/%lu/%lu/%lu/%lu/%lu/%lu",
+                      s.site, (unsigned long)s.count,
+                      (unsigned long)(s.count ? s.total_ms / s.count : 0),
+                      (unsigned long)s.worst_ms, (unsigned long)s.over_budget,
+                      (unsigned long)h[0], (unsigned long)h[1], (unsigned long)h[2], (unsigned long)h[3],
+                      (unsigned long)h[4], (unsigned long)h[5], (unsigned long)h[6], (unsigned long)h[7]);
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef AIR780EG_STALL_PROFILER_H
+#define AIR780EG_STALL_PROFILER_H
+
+#include <Arduino.h>
+
+/*
+ * 主循环阻塞分析器
+ *
+ * 库的公开入口（connect、subscribe、publish、updateWIFILocation、HTTP get等）
+ * 用 AIR780EG_STALL_SCOPE() 标记，启用后记录每个调用点的耗时：
+ * 调用次数、累计/最长耗时以及耗时分布直方图。
+ * 可设置预算，超过预算时触发回调，便于定位卡住主循环的调用。
+ */
+
+// 耗时直方图分段上限（毫秒），最后一段为超过上一上限的全部调用
+#define AIR780EG_STALL_BUCKETS 8
+
+// 单个调用点的统计
+struct Air780EGStallStats {
+    const char* site;          // 调用点名称，如 "MQTT::publish"
+    uint32_t count;            // 调用次数
+    uint32_t total_ms;         // 累计耗时
+    uint32_t worst_ms;         // 最长耗时
+    uint32_t last_ms;          // 最近一次耗时
+    uint32_t over_budget;      // 超出预算次数
+    uint32_t histogram[AIR780EG_STALL_BUCKETS];
+};
+
+// 超出预算回调
+typedef void (*Air780EGStallCallback)(const char* site, unsigned long elapsed_ms, unsigned long budget_ms);
+
+class Air780EGStallProfiler {
+private:
+    static const char* TAG;
+    static const int MAX_SITES = 32;
+    static const uint32_t bucket_limits[AIR780EG_STALL_BUCKETS - 1];
+
+    static bool enabled;
+    static unsigned long budget_ms;
+    static Air780EGStallCallback budget_callback;
+    static Air780EGStallStats sites[MAX_SITES];
+    static int site_count;
+
+    static int findOrAddSite(const char* site);
+
+public:
+    // 启用/禁用（默认禁用，禁用时入口处只有一次判断的开销）
+    static void enable(bool enable = true);
+    static bool isEnabled();
+
+    // 预算：单次调用超过 budget_ms 时触发回调（0表示不检查）
+    static void setBudget(unsigned long budget_ms, Air780EGStallCallback callback = nullptr);
+    static unsigned long getBudget();
+
+    // 查询
+    static int getSiteCount();
+    static Air780EGStallStats getStats(int index);
+    static bool getStats(const char* site, Air780EGStallStats& stats);
+    static uint32_t getBucketLimit(int bucket); // 返回分段上限，最后一段返回0
+    static void reset();
+    static void printStats();
+
+    // 记录一次调用（由 Air780EGStallScope 调用）
+    static void record(const char* site, int8_t& site_index, unsigned long elapsed_ms);
+};
+
+// RAII计时：构造时记录开始时间，析构时上报
+class Air780EGStallScope {
+private:
+    const char* site;
+    int8_t& site_index;
+    unsigned long start;
+    bool active;
+
+public:
+    Air780EGStallScope(const char* site_name, int8_t& index)
+        : site(site_name), site_index(index), start(0), active(Air780EGStallProfiler::isEnabled())
+    {
+        if (active)
+        {
+            start = millis();
+        }
+    }
+
+    ~Air780EGStallScope()
+    {
+        if (active)
+        {
+            Air780EGStallProfiler::record(site, site_index, millis() - start);
+        }
+    }
+};
+
+// 调用点索引缓存在函数内静态变量中，首次记录后查找为O(1)
+#define AIR780EG_STALL_SCOPE(site) \
+    static int8_t _air780eg_stall_site = -1; \
+    Air780EGStallScope _air780eg_stall_scope(site, _air780eg_stall_site)
+
+#endif // AIR780EG_STALL_PROFILER_H
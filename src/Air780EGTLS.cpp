@@ -0,0 +1,331 @@
+#include "Air780EGTLS.h"
+#include "Air780EGDebug.h"
+
+const char *Air780EGTLS::TAG = "TLS";
+
+Air780EGTLS::Air780EGTLS(Air780EGCore *core_instance, int ssl_context_id)
+    : core(core_instance), context_id(ssl_context_id)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        certs[i].name[0] = '\0';
+        certs[i].hash = 0;
+        certs[i].length = 0;
+        certs[i].installed = false;
+    }
+}
+
+// FNV-1a，用作证书文件名中的内容标识
+uint32_t Air780EGTLS::hash(const char *data, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (uint8_t)data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+const char *Air780EGTLS::certTag(int type)
+{
+    switch (type)
+    {
+    case CERT_CA:
+        return "ca";
+    case CERT_CLIENT:
+        return "crt";
+    default:
+        return "key";
+    }
+}
+
+void Air780EGTLS::setCertificate(CertType type, const String &pem)
+{
+    CertFile &cert = certs[type];
+    if (pem.isEmpty())
+    {
+        if (cert.length > 0)
+        {
+            configured = false;
+        }
+        cert.pem = "";
+        cert.name[0] = '\0';
+        cert.hash = 0;
+        cert.length = 0;
+        cert.installed = false;
+        return;
+    }
+
+    uint32_t h = hash(pem.c_str(), pem.length());
+    if (cert.installed && h == cert.hash && pem.length() == cert.length)
+    {
+        return;
+    }
+    cert.pem = pem;
+    cert.hash = h;
+    cert.length = pem.length();
+    cert.installed = false;
+    snprintf(cert.name, sizeof(cert.name), "tls%d_%s_%08lx.pem", context_id, certTag(type), (unsigned long)h);
+    configured = false;
+}
+
+void Air780EGTLS::setCertificates(const String &ca_cert, const String &client_cert, const String &client_key)
+{
+    setCertificate(CERT_CA, ca_cert);
+    setCertificate(CERT_CLIENT, client_cert);
+    setCertificate(CERT_KEY, client_key);
+}
+
+void Air780EGTLS::setVersion(int version)
+{
+    ssl_version = version;
+    configured = false;
+}
+
+void Air780EGTLS::setIgnoreLocalTime(bool ignore)
+{
+    ignore_local_time = ignore;
+    configured = false;
+}
+
+void Air780EGTLS::setNegotiateTimeout(int seconds)
+{
+    negotiate_timeout = seconds;
+    configured = false;
+}
+
+bool Air780EGTLS::fileSize(const char *name, long &size)
+{
+    String response = core->sendATCommandUntilExpected(String("AT+FSFLSIZE=\"") + name + "\"", "OK", 3000);
+    int pos = response.indexOf("+FSFLSIZE:");
+    if (pos < 0)
+    {
+        return false;
+    }
+    size = response.substring(pos + 10).toInt();
+    return true;
+}
+
+// 按 AT+FSWRITE 的单次上限分块写入：第一块从头写，之后追加
+bool Air780EGTLS::writeFile(const char *name, const String &data)
+{
+    String response = core->sendATCommandUntilExpected(String("AT+FSCREATE=\"") + name + "\"", "OK", 3000);
+    if (response.indexOf("OK") < 0)
+    {
+        AIR780EG_LOGE(TAG, "Failed to create %s", name);
+        return false;
+    }
+    for (size_t offset = 0; offset < data.length(); offset += WRITE_CHUNK)
+    {
+        size_t len = data.length() - offset;
+        if (len > WRITE_CHUNK)
+        {
+            len = WRITE_CHUNK;
+        }
+        String cmd = String("AT+FSWRITE=\"") + name + "\"," + (offset == 0 ? "0," : "1,") + String(len) + ",15";
+        response = core->sendATCommandWithPayload(cmd, data.substring(offset, offset + len), "",
+                                                  AT_PAYLOAD_PROMPT, "OK", 15000);
+        if (response.indexOf("OK") < 0)
+        {
+            AIR780EG_LOGE(TAG, "Failed to write %s at %u: %s", name, (unsigned)offset, response.c_str());
+            return false;
+        }
+        stats.upload_bytes += len;
+    }
+    return true;
+}
+
+// 删除同一上下文、同类证书的旧版本文件
+void Air780EGTLS::removeStaleFiles(int type)
+{
+    char prefix[16];
+    snprintf(prefix, sizeof(prefix), "tls%d_%s_", context_id, certTag(type));
+    String listing = core->sendATCommandUntilExpected("AT+FSLS=\"/\"", "OK", 3000);
+    int start = 0;
+    while (start < (int)listing.length())
+    {
+        int end = listing.indexOf('\n', start);
+        if (end < 0)
+        {
+            end = listing.length();
+        }
+        String line = listing.substring(start, end);
+        line.trim();
+        start = end + 1;
+        int pos = line.indexOf(prefix);
+        if (pos < 0)
+        {
+            continue;
+        }
+        String file = line.substring(pos);
+        if (file != certs[type].name)
+        {
+            AIR780EG_LOGI(TAG, "Removing stale certificate %s", file.c_str());
+            core->sendATCommandUntilExpected("AT+FSDEL=\"" + file + "\"", "OK", 3000);
+        }
+    }
+}
+
+bool Air780EGTLS::installCert(int type)
+{
+    CertFile &cert = certs[type];
+    if (cert.length == 0 || cert.installed)
+    {
+        return true;
+    }
+
+    long size = -1;
+    if (fileSize(cert.name, size) && size == (long)cert.length)
+    {
+        AIR780EG_LOGI(TAG, "Certificate %s already on module", cert.name);
+        stats.cert_reused++;
+    }
+    else
+    {
+        if (cert.pem.isEmpty())
+        {
+            // 内容已释放（例如模块文件被外部删除），需要重新 setCertificate()
+            AIR780EG_LOGE(TAG, "Certificate %s missing on module", cert.name);
+            return false;
+        }
+        AIR780EG_LOGI(TAG, "Uploading certificate %s (%u bytes)", cert.name, (unsigned)cert.length);
+        removeStaleFiles(type);
+        if (!writeFile(cert.name, cert.pem) || !fileSize(cert.name, size) || size != (long)cert.length)
+        {
+            AIR780EG_LOGE(TAG, "Certificate upload failed: %s", cert.name);
+            return false;
+        }
+        stats.cert_uploads++;
+    }
+    cert.installed = true;
+    cert.pem = "";  // 模块上已有，不再占用内存
+    return true;
+}
+
+bool Air780EGTLS::setOption(const char *option, const String &value)
+{
+    String cmd = String("AT+SSLCFG=\"") + option + "\"," + String(context_id) + "," + value;
+    String response = core->sendATCommandUntilExpected(cmd, "OK", 3000);
+    if (response.indexOf("OK") < 0)
+    {
+        AIR780EG_LOGE(TAG, "AT+SSLCFG \"%s\" failed: %s", option, response.c_str());
+        return false;
+    }
+    return true;
+}
+
+int Air780EGTLS::getSecurityLevel() const
+{
+    if (certs[CERT_CA].length == 0)
+    {
+        return 0;
+    }
+    return (certs[CERT_CLIENT].length > 0 && certs[CERT_KEY].length > 0) ? 2 : 1;
+}
+
+bool Air780EGTLS::apply(const String &hostname)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_CORE);
+    if (configured && hostname == configured_host)
+    {
+        return true;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (!installCert(i))
+        {
+            return false;
+        }
+    }
+
+    static const char *const options[3] = {"cacert", "clientcert", "clientkey"};
+    for (int i = 0; i < 3; i++)
+    {
+        if (certs[i].length > 0 && !setOption(options[i], String("\"") + certs[i].name + "\""))
+        {
+            return false;
+        }
+    }
+    int level = getSecurityLevel();
+    if (!setOption("seclevel", String(level)))
+    {
+        return false;
+    }
+    if (ssl_version >= 0 && !setOption("sslversion", String(ssl_version)))
+    {
+        return false;
+    }
+    if (ignore_local_time && !setOption("ignorelocaltime", "1"))
+    {
+        return false;
+    }
+    if (negotiate_timeout > 0 && !setOption("negotiatetimeout", String(negotiate_timeout)))
+    {
+        return false;
+    }
+    // 按域名校验证书；连接时即使使用缓存的IP也不受影响
+    if (level > 0 && !hostname.isEmpty() && !setOption("hostname", "\"" + hostname + "\""))
+    {
+        return false;
+    }
+
+    AIR780EG_LOGI(TAG, "SSL context %d configured, seclevel %d", context_id, level);
+    configured = true;
+    configured_host = hostname;
+    next_handshake_cold = true;
+    return true;
+}
+
+void Air780EGTLS::invalidate()
+{
+    configured = false;
+    for (int i = 0; i < 3; i++)
+    {
+        certs[i].installed = false;
+    }
+}
+
+bool Air780EGTLS::isConfigured() const
+{
+    return configured;
+}
+
+const char *Air780EGTLS::getCertFileName(CertType type) const
+{
+    return certs[type].name;
+}
+
+void Air780EGTLS::recordHandshake(unsigned long elapsed_ms)
+{
+    stats.handshakes++;
+    stats.last_handshake_ms = elapsed_ms;
+    if (elapsed_ms > stats.max_handshake_ms)
+    {
+        stats.max_handshake_ms = elapsed_ms;
+    }
+    if (next_handshake_cold)
+    {
+        next_handshake_cold = false;
+        stats.cold_handshakes++;
+        stats.cold_handshake_ms = elapsed_ms;
+        AIR780EG_LOGI(TAG, "Handshake (first after configuration): %lu ms", elapsed_ms);
+        return;
+    }
+    uint32_t warm = stats.handshakes - stats.cold_handshakes;
+    stats.warm_avg_ms = (stats.warm_avg_ms * (warm - 1) + elapsed_ms) / warm;
+    AIR780EG_LOGI(TAG, "Handshake: %lu ms (first %lu ms, later average %lu ms)",
+                  elapsed_ms, stats.cold_handshake_ms, stats.warm_avg_ms);
+}
+
+Air780EGTLSStats Air780EGTLS::getStats() const
+{
+    return stats;
+}
+
+void Air780EGTLS::resetStats()
+{
+    stats = Air780EGTLSStats();
+    next_handshake_cold = true;
+}
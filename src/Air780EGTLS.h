@@ -0,0 +1,99 @@
+#ifndef AIR780EG_TLS_H
+#define AIR780EG_TLS_H
+
+#include <Arduino.h>
+#include "Air780EGCore.h"
+
+/*
+ * 模块SSL上下文配置（AT+SSLCFG）和证书文件管理
+ *
+ * 证书写入模块文件系统（AT+FSCREATE / AT+FSWRITE），文件名包含内容的哈希：
+ *   tls<上下文>_<ca|crt|key>_<FNV-1a 8位十六进制>.pem
+ * 应用前用 AT+FSFLSIZE 查询该文件，存在且长度一致即复用，不再每次上电重新上传；
+ * 证书内容变化时上传新文件并删除同类的旧文件。
+ *
+ * 上下文ID：MQTT 为 88，HTTP 为 153，FTP 为 34。
+ * 固件的 AT+SSLCFG 没有会话复用（session resumption）选项，统计中分别记录配置后第一次握手
+ * 和之后的握手耗时，用于比较完整握手和固件内部可能的会话复用。
+ */
+
+#define AIR780EG_SSL_CTX_MQTT 88
+#define AIR780EG_SSL_CTX_HTTP 153
+
+// 握手和证书统计
+struct Air780EGTLSStats {
+    uint32_t cert_uploads;           // 上传的证书文件数
+    uint32_t cert_reused;            // 模块上已有、跳过上传的证书文件数
+    uint32_t upload_bytes;
+    uint32_t handshakes;
+    uint32_t cold_handshakes;          // 配置SSL上下文后的第一次握手（一定是完整握手）
+    unsigned long cold_handshake_ms;   // 最近一次配置后第一次握手的耗时
+    unsigned long warm_avg_ms;         // 之后握手的平均耗时
+    unsigned long last_handshake_ms;
+    unsigned long max_handshake_ms;
+};
+
+class Air780EGTLS {
+public:
+    enum CertType {
+        CERT_CA = 0,
+        CERT_CLIENT = 1,
+        CERT_KEY = 2
+    };
+
+private:
+    static const char* TAG;
+    static const size_t WRITE_CHUNK = 10240;  // AT+FSWRITE 单次上限
+
+    struct CertFile {
+        String pem;          // 等待上传的内容，上传或确认后释放
+        char name[32];
+        uint32_t hash;
+        size_t length;
+        bool installed;      // 模块上已确认存在
+    };
+
+    Air780EGCore* core;
+    int context_id;
+    CertFile certs[3];
+    int ssl_version = -1;           // -1 使用固件默认
+    bool ignore_local_time = false;
+    int negotiate_timeout = 0;      // 秒，0 使用固件默认
+    bool configured = false;
+    bool next_handshake_cold = true;
+    String configured_host;
+    Air780EGTLSStats stats = Air780EGTLSStats();
+
+    static const char* certTag(int type);
+    bool installCert(int type);
+    bool fileSize(const char* name, long& size);
+    bool writeFile(const char* name, const String& data);
+    void removeStaleFiles(int type);
+    bool setOption(const char* option, const String& value);
+
+public:
+    Air780EGTLS(Air780EGCore* core_instance, int ssl_context_id);
+
+    static uint32_t hash(const char* data, size_t len);
+
+    // 证书为PEM文本，空字符串表示不使用；调用后下一次 apply() 时检查并上传
+    void setCertificate(CertType type, const String& pem);
+    void setCertificates(const String& ca_cert, const String& client_cert, const String& client_key);
+    void setVersion(int version);                // 0 SSL3.0 / 1 TLS1.0 / 2 TLS1.1 / 3 TLS1.2 / 4 全部
+    void setIgnoreLocalTime(bool ignore);        // 模块时间未同步时不检查证书有效期
+    void setNegotiateTimeout(int seconds);       // 10~300
+
+    // 上传缺少的证书并设置SSL上下文；已配置且主机名不变时直接返回
+    // hostname 用于证书域名校验（按缓存IP连接时仍按域名校验）
+    bool apply(const String& hostname);
+    void invalidate();                           // 模块重启后需要重新配置
+    bool isConfigured() const;
+    int getSecurityLevel() const;                // 0 不认证 / 1 认证服务器 / 2 双向认证
+    const char* getCertFileName(CertType type) const;
+
+    void recordHandshake(unsigned long elapsed_ms);
+    Air780EGTLSStats getStats() const;
+    void resetStats();
+};
+
+#endif // AIR780EG_TLS_H
@@ -0,0 +1,503 @@
+#include "Air780EGTopicTrie.h"
+#include "Air780EGDebug.h"
+#include "Air780EGHeapTrace.h"
+
+static const char *TAG = "TopicTrie";
+
+Air780EGTopicTrie::Air780EGTopicTrie()
+{
+}
+
+Air780EGTopicTrie::~Air780EGTopicTrie()
+{
+    delete[] nodes;
+    delete[] text_pool;
+    delete[] edges;
+}
+
+// FNV-1a
+uint32_t Air780EGTopicTrie::hashLevel(const char *text, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (uint8_t)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t Air780EGTopicTrie::edgeSlot(int parent, uint32_t hash)
+{
+    uint32_t slot = hash ^ ((uint32_t)parent * 2654435761u);
+    return slot ^ (slot >> 16);
+}
+
+bool Air780EGTopicTrie::isValidFilter(const char *filter)
+{
+    if (filter == nullptr || filter[0] == '\0')
+    {
+        return false;
+    }
+    const char *level = filter;
+    while (true)
+    {
+        const char *slash = strchr(level, '/');
+        size_t len = slash ? (size_t)(slash - level) : strlen(level);
+        for (size_t i = 0; i < len; i++)
+        {
+            if ((level[i] == '+' || level[i] == '#') && len != 1)
+            {
+                return false;
+            }
+        }
+        if (len > 0xFFFF || (len == 1 && level[0] == '#' && slash))
+        {
+            return false;
+        }
+        if (!slash)
+        {
+            return true;
+        }
+        level = slash + 1;
+    }
+}
+
+bool Air780EGTopicTrie::reserveNodes(int count)
+{
+    if (count <= node_capacity)
+    {
+        return true;
+    }
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    int capacity = node_capacity > 0 ? node_capacity : 8;
+    while (capacity < count)
+    {
+        capacity *= 2;
+    }
+    Node *grown = new Node[capacity];
+    if (node_count > 0)
+    {
+        memcpy(grown, nodes, node_count * sizeof(Node));
+    }
+    delete[] nodes;
+    nodes = grown;
+    node_capacity = capacity;
+    rebuildEdges();
+    return true;
+}
+
+bool Air780EGTopicTrie::reserveText(uint32_t len)
+{
+    if (text_used + len <= text_capacity)
+    {
+        return true;
+    }
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    uint32_t capacity = text_capacity > 0 ? text_capacity : 64;
+    while (capacity < text_used + len)
+    {
+        capacity *= 2;
+    }
+    char *grown = new char[capacity];
+    if (text_used > 0)
+    {
+        memcpy(grown, text_pool, text_used);
+    }
+    delete[] text_pool;
+    text_pool = grown;
+    text_capacity = capacity;
+    return true;
+}
+
+// 查找表大小跟随节点容量，负载不超过一半，线性探测一般一两次命中
+void Air780EGTopicTrie::rebuildEdges()
+{
+    uint32_t size = 16;
+    while (size < (uint32_t)node_capacity * 2)
+    {
+        size *= 2;
+    }
+    delete[] edges;
+    edges = new int[size];
+    edge_mask = size - 1;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        edges[i] = -1;
+    }
+    for (int i = 1; i < node_count; i++)
+    {
+        const Node &node = nodes[i];
+        if (nodes[node.parent].plus_child == i || nodes[node.parent].hash_child == i)
+        {
+            continue;
+        }
+        uint32_t slot = edgeSlot(node.parent, node.hash) & edge_mask;
+        while (edges[slot] >= 0)
+        {
+            slot = (slot + 1) & edge_mask;
+        }
+        edges[slot] = i;
+    }
+}
+
+int Air780EGTopicTrie::findChild(int parent, const char *text, size_t len) const
+{
+    if (edges == nullptr)
+    {
+        return -1;
+    }
+    uint32_t hash = hashLevel(text, len);
+    for (uint32_t slot = edgeSlot(parent, hash) & edge_mask;; slot = (slot + 1) & edge_mask)
+    {
+        int index = edges[slot];
+        if (index < 0)
+        {
+            return -1;
+        }
+        const Node &node = nodes[index];
+        if (node.parent == parent && node.hash == hash && node.text_len == len &&
+            memcmp(text_pool + node.text_offset, text, len) == 0)
+        {
+            return index;
+        }
+    }
+}
+
+int Air780EGTopicTrie::createChild(int parent, const char *text, size_t len)
+{
+    if (!reserveNodes(node_count + 1) || !reserveText(len))
+    {
+        return -1;
+    }
+    int index = node_count++;
+    Node &node = nodes[index];
+    node.hash = hashLevel(text, len);
+    node.parent = parent;
+    node.text_offset = text_used;
+    node.text_len = len;
+    node.plus_child = -1;
+    node.hash_child = -1;
+    node.handler = nullptr;
+    node.context = nullptr;
+    node.qos = -1;
+    if (len > 0)
+    {
+        // 根节点没有文本，文本池可能尚未分配
+        memcpy(text_pool + text_used, text, len);
+        text_used += len;
+    }
+
+    if (parent < 0)
+    {
+        return index;
+    }
+    if (len == 1 && text[0] == '+')
+    {
+        nodes[parent].plus_child = index;
+    }
+    else if (len == 1 && text[0] == '#')
+    {
+        nodes[parent].hash_child = index;
+    }
+    else
+    {
+        uint32_t slot = edgeSlot(parent, node.hash) & edge_mask;
+        while (edges[slot] >= 0)
+        {
+            slot = (slot + 1) & edge_mask;
+        }
+        edges[slot] = index;
+    }
+    return index;
+}
+
+int Air780EGTopicTrie::findFilter(const char *filter) const
+{
+    if (node_count == 0 || !isValidFilter(filter))
+    {
+        return -1;
+    }
+    int node = 0;
+    const char *level = filter;
+    while (node >= 0)
+    {
+        const char *slash = strchr(level, '/');
+        size_t len = slash ? (size_t)(slash - level) : strlen(level);
+        if (len == 1 && level[0] == '+')
+        {
+            node = nodes[node].plus_child;
+        }
+        else if (len == 1 && level[0] == '#')
+        {
+            node = nodes[node].hash_child;
+        }
+        else
+        {
+            node = findChild(node, level, len);
+        }
+        if (!slash)
+        {
+            break;
+        }
+        level = slash + 1;
+    }
+    return node;
+}
+
+int Air780EGTopicTrie::insertFilter(const char *filter)
+{
+    if (!isValidFilter(filter))
+    {
+        AIR780EG_LOGW(TAG, "Invalid topic filter: %s", filter ? filter : "(null)");
+        return -1;
+    }
+    if (node_count == 0 && createChild(-1, "", 0) < 0)
+    {
+        return -1;
+    }
+    int node = 0;
+    const char *level = filter;
+    while (true)
+    {
+        const char *slash = strchr(level, '/');
+        size_t len = slash ? (size_t)(slash - level) : strlen(level);
+        int child;
+        if (len == 1 && level[0] == '+')
+        {
+            child = nodes[node].plus_child;
+        }
+        else if (len == 1 && level[0] == '#')
+        {
+            child = nodes[node].hash_child;
+        }
+        else
+        {
+            child = findChild(node, level, len);
+        }
+        if (child < 0)
+        {
+            child = createChild(node, level, len);
+            if (child < 0)
+            {
+                return -1;
+            }
+        }
+        node = child;
+        if (!slash)
+        {
+            return node;
+        }
+        level = slash + 1;
+    }
+}
+
+bool Air780EGTopicTrie::setHandler(const char *filter, MQTTTopicHandler handler, void *context)
+{
+    if (handler == nullptr)
+    {
+        return removeHandler(filter);
+    }
+    int node = insertFilter(filter);
+    if (node < 0)
+    {
+        return false;
+    }
+    if (nodes[node].handler == nullptr)
+    {
+        handler_count++;
+    }
+    nodes[node].handler = handler;
+    nodes[node].context = context;
+    return true;
+}
+
+bool Air780EGTopicTrie::removeHandler(const char *filter)
+{
+    int node = findFilter(filter);
+    if (node < 0 || nodes[node].handler == nullptr)
+    {
+        return false;
+    }
+    nodes[node].handler = nullptr;
+    nodes[node].context = nullptr;
+    handler_count--;
+    return true;
+}
+
+bool Air780EGTopicTrie::hasHandler(const char *filter) const
+{
+    int node = findFilter(filter);
+    return node >= 0 && nodes[node].handler != nullptr;
+}
+
+bool Air780EGTopicTrie::setSubscribed(const char *filter, int qos)
+{
+    int node = qos < 0 ? findFilter(filter) : insertFilter(filter);
+    if (node < 0)
+    {
+        return qos < 0;
+    }
+    bool was_subscribed = nodes[node].qos >= 0;
+    nodes[node].qos = qos < 0 ? -1 : (qos > 2 ? 2 : qos);
+    if (was_subscribed != (qos >= 0))
+    {
+        subscription_count += qos >= 0 ? 1 : -1;
+    }
+    return true;
+}
+
+int Air780EGTopicTrie::getSubscribedQos(const char *filter) const
+{
+    int node = findFilter(filter);
+    return node >= 0 ? nodes[node].qos : -1;
+}
+
+// 从节点回溯到根拼出过滤器，返回长度；缓冲区不足时返回0
+size_t Air780EGTopicTrie::buildFilter(int node, char *buffer, size_t size) const
+{
+    size_t len = 0;
+    for (int i = node; i > 0; i = nodes[i].parent)
+    {
+        len += nodes[i].text_len + (nodes[i].parent > 0 ? 1 : 0);
+    }
+    if (len + 1 > size)
+    {
+        return 0;
+    }
+    buffer[len] = '\0';
+    size_t pos = len;
+    for (int i = node; i > 0; i = nodes[i].parent)
+    {
+        pos -= nodes[i].text_len;
+        memcpy(buffer + pos, text_pool + nodes[i].text_offset, nodes[i].text_len);
+        if (nodes[i].parent > 0)
+        {
+            buffer[--pos] = '/';
+        }
+    }
+    return len;
+}
+
+// 访问者中可以重新订阅同一过滤器（重连恢复订阅）
+int Air780EGTopicTrie::forEachSubscription(MQTTSubscriptionVisitor visitor, void *context) const
+{
+    int visited = 0;
+    char buffer[128];
+    for (int i = 1; i < node_count; i++)
+    {
+        if (nodes[i].qos < 0)
+        {
+            continue;
+        }
+        int qos = nodes[i].qos;
+        if (buildFilter(i, buffer, sizeof(buffer)) > 0)
+        {
+            visitor(buffer, qos, context);
+        }
+        else
+        {
+            // 超长过滤器很少见，临时分配
+            size_t len = 0;
+            for (int n = i; n > 0; n = nodes[n].parent)
+            {
+                len += nodes[n].text_len + 1;
+            }
+            char *filter = new char[len + 1];
+            buildFilter(i, filter, len + 1);
+            visitor(filter, qos, context);
+            delete[] filter;
+        }
+        visited++;
+    }
+    return visited;
+}
+
+// 处理器中可能注册新的过滤器导致节点数组扩容，这里只按下标访问节点
+int Air780EGTopicTrie::fire(int node, const char *topic, size_t topic_len,
+                            const uint8_t *payload, size_t payload_len) const
+{
+    MQTTTopicHandler handler = nodes[node].handler;
+    if (handler == nullptr)
+    {
+        return 0;
+    }
+    handler(topic, topic_len, payload, payload_len, nodes[node].context);
+    return 1;
+}
+
+// 主题在该节点结束：节点本身和它的 '#' 子节点（"a/#" 也匹配 "a"）
+int Air780EGTopicTrie::fireLevelEnd(int node, const char *topic, size_t topic_len,
+                                    const uint8_t *payload, size_t payload_len) const
+{
+    int hash_child = nodes[node].hash_child;
+    int calls = fire(node, topic, topic_len, payload, payload_len);
+    if (hash_child >= 0)
+    {
+        calls += fire(hash_child, topic, topic_len, payload, payload_len);
+    }
+    return calls;
+}
+
+int Air780EGTopicTrie::matchLevel(int node, const char *level, const char *topic, size_t topic_len,
+                                  const uint8_t *payload, size_t payload_len) const
+{
+    const char *end = topic + topic_len;
+    const char *slash = (const char *)memchr(level, '/', end - level);
+    size_t len = (slash ? slash : end) - level;
+    bool wildcard = !(level == topic && len > 0 && level[0] == '$');
+
+    int exact = findChild(node, level, len);
+    int plus = wildcard ? nodes[node].plus_child : -1;
+    int hash = wildcard ? nodes[node].hash_child : -1;
+
+    int calls = 0;
+    if (hash >= 0)
+    {
+        calls += fire(hash, topic, topic_len, payload, payload_len);
+    }
+    int candidates[2] = {exact, plus};
+    for (int i = 0; i < 2; i++)
+    {
+        if (candidates[i] < 0)
+        {
+            continue;
+        }
+        if (slash)
+        {
+            calls += matchLevel(candidates[i], slash + 1, topic, topic_len, payload, payload_len);
+        }
+        else
+        {
+            calls += fireLevelEnd(candidates[i], topic, topic_len, payload, payload_len);
+        }
+    }
+    return calls;
+}
+
+int Air780EGTopicTrie::dispatch(const char *topic, size_t topic_len,
+                                const uint8_t *payload, size_t payload_len) const
+{
+    if (handler_count == 0 || topic == nullptr)
+    {
+        return 0;
+    }
+    return matchLevel(0, topic, topic, topic_len, payload, payload_len);
+}
+
+void Air780EGTopicTrie::clear()
+{
+    node_count = 0;
+    text_used = 0;
+    handler_count = 0;
+    subscription_count = 0;
+    for (uint32_t i = 0; edges && i <= edge_mask; i++)
+    {
+        edges[i] = -1;
+    }
+}
+
+size_t Air780EGTopicTrie::getMemoryUsage() const
+{
+    return node_capacity * sizeof(Node) + text_capacity + (edges ? (edge_mask + 1) * sizeof(int) : 0);
+}
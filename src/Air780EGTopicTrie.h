@@ -0,0 +1,104 @@
+#ifndef AIR780EG_TOPIC_TRIE_H
+#define AIR780EG_TOPIC_TRIE_H
+
+#include <Arduino.h>
+
+/*
+ * MQTT 主题过滤器前缀树
+ *
+ * 每个过滤器按 '/' 拆成层级，一个层级一个节点；过滤器的最后一个节点保存处理器和订阅QoS。
+ * '+' 和 '#' 子节点直接挂在父节点上，普通子节点通过 (父节点, 层级哈希) 开放寻址表查找，
+ * 所以分发开销只和主题层数、命中的通配符分支有关，与订阅数量无关。
+ *
+ * 节点、层级文本和查找表在订阅时按需扩容（容量翻倍），分发时不分配内存。
+ * 取消订阅只清除节点上的处理器和QoS，节点保留给之后的订阅复用。
+ *
+ * 匹配规则按 MQTT 3.1.1：
+ *   "a/+/c" 匹配 "a/b/c"；"a/#" 匹配 "a"、"a/b"、"a/b/c"
+ *   以 '$' 开头的主题（如 "$SYS/..."）不匹配首层的 '+' 和 '#'
+ */
+
+// 主题处理器：topic / payload 指向接收缓冲区，只在回调期间有效
+typedef void (*MQTTTopicHandler)(const char* topic, size_t topic_len,
+                                 const uint8_t* payload, size_t payload_len, void* context);
+
+// 遍历订阅：filter 为以0结尾的过滤器
+typedef void (*MQTTSubscriptionVisitor)(const char* filter, int qos, void* context);
+
+class Air780EGTopicTrie {
+private:
+    struct Node {
+        uint32_t hash;         // 层级文本哈希
+        int parent;
+        uint32_t text_offset;  // 层级文本在 text_pool 中的位置
+        uint16_t text_len;
+        int plus_child;        // '+' 子节点
+        int hash_child;        // '#' 子节点
+        MQTTTopicHandler handler;
+        void* context;
+        int8_t qos;            // 订阅QoS，-1 表示未订阅
+    };
+
+    Node* nodes = nullptr;
+    int node_count = 0;
+    int node_capacity = 0;
+
+    char* text_pool = nullptr;
+    uint32_t text_used = 0;
+    uint32_t text_capacity = 0;
+
+    // 普通子节点查找表，保存节点下标，-1 为空槽；大小为2的幂且不小于节点容量的2倍
+    int* edges = nullptr;
+    uint32_t edge_mask = 0;
+
+    int handler_count = 0;
+    int subscription_count = 0;
+
+    static uint32_t hashLevel(const char* text, size_t len);
+    static uint32_t edgeSlot(int parent, uint32_t hash);
+
+    bool reserveNodes(int count);
+    bool reserveText(uint32_t len);
+    void rebuildEdges();
+    int findChild(int parent, const char* text, size_t len) const;
+    int createChild(int parent, const char* text, size_t len);
+    int findFilter(const char* filter) const;
+    int insertFilter(const char* filter);
+
+    int fire(int node, const char* topic, size_t topic_len,
+             const uint8_t* payload, size_t payload_len) const;
+    int fireLevelEnd(int node, const char* topic, size_t topic_len,
+                     const uint8_t* payload, size_t payload_len) const;
+    int matchLevel(int node, const char* level, const char* topic, size_t topic_len,
+                   const uint8_t* payload, size_t payload_len) const;
+    size_t buildFilter(int node, char* buffer, size_t size) const;
+
+public:
+    Air780EGTopicTrie();
+    ~Air780EGTopicTrie();
+
+    // 过滤器是否合法：'+' 必须独占一层，'#' 必须独占最后一层
+    static bool isValidFilter(const char* filter);
+
+    // 注册处理器，同一过滤器再次注册时替换；handler 为空等同于 removeHandler
+    bool setHandler(const char* filter, MQTTTopicHandler handler, void* context = nullptr);
+    bool removeHandler(const char* filter);
+    bool hasHandler(const char* filter) const;
+
+    // 记录订阅状态，qos < 0 表示已取消订阅
+    bool setSubscribed(const char* filter, int qos);
+    int getSubscribedQos(const char* filter) const;  // 未订阅返回 -1
+    int forEachSubscription(MQTTSubscriptionVisitor visitor, void* context) const;
+
+    // 调用所有匹配的处理器，返回调用次数
+    int dispatch(const char* topic, size_t topic_len, const uint8_t* payload, size_t payload_len) const;
+
+    void clear();
+
+    int getHandlerCount() const { return handler_count; }
+    int getSubscriptionCount() const { return subscription_count; }
+    int getNodeCount() const { return node_count; }
+    size_t getMemoryUsage() const;
+};
+
+#endif // AIR780EG_TOPIC_TRIE_H
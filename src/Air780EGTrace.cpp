@@ -0,0 +1,252 @@
+#include "Air780EGTrace.h"
+#include "Air780EGDebug.h"
+
+const char *Air780EGTrace::TAG = "Trace";
+
+Air780EGTraceEvent *Air780EGTrace::events = nullptr;
+size_t Air780EGTrace::capacity = 0;
+size_t Air780EGTrace::head = 0;
+size_t Air780EGTrace::count = 0;
+uint32_t Air780EGTrace::dropped = 0;
+uint16_t Air780EGTrace::next_id = 1;
+unsigned long Air780EGTrace::start_us = 0;
+
+bool Air780EGTrace::begin(size_t max_events)
+{
+    end();
+    if (max_events == 0)
+    {
+        return false;
+    }
+
+    events = (Air780EGTraceEvent *)malloc(max_events * sizeof(Air780EGTraceEvent));
+    if (!events)
+    {
+        AIR780EG_LOGE(TAG, "Failed to allocate %u trace events", (unsigned)max_events);
+        return false;
+    }
+    capacity = max_events;
+    clear();
+    AIR780EG_LOGI(TAG, "Trace started, %u events", (unsigned)max_events);
+    return true;
+}
+
+void Air780EGTrace::end()
+{
+    if (events)
+    {
+        free(events);
+        events = nullptr;
+    }
+    capacity = 0;
+    head = 0;
+    count = 0;
+}
+
+bool Air780EGTrace::isEnabled()
+{
+    return events != nullptr;
+}
+
+void Air780EGTrace::clear()
+{
+    head = 0;
+    count = 0;
+    dropped = 0;
+    start_us = micros();
+}
+
+uint16_t Air780EGTrace::newId()
+{
+    if (!events)
+    {
+        return 0;
+    }
+    uint16_t id = next_id++;
+    if (next_id == 0)
+    {
+        next_id = 1;
+    }
+    return id;
+}
+
+void Air780EGTrace::push(uint16_t id, char ph, Air780EGTracePhase phase, const char *label,
+                         Air780EGTraceResult result)
+{
+    Air780EGTraceEvent &ev = events[head];
+    ev.ts_us = micros() - start_us;
+    ev.id = id;
+    ev.ph = ph;
+    ev.phase = phase;
+    ev.result = result;
+    if (label)
+    {
+        strncpy(ev.label, label, AIR780EG_TRACE_LABEL_LEN - 1);
+        ev.label[AIR780EG_TRACE_LABEL_LEN - 1] = '\0';
+    }
+    else
+    {
+        ev.label[0] = '\0';
+    }
+
+    head = (head + 1) % capacity;
+    if (count < capacity)
+    {
+        count++;
+    }
+    else
+    {
+        dropped++;
+    }
+}
+
+void Air780EGTrace::commandBegin(uint16_t id, const char *label)
+{
+    if (!events || id == 0)
+        return;
+    push(id, 'b', AIR780EG_TRACE_COMMAND, label);
+}
+
+void Air780EGTrace::commandEnd(uint16_t id, const char *label, Air780EGTraceResult result)
+{
+    if (!events || id == 0)
+        return;
+    push(id, 'e', AIR780EG_TRACE_COMMAND, label, result);
+}
+
+void Air780EGTrace::phaseBegin(uint16_t id, Air780EGTracePhase phase)
+{
+    if (!events || id == 0)
+        return;
+    push(id, 'b', phase, nullptr);
+}
+
+void Air780EGTrace::phaseEnd(uint16_t id, Air780EGTracePhase phase)
+{
+    if (!events || id == 0)
+        return;
+    push(id, 'e', phase, nullptr);
+}
+
+void Air780EGTrace::instant(Air780EGTracePhase phase, const char *label)
+{
+    if (!events)
+        return;
+    push(0, 'i', phase, label);
+}
+
+Air780EGTraceResult Air780EGTrace::resultOf(const String &response)
+{
+    if (response.length() == 0 || response == "TIMEOUT")
+        return AIR780EG_TRACE_RESULT_TIMEOUT;
+    if (response.indexOf("ERROR") >= 0)
+        return AIR780EG_TRACE_RESULT_ERROR;
+    return AIR780EG_TRACE_RESULT_OK;
+}
+
+const char *Air780EGTrace::phaseName(Air780EGTracePhase phase)
+{
+    switch (phase)
+    {
+    case AIR780EG_TRACE_COMMAND:  return "command";
+    case AIR780EG_TRACE_QUEUED:   return "queued";
+    case AIR780EG_TRACE_SPACING:  return "spacing";
+    case AIR780EG_TRACE_TX:       return "tx";
+    case AIR780EG_TRACE_AWAIT:    return "await";
+    case AIR780EG_TRACE_RESPONSE: return "response";
+    case AIR780EG_TRACE_CALLBACK: return "callback";
+    case AIR780EG_TRACE_URC:      return "URC";
+    default:                      return "unknown";
+    }
+}
+
+const char *Air780EGTrace::resultName(Air780EGTraceResult result)
+{
+    switch (result)
+    {
+    case AIR780EG_TRACE_RESULT_OK:      return "OK";
+    case AIR780EG_TRACE_RESULT_ERROR:   return "ERROR";
+    case AIR780EG_TRACE_RESULT_TIMEOUT: return "TIMEOUT";
+    default:                            return "";
+    }
+}
+
+size_t Air780EGTrace::writeEscaped(Print &out, const char *text)
+{
+    size_t written = 0;
+    for (const char *p = text; *p; p++)
+    {
+        char c = *p;
+        if (c == '"' || c == '\\')
+        {
+            written += out.print('\\');
+            written += out.print(c);
+        }
+        else if ((uint8_t)c < 0x20)
+        {
+            written += out.printf("\\u%04x", (uint8_t)c);
+        }
+        else
+        {
+            written += out.print(c);
+        }
+    }
+    return written;
+}
+
+size_t Air780EGTrace::exportJSON(Print &out)
+{
+    size_t written = 0;
+    written += out.print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    written += out.print("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Air780EG\"}}");
+
+    if (events)
+    {
+        size_t start = (head + capacity - count) % capacity;
+        for (size_t i = 0; i < count; i++)
+        {
+            const Air780EGTraceEvent &ev = events[(start + i) % capacity];
+            Air780EGTracePhase phase = (Air780EGTracePhase)ev.phase;
+
+            written += out.print(",\n{\"name\":\"");
+            if (phase == AIR780EG_TRACE_COMMAND && ev.label[0])
+            {
+                written += writeEscaped(out, ev.label);
+            }
+            else
+            {
+                written += out.print(phaseName(phase));
+            }
+
+            if (ev.ph == 'i')
+            {
+                written += out.printf("\",\"cat\":\"urc\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lu,\"pid\":1,\"tid\":1,\"args\":{\"text\":\"",
+                                      (unsigned long)ev.ts_us);
+                written += writeEscaped(out, ev.label);
+                written += out.print("\"}}");
+                continue;
+            }
+
+            written += out.printf("\",\"cat\":\"at\",\"ph\":\"%c\",\"id\":%u,\"ts\":%lu,\"pid\":1,\"tid\":1",
+                                  ev.ph, ev.id, (unsigned long)ev.ts_us);
+            if (ev.result != AIR780EG_TRACE_RESULT_NONE)
+            {
+                written += out.printf(",\"args\":{\"result\":\"%s\"}", resultName((Air780EGTraceResult)ev.result));
+            }
+            written += out.print("}");
+        }
+    }
+
+    written += out.print("\n]}\n");
+    return written;
+}
+
+size_t Air780EGTrace::getEventCount()
+{
+    return count;
+}
+
+uint32_t Air780EGTrace::getDroppedCount()
+{
+    return dropped;
+}
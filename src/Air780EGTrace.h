@@ -0,0 +1,96 @@
+#ifndef AIR780EG_TRACE_H
+#define AIR780EG_TRACE_H
+
+#include <Arduino.h>
+
+/*
+ * AT命令生命周期追踪，导出为 Chrome Trace Event JSON（可直接用 Perfetto / chrome://tracing 打开）
+ *
+ * 每条AT命令是一个异步span，内部按阶段嵌套：
+ *   queued   入队 -> 出队（仅异步队列）
+ *   spacing  等待AT指令最小间隔
+ *   tx       写串口
+ *   await    发送完成 -> 收到第一个字节
+ *   response 第一个字节 -> 完整响应
+ *   callback 完成回调
+ * URC分发记为瞬时事件。
+ *
+ * 事件写入预分配的环形缓冲区，写满后覆盖最早的事件；未调用 begin() 时所有钩子直接返回。
+ */
+
+// 事件阶段
+enum Air780EGTracePhase {
+    AIR780EG_TRACE_COMMAND = 0,
+    AIR780EG_TRACE_QUEUED,
+    AIR780EG_TRACE_SPACING,
+    AIR780EG_TRACE_TX,
+    AIR780EG_TRACE_AWAIT,
+    AIR780EG_TRACE_RESPONSE,
+    AIR780EG_TRACE_CALLBACK,
+    AIR780EG_TRACE_URC
+};
+
+// 命令结果
+enum Air780EGTraceResult {
+    AIR780EG_TRACE_RESULT_NONE = 0,
+    AIR780EG_TRACE_RESULT_OK,
+    AIR780EG_TRACE_RESULT_ERROR,
+    AIR780EG_TRACE_RESULT_TIMEOUT
+};
+
+#define AIR780EG_TRACE_LABEL_LEN 24
+
+struct Air780EGTraceEvent {
+    uint32_t ts_us;
+    uint16_t id;
+    char ph;        // 'b' 开始, 'e' 结束, 'i' 瞬时
+    uint8_t phase;  // Air780EGTracePhase
+    uint8_t result; // Air780EGTraceResult
+    char label[AIR780EG_TRACE_LABEL_LEN];
+};
+
+class Air780EGTrace {
+private:
+    static const char* TAG;
+
+    static Air780EGTraceEvent* events;
+    static size_t capacity;
+    static size_t head;
+    static size_t count;
+    static uint32_t dropped;
+    static uint16_t next_id;
+    static unsigned long start_us;
+
+    static void push(uint16_t id, char ph, Air780EGTracePhase phase, const char* label,
+                     Air780EGTraceResult result = AIR780EG_TRACE_RESULT_NONE);
+    static size_t writeEscaped(Print& out, const char* text);
+    static const char* phaseName(Air780EGTracePhase phase);
+    static const char* resultName(Air780EGTraceResult result);
+
+public:
+    // 分配事件缓冲区并开始追踪
+    static bool begin(size_t max_events = 256);
+    static void end();
+    static bool isEnabled();
+    static void clear();
+
+    // 钩子（由Core调用）
+    static uint16_t newId();
+    static void commandBegin(uint16_t id, const char* label);
+    static void commandEnd(uint16_t id, const char* label, Air780EGTraceResult result);
+    static void phaseBegin(uint16_t id, Air780EGTracePhase phase);
+    static void phaseEnd(uint16_t id, Air780EGTracePhase phase);
+    static void instant(Air780EGTracePhase phase, const char* label);
+
+    // 根据响应内容判断结果
+    static Air780EGTraceResult resultOf(const String& response);
+
+    // 导出 Chrome Trace Event JSON（设备上可直接输出到Serial）
+    static size_t exportJSON(Print& out);
+
+    // 统计
+    static size_t getEventCount();
+    static uint32_t getDroppedCount();
+};
+
+#endif // AIR780EG_TRACE_H
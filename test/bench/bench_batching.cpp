@@ -0,0 +1,162 @@
+// 遥测批量发布（user-035）：600个1秒间隔、约90字节的轨迹点，逐条 publishAsync() 与经 Air780EGBatcher
+// 攒批（上限1024字节，窗口30秒）比较 MPUB 次数、串口字节数、每个样本的堆分配和 add()+loop() 耗时。
+// 原始模式下从模块收到的数据中数出全部样本，确认攒批不丢样本且顺序不变
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <chrono>
+#include <vector>
+
+static const int SAMPLES = 600;
+static int publishes = 0;
+static std::vector<int> seen;  // 模块收到的样本序号
+
+static void countSamples(const std::string& data)
+{
+    size_t pos = 0;
+    while ((pos = data.find("{\"seq\":", pos)) != std::string::npos)
+    {
+        pos += 7;
+        seen.push_back(atoi(data.c_str() + pos));
+    }
+}
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line.rfind("AT+MPUBEX=", 0) == 0)
+    {
+        modem.expectData(std::stoul(line.substr(line.rfind(',') + 1)));
+        modem.reply(2, "\r\n>");
+    }
+    else if (line.rfind("AT+MPUB=", 0) == 0)
+    {
+        publishes++;
+        modem.reply(20, "\r\nOK\r\n");
+    }
+    else if (line == "AT+MQTTSTATU")
+    {
+        modem.inject("\r\n+MQTTSTATU :1\r\n\r\nOK\r\n");
+    }
+    else
+    {
+        modem.inject("\r\nOK\r\n");
+    }
+}
+
+static void answerData(host::FakeModem& modem, const std::string& data)
+{
+    publishes++;
+    countSamples(data);
+    modem.reply(20, "\r\nOK\r\n");
+}
+
+static String sample(int seq)
+{
+    char text[128];
+    snprintf(text, sizeof(text), "{\"seq\":%d,\"lat\":31.%07d,\"lng\":121.%07d,\"spd\":%d.%d,\"hdg\":%d,\"alt\":12.5,\"sat\":12}", seq,
+             2304160 + seq * 37, 4737010 + seq * 53, 30 + seq % 20, seq % 10, seq % 360);
+    return text;
+}
+
+struct Result {
+    int mpubs;
+    size_t uart_bytes;
+    double allocs_per_sample;
+    double us_per_sample;
+};
+
+static Result run(MQTTPayloadMode mode, bool batched)
+{
+    host::FakeModem modem;
+    modem.onCommand = answer;
+    modem.onData = answerData;
+    modem.written.reserve(1 << 20);
+    Air780EGCore core;
+    core.attachStream(&modem);
+    core.setATCommandDelay(0);
+    Air780EGGNSS gnss(&core);
+    Air780EGMQTT mqtt(&core, &gnss);
+    Air780EGHostTest::usePayloadMode(mqtt, mode);
+    Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+    Air780EGBatcher batcher(&mqtt);
+    batcher.setMaxPayload(1024);
+    batcher.setWindow(30000);
+    publishes = 0;
+    seen.clear();
+
+    std::chrono::duration<double, std::micro> busy(0);
+    Air780EGHeapTrace::reset();
+    Air780EGHeapTrace::enable();
+    for (int seq = 0; seq < SAMPLES; seq++)
+    {
+        String s = sample(seq);
+        auto start = std::chrono::steady_clock::now();
+        if (batched)
+        {
+            HOST_CHECK(batcher.add("dev/track", s));
+        }
+        else
+        {
+            HOST_CHECK(mqtt.publishAsync("dev/track", s) != 0);
+        }
+        busy += std::chrono::steady_clock::now() - start;
+        for (int ms = 0; ms < 1000; ms += 5)
+        {
+            start = std::chrono::steady_clock::now();
+            batcher.loop();
+            busy += std::chrono::steady_clock::now() - start;
+            core.processCommands();
+            mqtt.loop();
+            host::advance(5);
+        }
+    }
+    Air780EGHeapTrace::enable(false);
+    batcher.flush();
+    for (int ms = 0; ms < 1000; ms++)
+    {
+        core.processCommands();
+        mqtt.loop();
+        host::advance(1);
+    }
+
+    Air780EGBatchStats stats = batcher.getStats();
+    if (batched)
+    {
+        HOST_CHECK(stats.samples == SAMPLES && stats.published == SAMPLES && stats.dropped == 0);
+        HOST_CHECK(stats.max_batch_bytes <= 1024 && (int)stats.batches == publishes);
+    }
+    if (mode == MQTT_PAYLOAD_RAW)
+    {
+        bool in_order = (int)seen.size() == SAMPLES;
+        for (int i = 0; in_order && i < SAMPLES; i++)
+        {
+            in_order = seen[i] == i;
+        }
+        HOST_CHECK(in_order);
+    }
+    Air780EGHeapStats heap = Air780EGHeapTrace::getStats(AIR780EG_SUBSYS_MQTT);
+    return {publishes, modem.written.size(), (double)heap.alloc_count / SAMPLES, busy.count() / SAMPLES};
+}
+
+int main()
+{
+    host::useFakeClock();
+    printf("%d samples at 1 Hz, ~%u bytes each, limit 1024 B, window 30 s\n", SAMPLES, sample(300).length());
+    // 耗时：逐条发布为 publishAsync()，攒批为 add()+loop()
+    printf("mode  batched  mpubs  uart bytes  mqtt allocs/sample  us/sample (host, sanitizers on)\n");
+    for (MQTTPayloadMode mode : {MQTT_PAYLOAD_RAW, MQTT_PAYLOAD_HEX})
+    {
+        Result single = run(mode, false);
+        Result batch = run(mode, true);
+        for (const Result* r : {&single, &batch})
+        {
+            printf("%-5s %7s %6d %11u %19.2f %10.2f\n", mode == MQTT_PAYLOAD_RAW ? "raw" : "hex",
+                   r == &batch ? "yes" : "no", r->mpubs, (unsigned)r->uart_bytes, r->allocs_per_sample,
+                   r->us_per_sample);
+        }
+        HOST_CHECK(single.mpubs == SAMPLES);
+        HOST_CHECK(batch.mpubs * 10 <= SAMPLES);
+        HOST_CHECK(batch.uart_bytes < single.uart_bytes);
+        HOST_CHECK(batch.allocs_per_sample < single.allocs_per_sample);
+    }
+    return host::finish("bench_batching");
+}
@@ -0,0 +1,134 @@
+// 负载压缩（user-036）：与现场日志同结构的遥测JSON（单条约350字节、8条批量）的压缩率和单次耗时，
+// 以及随机二进制输入经 Air780EGCompress::decompress() 的往返。
+// 带 --write <目录> 时把压缩结果（.bin）和原文（.txt）写入目录，供 check_payload_decoder.py 用服务端脚本解码比对
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <chrono>
+#include <random>
+#include <vector>
+
+struct BytePrint : Print {
+    std::string bytes;
+    size_t write(uint8_t c) override
+    {
+        bytes += (char)c;
+        return 1;
+    }
+};
+
+static std::string compressed(const std::string& input)
+{
+    BytePrint out;
+    size_t n = Air780EGCompress::compress((const uint8_t*)input.data(), input.size(), out);
+    HOST_CHECK(n == out.bytes.size());
+    return out.bytes;
+}
+
+static bool roundTrips(const std::string& input, const std::string& packed)
+{
+    std::vector<uint8_t> out(input.size() + 1);
+    size_t n = Air780EGCompress::decompress((const uint8_t*)packed.data(), packed.size(), out.data(), out.size());
+    return n == input.size() && memcmp(out.data(), input.data(), n) == 0;
+}
+
+static std::string telemetry(int seq)
+{
+    char text[512];
+    snprintf(text, sizeof(text),
+             "{\"device_id\":\"860123456789012\",\"timestamp\":%d,\"mode\":\"normal\",\"gps\":{\"lat\":31.%06d,"
+             "\"lng\":121.%06d,\"speed\":%d.%d,\"course\":%d,\"satellites\":%d,\"hdop\":0.9,\"fixed\":true},"
+             "\"sensors\":{\"temperature\":%d.%d,\"humidity\":%d,\"voltage\":12.%d,\"imu\":{\"x\":0.0%d,\"y\":-0.0%d,"
+             "\"z\":9.8%d}},\"network\":{\"operator\":\"CHINA MOBILE\",\"registered\":true,\"signal\":%d,"
+             "\"battery\":%d},\"utc_date\":\"2025-10-12\",\"utc_time\":\"08:%02d:%02d\",\"uptime\":%d,\"counter\":%d,"
+             "\"status\":\"ok\"}",
+             1760257815 + seq, 230416 + seq * 7, 473701 + seq * 11, 30 + seq % 20, seq % 10, seq * 3 % 360,
+             10 + seq % 4, 25 + seq % 3, seq % 10, 60 + seq % 5, 40 + seq % 30, seq % 9, seq % 7, seq % 5,
+             20 + seq % 8, 80 - seq % 10, seq / 60 % 60, seq % 60, 3600 + seq, seq);
+    return text;
+}
+
+struct Result {
+    double ratio;
+    double us;
+};
+
+static Result measure(const std::string& input, int calls)
+{
+    std::string packed = compressed(input);
+    HOST_CHECK(roundTrips(input, packed));
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++)
+    {
+        compressed(input);
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return {(double)packed.size() / input.size(), elapsed.count() / calls};
+}
+
+static void writeFile(const std::string& path, const std::string& bytes)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    HOST_CHECK(file != nullptr);
+    if (file)
+    {
+        fwrite(bytes.data(), 1, bytes.size(), file);
+        fclose(file);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    HOST_CHECK(Air780EGCompress::begin());
+
+    std::string single = telemetry(1);
+    std::string batch = "[";
+    for (int i = 0; i < 8; i++)
+    {
+        batch += (i ? "," : "") + telemetry(i);
+    }
+    batch += "]";
+
+    std::vector<std::pair<std::string, std::string>> inputs = {{"single", single}, {"batch", batch}};
+    std::mt19937 rng(36);
+    for (int i = 0; i < 40; i++)
+    {
+        // 随机二进制、随机长度，以及带重复片段的输入
+        std::string input(rng() % 3000, '\0');
+        for (char& c : input)
+        {
+            c = (char)(i % 2 ? rng() % 4 : rng());
+        }
+        inputs.emplace_back("random" + std::to_string(i), input);
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--write") == 0)
+    {
+        for (const auto& input : inputs)
+        {
+            writeFile(std::string(argv[2]) + "/" + input.first + ".txt", input.second);
+            writeFile(std::string(argv[2]) + "/" + input.first + ".bin", compressed(input.second));
+        }
+        return host::finish("bench_compression --write");
+    }
+
+    for (const auto& input : inputs)
+    {
+        HOST_CHECK(roundTrips(input.second, compressed(input.second)));
+    }
+
+    Result one = measure(single, 500);
+    Result eight = measure(batch, 100);
+    printf("input            bytes   ratio   us/call (host, sanitizers on)\n");
+    printf("single record    %5u  %5.1f%%  %8.1f\n", (unsigned)single.size(), one.ratio * 100, one.us);
+    printf("8-record batch   %5u  %5.1f%%  %8.1f\n", (unsigned)batch.size(), eight.ratio * 100, eight.us);
+    HOST_CHECK(one.ratio < 0.6);
+    HOST_CHECK(eight.ratio < 0.35);
+
+    // 压缩结果不更小时按原文发送
+    String packed;
+    HOST_CHECK(!Air780EGCompress::compress(String("{\"a\":1}"), packed));
+    HOST_CHECK(Air780EGCompress::compress(String(single.c_str()), packed) && packed.length() < single.size());
+
+    Air780EGCompress::end();
+    return host::finish("bench_compression");
+}
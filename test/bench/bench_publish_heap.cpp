@@ -0,0 +1,112 @@
+// 发布的堆分配和耗时（user-032）：HEX 模式下 publish() 把负载边编码边写入串口，
+// 与原实现（sprintf 逐字节转HEX、String 拼接整条 AT+MPUB 后发送）比较每次发布的分配次数、字节数和耗时。
+// 负载619字节，与现场日志一致；流式发布不应分配与负载同量级的内存
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <chrono>
+
+static const int PUBLISHES = 200;
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line == "AT+MQTTSTATU")
+    {
+        modem.inject("\r\n+MQTTSTATU :1\r\n\r\nOK\r\n");
+    }
+    else
+    {
+        modem.inject("\r\nOK\r\n");
+    }
+}
+
+// 原实现
+static String toHexString(const String& input)
+{
+    String hex = "";
+    for (size_t i = 0; i < input.length(); ++i)
+    {
+        char buf[3];
+        sprintf(buf, "%02x", (unsigned char)input[i]);
+        hex += buf;
+    }
+    return hex;
+}
+
+static bool concatenatedPublish(Air780EGCore& core, const String& topic, const String& payload, int qos, bool retain)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+    String hex_payload = toHexString(payload);
+    String pub_cmd = "AT+MPUB=\"" + topic + "\"," + String(qos) + "," + String(retain ? 1 : 0) + ",\"" + hex_payload + "\"";
+    String response = core.sendATCommandUntilExpected(pub_cmd, "OK", 5000);
+    return response.indexOf("OK") >= 0;
+}
+
+struct Result {
+    double allocs;
+    double bytes;
+    double ns;
+};
+
+static Result measure(bool streamed, const String& payload)
+{
+    host::FakeModem modem;
+    modem.onCommand = answer;
+    modem.written.reserve(4 << 20);
+    Air780EGCore core;
+    core.attachStream(&modem);
+    core.setATCommandDelay(0);
+    Air780EGGNSS gnss(&core);
+    Air780EGMQTT mqtt(&core, &gnss);
+    Air780EGHostTest::usePayloadMode(mqtt, MQTT_PAYLOAD_HEX);
+    Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+
+    auto publish = [&]() {
+        return streamed ? mqtt.publish("dev/telemetry", payload) : concatenatedPublish(core, "dev/telemetry", payload, 0, false);
+    };
+    publish();
+    Air780EGHeapTrace::reset();
+    Air780EGHeapTrace::enable();
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < PUBLISHES; i++)
+    {
+        ok = publish() && ok;
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    Air780EGHeapTrace::enable(false);
+    HOST_CHECK(ok);
+
+    Result result = {0, 0, elapsed.count() / PUBLISHES};
+    for (int i = 0; i < AIR780EG_SUBSYS_COUNT; i++)
+    {
+        Air780EGHeapStats stats = Air780EGHeapTrace::getStats((Air780EGSubsystem)i);
+        result.allocs += (double)stats.alloc_count / PUBLISHES;
+        result.bytes += (double)stats.alloc_bytes / PUBLISHES;
+    }
+    return result;
+}
+
+int main()
+{
+    host::useFakeClock();
+    HOST_CHECK(Air780EGHeapTrace::isCompiledIn());
+
+    std::string text = "{\"seq\":1,\"lat\":31.2304,\"lng\":121.4737,\"track\":\"";
+    while (text.size() < 617)
+    {
+        text += (char)('a' + text.size() % 26);
+    }
+    text += "\"}";
+    String payload = text.c_str();
+
+    Result old_way = measure(false, payload);
+    Result streamed = measure(true, payload);
+    printf("%u byte payload     allocs   bytes    us (host, sanitizers on)\n", payload.length());
+    printf("concatenated       %6.1f %7.0f %5.1f\n", old_way.allocs, old_way.bytes, old_way.ns / 1000);
+    printf("streamed           %6.1f %7.0f %5.1f\n", streamed.allocs, streamed.bytes, streamed.ns / 1000);
+
+    HOST_CHECK(streamed.allocs < old_way.allocs);
+    HOST_CHECK(streamed.bytes < payload.length());
+    HOST_CHECK(old_way.bytes > payload.length() * 2);
+    return host::finish("bench_publish_heap");
+}
@@ -0,0 +1,102 @@
+// 发布吞吐（user-033）：115200 8N1 串口上连续同步发布619字节负载，比较 HEX、转义文本和 AT+MPUBEX 原始模式。
+// 模拟模块按收到的字节数计算串口传输时间后才应答，吞吐由虚拟时钟计算
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+
+static const int PUBLISHES = 50;
+static const unsigned long BAUD = 115200;
+static size_t line_start = 0;
+
+// 每字节10位（8N1）
+static unsigned long wireMs(size_t bytes)
+{
+    return (unsigned long)((bytes * 10 * 1000 + BAUD - 1) / BAUD);
+}
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    unsigned long ms = wireMs(modem.written.size() - line_start);
+    line_start = modem.written.size();
+    if (line.rfind("AT+MPUBEX=", 0) == 0)
+    {
+        modem.expectData(std::stoul(line.substr(line.rfind(',') + 1)));
+        modem.reply(ms, "\r\n>");
+    }
+    else
+    {
+        modem.reply(ms, "\r\nOK\r\n");
+    }
+}
+
+static void answerData(host::FakeModem& modem, const std::string& data)
+{
+    unsigned long ms = wireMs(modem.written.size() - line_start);
+    line_start = modem.written.size();
+    modem.reply(ms, "\r\nOK\r\n");
+}
+
+struct Result {
+    double bytes;   // 每次发布写入串口的字节数
+    double ms;      // 每次发布的耗时
+};
+
+static Result measure(MQTTPayloadMode mode, const String& payload)
+{
+    host::FakeModem modem;
+    modem.onCommand = answer;
+    modem.onData = answerData;
+    Air780EGCore core;
+    core.attachStream(&modem);
+    core.setATCommandDelay(0);
+    Air780EGGNSS gnss(&core);
+    Air780EGMQTT mqtt(&core, &gnss);
+    Air780EGHostTest::usePayloadMode(mqtt, mode);
+    Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+    line_start = 0;
+
+    unsigned long start = micros();
+    bool ok = true;
+    for (int i = 0; i < PUBLISHES; i++)
+    {
+        ok = mqtt.publish("dev/telemetry", payload) && ok;
+    }
+    HOST_CHECK(ok);
+    return {(double)modem.written.size() / PUBLISHES, (micros() - start) / 1000.0 / PUBLISHES};
+}
+
+int main()
+{
+    host::useFakeClock();
+
+    // 现场日志中的遥测JSON大小，不含CR/LF，三种模式都能发送
+    std::string text = "{\"device_id\":\"860000000000001\",\"lat\":31.2304,\"lng\":121.4737,\"track\":\"";
+    while (text.size() < 617)
+    {
+        text += (char)('a' + text.size() % 26);
+    }
+    text += "\"}";
+    String payload = text.c_str();
+
+    struct {
+        const char* name;
+        MQTTPayloadMode mode;
+        Result result;
+    } modes[] = {{"hex", MQTT_PAYLOAD_HEX, {}}, {"text", MQTT_PAYLOAD_TEXT, {}}, {"raw", MQTT_PAYLOAD_RAW, {}}};
+
+    printf("%u byte payload at %lu baud\n", payload.length(), BAUD);
+    printf("mode   uart bytes   ms/publish   publishes/s\n");
+    for (auto& m : modes)
+    {
+        m.result = measure(m.mode, payload);
+        printf("%-6s %10.0f %12.1f %13.2f\n", m.name, m.result.bytes, m.result.ms, 1000.0 / m.result.ms);
+    }
+
+    const Result& hex = modes[0].result;
+    const Result& raw = modes[2].result;
+    // HEX约为 2×负载 + 命令，原始模式约为 负载 + 命令
+    HOST_CHECK(hex.bytes > payload.length() * 2 && raw.bytes < payload.length() + 64);
+    HOST_CHECK(hex.ms > 105 && hex.ms < 120);
+    HOST_CHECK(raw.ms > 55 && raw.ms < 65);
+    HOST_CHECK(hex.ms / raw.ms > 1.8);
+    return host::finish("bench_publish_throughput");
+}
@@ -0,0 +1,122 @@
+// 主题分发（user-043）：前缀树与逐个比较过滤器的平铺分发在不同订阅数量下的单次耗时。
+// 每个订阅一个精确过滤器，另有两个匹配所有主题的通配符过滤器；两种方式的命中次数须一致，
+// 1000个订阅时前缀树至少快5倍
+#include "Air780EGTopicTrie.h"
+#include "HostSupport.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+static long hits = 0;
+
+static void onTopic(const char* topic, size_t topic_len, const uint8_t* payload, size_t payload_len, void* context)
+{
+    hits++;
+}
+
+// 平铺分发用的逐字符匹配，不分配内存
+static bool flatMatch(const char* filter, const char* topic, size_t topic_len)
+{
+    const char* end = topic + topic_len;
+    if (topic_len > 0 && topic[0] == '$' && (filter[0] == '+' || filter[0] == '#'))
+    {
+        return false;
+    }
+    while (true)
+    {
+        if (filter[0] == '#')
+        {
+            return true;
+        }
+        const char* slash = (const char*)memchr(topic, '/', end - topic);
+        const char* level_end = slash ? slash : end;
+        if (filter[0] == '+' && (filter[1] == '/' || filter[1] == '\0'))
+        {
+            filter++;
+        }
+        else
+        {
+            size_t len = level_end - topic;
+            if (strncmp(filter, topic, len) != 0 || (filter[len] != '/' && filter[len] != '\0'))
+            {
+                return false;
+            }
+            filter += len;
+        }
+        if (!slash)
+        {
+            // "a/#" 也匹配 "a"
+            return filter[0] == '\0' || strcmp(filter, "/#") == 0;
+        }
+        if (filter[0] != '/')
+        {
+            return false;
+        }
+        filter++;
+        topic = slash + 1;
+    }
+}
+
+template <class F>
+static double nsPerCall(int calls, F body)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++)
+    {
+        body(i);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / calls;
+}
+
+int main()
+{
+    printf("  subs   trie ns   flat ns\n");
+    for (int subs : {1, 50, 200, 1000})
+    {
+        std::vector<std::string> filters;
+        for (int i = 0; i < subs; i++)
+        {
+            filters.push_back("dev/" + std::to_string(i) + "/cmd");
+        }
+        filters.push_back("dev/+/cmd");
+        filters.push_back("dev/#");
+
+        Air780EGTopicTrie trie;
+        for (const std::string& filter : filters)
+        {
+            HOST_CHECK(trie.setHandler(filter.c_str(), onTopic));
+        }
+        std::vector<std::string> topics;
+        for (int i = 0; i < 64; i++)
+        {
+            topics.push_back("dev/" + std::to_string((i * 7919) % subs) + "/cmd");
+        }
+
+        const int calls = 100000 / (subs < 50 ? 1 : subs / 50);
+        hits = 0;
+        double trie_ns = nsPerCall(calls, [&](int i) {
+            const std::string& topic = topics[i % topics.size()];
+            trie.dispatch(topic.data(), topic.size(), (const uint8_t*)"x", 1);
+        });
+        long trie_hits = hits;
+        hits = 0;
+        double flat_ns = nsPerCall(calls, [&](int i) {
+            const std::string& topic = topics[i % topics.size()];
+            for (const std::string& filter : filters)
+            {
+                if (flatMatch(filter.c_str(), topic.data(), topic.size()))
+                {
+                    onTopic(topic.data(), topic.size(), (const uint8_t*)"x", 1, nullptr);
+                }
+            }
+        });
+        printf("%6d %9.0f %9.0f\n", subs, trie_ns, flat_ns);
+        HOST_CHECK(trie_hits == (long)calls * 3 && hits == trie_hits);
+        if (subs == 1000)
+        {
+            HOST_CHECK(trie_ns * 5 < flat_ns);
+        }
+    }
+    return host::finish("bench_topic_dispatch");
+}
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""服务端解码脚本与库的压缩格式一致性检查（user-036）。
+
+- tools/air780eg_payload.py 的 DICTIONARY 与 src/Air780EGCompress.cpp 中的字典逐字节相同
+- bench_compression --write 输出的压缩结果经 decode() 还原为原文
+
+用法：check_payload_decoder.py <bench_compression 可执行文件>
+"""
+
+import ast
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..")
+sys.path.insert(0, os.path.join(ROOT, "tools"))
+
+import air780eg_payload  # noqa: E402
+
+
+def cpp_dictionary():
+    with open(os.path.join(ROOT, "src", "Air780EGCompress.cpp"), encoding="utf-8") as f:
+        source = f.read()
+    body = re.search(r"static const char dictionary\[\] =(.*?);", source, re.S).group(1)
+    # 相邻的C字符串字面量拼接；字典中只有 \" 转义，与Python字面量写法相同
+    return "".join(ast.literal_eval(part) for part in re.findall(r'"(?:[^"\\]|\\.)*"', body)).encode()
+
+
+def main(argv):
+    if len(argv) != 2:
+        print(__doc__)
+        return 2
+    failures = 0
+    if cpp_dictionary() != air780eg_payload.DICTIONARY:
+        print("DICTIONARY differs from src/Air780EGCompress.cpp")
+        failures += 1
+
+    with tempfile.TemporaryDirectory() as out:
+        subprocess.run([argv[1], "--write", out], check=True)
+        names = sorted(n[:-4] for n in os.listdir(out) if n.endswith(".bin"))
+        for name in names:
+            with open(os.path.join(out, name + ".bin"), "rb") as f:
+                packed = f.read()
+            with open(os.path.join(out, name + ".txt"), "rb") as f:
+                original = f.read()
+            if not air780eg_payload.is_compressed(packed) or air780eg_payload.decode(packed) != original:
+                print("%s: decode() does not reproduce the input" % name)
+                failures += 1
+    print("check_payload_decoder: %d payloads, %s" % (len(names), "all checks passed" if not failures
+                                                         else "%d failure(s)" % failures))
+    return 1 if failures or not names else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
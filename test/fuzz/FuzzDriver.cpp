@@ -0,0 +1,253 @@
+/*
+ * 不使用 libFuzzer 时的 main()：
+ *   fuzz_xxx <文件或目录>...            逐个运行语料（回归测试；也可作为 AFL 的 @@ 目标）
+ *   fuzz_xxx -runs=N <目录>...          从语料出发随机变异 N 次
+ *   fuzz_xxx -throughput <目录>...      把每个种子按几种方式放大到 16K/64K，
+ *                                       耗时增长明显超过线性（>8倍，线性约4倍、平方约16倍）的输入报告并返回非0
+ */
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+typedef std::vector<std::string> Inputs;
+
+bool readFile(const std::string& path, std::string& out)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    char buffer[4096];
+    size_t n;
+    out.clear();
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        out.append(buffer, n);
+    }
+    fclose(file);
+    return true;
+}
+
+void collect(const std::string& path, Inputs& inputs, std::vector<std::string>& names)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+        fprintf(stderr, "cannot open %s\n", path.c_str());
+        exit(2);
+    }
+    if (!S_ISDIR(st.st_mode))
+    {
+        std::string data;
+        if (readFile(path, data))
+        {
+            inputs.push_back(data);
+            names.push_back(path);
+        }
+        return;
+    }
+    DIR* dir = opendir(path.c_str());
+    std::vector<std::string> entries;
+    while (struct dirent* entry = readdir(dir))
+    {
+        if (entry->d_name[0] != '.')
+        {
+            entries.push_back(path + "/" + entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end());
+    for (const std::string& entry : entries)
+    {
+        collect(entry, inputs, names);
+    }
+}
+
+void run(const std::string& input)
+{
+    LLVMFuzzerTestOneInput((const uint8_t*)input.data(), input.size());
+}
+
+// 变异：删除、插入分隔符、替换字节、截断、重复片段
+std::string mutate(const Inputs& seeds)
+{
+    static const char tokens[] = ",\"\r\n+: 0aZ";
+    std::string s = seeds[rand() % seeds.size()];
+    int count = 1 + rand() % 8;
+    for (int i = 0; i < count; i++)
+    {
+        size_t pos = s.empty() ? 0 : rand() % s.size();
+        switch (rand() % 5)
+        {
+        case 0:
+            if (!s.empty())
+            {
+                s.erase(pos, 1 + rand() % 4);
+            }
+            break;
+        case 1:
+            s.insert(pos, 1, tokens[rand() % (sizeof(tokens) - 1)]);
+            break;
+        case 2:
+            if (!s.empty())
+            {
+                s[pos] = (char)rand();
+            }
+            break;
+        case 3:
+            s.resize(pos);
+            break;
+        default:
+            s.insert(pos, s.substr(pos, rand() % 32));
+            break;
+        }
+    }
+    return s;
+}
+
+double measure(const std::string& input)
+{
+    double best = 1e30;
+    for (int rep = 0; rep < 3; rep++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        run(input);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, us);
+    }
+    return best;
+}
+
+// 把 filler 插到种子中间重复到约 size 字节；filler 为空时整个种子重复
+std::string grow(const std::string& seed, const std::string& filler, size_t size)
+{
+    const std::string& unit = filler.empty() ? seed : filler;
+    if (unit.empty())
+    {
+        return seed;
+    }
+    std::string pumped;
+    pumped.reserve(size + seed.size());
+    while (pumped.size() < size)
+    {
+        pumped += unit;
+    }
+    if (filler.empty())
+    {
+        return pumped;
+    }
+    size_t mid = seed.size() / 2;
+    return seed.substr(0, mid) + pumped + seed.substr(mid);
+}
+
+std::string printable(const std::string& text)
+{
+    std::string out;
+    for (char c : text)
+    {
+        if (c == '\r')
+            out += "\\r";
+        else if (c == '\n')
+            out += "\\n";
+        else if (c == '"')
+            out += "\\\"";
+        else
+            out += c;
+    }
+    return out;
+}
+
+int throughput(const Inputs& seeds, const std::vector<std::string>& names)
+{
+    static const char* fillers[] = {"", ",", "\"", "\r\n", "+MSUB:", "0", "A"};
+    const size_t small = 16 * 1024;
+    const size_t large = 64 * 1024;
+    int flagged = 0;
+    double worst = 0;
+    for (size_t i = 0; i < seeds.size(); i++)
+    {
+        for (const char* filler : fillers)
+        {
+            double t_small = measure(grow(seeds[i], filler, small));
+            double t_large = measure(grow(seeds[i], filler, large));
+            // 太快的输入计时噪声大，不参与比较
+            if (t_large < 200)
+            {
+                continue;
+            }
+            double ratio = t_large / std::max(t_small, 1.0);
+            worst = std::max(worst, ratio);
+            if (ratio > 8)
+            {
+                fprintf(stderr, "SUPER-LINEAR: %s filler \"%s\": 16K %.0fus, 64K %.0fus (x%.1f)\n",
+                        names[i].c_str(), printable(filler).c_str(), t_small, t_large, ratio);
+                flagged++;
+            }
+        }
+    }
+    printf("throughput: %zu seeds, worst 16K->64K growth x%.1f, %d flagged\n", seeds.size(), worst, flagged);
+    return flagged > 0 ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long runs = 0;
+    bool measure_throughput = false;
+    Inputs inputs;
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "-runs=", 6) == 0)
+        {
+            runs = atol(argv[i] + 6);
+        }
+        else if (strcmp(argv[i], "-throughput") == 0)
+        {
+            measure_throughput = true;
+        }
+        else if (argv[i][0] == '-')
+        {
+            // 其余 libFuzzer 参数忽略，便于两种构建共用 ctest 命令
+            continue;
+        }
+        else
+        {
+            collect(argv[i], inputs, names);
+        }
+    }
+    if (inputs.empty())
+    {
+        inputs.push_back(std::string());
+        names.push_back("<empty>");
+    }
+
+    if (measure_throughput)
+    {
+        return throughput(inputs, names);
+    }
+    for (const std::string& input : inputs)
+    {
+        run(input);
+    }
+    srand(1);
+    for (long i = 0; i < runs; i++)
+    {
+        run(mutate(inputs));
+    }
+    printf("%zu inputs, %ld mutations: ok\n", inputs.size(), runs);
+    return 0;
+}
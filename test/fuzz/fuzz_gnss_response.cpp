@@ -0,0 +1,12 @@
+// AT+CGNSINF 响应 / +UGNSINF 上报解析
+#include "Air780EGHostTest.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static Air780EGCore core;
+    static Air780EGGNSS gnss(&core);
+    String response;
+    response.concat((const char*)data, size);
+    Air780EGHostTest::parseGNSSResponse(gnss, response);
+    return 0;
+}
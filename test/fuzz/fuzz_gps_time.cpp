@@ -0,0 +1,20 @@
+// GNSS 日期/时间字段解析：第一个换行之前是日期部分，之后是时间部分
+#include "Air780EGHostTest.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static Air780EGCore core;
+    static Air780EGGNSS gnss(&core);
+    const char* text = (const char*)data;
+    const char* split = (const char*)memchr(data, '\n', size);
+    size_t date_len = split ? split - text : size;
+    String date_part;
+    String time_part;
+    date_part.concat(text, date_len);
+    if (split)
+    {
+        time_part.concat(split + 1, size - date_len - 1);
+    }
+    Air780EGHostTest::parseGPSTime(gnss, date_part, time_part);
+    return 0;
+}
@@ -0,0 +1,61 @@
+// HEX 负载解码（原 fromHexString，现在在 parseMQTTMessage 中直接解码到队列槽位）：
+// 输入作为 HEX 模式下 +MSUB 的数据部分，合法 HEX 时检查解码结果
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <cstdlib>
+
+static std::string delivered;
+static int delivered_count = 0;
+
+static void onMessage(const String& topic, const String& payload)
+{
+    delivered.assign(payload.c_str(), payload.length());
+    delivered_count++;
+}
+
+static int nibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static Air780EGCore core;
+    static Air780EGGNSS gnss(&core);
+    static Air780EGMQTT mqtt(&core, &gnss);
+    mqtt.setMessageCallback(onMessage);
+    Air780EGHostTest::usePayloadMode(mqtt, MQTT_PAYLOAD_HEX);
+
+    String message = "+MSUB: \"t\"," + String((unsigned)(size / 2)) + " byte,";
+    message.concat((const char*)data, size);
+    delivered_count = 0;
+    Air780EGHostTest::parseMQTTMessage(mqtt, message);
+    Air780EGHostTest::deliverMessages(mqtt);
+
+    std::string expected;
+    bool hex = size % 2 == 0;
+    for (size_t i = 0; hex && i < size; i += 2)
+    {
+        int hi = nibble(data[i]);
+        int lo = nibble(data[i + 1]);
+        hex = hi >= 0 && lo >= 0;
+        if (hex)
+        {
+            expected += (char)(hi << 4 | lo);
+        }
+    }
+    // 合法HEX必须原样解码；其余输入按文本保留，不能丢失字节
+    std::string raw((const char*)data, size);
+    if (delivered_count == 1 && delivered != (hex ? expected : raw))
+    {
+        fprintf(stderr, "hex decode mismatch for %zu input bytes\n", size);
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+// AT+HTTPREAD 响应解析：输入是模拟模块对 AT+HTTPREAD 的完整应答
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static bool clock_ready = false;
+    if (!clock_ready)
+    {
+        // 应答不完整时 sendATCommand 等到超时，虚拟时钟下不必真的等待
+        host::useFakeClock();
+        clock_ready = true;
+    }
+    std::string reply((const char*)data, size);
+    host::FakeModem modem;
+    modem.onCommand = [&reply](host::FakeModem& m, const std::string& line) {
+        if (line.rfind("AT+HTTPREAD", 0) == 0)
+        {
+            m.inject(reply);
+        }
+    };
+    Air780EGCore core;
+    core.attachStream(&modem);
+    core.setATCommandDelay(0);
+    Air780EGHTTP http(&core);
+    Air780EGHostTest::markHTTPInitialized(http);
+
+    uint8_t buffer[512];
+    size_t actual = 0;
+    http.readData(buffer, sizeof(buffer), actual);
+    if (actual > sizeof(buffer))
+    {
+        abort();
+    }
+    return 0;
+}
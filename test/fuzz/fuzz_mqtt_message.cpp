@@ -0,0 +1,23 @@
+// +MSUB 消息解析：第一个字节选择负载格式（原始/文本/HEX），其余是完整的上报行
+#include "Air780EGHostTest.h"
+
+static void onMessage(const String& topic, const String& payload) {}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static const MQTTPayloadMode modes[] = {MQTT_PAYLOAD_RAW, MQTT_PAYLOAD_TEXT, MQTT_PAYLOAD_HEX};
+    static Air780EGCore core;
+    static Air780EGGNSS gnss(&core);
+    static Air780EGMQTT mqtt(&core, &gnss);
+    if (size == 0)
+    {
+        return 0;
+    }
+    mqtt.setMessageCallback(onMessage);
+    Air780EGHostTest::usePayloadMode(mqtt, modes[data[0] % 3]);
+    String message;
+    message.concat((const char*)data + 1, size - 1);
+    Air780EGHostTest::parseMQTTMessage(mqtt, message);
+    Air780EGHostTest::deliverMessages(mqtt);
+    return 0;
+}
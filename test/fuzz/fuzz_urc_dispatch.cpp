@@ -0,0 +1,38 @@
+// URC 识别与分发：同一输入分两段交给 checkAndDispatchURC（命令响应路径），
+// 再作为串口数据交给 pollURC（空闲路径，含 +MSUB 按长度读取）
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+
+static void onMessage(const String& topic, const String& payload) {}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static bool clock_ready = false;
+    if (!clock_ready)
+    {
+        // 处理器里可能发同步命令（如 boot.rom 后重新初始化），虚拟时钟下超时不必真的等待
+        host::useFakeClock();
+        clock_ready = true;
+    }
+    host::FakeModem modem;
+    Air780EGCore core;
+    core.attachStream(&modem);
+    Air780EGGNSS gnss(&core);
+    Air780EGMQTT mqtt(&core, &gnss);
+    mqtt.setMessageCallback(onMessage);
+    Air780EGHostTest::registerURCHandlers(mqtt);
+    Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+
+    String response;
+    size_t scanned = 0;
+    response.concat((const char*)data, size / 2);
+    Air780EGHostTest::checkAndDispatchURC(core, response, scanned, false);
+    response.concat((const char*)data + size / 2, size - size / 2);
+    Air780EGHostTest::checkAndDispatchURC(core, response, scanned, true);
+    Air780EGHostTest::deliverMessages(mqtt);
+
+    modem.inject(std::string((const char*)data, size));
+    Air780EGHostTest::pollURC(core);
+    Air780EGHostTest::deliverMessages(mqtt);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#ifndef AIR780EG_HOST_TEST_H
+#define AIR780EG_HOST_TEST_H
+
+#include "Air780EG.h"
+
+/*
+ * 主机测试访问库内部解析函数的入口（各类以 friend 声明），
+ * 模糊测试直接喂解析器，不必经过完整的AT命令流程
+ */
+struct Air780EGHostTest {
+    // GNSS
+    static bool parseGNSSResponse(Air780EGGNSS& gnss, const String& response)
+    {
+        return gnss.parseGNSSResponse(response);
+    }
+    static void parseGPSTime(Air780EGGNSS& gnss, const String& date_part, const String& time_part)
+    {
+        gnss.parseGPSTime(date_part, time_part);
+    }
+
+    // MQTT
+    static bool parseMQTTMessage(Air780EGMQTT& mqtt, const String& message)
+    {
+        return mqtt.parseMQTTMessage(message);
+    }
+    static void deliverMessages(Air780EGMQTT& mqtt)
+    {
+        mqtt.processMessageCache();
+    }
+    static void registerURCHandlers(Air780EGMQTT& mqtt)
+    {
+        mqtt.registerURCHandlers();
+    }
+    // 跳过 init() 的探测，直接设定当前使用的负载格式
+    static void usePayloadMode(Air780EGMQTT& mqtt, MQTTPayloadMode mode)
+    {
+        mqtt.payload_mode = mode;
+    }
+    static void setState(Air780EGMQTT& mqtt, Air780EGMQTTState state)
+    {
+        mqtt.state = state;
+    }
+    static void resubscribeAll(Air780EGMQTT& mqtt)
+    {
+        mqtt.resubscribeAll();
+    }
+    // 定时任务到期堆：父节点不晚于子节点，heap_pos 与堆中位置一致，启用的任务都在堆中
+    static bool scheduledHeapValid(const Air780EGMQTT& mqtt)
+    {
+        int enabled = 0;
+        for (int i = 0; i < mqtt.scheduled_task_count; i++)
+        {
+            const ScheduledTask& task = mqtt.scheduled_tasks[i];
+            if (!task.enabled)
+            {
+                if (task.heap_pos >= 0)
+                    return false;
+                continue;
+            }
+            enabled++;
+            if (task.heap_pos < 0 || task.heap_pos >= mqtt.task_heap_count || mqtt.task_heap[task.heap_pos] != i)
+                return false;
+        }
+        for (int pos = 1; pos < mqtt.task_heap_count; pos++)
+        {
+            if (mqtt.taskDueBefore(mqtt.task_heap[pos], mqtt.task_heap[(pos - 1) / 2]))
+                return false;
+        }
+        return enabled == mqtt.task_heap_count;
+    }
+
+    // Core
+    static void checkAndDispatchURC(Air780EGCore& core, const String& response, size_t& scanned, bool final)
+    {
+        core.checkAndDispatchURC(response, scanned, final);
+    }
+    static void pollURC(Air780EGCore& core)
+    {
+        core.pollURC();
+    }
+
+    // HTTP：跳过 AT+HTTPINIT
+    static void markHTTPInitialized(Air780EGHTTP& http)
+    {
+        http.http_initialized = true;
+    }
+};
+
+#endif // AIR780EG_HOST_TEST_H
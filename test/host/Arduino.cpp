@@ -0,0 +1,253 @@
+#include "Arduino.h"
+#include "HostSupport.h"
+#include "Air780EGHeapTrace.h"
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+HardwareSerial Serial2;
+
+namespace {
+bool fake_clock = false;
+unsigned long fake_us = 0;
+unsigned long millis_offset = 0;
+bool log_enabled = getenv("AIR780EG_HOST_LOG") != nullptr;
+const auto start_time = std::chrono::steady_clock::now();
+}
+
+unsigned long micros()
+{
+    if (fake_clock)
+    {
+        return fake_us;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+unsigned long millis()
+{
+    return micros() / 1000 + millis_offset;
+}
+
+void delay(unsigned long ms)
+{
+    if (fake_clock)
+    {
+        fake_us += ms * 1000;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    if (fake_clock)
+    {
+        fake_us += us;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {}
+void pinMode(int, int) {}
+void digitalWrite(int, int) {}
+
+long random(long max_value)
+{
+    return max_value > 0 ? rand() % max_value : 0;
+}
+
+long random(long min_value, long max_value)
+{
+    return max_value > min_value ? min_value + rand() % (max_value - min_value) : min_value;
+}
+
+uint32_t esp_random()
+{
+    return (uint32_t)rand();
+}
+
+size_t Print::printf(const char* format, ...)
+{
+    char buffer[1024];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (n < 0)
+    {
+        return 0;
+    }
+    return write((const uint8_t*)buffer, std::min(n, (int)sizeof(buffer) - 1));
+}
+
+size_t Stream::readBytes(char* buffer, size_t length)
+{
+    size_t n = 0;
+    while (n < length && available())
+    {
+        buffer[n++] = read();
+    }
+    return n;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    if (this == &Serial && log_enabled)
+    {
+        putchar(c);
+    }
+    return 1;
+}
+
+namespace host {
+
+int failures = 0;
+
+void useFakeClock(unsigned long start_us)
+{
+    fake_clock = true;
+    fake_us = start_us;
+    millis_offset = 0;
+}
+
+void useRealClock()
+{
+    fake_clock = false;
+}
+
+void advance(unsigned long ms)
+{
+    fake_us += ms * 1000;
+}
+
+void wrapMillisIn(unsigned long ms)
+{
+    millis_offset = 0 - ms - micros() / 1000;
+}
+
+void enableLog(bool enable)
+{
+    log_enabled = enable;
+}
+
+void FakeModem::reply(unsigned long ms, const std::string& text)
+{
+    pending.emplace(micros() + ms * 1000, text);
+}
+
+// 模拟模块自身的分配不属于库，不计入堆追踪
+void FakeModem::release()
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_NONE);
+    unsigned long now = micros();
+    while (!pending.empty() && pending.begin()->first <= now)
+    {
+        rx += pending.begin()->second;
+        pending.erase(pending.begin());
+    }
+    if (drip == 0)
+    {
+        limit = rx.size();
+        return;
+    }
+    // 每毫秒虚拟时间放出 drip 字节
+    unsigned long now_ms = now / 1000;
+    if (now_ms != drip_ms)
+    {
+        limit += drip;
+        drip_ms = now_ms;
+    }
+    limit = std::max(limit, pos);
+    limit = std::min(limit, rx.size());
+}
+
+int FakeModem::available()
+{
+    release();
+    return (int)(limit - pos);
+}
+
+int FakeModem::read()
+{
+    if (available() <= 0)
+    {
+        return -1;
+    }
+    return (uint8_t)rx[pos++];
+}
+
+int FakeModem::peek()
+{
+    if (available() <= 0)
+    {
+        return -1;
+    }
+    return (uint8_t)rx[pos];
+}
+
+size_t FakeModem::write(uint8_t c)
+{
+    AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_NONE);
+    written += (char)c;
+    // 命令行 "\r\n" 中的 '\n' 不属于 onCommand 里 expectData() 之后的数据
+    if (skip_lf)
+    {
+        skip_lf = false;
+        if (c == '\n')
+        {
+            return 1;
+        }
+    }
+    if (data_left > 0)
+    {
+        data += (char)c;
+        if (--data_left == 0 && onData)
+        {
+            onData(*this, data);
+        }
+        return 1;
+    }
+    if (c == '\r' || c == '\n')
+    {
+        skip_lf = c == '\r';
+        std::string command;
+        command.swap(line);
+        commands++;
+        if (onCommand)
+        {
+            onCommand(*this, command);
+        }
+        return 1;
+    }
+    line += (char)c;
+    return 1;
+}
+
+std::string toHex(const std::string& bytes)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    std::string out;
+    out.reserve(bytes.size() * 2);
+    for (unsigned char c : bytes)
+    {
+        out += digits[c >> 4];
+        out += digits[c & 15];
+    }
+    return out;
+}
+
+int finish(const char* name)
+{
+    if (failures > 0)
+    {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, failures);
+        return 1;
+    }
+    printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+} // namespace host
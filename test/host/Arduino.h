@@ -0,0 +1,230 @@
+#ifndef AIR780EG_HOST_ARDUINO_H
+#define AIR780EG_HOST_ARDUINO_H
+
+/*
+ * 主机构建用的最小 Arduino 接口：只实现库实际用到的 String / Print / Stream / 时间函数。
+ * String 基于 std::string，语义按 Arduino 核心库（越界下标返回0，substring 参数自动交换等）。
+ * 时间可切换为虚拟时钟（见 HostSupport.h），delay() 只推进虚拟时间，仿真不必真的等待。
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+
+using std::max;
+using std::min;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define SERIAL_8N1 0
+#define F(x) x
+#define PROGMEM
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+long random(long max_value);
+long random(long min_value, long max_value);
+uint32_t esp_random();
+
+class String {
+private:
+    std::string s;
+
+    static std::string number(const char* format, ...)
+    {
+        char buffer[64];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return buffer;
+    }
+
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& other) : s(other) {}
+    String(char c) : s(1, c) {}
+    String(int v, unsigned char base = 10) : s(number(base == 16 ? "%x" : "%d", v)) {}
+    String(unsigned int v, unsigned char base = 10) : s(number(base == 16 ? "%x" : "%u", v)) {}
+    String(long v, unsigned char base = 10) : s(number(base == 16 ? "%lx" : "%ld", v)) {}
+    String(unsigned long v, unsigned char base = 10) : s(number(base == 16 ? "%lx" : "%lu", v)) {}
+    String(float v, unsigned int digits = 2) : s(number("%.*f", digits, v)) {}
+    String(double v, unsigned int digits = 2) : s(number("%.*f", digits, v)) {}
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+
+    char charAt(unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    char& operator[](unsigned int i) { return s[i]; }
+
+    int indexOf(char c, unsigned int from = 0) const { return found(s.find(c, from)); }
+    int indexOf(const String& t, unsigned int from = 0) const { return found(s.find(t.s, from)); }
+    int lastIndexOf(char c) const { return found(s.rfind(c)); }
+    int lastIndexOf(char c, unsigned int from) const { return found(s.rfind(c, from)); }
+    static int found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+
+    String substring(unsigned int from) const { return from >= s.size() ? String() : String(s.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        if (from > to)
+        {
+            std::swap(from, to);
+        }
+        return from >= s.size() ? String() : String(s.substr(from, to - from));
+    }
+
+    bool startsWith(const String& p) const { return s.size() >= p.s.size() && s.compare(0, p.s.size(), p.s) == 0; }
+    bool startsWith(const String& p, unsigned int offset) const
+    {
+        return s.size() >= offset + p.s.size() && s.compare(offset, p.s.size(), p.s) == 0;
+    }
+    bool endsWith(const String& p) const
+    {
+        return s.size() >= p.s.size() && s.compare(s.size() - p.s.size(), p.s.size(), p.s) == 0;
+    }
+
+    void trim()
+    {
+        size_t a = s.find_first_not_of(" \t\r\n");
+        if (a == std::string::npos)
+        {
+            s.clear();
+            return;
+        }
+        size_t b = s.find_last_not_of(" \t\r\n");
+        s = s.substr(a, b - a + 1);
+    }
+    void replace(const String& from, const String& to)
+    {
+        if (from.s.empty())
+        {
+            return;
+        }
+        for (size_t p = 0; (p = s.find(from.s, p)) != std::string::npos; p += to.s.size())
+        {
+            s.replace(p, from.s.size(), to.s);
+        }
+    }
+    void remove(unsigned int index)
+    {
+        if (index < s.size())
+        {
+            s.erase(index);
+        }
+    }
+    void remove(unsigned int index, unsigned int count)
+    {
+        if (index < s.size())
+        {
+            s.erase(index, count);
+        }
+    }
+    void toLowerCase() { for (auto& c : s) c = tolower((unsigned char)c); }
+    void toUpperCase() { for (auto& c : s) c = toupper((unsigned char)c); }
+
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    double toDouble() const { return atof(s.c_str()); }
+
+    bool concat(const char* p, unsigned int n) { s.append(p, n); return true; }
+    bool concat(const String& other) { s += other.s; return true; }
+    bool concat(char c) { s += c; return true; }
+    String& operator+=(const String& other) { s += other.s; return *this; }
+    String& operator+=(const char* other) { s += other; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(int v) { return *this += String(v); }
+    String& operator+=(unsigned int v) { return *this += String(v); }
+    String& operator+=(long v) { return *this += String(v); }
+    String& operator+=(unsigned long v) { return *this += String(v); }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+    friend String operator+(const String& a, char b) { return String(a.s + b); }
+
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator==(const char* other) const { return s == other; }
+    bool operator!=(const String& other) const { return s != other.s; }
+    bool operator!=(const char* other) const { return s != other; }
+    bool operator<(const String& other) const { return s < other.s; }
+    bool equals(const String& other) const { return s == other.s; }
+    void getBytes(unsigned char* buffer, unsigned int size) const { strncpy((char*)buffer, s.c_str(), size); }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            write(buffer[i]);
+        }
+        return size;
+    }
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+    virtual int availableForWrite() { return 128; }
+    virtual void flush() {}
+
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return print(String(v)); }
+    size_t print(unsigned int v) { return print(String(v)); }
+    size_t print(long v) { return print(String(v)); }
+    size_t print(unsigned long v) { return print(String(v)); }
+    size_t print(double v, int digits = 2) { return print(String(v, digits)); }
+    size_t println() { return write("\r\n"); }
+    template <class T>
+    size_t println(const T& v) { return print(v) + println(); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    void setTimeout(unsigned long) {}
+};
+
+// 主机上的串口：Serial 输出到 stdout（日志），其余串口不收不发，仿真通过 attachStream() 接入
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long, uint32_t = 0, int8_t = -1, int8_t = -1) {}
+    void end() {}
+    void updateBaudRate(unsigned long) {}
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    size_t write(uint8_t c) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+#endif // AIR780EG_HOST_ARDUINO_H
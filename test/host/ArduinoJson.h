@@ -0,0 +1,83 @@
+#ifndef AIR780EG_HOST_ARDUINO_JSON_H
+#define AIR780EG_HOST_ARDUINO_JSON_H
+
+#include "Arduino.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+// 主机构建只需要 getLocationJSON() 用到的部分：单层对象，按写入顺序输出紧凑JSON。
+// 浮点数按 ArduinoJson 6 的方式以 double 保存、最多9位小数并去掉末尾的0，用于比较编码大小
+struct JsonVariantStub {
+    std::string* value;
+
+    JsonVariantStub& operator=(bool v)
+    {
+        *value = v ? "true" : "false";
+        return *this;
+    }
+    JsonVariantStub& operator=(int v) { return number((long long)v); }
+    JsonVariantStub& operator=(long v) { return number((long long)v); }
+    JsonVariantStub& operator=(unsigned int v) { return number((long long)v); }
+    JsonVariantStub& operator=(unsigned long v) { return number((long long)v); }
+    JsonVariantStub& operator=(float v) { return real(v); }
+    JsonVariantStub& operator=(double v) { return real(v); }
+    JsonVariantStub& operator=(const char* v)
+    {
+        *value = std::string("\"") + v + "\"";
+        return *this;
+    }
+    JsonVariantStub& operator=(const String& v) { return operator=(v.c_str()); }
+
+private:
+    JsonVariantStub& number(long long v)
+    {
+        *value = std::to_string(v);
+        return *this;
+    }
+    JsonVariantStub& real(double v)
+    {
+        char buffer[48];
+        snprintf(buffer, sizeof(buffer), "%.9f", v);
+        std::string text = buffer;
+        text.erase(text.find_last_not_of('0') + 1);
+        if (text.back() == '.')
+        {
+            text.pop_back();
+        }
+        *value = text == "-0" ? "0" : text;
+        return *this;
+    }
+};
+
+class DynamicJsonDocument {
+private:
+    std::vector<std::pair<std::string, std::string>> members;
+
+public:
+    explicit DynamicJsonDocument(size_t) {}
+    JsonVariantStub operator[](const char* key)
+    {
+        for (auto& member : members)
+        {
+            if (member.first == key)
+            {
+                return JsonVariantStub{&member.second};
+            }
+        }
+        members.emplace_back(key, "null");
+        return JsonVariantStub{&members.back().second};
+    }
+    template <class T>
+    T as() const
+    {
+        std::string out = "{";
+        for (const auto& member : members)
+        {
+            out += (out.size() > 1 ? ",\"" : "\"") + member.first + "\":" + member.second;
+        }
+        return T(out + "}");
+    }
+};
+
+#endif // AIR780EG_HOST_ARDUINO_JSON_H
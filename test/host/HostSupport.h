@@ -0,0 +1,81 @@
+#ifndef AIR780EG_HOST_SUPPORT_H
+#define AIR780EG_HOST_SUPPORT_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+/*
+ * 主机测试公用部分：虚拟时钟、模拟模块、检查宏
+ */
+
+namespace host {
+
+// 虚拟时钟：开启后 millis()/micros() 只由 advance() 和 delay() 推进
+void useFakeClock(unsigned long start_us = 1000000);
+void useRealClock();
+void advance(unsigned long ms);
+// 让 millis() 在 ms 毫秒后回绕到0（只平移 millis()，micros() 不变）。
+// 主机上 unsigned long 为64位，回绕发生在 2^64 而不是设备上的 2^32，库中按有符号差值比较的代码相同
+void wrapMillisIn(unsigned long ms);
+
+// 日志输出到 stdout（默认关闭，环境变量 AIR780EG_HOST_LOG=1 打开）
+void enableLog(bool enable);
+
+// 模拟模块：按行接收库发出的AT命令并交给 onCommand 处理，应答可以立即给出或按虚拟时间延迟到达。
+// 以 '\r' 结束一行（随后的 '\n' 忽略）；expectData(n) 之后的 n 个字节作为提示符后的原始数据收集
+class FakeModem : public Stream {
+public:
+    std::function<void(FakeModem& modem, const std::string& line)> onCommand;
+    std::function<void(FakeModem& modem, const std::string& data)> onData;
+    std::string written;      // 库发出的全部字节
+    int commands = 0;
+
+    // 立即可读
+    void inject(const std::string& text) { rx += text; }
+    // ms 毫秒（虚拟时间）后可读；同一时刻的数据按调用顺序到达
+    void reply(unsigned long ms, const std::string& text);
+    void expectData(size_t length) { data_left = length; data.clear(); }
+    // 每毫秒虚拟时间最多放出的字节数，0 为不限（模拟串口逐段到达）
+    void setDrip(size_t bytes) { drip = bytes; }
+    bool idle() const { return pending.empty() && pos >= rx.size(); }
+    size_t unread() const { return rx.size() - pos; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+private:
+    std::string rx;
+    size_t pos = 0;
+    size_t limit = 0;
+    size_t drip = 0;
+    unsigned long drip_ms = 0;
+    std::string line;
+    bool skip_lf = false;
+    size_t data_left = 0;
+    std::string data;
+    std::multimap<unsigned long, std::string> pending;
+    void release();
+};
+
+std::string toHex(const std::string& bytes);
+
+extern int failures;
+int finish(const char* name);
+
+} // namespace host
+
+#define HOST_CHECK(cond)                                                               \
+    do                                                                                 \
+    {                                                                                  \
+        if (!(cond))                                                                   \
+        {                                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);   \
+            host::failures++;                                                          \
+        }                                                                              \
+    } while (0)
+
+#endif // AIR780EG_HOST_SUPPORT_H
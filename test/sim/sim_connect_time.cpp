@@ -0,0 +1,193 @@
+// 异步连接流程（user-048）：模拟时延 DNS 400ms、TCP 握手 300ms、CONNACK 150ms、其余应答 20ms，
+// 统计连接耗时中位数；缓存IP连接失败后回退到域名；断线重连不阻塞 loop()，
+// 重连期间到达的旧发布错误不会再开始一条连接流程；TCP 很快建立时 AT+MCONNECT 也不等待命令间隔
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <algorithm>
+
+struct BrokerModem {
+    host::FakeModem modem;
+    int network_queries = 0;
+    int dns_queries = 0;
+    int connects_by_ip = 0;
+    bool refuse_ip = false;
+    bool fail_publish = false;         // 发布应答 ERROR，应答前连接断开
+    int mipstarts = 0;
+    unsigned long tcp_ms = 300;        // 按IP连接时的TCP握手耗时
+    unsigned long tcp_ok_at = 0;       // CONNECT OK 到达的时间
+    unsigned long mconnect_at = 0;     // 收到 AT+MCONNECT 的时间
+
+    BrokerModem()
+    {
+        modem.onCommand = [this](host::FakeModem& m, const std::string& line) { answer(m, line); };
+    }
+
+    void answer(host::FakeModem& m, const std::string& line)
+    {
+        if (line == "AT+MQTTSTATU")
+        {
+            m.reply(20, "\r\n+MQTTSTATU :1\r\n\r\nOK\r\n");
+        }
+        else if (line == "AT+CEREG?")
+        {
+            network_queries++;
+            m.reply(20, "\r\n+CEREG: 0,1\r\n\r\nOK\r\n");
+        }
+        else if (line == "AT+CGATT?")
+        {
+            m.reply(20, "\r\n+CGATT: 1\r\n\r\nOK\r\n");
+        }
+        else if (line.rfind("AT+CDNSGIP", 0) == 0)
+        {
+            dns_queries++;
+            m.reply(20, "\r\nOK\r\n");
+            m.reply(400, "\r\n+CDNSGIP: 1,\"broker.example.com\",\"47.100.1.2\"\r\n");
+        }
+        else if (line.rfind("AT+MIPSTART", 0) == 0)
+        {
+            mipstarts++;
+            bool by_ip = line.find("47.100.1.2") != std::string::npos;
+            connects_by_ip += by_ip;
+            m.reply(20, "\r\nOK\r\n");
+            if (by_ip && refuse_ip)
+            {
+                m.reply(300, "\r\nCONNECT FAIL\r\n");
+                return;
+            }
+            // 按域名连接时模块内部还要解析一次
+            unsigned long delay_ms = by_ip ? tcp_ms : 700;
+            tcp_ok_at = millis() + delay_ms;
+            m.reply(delay_ms, "\r\nCONNECT OK\r\n");
+        }
+        else if (line.rfind("AT+MCONNECT", 0) == 0)
+        {
+            mconnect_at = millis();
+            m.reply(20, "\r\nOK\r\n");
+            m.reply(150, "\r\nCONNACK OK\r\n");
+        }
+        else if (fail_publish && line.rfind("AT+MPUB", 0) == 0)
+        {
+            m.reply(10, "\r\nCLOSED\r\n");
+            m.reply(50, "\r\nERROR\r\n");
+        }
+        else if (line == "AT+MPUBEX=?")
+        {
+            m.reply(20, "\r\nERROR\r\n");
+        }
+        else
+        {
+            m.reply(20, "\r\nOK\r\n");
+        }
+    }
+};
+
+struct Sim {
+    BrokerModem broker;
+    Air780EGCore core;
+    Air780EGGNSS gnss{&core};
+    Air780EGMQTT mqtt{&core, &gnss};
+
+    Sim()
+    {
+        core.attachStream(&broker.modem);
+        mqtt.init();
+    }
+
+    void run(unsigned long ms)
+    {
+        unsigned long end = millis() + ms;
+        while (millis() < end)
+        {
+            core.processCommands();
+            mqtt.loop();
+            host::advance(1);
+        }
+    }
+
+    // 同步连接耗时（ms）
+    unsigned long timedConnect()
+    {
+        Air780EGHostTest::setState(mqtt, MQTT_DISCONNECTED);
+        unsigned long start = millis();
+        mqtt.connect("broker.example.com", 1883, "sim-device");
+        return millis() - start;
+    }
+};
+
+int main()
+{
+    host::useFakeClock();
+    {
+        Sim sim;
+        printf("connect ms:");
+        for (int i = 0; i < 8; i++)
+        {
+            printf(" %lu", sim.timedConnect());
+            HOST_CHECK(sim.mqtt.isConnected());
+            sim.run(2000);
+        }
+        MQTTConnectStats stats = sim.mqtt.getConnectStats();
+        printf("\nmedian %lu ms (tcp %lu, connack %lu), network checks skipped %u, dns hits %u\n", stats.median_ms,
+               stats.last_tcp_ms, stats.last_connack_ms, stats.network_checks_skipped, stats.dns_cache_hits);
+        // 第一次按域名连接约1.4秒，之后用缓存IP并跳过网络检查，约550ms
+        HOST_CHECK(stats.successes == 8);
+        HOST_CHECK(stats.median_ms >= 450 && stats.median_ms <= 650);
+        HOST_CHECK(stats.dns_lookups == 1 && sim.broker.dns_queries == 1);
+        HOST_CHECK(sim.broker.network_queries == 1);
+        HOST_CHECK(sim.mqtt.getBrokerIP() == "47.100.1.2");
+        printf("AT+MCONNECT sent %lu ms after CONNECT OK\n", sim.broker.mconnect_at - sim.broker.tcp_ok_at);
+
+        // 缓存IP拒绝连接：清除缓存，下次按域名连接
+        sim.broker.refuse_ip = true;
+        sim.timedConnect();
+        HOST_CHECK(!sim.mqtt.isConnected() && sim.mqtt.getBrokerIP().length() == 0);
+        sim.timedConnect();
+        HOST_CHECK(sim.mqtt.isConnected());
+    }
+    {
+        // 断线后的自动重连在 loop() 中分步完成，单次 loop() 不等待应答
+        Sim sim;
+        sim.mqtt.connect("broker.example.com", 1883, "sim-device");
+        sim.run(2000);
+        sim.broker.modem.inject("\r\nCLOSED\r\n");
+        unsigned long longest = 0;
+        for (int i = 0; i < 5000; i++)
+        {
+            unsigned long start = millis();
+            sim.core.processCommands();
+            sim.mqtt.loop();
+            longest = std::max(longest, millis() - start);
+            host::advance(1);
+        }
+        printf("reconnect: state %d, successes %u, longest loop() %lu ms\n", sim.mqtt.getState(),
+               sim.mqtt.getReconnectStats().successes, longest);
+        HOST_CHECK(sim.mqtt.isConnected() && sim.mqtt.getReconnectStats().successes == 1);
+        HOST_CHECK(longest <= 5);
+    }
+    {
+        // 发布等待应答时断线：重连已开始后才到达的 ERROR 不改变状态，只有一条连接流程
+        Sim sim;
+        sim.mqtt.connect("broker.example.com", 1883, "sim-device");
+        sim.run(2000);
+        sim.broker.fail_publish = true;
+        sim.broker.mipstarts = 0;
+        sim.mqtt.publishAsync("t/x", "abc", 0);
+        sim.run(3000);
+        printf("publish error during reconnect: state %d, MIPSTART %d, successes %u\n", sim.mqtt.getState(),
+               sim.broker.mipstarts, sim.mqtt.getReconnectStats().successes);
+        HOST_CHECK(sim.mqtt.isConnected() && sim.broker.mipstarts == 1);
+        HOST_CHECK(sim.mqtt.getReconnectStats().successes == 1);
+    }
+    {
+        // TCP 握手只要 30ms，CONNECT OK 到达时距 AT+MIPSTART 发出还不到命令间隔（默认100ms）
+        Sim sim;
+        sim.mqtt.connect("broker.example.com", 1883, "sim-device");
+        sim.run(2000);
+        sim.broker.tcp_ms = 30;
+        sim.timedConnect();
+        unsigned long gap = sim.broker.mconnect_at - sim.broker.tcp_ok_at;
+        printf("fast TCP: AT+MCONNECT sent %lu ms after CONNECT OK\n", gap);
+        HOST_CHECK(sim.mqtt.isConnected() && gap <= 1);
+    }
+    return host::finish("sim_connect_time");
+}
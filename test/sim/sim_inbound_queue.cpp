@@ -0,0 +1,217 @@
+// 下行消息队列（user-041）：8 个槽位收到 20 条连续 +MSUB 时三种溢出策略的行为，
+// 命令响应中夹带的 +MSUB 只交付一次，主题处理器读取中的队首槽位不被新消息覆盖，
+// 暂停期间Core暂存的消息有字节上限
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <algorithm>
+#include <vector>
+
+static std::vector<std::string> received;
+
+static void onMessage(const String& topic, const String& payload)
+{
+    received.push_back(std::string(payload.c_str(), payload.length()));
+}
+
+static std::string msub(int index)
+{
+    std::string payload = "cmd-" + std::to_string(index);
+    return "\r\n+MSUB: \"dev/cmd\"," + std::to_string(payload.size()) + " byte," + host::toHex(payload) + "\r\n";
+}
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line == "AT+MPUBEX=?")
+    {
+        modem.inject("\r\nERROR\r\n"); // 不支持原始字节发布，使用HEX模式
+    }
+    else if (line == "AT+MQTTSTATU")
+    {
+        modem.inject("\r\n+MQTTSTATU :1\r\n\r\nOK\r\n");
+    }
+    else if (line == "AT+CSQ")
+    {
+        // 应答稍后到达，中间插入的上报由测试注入
+        modem.reply(5, "\r\n+CSQ: 20,0\r\n\r\nOK\r\n");
+    }
+    else if (line == "AT+CGATT?")
+    {
+        // 响应中夹带一串消息，足以填满队列
+        std::string text = "\r\n+CGATT: 1\r\n";
+        for (int i = 100; i < 110; i++)
+        {
+            text += msub(i);
+        }
+        modem.inject(text + "\r\nOK\r\n");
+    }
+    else
+    {
+        modem.inject("\r\nOK\r\n");
+    }
+}
+
+static Air780EGCore* handler_core = nullptr;
+static bool handler_intact = true;
+
+// 第一条消息的处理器中执行同步命令，其间到达的消息把队列填满
+static void onTopic(const char* topic, size_t topic_len, const uint8_t* payload, size_t payload_len, void* context)
+{
+    std::string before((const char*)payload, payload_len);
+    if (before == "cmd-0")
+    {
+        handler_core->sendATCommand("AT+CGATT?", 1000);
+        handler_intact = std::string((const char*)payload, payload_len) == before;
+    }
+    received.push_back(before);
+}
+
+struct Sim {
+    host::FakeModem modem;
+    Air780EGCore core;
+    Air780EGGNSS gnss{&core};
+    Air780EGMQTT mqtt{&core, &gnss};
+
+    Sim()
+    {
+        modem.onCommand = answer;
+        core.attachStream(&modem);
+        core.setATCommandDelay(0);
+        mqtt.init();
+        Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+        mqtt.setMessageCallback(onMessage);
+        received.clear();
+    }
+
+    void pump(int ms)
+    {
+        for (int i = 0; i < ms; i++)
+        {
+            core.processCommands();
+            mqtt.loop();
+            host::advance(1);
+        }
+    }
+};
+
+static void burst(Sim& sim, MQTTInboundOverflowPolicy policy)
+{
+    sim.mqtt.setInboundOverflowPolicy(policy);
+    for (int i = 0; i < 20; i++)
+    {
+        sim.modem.inject(msub(i));
+    }
+    // 一次读取：队列只有8个槽位
+    sim.core.processCommands();
+}
+
+int main()
+{
+    host::useFakeClock();
+    {
+        Sim sim;
+        burst(sim, MQTT_INBOUND_DROP_OLDEST);
+        MQTTInboundStats stats = sim.mqtt.getInboundStats();
+        HOST_CHECK(stats.depth == 8 && stats.dropped_oldest == 12);
+        sim.pump(10);
+        HOST_CHECK(received.size() == 8 && received.front() == "cmd-12" && received.back() == "cmd-19");
+    }
+    {
+        Sim sim;
+        burst(sim, MQTT_INBOUND_DROP_NEWEST);
+        MQTTInboundStats stats = sim.mqtt.getInboundStats();
+        HOST_CHECK(stats.depth == 8 && stats.dropped_newest == 12);
+        sim.pump(10);
+        HOST_CHECK(received.size() == 8 && received.front() == "cmd-0" && received.back() == "cmd-7");
+    }
+    {
+        Sim sim;
+        burst(sim, MQTT_INBOUND_PAUSE);
+        MQTTInboundStats stats = sim.mqtt.getInboundStats();
+        // 队列满后停止读取，其余消息留在串口
+        HOST_CHECK(stats.depth == 8 && stats.dropped_oldest == 0 && stats.dropped_newest == 0);
+        HOST_CHECK(stats.pauses > 0 && sim.modem.unread() > 0);
+        sim.pump(10);
+        HOST_CHECK(received.size() == 20 && received.back() == "cmd-19");
+        HOST_CHECK(!sim.core.isURCInputPaused());
+    }
+    {
+        // 暂停策略下命令执行期间到达的连续消息：队列满后暂存在Core，一条也不丢
+        Sim sim;
+        sim.mqtt.setInboundOverflowPolicy(MQTT_INBOUND_PAUSE);
+        sim.core.sendATCommandAsync("AT+CSQ");
+        sim.core.sendATCommandAsync("AT+CSQ");
+        sim.core.processCommands();
+        for (int i = 0; i < 20; i++)
+        {
+            sim.modem.inject(msub(i));
+        }
+        sim.core.processCommands();
+        MQTTInboundStats stats = sim.mqtt.getInboundStats();
+        HOST_CHECK(stats.depth == 8 && stats.dropped_newest == 0 && stats.dropped_oldest == 0);
+        sim.pump(50);
+        stats = sim.mqtt.getInboundStats();
+        HOST_CHECK(received.size() == 20 && stats.dropped_newest == 0);
+        for (size_t i = 0; i < received.size(); i++)
+        {
+            HOST_CHECK(received[i] == "cmd-" + std::to_string(i));
+        }
+    }
+    {
+        // 暂停策略下命令执行期间持续到达大消息：Core暂存的字节数有上限，超出的按队列已满丢弃并计数
+        Sim sim;
+        sim.mqtt.setInboundOverflowPolicy(MQTT_INBOUND_PAUSE);
+        std::string body(400, 'y');
+        sim.core.sendATCommandAsync("AT+CSQ");
+        sim.core.processCommands();
+        size_t max_held = 0;
+        for (int i = 0; i < 40; i++)
+        {
+            sim.modem.inject("\r\n+MSUB: \"dev/cmd\",400 byte," + host::toHex(body) + "\r\n");
+            sim.core.processCommands();
+            max_held = std::max(max_held, sim.core.getHeldURCBytes());
+        }
+        sim.pump(50);
+        MQTTInboundStats stats = sim.mqtt.getInboundStats();
+        printf("held: max %u bytes, %u overflows, %u delivered, %u dropped\n", (unsigned)max_held,
+               (unsigned)sim.core.getHeldURCOverflows(), (unsigned)received.size(), (unsigned)stats.dropped_newest);
+        HOST_CHECK(max_held > 0 && max_held <= 4096);
+        HOST_CHECK(sim.core.getHeldURCOverflows() > 0 && stats.dropped_newest == sim.core.getHeldURCOverflows());
+        HOST_CHECK(received.size() + stats.dropped_newest == 40 && sim.core.getHeldURCBytes() == 0);
+    }
+    {
+        // 暂停策略下两条超过槽位大小的消息：第二条等第一条交付后再接收
+        Sim sim;
+        sim.mqtt.setInboundOverflowPolicy(MQTT_INBOUND_PAUSE);
+        std::string big(600, 'x');
+        sim.core.sendATCommandAsync("AT+CSQ");
+        sim.core.processCommands();
+        sim.modem.inject("\r\n+MSUB: \"ota\",600 byte," + host::toHex(big) + "\r\n");
+        sim.modem.inject("\r\n+MSUB: \"ota\",600 byte," + host::toHex(big) + "\r\n");
+        sim.pump(50);
+        MQTTInboundStats stats = sim.mqtt.getInboundStats();
+        HOST_CHECK(received.size() == 2 && stats.large == 2 && stats.oversized == 0);
+    }
+    {
+        // 命令执行期间到达的上报：随响应读取，只交付一次
+        Sim sim;
+        sim.core.sendATCommandAsync("AT+CSQ");
+        sim.core.processCommands();
+        sim.modem.inject("\r\n+MSUB: \"a/b\",5 byte,68656c6c6f\r\n");
+        sim.pump(20);
+        HOST_CHECK(received.size() == 1 && received[0] == "hello");
+        HOST_CHECK(sim.mqtt.getInboundStats().received == 1);
+    }
+    {
+        // 主题处理器直接读取槽位：处理器执行期间队列满，丢弃最早策略也不覆盖正在交付的消息
+        Sim sim;
+        handler_core = &sim.core;
+        HOST_CHECK(sim.mqtt.addTopicHandler("dev/cmd", onTopic));
+        sim.modem.inject(msub(0));
+        sim.pump(20);
+        MQTTInboundStats stats = sim.mqtt.getInboundStats();
+        HOST_CHECK(handler_intact);
+        HOST_CHECK(received.size() > 1 && received[0] == "cmd-0" && received[1] == "cmd-100");
+        HOST_CHECK(stats.dropped_newest == 3 && stats.dropped_oldest == 0);
+    }
+    return host::finish("sim_inbound_queue");
+}
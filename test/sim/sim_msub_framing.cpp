@@ -0,0 +1,151 @@
+// +MSUB 按声明长度读取（user-042）：带 CR/LF 的 3000 字节二进制负载分段到达、
+// 主题含逗号、命令响应中夹带含 "OK\r\n" 的负载，原始和HEX两种格式都应原样交付；
+// 同步命令同样按长度读取，且不会在消息读到一半时发送
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <vector>
+
+static std::vector<std::string> received;
+
+static void onMessage(const String& topic, const String& payload)
+{
+    received.push_back(std::string(topic.c_str()) + "|" + std::string(payload.c_str(), payload.length()));
+}
+
+static bool hex_mode = false;
+static std::string csq_response;
+static size_t unread_at_send = 0;
+static const std::string sub_payload = "xx\r\nSUBACK\r\nOK\r\nyy";
+
+static void onCSQ(ATCommandResult result, const String& response, unsigned long latency_ms, void* context)
+{
+    csq_response.assign(response.c_str(), response.length());
+}
+
+static std::string msub(const std::string& topic, const std::string& payload)
+{
+    return "\r\n+MSUB: \"" + topic + "\"," + std::to_string(payload.size()) + " byte," +
+           (hex_mode ? host::toHex(payload) : payload) + "\r\n";
+}
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line == "AT+MPUBEX=?")
+    {
+        modem.inject(hex_mode ? "\r\nERROR\r\n" : "\r\nOK\r\n");
+    }
+    else if (line == "AT+MQTTSTATU")
+    {
+        modem.inject("\r\n+MQTTSTATU :1\r\n\r\nOK\r\n");
+    }
+    else if (line == "AT+CSQ")
+    {
+        unread_at_send = modem.unread();
+        modem.reply(5, "\r\n+CSQ: 20,0\r\n\r\nOK\r\n");
+    }
+    else if (line == "AT+MSUB=\"dev/sync\",1")
+    {
+        // OK 与 SUBACK 之间到达一条负载含 SUBACK 和 OK 的消息
+        modem.inject("\r\nOK\r\n" + msub("dev/sync", sub_payload) + "\r\nSUBACK\r\n");
+    }
+    else
+    {
+        modem.inject("\r\nOK\r\n");
+    }
+}
+
+static std::string binary(size_t size, int seed)
+{
+    std::string data;
+    for (size_t i = 0; i < size; i++)
+    {
+        data.push_back((char)((i * 31 + seed) % 256));
+    }
+    data[size / 2] = '\r';
+    data[size / 2 + 1] = '\n';
+    return data;
+}
+
+static void run(bool hex)
+{
+    hex_mode = hex;
+    received.clear();
+    host::FakeModem modem;
+    modem.onCommand = answer;
+    Air780EGCore core;
+    core.attachStream(&modem);
+    core.setATCommandDelay(0);
+    Air780EGGNSS gnss(&core);
+    Air780EGMQTT mqtt(&core, &gnss);
+    mqtt.init();
+    HOST_CHECK(mqtt.getPayloadMode() == (hex ? MQTT_PAYLOAD_HEX : MQTT_PAYLOAD_RAW));
+    Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+    mqtt.setMessageCallback(onMessage);
+    auto pump = [&](int ms) {
+        for (int i = 0; i < ms; i++)
+        {
+            core.processCommands();
+            mqtt.loop();
+            host::advance(1);
+        }
+    };
+
+    // 1. 空闲时到达的大负载，每毫秒100字节
+    std::string big = binary(3000, 1);
+    modem.setDrip(100);
+    modem.inject(msub("cfg/ota", big));
+    pump(100);
+    modem.setDrip(0);
+    pump(10);
+
+    // 2. 主题含逗号
+    std::string small = binary(40, 2);
+    modem.inject(msub("a,b/c", small));
+    pump(10);
+
+    // 3. 命令响应中夹带的消息，负载里有 OK
+    std::string okish = "xx\r\nOK\r\nyy";
+    csq_response.clear();
+    core.sendATCommandAsync("AT+CSQ", onCSQ, nullptr);
+    core.processCommands();
+    modem.inject(msub("dev/cmd", okish));
+    pump(20);
+
+    // 4. 同步订阅期间到达的消息：照常交付，负载里的 SUBACK 不结束命令
+    HOST_CHECK(mqtt.subscribe("dev/sync", 1));
+    pump(10);
+
+    // 5. 消息读到一半时发起同步命令：先读完消息再发送
+    modem.setDrip(8);
+    modem.inject(msub("dev/slow", okish));
+    pump(3);
+    unread_at_send = 0;
+    String csq = core.sendATCommand("AT+CSQ", 1000);
+    modem.setDrip(0);
+    // 发送时只剩消息末尾的 CR/LF 未读
+    HOST_CHECK(unread_at_send <= 2);
+    HOST_CHECK(csq.indexOf("+CSQ: 20,0") >= 0 && csq.indexOf("yy") < 0);
+    pump(10);
+
+    HOST_CHECK(received.size() == 5);
+    if (received.size() == 5)
+    {
+        HOST_CHECK(received[0] == "cfg/ota|" + big);
+        HOST_CHECK(received[1] == "a,b/c|" + small);
+        HOST_CHECK(received[2] == "dev/cmd|" + okish);
+        HOST_CHECK(received[3] == "dev/sync|" + sub_payload);
+        HOST_CHECK(received[4] == "dev/slow|" + okish);
+    }
+    HOST_CHECK(mqtt.getInboundStats().large == 1);
+    // AT+CSQ 的响应没有被负载里的 OK 提前结束，也不含消息内容
+    HOST_CHECK(csq_response.find("+CSQ: 20,0") != std::string::npos);
+    HOST_CHECK(csq_response.find("yy") == std::string::npos);
+}
+
+int main()
+{
+    host::useFakeClock();
+    run(false);
+    run(true);
+    return host::finish("sim_msub_framing");
+}
@@ -0,0 +1,265 @@
+// 离线发布队列（user-034）：定时任务离线时返回的 "{}" 不写入队列；
+// 旧版本写入的 "{}" 记录在补发时删除，不阻塞之后的消息；
+// 压缩中途写入失败时原日志和索引不变，替换过程中断电后 begin() 从临时文件恢复；写入失败有计数
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <vector>
+
+static const char* LOG_PATH = "sim_outbox.log";
+static const char* TMP_PATH = "sim_outbox.log.tmp";
+
+// 压缩时写入 fail_after 字节后出错的存储
+struct FaultyStorage : Air780EGOutboxStorage {
+    Air780EGOutboxFile file{LOG_PATH};
+    long fail_after = -1;
+    size_t rewritten = 0;
+
+    size_t size() override { return file.size(); }
+    bool read(size_t offset, uint8_t* buffer, size_t len) override { return file.read(offset, buffer, len); }
+    bool append(const uint8_t* data, size_t len) override { return file.append(data, len); }
+    bool patch(size_t offset, uint8_t value) override { return file.patch(offset, value); }
+    bool clear() override { return file.clear(); }
+    bool rewriteBegin() override
+    {
+        rewritten = 0;
+        return file.rewriteBegin();
+    }
+    bool rewriteAppend(const uint8_t* data, size_t len) override
+    {
+        if (fail_after >= 0 && rewritten + len > (size_t)fail_after)
+        {
+            return false;
+        }
+        rewritten += len;
+        return file.rewriteAppend(data, len);
+    }
+    bool rewriteCommit() override { return file.rewriteCommit(); }
+    void rewriteAbort() override { file.rewriteAbort(); }
+    void recover() override { file.recover(); }
+};
+
+static bool exists(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file)
+    {
+        fclose(file);
+    }
+    return file != nullptr;
+}
+
+static std::string payloadOf(int i)
+{
+    return "{\"seq\":" + std::to_string(i) + ",\"pad\":\"xxxxxxxxxxxxxxxx\"}";
+}
+
+// 剩余消息按顺序取出并核对内容
+static bool drainsInOrder(Air780EGOutbox& outbox, const std::vector<int>& expected)
+{
+    bool ok = outbox.size() == expected.size();
+    for (int seq : expected)
+    {
+        String topic, payload;
+        int qos;
+        bool retain;
+        uint32_t ticket;
+        if (!outbox.peek(topic, payload, qos, retain, ticket))
+        {
+            return false;
+        }
+        ok = ok && topic == "dev/t" && std::string(payload.c_str()) == payloadOf(seq);
+        outbox.remove(ticket);
+    }
+    return ok && outbox.isEmpty();
+}
+
+static void compactionFailure()
+{
+    remove(LOG_PATH);
+    remove(TMP_PATH);
+    FaultyStorage storage;
+    Air780EGOutbox outbox;
+    HOST_CHECK(outbox.begin(&storage, 1024, 32));
+    for (int i = 0; i < 12; i++)
+    {
+        HOST_CHECK(outbox.push("dev/t", payloadOf(i).c_str()));
+    }
+    size_t log_size = storage.size();
+
+    // 删除前8条时触发压缩，第一次压缩在写入一部分后失败
+    storage.fail_after = 60;
+    for (int i = 0; i < 8; i++)
+    {
+        String topic, payload;
+        int qos;
+        bool retain;
+        uint32_t ticket;
+        HOST_CHECK(outbox.peek(topic, payload, qos, retain, ticket));
+        outbox.remove(ticket);
+        storage.fail_after = i < 6 ? 60 : -1;
+    }
+    Air780EGOutboxStats stats = outbox.getStats();
+    printf("compaction: %u compactions, log %u -> %u bytes\n", (unsigned)stats.compactions, (unsigned)log_size,
+           (unsigned)stats.file_bytes);
+    HOST_CHECK(!exists(TMP_PATH));
+    HOST_CHECK(drainsInOrder(outbox, {8, 9, 10, 11}));
+
+    // 只有失败的压缩时：原日志大小不变，重新打开后内容完整
+    remove(LOG_PATH);
+    outbox.end();
+    HOST_CHECK(outbox.begin(&storage, 1024, 32));
+    for (int i = 0; i < 12; i++)
+    {
+        outbox.push("dev/t", payloadOf(i).c_str());
+    }
+    log_size = storage.size();
+    outbox.resetStats();
+    storage.fail_after = 60;
+    for (int i = 0; i < 8; i++)
+    {
+        String topic, payload;
+        int qos;
+        bool retain;
+        uint32_t ticket;
+        outbox.peek(topic, payload, qos, retain, ticket);
+        outbox.remove(ticket);
+    }
+    HOST_CHECK(outbox.getStats().compactions == 0 && storage.size() == log_size && !exists(TMP_PATH));
+    outbox.end();
+    storage.fail_after = -1;
+    HOST_CHECK(outbox.begin(&storage, 1024, 32));
+    HOST_CHECK(drainsInOrder(outbox, {8, 9, 10, 11}));
+    outbox.end();
+}
+
+// 替换日志时断电：只剩完整的临时文件时恢复它；原日志还在时丢弃未完成的临时文件
+static void powerCutDuringCommit()
+{
+    remove(LOG_PATH);
+    remove(TMP_PATH);
+    {
+        Air780EGOutboxFile storage(LOG_PATH);
+        Air780EGOutbox outbox;
+        outbox.begin(&storage);
+        for (int i = 0; i < 3; i++)
+        {
+            outbox.push("dev/t", payloadOf(i).c_str());
+        }
+        outbox.end();
+    }
+    rename(LOG_PATH, TMP_PATH);
+    {
+        Air780EGOutboxFile storage(LOG_PATH);
+        Air780EGOutbox outbox;
+        HOST_CHECK(outbox.begin(&storage));
+        HOST_CHECK(!exists(TMP_PATH));
+        HOST_CHECK(drainsInOrder(outbox, {0, 1, 2}));
+        outbox.end();
+    }
+
+    {
+        Air780EGOutboxFile storage(LOG_PATH);
+        Air780EGOutbox outbox;
+        outbox.begin(&storage);
+        outbox.push("dev/t", payloadOf(5).c_str());
+        outbox.end();
+    }
+    FILE* partial = fopen(TMP_PATH, "wb");
+    fwrite("\xA7\xFF", 1, 2, partial);
+    fclose(partial);
+    {
+        Air780EGOutboxFile storage(LOG_PATH);
+        Air780EGOutbox outbox;
+        HOST_CHECK(outbox.begin(&storage));
+        HOST_CHECK(!exists(TMP_PATH));
+        HOST_CHECK(drainsInOrder(outbox, {5}));
+        outbox.end();
+    }
+    remove(LOG_PATH);
+}
+
+static String emptyTask()
+{
+    return "{}";
+}
+
+// 按日志格式直接写入一条记录（模拟旧版本留下的数据）
+static void writeRecord(const std::string& topic, const std::string& payload)
+{
+    FILE* file = fopen(LOG_PATH, "ab");
+    unsigned char header[AIR780EG_OUTBOX_HEADER_SIZE] = {0xA7, 0xFF, 0, 0, (unsigned char)topic.size(),
+                                                         (unsigned char)(payload.size() & 0xFF),
+                                                         (unsigned char)(payload.size() >> 8)};
+    fwrite(header, 1, sizeof(header), file);
+    fwrite(topic.data(), 1, topic.size(), file);
+    fwrite(payload.data(), 1, payload.size(), file);
+    fclose(file);
+}
+
+int main()
+{
+    host::useFakeClock();
+    remove(LOG_PATH);
+    writeRecord("dev/status", "{}");
+    writeRecord("dev/status", "{\"v\":1}");
+
+    host::FakeModem modem;
+    modem.onCommand = [](host::FakeModem& m, const std::string& line) {
+        m.reply(5, line == "AT+MQTTSTATU" ? "\r\n+MQTTSTATU :1\r\n\r\nOK\r\n" : "\r\nOK\r\n");
+    };
+    Air780EGCore core;
+    core.attachStream(&modem);
+    core.setATCommandDelay(0);
+    Air780EGGNSS gnss(&core);
+    Air780EGMQTT mqtt(&core, &gnss);
+
+    Air780EGOutboxFile storage(LOG_PATH);
+    Air780EGOutbox outbox;
+    HOST_CHECK(outbox.begin(&storage));
+    HOST_CHECK(outbox.size() == 2);
+    outbox.setDrainRate(0);
+    mqtt.setOutbox(&outbox);
+
+    // 空负载不入队
+    HOST_CHECK(!outbox.push("dev/status", "{}"));
+    HOST_CHECK(!outbox.push("dev/status", ""));
+
+    // 离线时定时任务返回 "{}"：不写入队列
+    Air780EGHostTest::setState(mqtt, MQTT_DISCONNECTED);
+    mqtt.addScheduledTask("status", "dev/status", emptyTask, 1000);
+    for (int i = 0; i < 5000; i++)
+    {
+        mqtt.loop();
+        host::advance(1);
+    }
+    HOST_CHECK(outbox.size() == 2);
+
+    // 连接后：旧的 "{}" 记录被删除，之后的消息正常补发
+    mqtt.removeScheduledTask("status");
+    Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+    modem.written.clear();
+    for (int i = 0; i < 500 && !outbox.isEmpty(); i++)
+    {
+        core.processCommands();
+        mqtt.loop();
+        host::advance(1);
+    }
+    Air780EGOutboxStats stats = outbox.getStats();
+    HOST_CHECK(outbox.isEmpty());
+    HOST_CHECK(stats.drained == 1 && stats.drain_failures == 0);
+    HOST_CHECK(modem.written.find("dev/status") != std::string::npos);
+
+    // 离线时队列写不下：publish() 返回false，失败被计数
+    Air780EGHostTest::setState(mqtt, MQTT_DISCONNECTED);
+    std::string huge(40000, 'x');
+    HOST_CHECK(!mqtt.publish("dev/big", huge.c_str()));
+    HOST_CHECK(mqtt.publishAsync("dev/big", huge.c_str()) == 0);
+    HOST_CHECK(mqtt.getOutboxStoreFailures() == 2 && outbox.getStats().rejected == 2);
+
+    outbox.end();
+    remove(LOG_PATH);
+
+    compactionFailure();
+    powerCutDuringCommit();
+    return host::finish("sim_outbox");
+}
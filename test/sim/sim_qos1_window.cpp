@@ -0,0 +1,192 @@
+// QoS1 在途窗口（user-044）：模拟模块 5ms 应答OK、200ms 后上报 +MPUBACK，
+// 100 条QoS1发布在窗口 1/2/4/8 下的吞吐量；确认丢失重传、ERROR 重试、超过次数报告失败；
+// 默认方式（不设置确认URC）下成功只表示模块已接受
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <vector>
+
+struct PublishModem {
+    host::FakeModem modem;
+    bool send_ack = true;
+    int publishes = 0;
+    int drop_ack_of = -1;  // 不上报确认的发布序号
+    int error_of = -1;     // 应答 ERROR 的发布序号
+
+    PublishModem()
+    {
+        modem.onCommand = [this](host::FakeModem& m, const std::string& line) {
+            if (line.rfind("AT+MPUB", 0) != 0)
+            {
+                m.reply(1, line == "AT+MQTTSTATU" ? "\r\n+MQTTSTATU :1\r\n\r\nOK\r\n" : "\r\nOK\r\n");
+                return;
+            }
+            int n = publishes++;
+            if (n == error_of)
+            {
+                m.reply(5, "\r\nERROR\r\n");
+                return;
+            }
+            m.reply(5, "\r\nOK\r\n");
+            if (send_ack && n != drop_ack_of)
+            {
+                m.reply(200, "\r\n+MPUBACK: 1\r\n");
+            }
+        };
+    }
+};
+
+struct Sim {
+    PublishModem fake;
+    Air780EGCore core;
+    Air780EGGNSS gnss{&core};
+    Air780EGMQTT mqtt{&core, &gnss};
+
+    Sim()
+    {
+        core.attachStream(&fake.modem);
+        core.setATCommandDelay(0);
+        Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+    }
+
+    void step()
+    {
+        core.processCommands();
+        mqtt.loop();
+        host::advance(1);
+    }
+};
+
+static int done_ok = 0;
+static int done_failed = 0;
+static std::vector<uint16_t> order;
+static unsigned long last_latency = 0;
+
+static void onPublished(uint16_t id, MQTTPublishResult result, unsigned long latency_ms)
+{
+    last_latency = latency_ms;
+    if (result == MQTT_PUBLISH_OK)
+    {
+        done_ok++;
+    }
+    else
+    {
+        done_failed++;
+    }
+    order.push_back(id);
+}
+
+static void reset()
+{
+    done_ok = 0;
+    done_failed = 0;
+    order.clear();
+}
+
+// 返回每秒确认的消息数
+static double throughput(int window)
+{
+    reset();
+    Sim sim;
+    sim.mqtt.setPublishAckURC("+MPUBACK");
+    sim.mqtt.setQoS1Window(window);
+    const int total = 100;
+    int sent = 0;
+    unsigned long start = millis();
+    while (done_ok + done_failed < total && millis() - start < 600000)
+    {
+        while (sent < total && sim.mqtt.publishAsync("t/x", "{\"v\":1}", 1, false, onPublished))
+        {
+            sent++;
+        }
+        sim.step();
+    }
+    double rate = total / ((millis() - start) / 1000.0);
+    MQTTQoS1Stats stats = sim.mqtt.getQoS1Stats();
+    bool in_order = true;
+    for (size_t i = 1; i < order.size(); i++)
+    {
+        in_order = in_order && order[i] > order[i - 1];
+    }
+    printf("window %d: %.1f msg/s, avg ack %lu ms, max in-flight %u, retransmits %u\n", window, rate,
+           stats.avg_ack_ms, stats.max_inflight, stats.retransmits);
+    HOST_CHECK(done_ok == total && stats.retransmits == 0 && in_order);
+    HOST_CHECK(stats.max_inflight == window);
+    return rate;
+}
+
+int main()
+{
+    host::useFakeClock();
+
+    // 1. 吞吐量随窗口线性增长：RTT 200ms 时约为 窗口×5 条/秒
+    for (int window : {1, 2, 4, 8})
+    {
+        double rate = throughput(window);
+        HOST_CHECK(rate > window * 5 * 0.9 && rate < window * 5 * 1.1);
+    }
+
+    // 2. 第二条的确认丢失：超时后重传，三条都成功
+    {
+        reset();
+        Sim sim;
+        sim.fake.drop_ack_of = 1;
+        sim.mqtt.setPublishAckURC("+MPUBACK");
+        sim.mqtt.setQoS1Window(1);
+        sim.mqtt.setQoS1Retry(1000, 3);
+        for (int i = 0; i < 3; i++)
+        {
+            sim.mqtt.publishAsync("t/x", "abc", 1, false, onPublished);
+        }
+        for (int i = 0; i < 5000 && done_ok + done_failed < 3; i++)
+        {
+            sim.step();
+        }
+        HOST_CHECK(done_ok == 3 && sim.mqtt.getQoS1Stats().retransmits == 1 && sim.fake.publishes == 4);
+    }
+
+    // 3. 默认以OK为确认：ERROR 后重试
+    {
+        reset();
+        Sim sim;
+        sim.fake.send_ack = false;
+        sim.fake.error_of = 0;
+        sim.mqtt.publishAsync("t/x", "abc", 1, false, onPublished);
+        for (int i = 0; i < 200 && done_ok + done_failed < 1; i++)
+        {
+            sim.step();
+            // ERROR 会把连接标记为异常，这里只关心重试
+            Air780EGHostTest::setState(sim.mqtt, MQTT_CONNECTED);
+        }
+        HOST_CHECK(done_ok == 1 && sim.mqtt.getQoS1Stats().retransmits == 1 && sim.fake.publishes == 2);
+    }
+
+    // 4. 只允许发送一次且确认丢失：报告失败并释放槽位
+    {
+        reset();
+        Sim sim;
+        sim.fake.drop_ack_of = 0;
+        sim.mqtt.setPublishAckURC("+MPUBACK");
+        sim.mqtt.setQoS1Retry(500, 1);
+        sim.mqtt.publishAsync("t/x", "abc", 1, false, onPublished);
+        for (int i = 0; i < 2000 && done_ok + done_failed < 1; i++)
+        {
+            sim.step();
+        }
+        HOST_CHECK(done_failed == 1 && sim.mqtt.getQoS1Stats().failed == 1 && sim.mqtt.getPendingPublishCount() == 0);
+    }
+    // 5. 默认以OK为确认：模块从不上报PUBACK也报告成功，耗时只是模块应答命令的时间
+    {
+        reset();
+        Sim sim;
+        sim.fake.send_ack = false;
+        sim.mqtt.publishAsync("t/x", "abc", 1, false, onPublished);
+        for (int i = 0; i < 100 && done_ok + done_failed < 1; i++)
+        {
+            sim.step();
+        }
+        MQTTQoS1Stats stats = sim.mqtt.getQoS1Stats();
+        printf("default ack: ok after %lu ms without PUBACK\n", last_latency);
+        HOST_CHECK(done_ok == 1 && last_latency < 20 && stats.retransmits == 0);
+    }
+    return host::finish("sim_qos1_window");
+}
@@ -0,0 +1,152 @@
+// AT收发录制与回放（user-028）：对模拟模块录制一段会话（查询命令、原始模式发布的 'D' 记录、
+// 空闲时到达的上报），再用 Air780EGReplayStream 回放给新的 Core。
+// 相同的调用顺序得到相同的应答、应答时延与录制一致且不计不一致；改动一条命令计一次不一致，
+// 捕获结束后多发的命令计为意外发送；流式输出与 dump() 的内容相同
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+
+struct BytePrint : Print {
+    std::string bytes;
+    size_t write(uint8_t c) override
+    {
+        bytes += (char)c;
+        return 1;
+    }
+};
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line == "AT+CSQ")
+    {
+        modem.reply(30, "\r\n+CSQ: 21,0\r\n\r\nOK\r\n");
+    }
+    else if (line.rfind("AT+MPUBEX=", 0) == 0)
+    {
+        modem.expectData(std::stoul(line.substr(line.rfind(',') + 1)));
+        modem.reply(5, "\r\n>");
+    }
+    else
+    {
+        modem.reply(10, "\r\nOK\r\n");
+    }
+}
+
+static void answerData(host::FakeModem& modem, const std::string& /* data */)
+{
+    modem.reply(40, "\r\nOK\r\n");
+}
+
+struct Session {
+    String csq;
+    String cgatt;
+    unsigned long csq_ms = 0;
+    bool published = false;
+    String urc;
+};
+
+static void onRing(const String& urc, void* context)
+{
+    *(String*)context = urc;
+}
+
+// 录制与回放使用同一段驱动代码，cgatt_cmd 用来制造一条不一致的命令。
+// MQTT 析构时发送的 AT+MDISCONNECT 也在录制范围内
+static Session drive(Stream& stream, Air780EGRecorder* recorder, const char* cgatt_cmd)
+{
+    Session session;
+    Air780EGCore core;
+    core.attachStream(&stream);
+    core.setATCommandDelay(0);
+    core.setRecorder(recorder);
+    core.addURCHandler("RING", onRing, &session.urc);
+    if (recorder)
+    {
+        recorder->start();
+    }
+    {
+        Air780EGGNSS gnss(&core);
+        Air780EGMQTT mqtt(&core, &gnss);
+        Air780EGHostTest::usePayloadMode(mqtt, MQTT_PAYLOAD_RAW);
+        Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+
+        unsigned long start = millis();
+        session.csq = core.sendATCommand("AT+CSQ");
+        session.csq_ms = millis() - start;
+        session.cgatt = core.sendATCommand(cgatt_cmd);
+        session.published = mqtt.publish("dev/t", "{\"v\":1}", 1);
+        for (int ms = 0; ms < 200; ms++)
+        {
+            core.processCommands();
+            host::advance(1);
+        }
+    }
+    if (recorder)
+    {
+        recorder->stop();
+    }
+    return session;
+}
+
+int main()
+{
+    host::useFakeClock();
+
+    // 录制：RING 在最后一条命令的应答之后到达，由空闲时的上报读取分发
+    host::FakeModem modem;
+    modem.onCommand = [](host::FakeModem& m, const std::string& line) {
+        answer(m, line);
+        if (line.rfind("AT+MPUBEX=", 0) == 0)
+        {
+            m.reply(100, "\r\nRING\r\n");
+        }
+    };
+    modem.onData = answerData;
+    Air780EGRecorder recorder;
+    BytePrint streamed;
+    HOST_CHECK(recorder.begin(8192));
+    recorder.setSink(&streamed);
+    Session recorded = drive(modem, &recorder, "AT+CGATT?");
+    HOST_CHECK(recorded.csq.indexOf("+CSQ: 21,0") >= 0 && recorded.published && recorded.urc == "RING");
+    HOST_CHECK(recorder.getDroppedRecords() == 0 && recorder.getEvictedRecords() == 0);
+
+    BytePrint capture;
+    HOST_CHECK(recorder.dump(capture) == capture.bytes.size());
+    HOST_CHECK(capture.bytes == streamed.bytes);
+    HOST_CHECK(capture.bytes.find("{\"v\":1}") != std::string::npos);  // 原始负载的 'D' 记录
+    printf("captured %u bytes, %u records\n", (unsigned)capture.bytes.size(), recorder.getRecordCount());
+
+    // 原速回放：应答、时延和上报与录制一致
+    Air780EGReplayStream replay;
+    HOST_CHECK(replay.begin((const uint8_t*)capture.bytes.data(), capture.bytes.size()));
+    replay.setSpeed(1.0f);
+    Session replayed = drive(replay, nullptr, "AT+CGATT?");
+    printf("replay: %u lines, %u mismatches, %u unexpected, AT+CSQ %lu ms (recorded %lu ms)\n",
+           replay.getTxLineCount(), replay.getTxMismatchCount(), replay.getUnexpectedTxCount(), replayed.csq_ms,
+           recorded.csq_ms);
+    HOST_CHECK(replayed.csq == recorded.csq && replayed.cgatt == recorded.cgatt);
+    HOST_CHECK(replayed.published && replayed.urc == "RING");
+    HOST_CHECK(replayed.csq_ms >= 30 && replayed.csq_ms <= recorded.csq_ms + 1);
+    HOST_CHECK(replay.getTxMismatchCount() == 0 && replay.getUnexpectedTxCount() == 0);
+    HOST_CHECK(replay.getTxLineCount() == 5);  // AT+CSQ、AT+CGATT?、AT+MPUBEX、原始负载和 AT+MDISCONNECT
+    HOST_CHECK(replay.isFinished());
+
+    // 捕获结束后再发送的命令计为意外发送
+    replay.print("AT\r\n");
+    HOST_CHECK(replay.getUnexpectedTxCount() == 1);
+
+    // 改动一条命令：计一次不一致，其余命令仍对齐，应答照常按捕获释放
+    Air780EGReplayStream changed;
+    HOST_CHECK(changed.begin((const uint8_t*)capture.bytes.data(), capture.bytes.size()));
+    changed.setSpeed(0);
+    Session diverged = drive(changed, nullptr, "AT+CGATT=1");
+    printf("changed command: %u mismatches\n", changed.getTxMismatchCount());
+    HOST_CHECK(changed.getTxMismatchCount() == 1 && changed.getUnexpectedTxCount() == 0);
+    HOST_CHECK(diverged.csq == recorded.csq && diverged.published);
+
+    // 文件头损坏时拒绝回放
+    std::string corrupt = capture.bytes;
+    corrupt[0] = 'X';
+    Air780EGReplayStream invalid;
+    HOST_CHECK(!invalid.begin((const uint8_t*)corrupt.data(), corrupt.size()) && invalid.isFinished());
+    return host::finish("sim_replay");
+}
@@ -0,0 +1,68 @@
+// 恢复订阅（user-046）：重连后的订阅连续发送，SUBACK 由上报处理器计数；
+// 恢复期间应用同步订阅的 SUBACK 是该命令自身的应答，不计入恢复数
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line == "AT+MSUB=\"user/t\",1")
+    {
+        modem.reply(5, "\r\nOK\r\n");
+        modem.reply(50, "\r\nSUBACK\r\n");
+    }
+    else if (line.rfind("AT+MSUB=", 0) == 0)
+    {
+        // 服务器较慢：恢复订阅的 SUBACK 在应用订阅之后到达
+        modem.reply(5, "\r\nOK\r\n");
+        modem.reply(300, "\r\nSUBACK\r\n");
+    }
+    else if (line == "AT+MQTTSTATU")
+    {
+        modem.reply(5, "\r\n+MQTTSTATU :1\r\n\r\nOK\r\n");
+    }
+    else
+    {
+        modem.reply(5, "\r\nOK\r\n");
+    }
+}
+
+int main()
+{
+    host::useFakeClock();
+    host::FakeModem modem;
+    modem.onCommand = answer;
+    Air780EGCore core;
+    core.attachStream(&modem);
+    core.setATCommandDelay(0);
+    Air780EGGNSS gnss(&core);
+    Air780EGMQTT mqtt(&core, &gnss);
+    mqtt.init();
+    Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+    auto pump = [&](int ms) {
+        for (int i = 0; i < ms; i++)
+        {
+            core.processCommands();
+            mqtt.loop();
+            host::advance(1);
+        }
+    };
+
+    HOST_CHECK(mqtt.subscribe("a/1", 1) && mqtt.subscribe("a/2", 1) && mqtt.subscribe("a/3", 1));
+    pump(10);
+
+    // 恢复订阅已发出、SUBACK 未到时应用同步订阅
+    Air780EGHostTest::resubscribeAll(mqtt);
+    pump(10);
+    HOST_CHECK(mqtt.subscribe("user/t", 1));
+    MQTTReconnectStats stats = mqtt.getReconnectStats();
+    printf("after sync subscribe: resubscribed %u\n", stats.resubscribed);
+    HOST_CHECK(stats.resubscribed == 0);
+
+    // 三条恢复订阅的 SUBACK 全部计数，最后一条到达时才算恢复完成
+    pump(1000);
+    stats = mqtt.getReconnectStats();
+    printf("restored: %u ok, %u failed\n", stats.resubscribed, stats.resubscribe_failed);
+    HOST_CHECK(stats.resubscribed == 3 && stats.resubscribe_failed == 0);
+    HOST_CHECK(modem.idle());
+    return host::finish("sim_resubscribe");
+}
@@ -0,0 +1,128 @@
+// 零分配定时任务（user-040）：写缓冲区形式的定时任务在 HEX 和 AT+MPUBEX 两种负载模式下
+// 每次发布不分配堆内存；对照返回 String 的回调形式，确认堆追踪确实在统计
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+
+static const int PUBLISHES = 100;
+static int publishes = 0;
+static int sequence = 0;
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line.rfind("AT+MPUBEX=", 0) == 0)
+    {
+        // 最后一个参数是负载长度，收到 '>' 后写入
+        modem.expectData(std::stoul(line.substr(line.rfind(',') + 1)));
+        modem.inject("\r\n>");
+    }
+    else if (line.rfind("AT+MPUB=", 0) == 0)
+    {
+        publishes++;
+        modem.inject("\r\nOK\r\n");
+    }
+    else if (line == "AT+MQTTSTATU")
+    {
+        modem.inject("\r\n+MQTTSTATU :1\r\n\r\nOK\r\n");
+    }
+    else
+    {
+        modem.inject("\r\nOK\r\n");
+    }
+}
+
+static void answerData(host::FakeModem& modem, const std::string& data)
+{
+    publishes++;
+    modem.inject("\r\nOK\r\n");
+}
+
+// 约600字节的遥测，与现场日志中的负载大小相当
+static size_t writeTelemetry(uint8_t* buffer, size_t size, void* context)
+{
+    int n = snprintf((char*)buffer, size, "{\"seq\":%d,\"lat\":31.2304,\"lng\":121.4737,\"speed\":42.5,\"track\":\"",
+                     ++sequence);
+    for (; n < 590 && (size_t)n < size; n++)
+    {
+        buffer[n] = 'a' + n % 26;
+    }
+    n += snprintf((char*)buffer + n, size - n, "\"}");
+    return n;
+}
+
+static String telemetryString()
+{
+    uint8_t buffer[640];
+    size_t len = writeTelemetry(buffer, sizeof(buffer), nullptr);
+    String payload;
+    payload.concat((const char*)buffer, len);
+    return payload;
+}
+
+static uint32_t totalAllocs()
+{
+    uint32_t count = 0;
+    for (int i = 0; i < AIR780EG_SUBSYS_COUNT; i++)
+    {
+        count += Air780EGHeapTrace::getStats((Air780EGSubsystem)i).alloc_count;
+    }
+    return count;
+}
+
+// 先运行几个周期让一次性的分配（日志缓冲、槽位等）完成，再统计 PUBLISHES 次发布的分配次数
+static double allocsPerPublish(MQTTPayloadMode mode, bool writer)
+{
+    host::FakeModem modem;
+    modem.onCommand = answer;
+    modem.onData = answerData;
+    modem.written.reserve(1 << 20);
+    Air780EGCore core;
+    core.attachStream(&modem);
+    core.setATCommandDelay(0);
+    Air780EGGNSS gnss(&core);
+    Air780EGMQTT mqtt(&core, &gnss);
+    Air780EGHostTest::registerURCHandlers(mqtt);
+    Air780EGHostTest::usePayloadMode(mqtt, mode);
+    Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+    if (writer)
+    {
+        HOST_CHECK(mqtt.addScheduledTask("telemetry", "dev/telemetry", writeTelemetry, nullptr, 640, 1000));
+    }
+    else
+    {
+        HOST_CHECK(mqtt.addScheduledTask("telemetry", "dev/telemetry", telemetryString, 1000));
+    }
+
+    auto run = [&](int count) {
+        int target = publishes + count;
+        for (int i = 0; i < count * 2000 && publishes < target; i++)
+        {
+            core.processCommands();
+            mqtt.loop();
+            host::advance(1);
+        }
+    };
+    publishes = 0;
+    run(3);
+    Air780EGHeapTrace::reset();
+    Air780EGHeapTrace::enable();
+    int start = publishes;
+    run(PUBLISHES);
+    Air780EGHeapTrace::enable(false);
+    int measured = publishes - start;
+    HOST_CHECK(measured == PUBLISHES);
+    printf("%s %-6s: %.2f allocs / %.0f bytes per publish\n", mode == MQTT_PAYLOAD_RAW ? "mpubex" : "hex   ",
+           writer ? "writer" : "string", (double)totalAllocs() / measured,
+           (double)Air780EGHeapTrace::getStats(AIR780EG_SUBSYS_MQTT).alloc_bytes / measured);
+    return (double)totalAllocs() / measured;
+}
+
+int main()
+{
+    host::useFakeClock();
+    HOST_CHECK(Air780EGHeapTrace::isCompiledIn());
+
+    HOST_CHECK(allocsPerPublish(MQTT_PAYLOAD_HEX, true) == 0);
+    HOST_CHECK(allocsPerPublish(MQTT_PAYLOAD_RAW, true) == 0);
+    HOST_CHECK(allocsPerPublish(MQTT_PAYLOAD_HEX, false) >= 1);
+    return host::finish("sim_scheduled_writer");
+}
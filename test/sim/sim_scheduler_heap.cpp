@@ -0,0 +1,251 @@
+// 定时任务到期堆（user-038）：关闭自动相位，每个任务的执行时间都可以精确计算。
+// 每毫秒一次 loop() 下各任务准时执行、堆序始终成立、getTimeUntilNextTask() 与参考值一致；
+// setScheduledTaskInterval() 原地改间隔后从上一个计划时间起按新间隔排期；
+// removeScheduledTask() 用最后一个任务填补空位（包括在回调中移除），其余任务不受影响；
+// 容量可调整；millis() 回绕前后按原间隔执行
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <climits>
+#include <map>
+#include <vector>
+
+struct Run {
+    std::string task;
+    unsigned long ms;
+};
+
+static std::vector<Run> runs;
+static std::map<std::string, std::string> remove_on_run;  // 任务第一次执行时移除另一个任务
+static Air780EGMQTT* current = nullptr;
+
+static size_t writeTask(uint8_t* buffer, size_t size, void* context)
+{
+    const char* name = (const char*)context;
+    runs.push_back({name, millis()});
+    auto it = remove_on_run.find(name);
+    if (it != remove_on_run.end())
+    {
+        std::string victim = it->second;
+        remove_on_run.erase(it);
+        HOST_CHECK(current->removeScheduledTask(victim.c_str()));
+    }
+    return snprintf((char*)buffer, size, "{\"task\":\"%s\"}", name);
+}
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line == "AT+MQTTSTATU")
+    {
+        modem.inject("\r\n+MQTTSTATU :1\r\n\r\nOK\r\n");
+    }
+    else
+    {
+        modem.inject("\r\nOK\r\n");
+    }
+}
+
+struct Sim {
+    host::FakeModem modem;
+    Air780EGCore core;
+    Air780EGGNSS gnss{&core};
+    Air780EGMQTT mqtt{&core, &gnss};
+    unsigned long start;
+
+    Sim()
+    {
+        modem.onCommand = answer;
+        core.attachStream(&modem);
+        core.setATCommandDelay(0);
+        Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+        mqtt.setScheduledTaskPhaseSpread(false);
+        runs.clear();
+        remove_on_run.clear();
+        current = &mqtt;
+        start = millis();
+    }
+
+    bool add(const char* name, unsigned long interval_ms)
+    {
+        return mqtt.addScheduledTask(name, "dev/sched", writeTask, (void*)name, 64, interval_ms);
+    }
+
+    // 运行到相对开始时间 until_ms，每毫秒一次 loop()
+    void runUntil(unsigned long until_ms)
+    {
+        while (millis() - start < until_ms)
+        {
+            step();
+        }
+    }
+
+    void step()
+    {
+        mqtt.loop();
+        core.processCommands();
+        HOST_CHECK(Air780EGHostTest::scheduledHeapValid(mqtt));
+        host::advance(1);
+    }
+};
+
+// 任务相对开始时间的执行时刻
+static std::vector<unsigned long> runTimes(const std::string& task, unsigned long start)
+{
+    std::vector<unsigned long> times;
+    for (const Run& run : runs)
+    {
+        if (run.task == task)
+        {
+            times.push_back(run.ms - start);
+        }
+    }
+    return times;
+}
+
+static std::vector<unsigned long> every(unsigned long interval, unsigned long from, unsigned long until)
+{
+    std::vector<unsigned long> times;
+    for (unsigned long t = from; t < until; t += interval)
+    {
+        times.push_back(t);
+    }
+    return times;
+}
+
+static const char* const NAMES[] = {"t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7", "t8", "t9", "t10", "t11"};
+static const unsigned long INTERVALS[] = {1000, 1500, 2000, 2500, 3000, 3700, 4100, 5000, 6000, 7300, 8000, 9000};
+
+static void heapOrder()
+{
+    Sim sim;
+    // 默认容量10：第11个任务添加失败，扩容后保留已有任务
+    for (int i = 0; i < 10; i++)
+    {
+        HOST_CHECK(sim.add(NAMES[i], INTERVALS[i]));
+    }
+    HOST_CHECK(!sim.add(NAMES[10], INTERVALS[10]));
+    HOST_CHECK(!sim.mqtt.setMaxScheduledTasks(9));
+    HOST_CHECK(sim.mqtt.setMaxScheduledTasks(16) && sim.mqtt.getMaxScheduledTasks() == 16);
+    HOST_CHECK(sim.add(NAMES[10], INTERVALS[10]) && sim.add(NAMES[11], INTERVALS[11]));
+    HOST_CHECK(sim.mqtt.getScheduledTaskCount() == 12 && Air780EGHostTest::scheduledHeapValid(sim.mqtt));
+
+    // 每一步之后与参考值比较：已执行到 now-1，下一次是每个任务大于 now-1 的最小整数倍间隔
+    int mismatches = 0;
+    while (millis() - sim.start < 60000)
+    {
+        sim.step();
+        unsigned long now = millis() - sim.start;
+        unsigned long soonest = ULONG_MAX;
+        for (int i = 0; i < 12; i++)
+        {
+            soonest = std::min(soonest, ((now - 1) / INTERVALS[i] + 1) * INTERVALS[i] - now);
+        }
+        if (sim.mqtt.getTimeUntilNextTask() != soonest)
+        {
+            mismatches++;
+        }
+    }
+    HOST_CHECK(mismatches == 0);
+
+    for (int i = 0; i < 12; i++)
+    {
+        HOST_CHECK(runTimes(NAMES[i], sim.start) == every(INTERVALS[i], INTERVALS[i], 60000));
+    }
+    printf("heap order: 12 tasks, %u runs in 60 s, all on time\n", (unsigned)runs.size());
+}
+
+static void intervalChange()
+{
+    Sim sim;
+    HOST_CHECK(sim.add("a", 10000) && sim.add("b", 6000) && sim.add("c", 7000));
+
+    // 3秒时改为4秒：从上一个计划时间（添加时刻）起算，4秒时执行
+    sim.runUntil(3000);
+    HOST_CHECK(sim.mqtt.setScheduledTaskInterval("a", 4000));
+    HOST_CHECK(sim.mqtt.getTimeUntilNextTask() == 1000);
+    // 9秒时改为20秒：上一个计划时间是8秒，下一次在28秒
+    sim.runUntil(9000);
+    HOST_CHECK(sim.mqtt.setScheduledTaskInterval("a", 20000));
+    // 31秒时 b 改为1秒：上一个计划时间是30秒，新的计划时间已过，立即执行
+    sim.runUntil(31000);
+    HOST_CHECK(sim.mqtt.setScheduledTaskInterval("b", 1000));
+    HOST_CHECK(sim.mqtt.getTimeUntilNextTask() == 0);
+    sim.runUntil(34000);
+    HOST_CHECK(!sim.mqtt.setScheduledTaskInterval("missing", 1000));
+
+    HOST_CHECK(runTimes("a", sim.start) == std::vector<unsigned long>({4000, 8000, 28000}));
+    HOST_CHECK(runTimes("b", sim.start) == std::vector<unsigned long>({6000, 12000, 18000, 24000, 30000, 31000, 32000, 33000}));
+    HOST_CHECK(runTimes("c", sim.start) == every(7000, 7000, 34000));
+}
+
+static void removal()
+{
+    Sim sim;
+    for (int i = 0; i < 6; i++)
+    {
+        HOST_CHECK(sim.add(NAMES[i], INTERVALS[i]));
+    }
+    // 移除中间的任务：最后一个任务移到空位
+    HOST_CHECK(sim.mqtt.removeScheduledTask("t1"));
+    HOST_CHECK(sim.mqtt.getScheduledTaskCount() == 5);
+    HOST_CHECK(sim.mqtt.getScheduledTaskInfo(1).startsWith("Task: t5,"));
+    HOST_CHECK(!sim.mqtt.removeScheduledTask("t1"));
+
+    // t2 第一次执行时移除 t3，t4 第一次执行时移除自己
+    remove_on_run["t2"] = "t3";
+    remove_on_run["t4"] = "t4";
+    sim.runUntil(20000);
+    HOST_CHECK(sim.mqtt.getScheduledTaskCount() == 3);
+
+    HOST_CHECK(runTimes("t0", sim.start) == every(1000, 1000, 20000));
+    HOST_CHECK(runTimes("t1", sim.start).empty());
+    HOST_CHECK(runTimes("t2", sim.start) == every(2000, 2000, 20000));
+    HOST_CHECK(runTimes("t3", sim.start).empty());  // 2.5秒到期之前已在2秒时移除
+    HOST_CHECK(runTimes("t4", sim.start) == std::vector<unsigned long>({3000}));
+    HOST_CHECK(runTimes("t5", sim.start) == every(3700, 3700, 20000));
+
+    // 禁用期间不执行，重新启用后回到原时间线
+    HOST_CHECK(sim.mqtt.disableScheduledTask("t5"));
+    sim.runUntil(30000);
+    HOST_CHECK(sim.mqtt.enableScheduledTask("t5"));
+    sim.runUntil(40000);
+    std::vector<unsigned long> t5 = runTimes("t5", sim.start);
+    HOST_CHECK(t5.size() == 5 + 1 + 2);
+    if (t5.size() == 8)
+    {
+        HOST_CHECK(t5[5] == 30000);                      // 重新启用后执行一次（TASK_MISS_SKIP）
+        HOST_CHECK(t5[6] == 33300 && t5[7] == 37000);    // 回到 3.7 秒的整数倍
+    }
+
+    sim.mqtt.clearAllScheduledTasks();
+    HOST_CHECK(sim.mqtt.getScheduledTaskCount() == 0 && sim.mqtt.getTimeUntilNextTask() == ULONG_MAX);
+}
+
+static void millisWrap()
+{
+    Sim sim;
+    host::wrapMillisIn(2500);
+    sim.start = millis();
+    HOST_CHECK(sim.add("fast", 1000) && sim.add("slow", 3000));
+    // 回绕前：下一个任务还有1秒，不会因为回绕被当成已到期或很久以后
+    HOST_CHECK(sim.mqtt.getTimeUntilNextTask() == 1000);
+    sim.runUntil(2400);
+    HOST_CHECK(sim.mqtt.getTimeUntilNextTask() == 600);
+    sim.runUntil(2600);
+    HOST_CHECK(millis() < sim.start);  // 已回绕
+    HOST_CHECK(sim.mqtt.getTimeUntilNextTask() == 400);
+    sim.runUntil(12000);
+
+    HOST_CHECK(runTimes("fast", sim.start) == every(1000, 1000, 12000));
+    HOST_CHECK(runTimes("slow", sim.start) == every(3000, 3000, 12000));
+    printf("millis() wrap: %u runs across the wrap, all on time\n", (unsigned)runs.size());
+}
+
+int main()
+{
+    host::useFakeClock();
+    heapOrder();
+    intervalChange();
+    removal();
+    millisWrap();
+    return host::finish("sim_scheduler_heap");
+}
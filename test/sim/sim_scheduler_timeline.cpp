@@ -0,0 +1,309 @@
+// 定时任务时间线（user-039）：
+// - 自动相位按黄金分割序列错开，首次执行时刻与公式一致，任意任务数下相邻相位间隔不小于 interval/(3n)
+// - 10分钟、5个5秒任务、每次 loop() 之间阻塞50~300ms：不错开时每次都是5个任务在同一次 loop() 中突发，
+//   错开后每次 loop() 最多执行1个；每个任务120次，执行时刻相对计划时间的延迟不累积（不漂移）；
+//   getScheduledTaskStats() 的延迟和周期抖动与按实际执行时刻计算的结果一致
+// - 主循环阻塞12秒后，TASK_MISS_SKIP 执行一次并跳过其余周期，TASK_MISS_CATCH_UP 每次 loop() 补一个周期；
+//   零分配任务补执行时上一次的负载仍在发送，补的周期计为跳过
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+struct Run {
+    std::string task;
+    unsigned long ms;
+    int loop;
+};
+
+static std::vector<Run> runs;
+static int loops = 0;
+
+static size_t writeTask(uint8_t* buffer, size_t size, void* context)
+{
+    const char* name = (const char*)context;
+    runs.push_back({name, millis(), loops});
+    return snprintf((char*)buffer, size, "{\"task\":\"%s\"}", name);
+}
+
+// 发布约20ms后应答（串口发送和模块处理），之前的负载仍在发送队列中
+// 返回 String 的回调形式，每次发布复制负载
+static String skipTask()
+{
+    runs.push_back({"skip", millis(), loops});
+    return "{\"task\":\"skip\"}";
+}
+
+static String catchTask()
+{
+    runs.push_back({"catch", millis(), loops});
+    return "{\"task\":\"catch\"}";
+}
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line.rfind("AT+MPUB=", 0) == 0)
+    {
+        modem.reply(20, "\r\nOK\r\n");
+    }
+    else if (line == "AT+MQTTSTATU")
+    {
+        modem.inject("\r\n+MQTTSTATU :1\r\n\r\nOK\r\n");
+    }
+    else
+    {
+        modem.inject("\r\nOK\r\n");
+    }
+}
+
+struct Sim {
+    host::FakeModem modem;
+    Air780EGCore core;
+    Air780EGGNSS gnss{&core};
+    Air780EGMQTT mqtt{&core, &gnss};
+    unsigned long start;
+
+    explicit Sim(bool spread)
+    {
+        modem.onCommand = answer;
+        core.attachStream(&modem);
+        core.setATCommandDelay(0);
+        Air780EGHostTest::setState(mqtt, MQTT_CONNECTED);
+        mqtt.setScheduledTaskPhaseSpread(spread);
+        mqtt.setMaxScheduledTasks(16);
+        runs.clear();
+        loops = 0;
+        start = millis();
+    }
+
+    bool add(const char* name, unsigned long interval_ms)
+    {
+        return mqtt.addScheduledTask(name, "dev/sched", writeTask, (void*)name, 64, interval_ms);
+    }
+
+    // 一次 loop()，之后主循环阻塞 block_ms
+    void step(unsigned long block_ms)
+    {
+        mqtt.loop();
+        core.processCommands();
+        loops++;
+        host::advance(block_ms);
+    }
+
+    void runUntil(unsigned long until_ms)
+    {
+        while (millis() - start < until_ms)
+        {
+            step(1);
+        }
+    }
+};
+
+static std::vector<unsigned long> runTimes(const std::string& task, unsigned long start)
+{
+    std::vector<unsigned long> times;
+    for (const Run& run : runs)
+    {
+        if (run.task == task)
+        {
+            times.push_back(run.ms - start);
+        }
+    }
+    return times;
+}
+
+// 一次 loop() 中执行的任务数的最大值
+static int maxRunsPerLoop()
+{
+    std::map<int, int> per_loop;
+    int most = 0;
+    for (const Run& run : runs)
+    {
+        most = std::max(most, ++per_loop[run.loop]);
+    }
+    return most;
+}
+
+// 参考实现：第 k 个任务的自动相位
+static unsigned long goldenPhase(uint32_t k, unsigned long interval)
+{
+    uint32_t frac = (uint32_t)(k * 2654435769u);
+    return interval - (unsigned long)(((uint64_t)frac * interval) >> 32);
+}
+
+static const char* const NAMES[] = {"t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7", "t8", "t9", "t10", "t11"};
+
+static void phaseSpread()
+{
+    const unsigned long interval = 5000;
+    for (int n = 2; n <= 12; n++)
+    {
+        Sim sim(true);
+        for (int i = 0; i < n; i++)
+        {
+            HOST_CHECK(sim.add(NAMES[i], interval));
+        }
+        sim.runUntil(interval + 1);
+
+        std::vector<unsigned long> offsets;
+        for (int i = 0; i < n; i++)
+        {
+            std::vector<unsigned long> times = runTimes(NAMES[i], sim.start);
+            HOST_CHECK(!times.empty() && times[0] == goldenPhase(i, interval));
+            offsets.push_back(times.empty() ? 0 : times[0] % interval);
+        }
+        std::sort(offsets.begin(), offsets.end());
+        unsigned long min_gap = offsets.front() + interval - offsets.back();
+        for (int i = 1; i < n; i++)
+        {
+            min_gap = std::min(min_gap, offsets[i] - offsets[i - 1]);
+        }
+        HOST_CHECK(min_gap * 3 * n >= interval);
+        HOST_CHECK(maxRunsPerLoop() == 1);
+    }
+
+    // 手动设定相位：整条时间线平移，第一个任务不错开时相位等于间隔
+    Sim sim(true);
+    HOST_CHECK(sim.add("a", interval) && sim.add("b", interval));
+    HOST_CHECK(sim.mqtt.setScheduledTaskPhase("b", 1234));
+    sim.runUntil(12000);
+    HOST_CHECK(runTimes("a", sim.start) == std::vector<unsigned long>({5000, 10000}));
+    HOST_CHECK(runTimes("b", sim.start) == std::vector<unsigned long>({1234, 6234, 11234}));
+}
+
+struct TimelineResult {
+    int max_per_loop;
+    int loops_with_runs;
+    double mean_jitter;
+};
+
+// 10分钟，5个5秒任务，loop() 之间阻塞50~300ms
+static TimelineResult tenMinutes(bool spread)
+{
+    const unsigned long interval = 5000;
+    const unsigned long duration = 10 * 60 * 1000;
+    Sim sim(spread);
+    for (int i = 0; i < 5; i++)
+    {
+        HOST_CHECK(sim.add(NAMES[i], interval));
+    }
+    std::mt19937 rng(39);
+    // 运行到10分钟整的计划时间之后再加一次最长阻塞，保证每个任务的第120次都已执行
+    while (millis() - sim.start <= duration + 300)
+    {
+        sim.step(50 + rng() % 251);
+    }
+
+    double jitter_sum = 0;
+    int jitter_count = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        unsigned long phase = spread ? goldenPhase(i, interval) : interval;
+        std::vector<unsigned long> times = runTimes(NAMES[i], sim.start);
+        HOST_CHECK(times.size() == 120);
+
+        // 第 k 次执行的计划时间是 phase + k*interval，延迟不超过一次阻塞，不随时间累积
+        unsigned long late_sum = 0;
+        unsigned long late_max = 0;
+        unsigned long jitter_total = 0;
+        unsigned long jitter_max = 0;
+        for (size_t k = 0; k < times.size(); k++)
+        {
+            unsigned long planned = phase + k * interval;
+            HOST_CHECK(times[k] >= planned && times[k] - planned <= 300);
+            late_sum += times[k] - planned;
+            late_max = std::max(late_max, times[k] - planned);
+            if (k > 0)
+            {
+                unsigned long period = times[k] - times[k - 1];
+                unsigned long jitter = period > interval ? period - interval : interval - period;
+                jitter_total += jitter;
+                jitter_max = std::max(jitter_max, jitter);
+            }
+        }
+
+        ScheduledTaskStats stats;
+        HOST_CHECK(sim.mqtt.getScheduledTaskStats(NAMES[i], stats));
+        HOST_CHECK(stats.runs == times.size() && stats.skipped == 0);
+        HOST_CHECK(stats.avg_late_ms == late_sum / times.size() && stats.max_late_ms == late_max);
+        HOST_CHECK(stats.avg_jitter_ms == jitter_total / (times.size() - 1) && stats.max_jitter_ms == jitter_max);
+        jitter_sum += jitter_total;
+        jitter_count += times.size() - 1;
+    }
+
+    std::map<int, int> per_loop;
+    for (const Run& run : runs)
+    {
+        per_loop[run.loop]++;
+    }
+    return {maxRunsPerLoop(), (int)per_loop.size(), jitter_count ? jitter_sum / jitter_count : 0};
+}
+
+static void missPolicies()
+{
+    Sim sim(false);
+    HOST_CHECK(sim.mqtt.addScheduledTask("skip", "dev/sched", skipTask, 5000));
+    HOST_CHECK(sim.mqtt.addScheduledTask("catch", "dev/sched", catchTask, 5000));
+    HOST_CHECK(sim.add("writer", 5000));
+    HOST_CHECK(sim.mqtt.setScheduledTaskMissPolicy("catch", TASK_MISS_CATCH_UP));
+    HOST_CHECK(sim.mqtt.setScheduledTaskMissPolicy("writer", TASK_MISS_CATCH_UP));
+    sim.runUntil(6000);
+    // 主循环阻塞12秒：10秒和15秒的周期都错过
+    sim.step(12000);
+    int blocked_loop = loops;
+    sim.runUntil(26000);
+
+    // 跳过：18秒时执行一次，15秒的周期跳过，之后回到5秒的整数倍
+    HOST_CHECK(runTimes("skip", sim.start) == std::vector<unsigned long>({5000, 18000, 20000, 25000}));
+    // 补执行：18秒和紧接着的下一次 loop() 各补一个周期
+    HOST_CHECK(runTimes("catch", sim.start) == std::vector<unsigned long>({5000, 18000, 18001, 20000, 25000}));
+    int catch_loops[2] = {-1, -1};
+    int n = 0;
+    for (const Run& run : runs)
+    {
+        if (run.task == "catch" && run.loop >= blocked_loop && n < 2)
+        {
+            catch_loops[n++] = run.loop;
+        }
+    }
+    HOST_CHECK(catch_loops[0] == blocked_loop && catch_loops[1] == blocked_loop + 1);
+    // 零分配任务：补执行时上一次的负载还在发送，缓冲区不能覆盖，这个周期计为跳过
+    HOST_CHECK(runTimes("writer", sim.start) == std::vector<unsigned long>({5000, 18000, 20000, 25000}));
+
+    ScheduledTaskStats skip;
+    ScheduledTaskStats catch_up;
+    ScheduledTaskStats writer;
+    HOST_CHECK(sim.mqtt.getScheduledTaskStats("skip", skip) && sim.mqtt.getScheduledTaskStats("catch", catch_up) &&
+               sim.mqtt.getScheduledTaskStats("writer", writer));
+    HOST_CHECK(skip.runs == 4 && skip.skipped == 1 && skip.max_late_ms == 8000);
+    HOST_CHECK(catch_up.runs == 5 && catch_up.skipped == 0 && catch_up.max_late_ms == 8000);
+    HOST_CHECK(writer.skipped == 1);
+    // 延迟超过一个间隔的那次不计抖动，之后的间隔照常计入：skip 18→20秒，catch 18.000→18.001秒
+    HOST_CHECK(skip.max_jitter_ms == 3000);
+    HOST_CHECK(catch_up.max_jitter_ms == 4999);
+
+    sim.mqtt.resetScheduledTaskStats();
+    HOST_CHECK(sim.mqtt.getScheduledTaskStats("catch", catch_up) && catch_up.runs == 0 && catch_up.max_jitter_ms == 0);
+}
+
+int main()
+{
+    host::useFakeClock();
+    phaseSpread();
+
+    TimelineResult burst = tenMinutes(false);
+    TimelineResult spread = tenMinutes(true);
+    printf("10 min, 5 tasks x 5 s, 50-300 ms loop latency\n");
+    printf("  no spread: up to %d tasks per loop, %d loops with runs, mean period jitter %.0f ms\n",
+           burst.max_per_loop, burst.loops_with_runs, burst.mean_jitter);
+    printf("  spread:    up to %d tasks per loop, %d loops with runs, mean period jitter %.0f ms\n",
+           spread.max_per_loop, spread.loops_with_runs, spread.mean_jitter);
+    HOST_CHECK(burst.max_per_loop == 5 && burst.loops_with_runs == 120);
+    HOST_CHECK(spread.max_per_loop == 1 && spread.loops_with_runs == 600);
+    HOST_CHECK(spread.mean_jitter < 150);
+
+    missPolicies();
+    return host::finish("sim_scheduler_timeline");
+}
@@ -0,0 +1,213 @@
+// TLS证书文件（user-049）：模拟模块带一个文件系统（AT+FSFLSIZE / FSCREATE / FSWRITE / FSLS / FSDEL）。
+// 文件名含内容的 FNV-1a 哈希；重启后同样的证书按文件名和长度复用、不再上传；
+// 证书变化时只上传变化的那一个并删除同类旧文件，其他上下文的文件不受影响；
+// 模块上的文件长度不对时重新上传；超过 AT+FSWRITE 单次上限的证书分块追加写入
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <map>
+#include <vector>
+
+static std::map<std::string, std::string> files;  // 模块文件系统
+static std::vector<std::string> sslcfg;           // 收到的 AT+SSLCFG 命令
+static int writes = 0;
+static std::string write_target;
+static bool write_append = false;
+
+static std::string quoted(const std::string& line)
+{
+    size_t start = line.find('"') + 1;
+    return line.substr(start, line.find('"', start) - start);
+}
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line.rfind("AT+FSFLSIZE=", 0) == 0)
+    {
+        auto it = files.find(quoted(line));
+        modem.reply(5, it == files.end() ? "\r\nERROR\r\n"
+                                         : "\r\n+FSFLSIZE: " + std::to_string(it->second.size()) + "\r\n\r\nOK\r\n");
+    }
+    else if (line.rfind("AT+FSCREATE=", 0) == 0)
+    {
+        files[quoted(line)] = "";
+        modem.reply(5, "\r\nOK\r\n");
+    }
+    else if (line.rfind("AT+FSWRITE=", 0) == 0)
+    {
+        // AT+FSWRITE="<name>",<0 覆盖 / 1 追加>,<长度>,<超时>
+        size_t args = line.find("\",") + 2;
+        write_target = quoted(line);
+        write_append = line[args] == '1';
+        size_t len = std::stoul(line.substr(args + 2));
+        writes++;
+        modem.expectData(len);
+        modem.reply(5, "\r\n>");
+    }
+    else if (line == "AT+FSLS=\"/\"")
+    {
+        std::string listing = "\r\n";
+        for (const auto& file : files)
+        {
+            listing += file.first + "\r\n";
+        }
+        modem.reply(5, listing + "\r\nOK\r\n");
+    }
+    else if (line.rfind("AT+FSDEL=", 0) == 0)
+    {
+        files.erase(quoted(line));
+        modem.reply(5, "\r\nOK\r\n");
+    }
+    else
+    {
+        if (line.rfind("AT+SSLCFG=", 0) == 0)
+        {
+            sslcfg.push_back(line.substr(10));
+        }
+        modem.reply(5, "\r\nOK\r\n");
+    }
+}
+
+static void answerData(host::FakeModem& modem, const std::string& data)
+{
+    std::string& file = files[write_target];
+    file = write_append ? file + data : data;
+    modem.reply(5, "\r\nOK\r\n");
+}
+
+static std::string pem(const char* label, size_t body)
+{
+    std::string text = std::string("-----BEGIN ") + label + "-----\n";
+    for (size_t i = 0; i < body; i++)
+    {
+        text += (char)('A' + (i * 7 + strlen(label)) % 26);
+        if (i % 64 == 63)
+        {
+            text += '\n';
+        }
+    }
+    return text + "\n-----END " + label + "-----\n";
+}
+
+// 参考实现：FNV-1a 32位
+static std::string expectedName(int context, const char* tag, const std::string& content)
+{
+    uint32_t h = 2166136261u;
+    for (unsigned char c : content)
+    {
+        h = (h ^ c) * 16777619u;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "tls%d_%s_%08x.pem", context, tag, h);
+    return name;
+}
+
+static int countFiles(const char* prefix)
+{
+    int n = 0;
+    for (const auto& file : files)
+    {
+        n += file.first.rfind(prefix, 0) == 0;
+    }
+    return n;
+}
+
+int main()
+{
+    host::useFakeClock();
+    host::FakeModem modem;
+    modem.onCommand = answer;
+    modem.onData = answerData;
+    Air780EGCore core;
+    core.attachStream(&modem);
+    core.setATCommandDelay(0);
+
+    const std::string ca = pem("CERTIFICATE", 1200);
+    const std::string crt = pem("CERTIFICATE", 900);
+    const std::string key = pem("PRIVATE KEY", 1600);
+    const std::string ca_name = expectedName(AIR780EG_SSL_CTX_MQTT, "ca", ca);
+    const std::string crt_name = expectedName(AIR780EG_SSL_CTX_MQTT, "crt", crt);
+    const std::string key_name = expectedName(AIR780EG_SSL_CTX_MQTT, "key", key);
+    // 另一个上下文（HTTP）的CA，不能被MQTT上下文当作旧文件删除
+    const std::string http_ca = expectedName(AIR780EG_SSL_CTX_HTTP, "ca", ca);
+    files[http_ca] = ca;
+
+    // 首次：三个文件按内容哈希命名上传，内容与证书相同，SSL上下文按文件名配置
+    {
+        Air780EGTLS tls(&core, AIR780EG_SSL_CTX_MQTT);
+        tls.setCertificates(ca.c_str(), crt.c_str(), key.c_str());
+        HOST_CHECK(tls.getCertFileName(Air780EGTLS::CERT_CA) == ca_name);
+        HOST_CHECK(tls.apply("broker.example.com"));
+        Air780EGTLSStats stats = tls.getStats();
+        HOST_CHECK(stats.cert_uploads == 3 && stats.cert_reused == 0);
+        HOST_CHECK(stats.upload_bytes == ca.size() + crt.size() + key.size());
+        HOST_CHECK(files[ca_name] == ca && files[crt_name] == crt && files[key_name] == key);
+        HOST_CHECK(tls.getSecurityLevel() == 2);
+        std::vector<std::string> expected = {
+            "\"cacert\",88,\"" + ca_name + "\"",  "\"clientcert\",88,\"" + crt_name + "\"",
+            "\"clientkey\",88,\"" + key_name + "\"", "\"seclevel\",88,2",
+            "\"hostname\",88,\"broker.example.com\""};
+        HOST_CHECK(sslcfg == expected);
+
+        // 已配置且主机名不变时不再发送命令
+        int commands = modem.commands;
+        HOST_CHECK(tls.apply("broker.example.com") && modem.commands == commands);
+    }
+
+    // 重启：同样的证书只查询文件长度，全部复用，不再上传
+    {
+        Air780EGTLS tls(&core, AIR780EG_SSL_CTX_MQTT);
+        tls.setCertificates(ca.c_str(), crt.c_str(), key.c_str());
+        writes = 0;
+        HOST_CHECK(tls.apply("broker.example.com"));
+        Air780EGTLSStats stats = tls.getStats();
+        printf("after reboot: %u reused, %u uploaded\n", stats.cert_reused, stats.cert_uploads);
+        HOST_CHECK(stats.cert_reused == 3 && stats.cert_uploads == 0 && stats.upload_bytes == 0 && writes == 0);
+    }
+
+    // 更换CA：只上传新CA，旧CA文件删除，客户端证书和私钥复用，HTTP上下文的文件保留
+    const std::string ca2 = pem("CERTIFICATE", 1300);
+    const std::string ca2_name = expectedName(AIR780EG_SSL_CTX_MQTT, "ca", ca2);
+    {
+        Air780EGTLS tls(&core, AIR780EG_SSL_CTX_MQTT);
+        tls.setCertificates(ca2.c_str(), crt.c_str(), key.c_str());
+        HOST_CHECK(tls.apply("broker.example.com"));
+        Air780EGTLSStats stats = tls.getStats();
+        HOST_CHECK(stats.cert_uploads == 1 && stats.cert_reused == 2);
+        HOST_CHECK(files.count(ca2_name) && !files.count(ca_name) && files.count(http_ca));
+        HOST_CHECK(countFiles("tls88_") == 3 && countFiles("tls153_") == 1);
+    }
+
+    // 模块上的文件不完整（长度不符）：重新上传
+    files[crt_name].resize(100);
+    {
+        Air780EGTLS tls(&core, AIR780EG_SSL_CTX_MQTT);
+        tls.setCertificates(ca2.c_str(), crt.c_str(), key.c_str());
+        HOST_CHECK(tls.apply("broker.example.com"));
+        HOST_CHECK(tls.getStats().cert_uploads == 1 && tls.getStats().cert_reused == 2);
+        HOST_CHECK(files[crt_name] == crt);
+    }
+
+    // 超过单次写入上限（10240字节）的证书：先覆盖写第一块，再追加
+    const std::string bundle = pem("CERTIFICATE", 24000);
+    const std::string bundle_name = expectedName(AIR780EG_SSL_CTX_HTTP, "ca", bundle);
+    {
+        Air780EGTLS tls(&core, AIR780EG_SSL_CTX_HTTP);
+        tls.setCertificate(Air780EGTLS::CERT_CA, bundle.c_str());
+        writes = 0;
+        sslcfg.clear();
+        HOST_CHECK(tls.apply(""));
+        printf("%u-byte CA bundle written in %d chunks\n", (unsigned)bundle.size(), writes);
+        HOST_CHECK(writes == (int)((bundle.size() + 10239) / 10240) && files[bundle_name] == bundle);
+        HOST_CHECK(!files.count(http_ca));  // 同一上下文的旧CA
+        HOST_CHECK(tls.getSecurityLevel() == 1);
+        HOST_CHECK(sslcfg.back() == "\"seclevel\",153,1");  // 主机名为空时不设置
+
+        // 模块重启后重新配置；证书内容已在确认后释放，文件被外部删除时报告失败而不是上传空文件
+        tls.invalidate();
+        files.erase(bundle_name);
+        HOST_CHECK(!tls.apply("") && !files.count(bundle_name));
+    }
+
+    HOST_CHECK(modem.idle());
+    return host::finish("sim_tls_certs");
+}
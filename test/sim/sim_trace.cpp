@@ -0,0 +1,393 @@
+// 命令生命周期追踪（user-029）：对模拟模块运行同步、异步、出错和超时的命令，导出的 Chrome Trace JSON
+// 经严格解析后检查每条命令的 b/e 成对、阶段按 spacing → tx → await → response → callback 嵌套、
+// 结果和应答时延；命令文本和上报中的引号、反斜杠、控制字符被转义；
+// 缓冲区写满后只保留最新的事件，导出仍是合法JSON且按时间排序
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <map>
+#include <set>
+#include <vector>
+
+struct BytePrint : Print {
+    std::string bytes;
+    size_t write(uint8_t c) override
+    {
+        bytes += (char)c;
+        return 1;
+    }
+};
+
+// 严格的JSON解析，只保留检查需要的部分：对象成员、数组元素、字符串和数字
+struct Json {
+    char type = 0;  // 'o' 对象, 'a' 数组, 's' 字符串, 'n' 数字, 'l' true/false/null
+    std::string text;
+    double number = 0;
+    std::map<std::string, Json> members;
+    std::vector<Json> items;
+
+    const Json& operator[](const char* key) const
+    {
+        static const Json missing;
+        auto it = members.find(key);
+        return it == members.end() ? missing : it->second;
+    }
+};
+
+struct JsonParser {
+    const std::string& in;
+    size_t pos = 0;
+
+    void skipSpace()
+    {
+        while (pos < in.size() && strchr(" \t\r\n", in[pos]))
+        {
+            pos++;
+        }
+    }
+
+    bool literal(const char* word)
+    {
+        size_t n = strlen(word);
+        if (in.compare(pos, n, word) != 0)
+        {
+            return false;
+        }
+        pos += n;
+        return true;
+    }
+
+    bool string(std::string& out)
+    {
+        if (pos >= in.size() || in[pos] != '"')
+        {
+            return false;
+        }
+        for (pos++; pos < in.size(); pos++)
+        {
+            unsigned char c = in[pos];
+            if (c == '"')
+            {
+                pos++;
+                return true;
+            }
+            if (c < 0x20)
+            {
+                return false;  // 未转义的控制字符
+            }
+            if (c != '\\')
+            {
+                out += (char)c;
+                continue;
+            }
+            if (++pos >= in.size())
+            {
+                return false;
+            }
+            switch (in[pos])
+            {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'u':
+                if (pos + 4 >= in.size() || in.find_first_not_of("0123456789abcdefABCDEF", pos + 1) < pos + 5)
+                {
+                    return false;
+                }
+                out += (char)std::stoi(in.substr(pos + 1, 4), nullptr, 16);
+                pos += 4;
+                break;
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool value(Json& out)
+    {
+        skipSpace();
+        if (pos >= in.size())
+        {
+            return false;
+        }
+        char c = in[pos];
+        if (c == '{' || c == '[')
+        {
+            out.type = c == '{' ? 'o' : 'a';
+            char close = c == '{' ? '}' : ']';
+            pos++;
+            skipSpace();
+            if (pos < in.size() && in[pos] == close)
+            {
+                pos++;
+                return true;
+            }
+            while (true)
+            {
+                Json item;
+                if (out.type == 'o')
+                {
+                    std::string key;
+                    skipSpace();
+                    if (!string(key))
+                    {
+                        return false;
+                    }
+                    skipSpace();
+                    if (pos >= in.size() || in[pos++] != ':' || !value(item) || out.members.count(key))
+                    {
+                        return false;
+                    }
+                    out.members[key] = item;
+                }
+                else
+                {
+                    if (!value(item))
+                    {
+                        return false;
+                    }
+                    out.items.push_back(item);
+                }
+                skipSpace();
+                if (pos < in.size() && in[pos] == ',')
+                {
+                    pos++;
+                    continue;
+                }
+                return pos < in.size() && in[pos++] == close;
+            }
+        }
+        if (c == '"')
+        {
+            out.type = 's';
+            return string(out.text);
+        }
+        if (literal("true") || literal("false") || literal("null"))
+        {
+            out.type = 'l';
+            return true;
+        }
+        size_t end = in.find_first_not_of("-+.eE0123456789", pos);
+        if (end == pos)
+        {
+            return false;
+        }
+        out.type = 'n';
+        out.number = std::stod(in.substr(pos, end - pos));
+        pos = end;
+        return true;
+    }
+};
+
+// 解析导出结果并返回 traceEvents（去掉首个 process_name 元数据事件）
+static std::vector<Json> exportEvents()
+{
+    BytePrint out;
+    size_t written = Air780EGTrace::exportJSON(out);
+    HOST_CHECK(written == out.bytes.size());
+    Json root;
+    JsonParser parser{out.bytes};
+    bool valid = parser.value(root);
+    parser.skipSpace();
+    HOST_CHECK(valid && parser.pos == out.bytes.size());
+    HOST_CHECK(root["displayTimeUnit"].text == "ms");
+    const std::vector<Json>& events = root["traceEvents"].items;
+    HOST_CHECK(!events.empty() && events[0]["ph"].text == "M" && events[0]["name"].text == "process_name");
+    return events.empty() ? events : std::vector<Json>(events.begin() + 1, events.end());
+}
+
+// 一条命令的事件序列
+struct Span {
+    std::string name;
+    std::string result;
+    std::vector<std::string> phases;   // 按顺序，'b' 记为 "+name"，'e' 记为 "-name"
+    std::map<std::string, double> begin_ts;
+    std::map<std::string, double> duration_us;
+};
+
+static const std::set<std::string> PHASES = {"queued", "spacing", "tx", "await", "response", "callback"};
+
+static std::map<int, Span> spans(const std::vector<Json>& events)
+{
+    std::map<int, Span> result;
+    double last_ts = 0;
+    for (const Json& ev : events)
+    {
+        HOST_CHECK(ev["ts"].type == 'n' && ev["ts"].number >= last_ts);
+        last_ts = ev["ts"].number;
+        if (ev["ph"].text == "i")
+        {
+            continue;
+        }
+        HOST_CHECK(ev["cat"].text == "at" && ev["id"].type == 'n');
+        Span& span = result[(int)ev["id"].number];
+        bool is_begin = ev["ph"].text == "b";
+        HOST_CHECK(is_begin || ev["ph"].text == "e");
+        // 命令的开始和结束事件以命令文本为名称，阶段事件以阶段名为名称
+        std::string phase = ev["name"].text;
+        if (!PHASES.count(phase))
+        {
+            span.name = phase;
+            phase = "command";
+            if (!is_begin)
+            {
+                span.result = ev["args"]["result"].text;
+            }
+        }
+        span.phases.push_back((is_begin ? "+" : "-") + phase);
+        if (is_begin)
+        {
+            span.begin_ts[phase] = ev["ts"].number;
+        }
+        else
+        {
+            span.duration_us[phase] = ev["ts"].number - span.begin_ts[phase];
+        }
+    }
+    return result;
+}
+
+static std::string sequence(const Span& span)
+{
+    std::string text;
+    for (const std::string& phase : span.phases)
+    {
+        text += (text.empty() ? "" : " ") + phase;
+    }
+    return text;
+}
+
+static void answer(host::FakeModem& modem, const std::string& line)
+{
+    if (line == "AT+CSQ")
+    {
+        modem.reply(30, "\r\n+CSQ: 21,0\r\n\r\nOK\r\n");
+    }
+    else if (line == "AT+CIPSTART=\"TCP\",\"a\\b\",80")
+    {
+        modem.reply(8, "\r\nERROR\r\n");
+    }
+    else if (line == "AT+SILENT")
+    {
+        // 不应答，同步命令超时
+    }
+    else
+    {
+        modem.reply(12, "\r\nOK\r\n");
+    }
+}
+
+static int callbacks = 0;
+
+static void onDone(ATCommandResult /* result */, const String& /* response */, unsigned long /* latency_ms */,
+                   void* /* context */)
+{
+    callbacks++;
+}
+
+int main()
+{
+    host::useFakeClock();
+    host::FakeModem modem;
+    modem.onCommand = answer;
+    Air780EGCore core;
+    core.attachStream(&modem);
+    core.setATCommandDelay(20);
+    static int rings = 0;
+    core.addURCHandler("RING", [](const String& /* urc */, void* /* context */) { rings++; }, nullptr);
+
+    // 未调用 begin() 时不记录，导出只有元数据
+    core.sendATCommand("AT");
+    HOST_CHECK(!Air780EGTrace::isEnabled() && exportEvents().empty());
+
+    HOST_CHECK(Air780EGTrace::begin(512));
+    core.sendATCommand("AT+CSQ");
+    core.sendATCommand("AT+CIPSTART=\"TCP\",\"a\\b\",80");
+    core.sendATCommand("AT+SILENT", 100);
+    HOST_CHECK(core.sendATCommandAsync("AT+CGATT?", onDone, nullptr));
+    for (int ms = 0; ms < 100; ms++)
+    {
+        core.processCommands();
+        host::advance(1);
+    }
+    modem.inject("\r\nRING \"x\"\\y\x01\r\n");
+    core.processCommands();
+    Air780EGTrace::instant(AIR780EG_TRACE_URC, "tab\there\nnl");
+    HOST_CHECK(callbacks == 1 && rings == 1);
+
+    std::vector<Json> events = exportEvents();
+    std::map<int, Span> commands = spans(events);
+    HOST_CHECK(commands.size() == 4);
+    std::vector<Span> ordered;
+    for (const auto& entry : commands)
+    {
+        ordered.push_back(entry.second);
+        printf("%-24s %-8s %s\n", entry.second.name.c_str(), entry.second.result.c_str(), sequence(entry.second).c_str());
+    }
+    if (ordered.size() == 4)
+    {
+        // 同步命令：间隔等待、写串口、等待首字节、读取完整响应；await 约为模块的30ms应答延迟
+        HOST_CHECK(ordered[0].name == "AT+CSQ" && ordered[0].result == "OK");
+        HOST_CHECK(sequence(ordered[0]) == "+command +spacing -spacing +tx -tx +await -await +response -response -command");
+        HOST_CHECK(ordered[0].duration_us["await"] >= 29000 && ordered[0].duration_us["await"] <= 31000);
+        HOST_CHECK(ordered[0].duration_us["spacing"] > 0);
+
+        // 标签截断为23个字符，引号和反斜杠原样还原
+        HOST_CHECK(ordered[1].name == std::string("AT+CIPSTART=\"TCP\",\"a\\b\",80").substr(0, AIR780EG_TRACE_LABEL_LEN - 1));
+        HOST_CHECK(ordered[1].result == "ERROR");
+
+        // 超时：没有首字节，await 一直持续到命令结束
+        HOST_CHECK(ordered[2].name == "AT+SILENT" && ordered[2].result == "TIMEOUT");
+        HOST_CHECK(sequence(ordered[2]).find("response") == std::string::npos);
+        HOST_CHECK(ordered[2].duration_us["await"] >= 100000);
+
+        // 异步命令：排队阶段在最前，回调阶段在命令结束之前
+        HOST_CHECK(ordered[3].name == "AT+CGATT?" && ordered[3].result == "OK");
+        std::string async = sequence(ordered[3]);
+        HOST_CHECK(async.rfind("+command +queued -queued", 0) == 0);
+        HOST_CHECK(async.find("+callback -callback -command") != std::string::npos);
+    }
+
+    // 上报为瞬时事件，控制字符以 \u 转义后还原
+    std::vector<std::string> urcs;
+    for (const Json& ev : events)
+    {
+        if (ev["ph"].text == "i")
+        {
+            HOST_CHECK(ev["cat"].text == "urc" && ev["name"].text == "URC" && ev["s"].text == "t");
+            urcs.push_back(ev["args"]["text"].text);
+        }
+    }
+    HOST_CHECK(urcs.size() == 2);
+    if (urcs.size() == 2)
+    {
+        HOST_CHECK(urcs[0] == "RING \"x\"\\y\x01");
+        HOST_CHECK(urcs[1] == "tab\there\nnl");
+    }
+
+    // 环形缓冲区写满：只保留最新的16个事件，被覆盖的事件计数，导出仍按时间排序
+    HOST_CHECK(Air780EGTrace::begin(16));
+    for (int i = 0; i < 10; i++)
+    {
+        core.sendATCommand("AT+CSQ");
+        host::advance(5);
+    }
+    HOST_CHECK(Air780EGTrace::getEventCount() == 16);
+    // 无需等待间隔时每条命令8个事件：command、tx、await、response 各一对
+    HOST_CHECK(Air780EGTrace::getDroppedCount() == 10 * 8 - 16);
+    events = exportEvents();
+    HOST_CHECK(events.size() == 16);
+    spans(events);
+    // 最后一个事件是最后一条命令的结束
+    HOST_CHECK(!events.empty() && events.back()["ph"].text == "e" && events.back()["name"].text == "AT+CSQ" &&
+               events.back()["args"]["result"].text == "OK");
+    printf("ring of 16: %u events kept, %u overwritten\n", (unsigned)Air780EGTrace::getEventCount(),
+           Air780EGTrace::getDroppedCount());
+
+    Air780EGTrace::end();
+    HOST_CHECK(!Air780EGTrace::isEnabled() && exportEvents().empty());
+    return host::finish("sim_trace");
+}
@@ -0,0 +1,99 @@
+// 堆分配追踪（user-026）：固定场景下各子系统的计数。
+// 分配记到最内层作用域，作用域外和禁用时不计；live_bytes 是作用域内的净占用，
+// 释放别处分配的内存时为负，分配后交给调用者在作用域外释放时保持为正
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+
+static Air780EGHeapStats stats(Air780EGSubsystem subsystem)
+{
+    return Air780EGHeapTrace::getStats(subsystem);
+}
+
+static char* allocateIn(Air780EGSubsystem subsystem, size_t size)
+{
+    AIR780EG_HEAP_SCOPE(subsystem);
+    return new char[size];
+}
+
+static void freeIn(Air780EGSubsystem subsystem, char* block)
+{
+    AIR780EG_HEAP_SCOPE(subsystem);
+    delete[] block;
+}
+
+int main()
+{
+    HOST_CHECK(Air780EGHeapTrace::isCompiledIn());
+
+    // 禁用时不计
+    Air780EGHeapTrace::reset();
+    freeIn(AIR780EG_SUBSYS_GNSS, allocateIn(AIR780EG_SUBSYS_GNSS, 64));
+    HOST_CHECK(stats(AIR780EG_SUBSYS_GNSS).alloc_count == 0);
+
+    Air780EGHeapTrace::enable();
+
+    // 同一作用域内分配和释放：次数、字节和峰值，净占用回到0
+    Air780EGHeapTrace::reset();
+    {
+        AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_GNSS);
+        char* a = new char[100];
+        char* b = new char[200];
+        delete[] a;
+        delete[] b;
+    }
+    Air780EGHeapStats gnss = stats(AIR780EG_SUBSYS_GNSS);
+    HOST_CHECK(gnss.alloc_count == 2 && gnss.free_count == 2);
+    HOST_CHECK(gnss.alloc_bytes >= 300 && gnss.free_bytes == gnss.alloc_bytes);
+    HOST_CHECK(gnss.live_bytes == 0 && gnss.peak_bytes == (int32_t)gnss.alloc_bytes);
+
+    // 嵌套作用域：内层的分配只记到内层子系统
+    Air780EGHeapTrace::reset();
+    {
+        AIR780EG_HEAP_SCOPE(AIR780EG_SUBSYS_MQTT);
+        char* outer = new char[32];
+        freeIn(AIR780EG_SUBSYS_CORE, allocateIn(AIR780EG_SUBSYS_CORE, 48));
+        delete[] outer;
+    }
+    HOST_CHECK(stats(AIR780EG_SUBSYS_MQTT).alloc_count == 1 && stats(AIR780EG_SUBSYS_MQTT).alloc_bytes >= 32);
+    HOST_CHECK(stats(AIR780EG_SUBSYS_CORE).alloc_count == 1 && stats(AIR780EG_SUBSYS_CORE).alloc_bytes >= 48);
+    HOST_CHECK(stats(AIR780EG_SUBSYS_NETWORK).alloc_count == 0 && stats(AIR780EG_SUBSYS_HTTP).alloc_count == 0);
+
+    // 作用域外的分配不计
+    Air780EGHeapTrace::reset();
+    char* unscoped = new char[16];
+    delete[] unscoped;
+    for (int i = 0; i < AIR780EG_SUBSYS_COUNT; i++)
+    {
+        HOST_CHECK(stats((Air780EGSubsystem)i).alloc_count == 0 && stats((Air780EGSubsystem)i).free_count == 0);
+    }
+
+    // 跨作用域：MQTT 分配、HTTP 释放，各自的净占用一正一负，合计为0
+    Air780EGHeapTrace::reset();
+    freeIn(AIR780EG_SUBSYS_HTTP, allocateIn(AIR780EG_SUBSYS_MQTT, 80));
+    Air780EGHeapStats mqtt = stats(AIR780EG_SUBSYS_MQTT);
+    Air780EGHeapStats http = stats(AIR780EG_SUBSYS_HTTP);
+    HOST_CHECK(mqtt.live_bytes > 0 && http.live_bytes == -mqtt.live_bytes);
+    HOST_CHECK(http.alloc_count == 0 && http.free_count == 1 && http.peak_bytes == 0);
+
+    // 作用域外分配、作用域内释放：净占用为负
+    Air780EGHeapTrace::reset();
+    freeIn(AIR780EG_SUBSYS_NETWORK, new char[24]);
+    HOST_CHECK(stats(AIR780EG_SUBSYS_NETWORK).live_bytes < 0);
+
+    // 库的实际调用：getLocationJSON() 的分配记到GNSS，返回的 String 在调用者处释放，净占用保持为正
+    Air780EGHeapTrace::reset();
+    Air780EGGNSS location(nullptr);
+    Air780EGHostTest::parseGNSSResponse(location, "+CGNSINF: 1,1,20251012083015.000,31.230416,121.473701,10.5,"
+                                                  "36.2,270.5,0.9,1.2,0.8,12\r\n");
+    Air780EGHeapTrace::reset();
+    {
+        String json = location.getLocationJSON();
+        HOST_CHECK(json.length() > 0);
+    }
+    gnss = stats(AIR780EG_SUBSYS_GNSS);
+    HOST_CHECK(gnss.alloc_count > 0 && gnss.live_bytes > 0 && gnss.peak_bytes >= gnss.live_bytes);
+    HOST_CHECK(stats(AIR780EG_SUBSYS_MQTT).alloc_count == 0 && stats(AIR780EG_SUBSYS_CORE).alloc_count == 0);
+
+    Air780EGHeapTrace::enable(false);
+    return host::finish("unit_heap_trace");
+}
@@ -0,0 +1,156 @@
+// CBOR位置编码（user-037）：getLocationCBOR() 的输出按 RFC 8949 解码后与GNSS数据逐字段一致，
+// 覆盖有效定位、负坐标、未定位和无时间的情况；编码长度不超过 getLocationJSON() 的1/3
+#include "Air780EGHostTest.h"
+#include "HostSupport.h"
+#include <cmath>
+#include <map>
+
+// 只支持位置编码用到的类型：整数（主类型0/1）和以整数为键的映射（主类型5）
+struct CBORReader {
+    const uint8_t* data;
+    size_t len;
+    size_t pos = 0;
+    bool ok = true;
+
+    bool head(uint8_t& major, uint64_t& arg)
+    {
+        if (pos >= len)
+        {
+            return ok = false;
+        }
+        major = data[pos] >> 5;
+        uint8_t info = data[pos++] & 0x1F;
+        if (info < 24)
+        {
+            arg = info;
+            return true;
+        }
+        if (info > 27)
+        {
+            return ok = false;
+        }
+        size_t n = (size_t)1 << (info - 24);
+        if (pos + n > len)
+        {
+            return ok = false;
+        }
+        arg = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            arg = (arg << 8) | data[pos++];
+        }
+        // 最短编码：能放进更短形式的值不应使用更长的头
+        ok = ok && arg >= (info == 24 ? 24 : (uint64_t)1 << (4 << (info - 24)));
+        return ok;
+    }
+
+    bool integer(int64_t& value)
+    {
+        uint8_t major;
+        uint64_t arg;
+        if (!head(major, arg) || major > 1)
+        {
+            return ok = false;
+        }
+        value = major == 0 ? (int64_t)arg : -1 - (int64_t)arg;
+        return true;
+    }
+
+    std::map<int64_t, int64_t> map()
+    {
+        std::map<int64_t, int64_t> result;
+        uint8_t major;
+        uint64_t pairs;
+        if (!head(major, pairs) || major != 5)
+        {
+            ok = false;
+            return result;
+        }
+        for (uint64_t i = 0; i < pairs && ok; i++)
+        {
+            int64_t key, value;
+            if (integer(key) && integer(value))
+            {
+                ok = ok && result.count(key) == 0;
+                result[key] = value;
+            }
+        }
+        ok = ok && pos == len;
+        return result;
+    }
+};
+
+struct Fix {
+    const char* name;
+    const char* cgnsinf;
+    bool valid;
+    int64_t time;  // -1 表示没有时间
+};
+
+static const Fix FIXES[] = {
+    {"valid", "1,1,20251012083015.000,31.230416,121.473701,10.5,36.2,270.5,0.9,1.2,0.8,12", true, 1760257815},
+    {"negative", "1,1,20240229235959.000,-33.868820,-151.209296,-5.5,0.0,359.9,1.4,2.0,1.1,7", true, 1709251199},
+    {"invalid", "1,0,,,,,,,,,,0", false, -1},
+    {"no time", "1,1,,48.858370,2.294481,35.0,3.4,90.0,1.1,1.5,0.9,9", true, -1},
+};
+
+static bool fixedEquals(int64_t encoded, double value, double scale)
+{
+    return encoded == (int64_t)llround(value * scale);
+}
+
+int main()
+{
+    size_t json_total = 0;
+    size_t cbor_total = 0;
+    for (const Fix& fix : FIXES)
+    {
+        Air780EGGNSS gnss(nullptr);
+        HOST_CHECK(Air780EGHostTest::parseGNSSResponse(gnss, String("+CGNSINF: ") + fix.cgnsinf + "\r\n"));
+
+        uint8_t buffer[48];
+        size_t len = gnss.getLocationCBOR(buffer, sizeof(buffer));
+        HOST_CHECK(len > 0);
+        CBORReader reader{buffer, len};
+        std::map<int64_t, int64_t> m = reader.map();
+        HOST_CHECK(reader.ok);
+
+        int64_t flags = m[LOCATION_KEY_FLAGS];
+        HOST_CHECK(((flags & 0x01) != 0) == fix.valid && ((flags & 0x01) != 0) == gnss.isValid());
+        HOST_CHECK((flags & 0x06) == 0);
+        HOST_CHECK(fixedEquals(m[LOCATION_KEY_LATITUDE], gnss.getLatitude(), 1e7));
+        HOST_CHECK(fixedEquals(m[LOCATION_KEY_LONGITUDE], gnss.getLongitude(), 1e7));
+        HOST_CHECK(fixedEquals(m[LOCATION_KEY_ALTITUDE], gnss.getAltitude(), 10));
+        HOST_CHECK(fixedEquals(m[LOCATION_KEY_SPEED], gnss.getSpeed(), 10));
+        HOST_CHECK(fixedEquals(m[LOCATION_KEY_COURSE], gnss.getCourse(), 10));
+        HOST_CHECK(fixedEquals(m[LOCATION_KEY_HDOP], gnss.getHDOP(), 10));
+        HOST_CHECK(m[LOCATION_KEY_SATELLITES] == gnss.getSatelliteCount());
+        if (fix.time >= 0)
+        {
+            HOST_CHECK((flags & 0x08) && m.count(LOCATION_KEY_TIME) && m[LOCATION_KEY_TIME] == fix.time);
+            HOST_CHECK(m.size() == 9);
+        }
+        else
+        {
+            HOST_CHECK(!(flags & 0x08) && !m.count(LOCATION_KEY_TIME) && m.size() == 8);
+        }
+        if (fix.valid && std::string(fix.name) == "negative")
+        {
+            HOST_CHECK(m[LOCATION_KEY_LATITUDE] == -338688200 && m[LOCATION_KEY_LONGITUDE] == -1512092960);
+            HOST_CHECK(m[LOCATION_KEY_ALTITUDE] == -55);
+        }
+
+        // 缓冲区不足时返回0
+        HOST_CHECK(gnss.getLocationCBOR(buffer, len - 1) == 0);
+
+        String json = gnss.getLocationJSON();
+        printf("%-8s: cbor %2u bytes, json %3u bytes (%.1fx)\n", fix.name, (unsigned)len, json.length(),
+               (double)json.length() / len);
+        HOST_CHECK(json.length() >= len * 3);
+        json_total += json.length();
+        cbor_total += len;
+    }
+    printf("total   : cbor %u bytes, json %u bytes (%.1fx)\n", (unsigned)cbor_total, (unsigned)json_total,
+           (double)json_total / cbor_total);
+    return host::finish("unit_location_cbor");
+}
@@ -0,0 +1,185 @@
+// 主题前缀树（user-043）：分发结果与按 MQTT 3.1.1 逐层比较的参考实现一致。
+// 固定用例覆盖 '+' / '#'、"$SYS" 不匹配首层通配符、"a/#" 匹配 "a"、空层级；
+// 随机用例在小词表上生成过滤器和主题，逐条比较命中集合，并检查删除处理器和清空
+#include "Air780EGTopicTrie.h"
+#include "HostSupport.h"
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+static std::vector<std::string> split(const std::string& text)
+{
+    std::vector<std::string> levels;
+    size_t start = 0;
+    while (true)
+    {
+        size_t slash = text.find('/', start);
+        levels.push_back(text.substr(start, slash - start));
+        if (slash == std::string::npos)
+        {
+            return levels;
+        }
+        start = slash + 1;
+    }
+}
+
+// 参考实现：按层比较
+static bool referenceMatch(const std::string& filter, const std::string& topic)
+{
+    std::vector<std::string> f = split(filter);
+    std::vector<std::string> t = split(topic);
+    if (!topic.empty() && topic[0] == '$' && (f[0] == "+" || f[0] == "#"))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < f.size(); i++)
+    {
+        if (f[i] == "#")
+        {
+            return true;
+        }
+        if (i >= t.size() || (f[i] != "+" && f[i] != t[i]))
+        {
+            return false;
+        }
+    }
+    return f.size() == t.size();
+}
+
+static std::set<int> fired;
+
+static void onTopic(const char* topic, size_t topic_len, const uint8_t* payload, size_t payload_len, void* context)
+{
+    HOST_CHECK(fired.insert((int)(intptr_t)context).second);
+}
+
+static std::set<int> dispatch(const Air780EGTopicTrie& trie, const std::string& topic)
+{
+    fired.clear();
+    int calls = trie.dispatch(topic.data(), topic.size(), (const uint8_t*)"x", 1);
+    HOST_CHECK(calls == (int)fired.size());
+    return fired;
+}
+
+static std::set<int> expected(const std::vector<std::string>& filters, const std::vector<bool>& active,
+                              const std::string& topic)
+{
+    std::set<int> result;
+    for (size_t i = 0; i < filters.size(); i++)
+    {
+        if (active[i] && referenceMatch(filters[i], topic))
+        {
+            result.insert((int)i);
+        }
+    }
+    return result;
+}
+
+static bool matches(const char* filter, const char* topic)
+{
+    Air780EGTopicTrie trie;
+    HOST_CHECK(trie.setHandler(filter, onTopic, (void*)(intptr_t)1));
+    bool hit = dispatch(trie, topic).count(1) > 0;
+    HOST_CHECK(hit == referenceMatch(filter, topic));
+    return hit;
+}
+
+int main()
+{
+    // 固定用例
+    HOST_CHECK(matches("a/+/c", "a/b/c"));
+    HOST_CHECK(!matches("a/+/c", "a/b/c/d"));
+    HOST_CHECK(!matches("a/+", "a"));
+    HOST_CHECK(matches("a/#", "a"));
+    HOST_CHECK(matches("a/#", "a/b/c"));
+    HOST_CHECK(!matches("a/#", "ab"));
+    HOST_CHECK(matches("#", "a/b"));
+    HOST_CHECK(!matches("#", "$SYS/broker"));
+    HOST_CHECK(!matches("+/broker", "$SYS/broker"));
+    HOST_CHECK(matches("$SYS/#", "$SYS/broker"));
+    HOST_CHECK(matches("$SYS/+", "$SYS/broker"));
+    HOST_CHECK(matches("a/$x", "a/$x"));
+    HOST_CHECK(matches("a/+", "a/$x"));
+    HOST_CHECK(matches("a//b", "a//b"));
+    HOST_CHECK(matches("a/+/b", "a//b"));
+    HOST_CHECK(!matches("a/b", "a//b"));
+    HOST_CHECK(matches("+/a", "/a"));
+    HOST_CHECK(matches("/#", "/a"));
+    HOST_CHECK(matches("a/+", "a/"));
+    HOST_CHECK(!matches("a", "a/"));
+
+    HOST_CHECK(Air780EGTopicTrie::isValidFilter("a/+/#"));
+    HOST_CHECK(Air780EGTopicTrie::isValidFilter("a//b"));
+    HOST_CHECK(!Air780EGTopicTrie::isValidFilter("a/#/b"));
+    HOST_CHECK(!Air780EGTopicTrie::isValidFilter("a/b+"));
+    HOST_CHECK(!Air780EGTopicTrie::isValidFilter(""));
+
+    // 随机用例：过滤器和主题取自同一个小词表，包含空层级和 '$' 开头的层级
+    static const char* LEVELS[] = {"a", "b", "c", "", "$SYS", "dev"};
+    std::mt19937 rng(43);
+    auto pick = [&](int n) { return (int)(rng() % n); };
+    auto randomTopic = [&]() {
+        std::string topic = LEVELS[pick(6)];
+        for (int depth = pick(4); depth > 0; depth--)
+        {
+            topic += "/";
+            topic += LEVELS[pick(6)];
+        }
+        return topic.empty() ? std::string("a") : topic;  // 主题至少一个字符
+    };
+
+    for (int round = 0; round < 20; round++)
+    {
+        Air780EGTopicTrie trie;
+        std::vector<std::string> filters;
+        std::vector<bool> active;
+        while (filters.size() < 60)
+        {
+            std::string filter;
+            int depth = 1 + pick(4);
+            for (int i = 0; i < depth; i++)
+            {
+                int kind = pick(8);
+                std::string level = kind == 0 ? "+" : (kind == 1 && i == depth - 1 ? "#" : LEVELS[pick(6)]);
+                filter += (i > 0 ? "/" : "") + level;
+            }
+            if (filter.empty() || std::find(filters.begin(), filters.end(), filter) != filters.end())
+            {
+                continue;
+            }
+            HOST_CHECK(Air780EGTopicTrie::isValidFilter(filter.c_str()));
+            HOST_CHECK(trie.setHandler(filter.c_str(), onTopic, (void*)(intptr_t)filters.size()));
+            filters.push_back(filter);
+            active.push_back(true);
+        }
+        HOST_CHECK(trie.getHandlerCount() == 60);
+
+        for (int i = 0; i < 200; i++)
+        {
+            std::string topic = randomTopic();
+            if (dispatch(trie, topic) != expected(filters, active, topic))
+            {
+                fprintf(stderr, "mismatch for topic \"%s\"\n", topic.c_str());
+                host::failures++;
+            }
+        }
+
+        // 删除一半处理器后节点保留，分发结果仍与参考一致
+        for (size_t i = 0; i < filters.size(); i += 2)
+        {
+            HOST_CHECK(trie.removeHandler(filters[i].c_str()));
+            active[i] = false;
+        }
+        HOST_CHECK(trie.getHandlerCount() == 30);
+        for (int i = 0; i < 200; i++)
+        {
+            std::string topic = randomTopic();
+            HOST_CHECK(dispatch(trie, topic) == expected(filters, active, topic));
+        }
+
+        trie.clear();
+        HOST_CHECK(trie.getHandlerCount() == 0 && dispatch(trie, "a/b").empty());
+    }
+    return host::finish("unit_topic_trie");
+}
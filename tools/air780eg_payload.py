@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""Air780EG 负载的服务端解码。
+
+- 以 0xA8 0x01 开头：Air780EGCompress 压缩格式（LZSS + 静态JSON键字典），
+  格式说明见 src/Air780EGCompress.h
+- Air780EGGNSS::getLocationCBOR 的CBOR位置编码：decode_location() 转换为
+  与 getLocationJSON 相同字段的字典
+
+    from air780eg_payload import decode, decode_location
+    text = decode(mqtt_payload_bytes)
+    location = decode_location(cbor_bytes)
+
+命令行：
+    python3 air780eg_payload.py <HEX字符串>
+    python3 air780eg_payload.py -f payload.bin
+    python3 air780eg_payload.py --location <HEX字符串>
+"""
+
+import datetime
+import json
+import struct
+import sys
+
+MAGIC = 0xA8
+VERSION = 1
+LENGTH_BITS = 5
+MIN_MATCH = 3
+
+# 必须与 src/Air780EGCompress.cpp 中的字典逐字节一致（主机测试 check_payload_decoder 检查）
+DICTIONARY = (
+    '"sensors":{"temperature":,"humidity":,"voltage":,"imu":{"x":,"y":,"z":'
+    '"network":{"operator":"","registered":true,"signal":,"battery":'
+    '"utc_date":"","utc_time":"","uptime":,"counter":,"status":"'
+    '"firmware":"","hardware":"esp32-air780eg","location":{'
+    '"latitude":,"longitude":,"altitude":,"satellites":,"hdop":,"accuracy":'
+    '"fixed":false,"valid":true,"speed":,"course":,"heading":'
+    '{"device_id":"","timestamp":,"mode":"normal","gps":{"lat":,"lng":'
+).encode()
+
+
+def is_compressed(data: bytes) -> bool:
+    return len(data) >= 2 and data[0] == MAGIC and data[1] == VERSION
+
+
+def decompress(data: bytes) -> bytes:
+    if not is_compressed(data):
+        raise ValueError("not an Air780EG compressed payload")
+    out = bytearray(DICTIONARY)
+    start = len(out)
+    i = 2
+    while i < len(data):
+        control = data[i]
+        i += 1
+        for bit in range(8):
+            if i >= len(data):
+                break
+            if not control & (1 << bit):
+                out.append(data[i])
+                i += 1
+                continue
+            if i + 2 > len(data):
+                raise ValueError("truncated back-reference")
+            word = (data[i] << 8) | data[i + 1]
+            i += 2
+            dist = (word >> LENGTH_BITS) + 1
+            length = (word & ((1 << LENGTH_BITS) - 1)) + MIN_MATCH
+            if dist > len(out):
+                raise ValueError("back-reference before dictionary")
+            for _ in range(length):
+                out.append(out[-dist])
+    return bytes(out[start:])
+
+
+def decode(data: bytes) -> bytes:
+    """压缩负载返回解压结果，未压缩的原样返回。"""
+    return decompress(data) if is_compressed(data) else data
+
+
+def cbor_loads(data: bytes):
+    """最小CBOR解码（整数、字节串、文本、数组、映射、简单值和浮点）。"""
+    value, end = _cbor_item(data, 0)
+    if end != len(data):
+        raise ValueError("trailing bytes after CBOR item")
+    return value
+
+
+def _cbor_item(data, i):
+    if i >= len(data):
+        raise ValueError("truncated CBOR")
+    major, info = data[i] >> 5, data[i] & 0x1F
+    i += 1
+    if major == 7:
+        if info == 20:
+            return False, i
+        if info == 21:
+            return True, i
+        if info == 22:
+            return None, i
+        if info == 25:
+            return struct.unpack(">e", data[i:i + 2])[0], i + 2
+        if info == 26:
+            return struct.unpack(">f", data[i:i + 4])[0], i + 4
+        if info == 27:
+            return struct.unpack(">d", data[i:i + 8])[0], i + 8
+        raise ValueError("unsupported simple value %d" % info)
+    if info < 24:
+        arg = info
+    elif info <= 27:
+        n = 1 << (info - 24)
+        if i + n > len(data):
+            raise ValueError("truncated CBOR")
+        arg = int.from_bytes(data[i:i + n], "big")
+        i += n
+    else:
+        raise ValueError("indefinite length not supported")
+    if major == 0:
+        return arg, i
+    if major == 1:
+        return -1 - arg, i
+    if major in (2, 3):
+        if i + arg > len(data):
+            raise ValueError("truncated CBOR")
+        raw = bytes(data[i:i + arg])
+        return (raw if major == 2 else raw.decode()), i + arg
+    if major == 4:
+        items = []
+        for _ in range(arg):
+            item, i = _cbor_item(data, i)
+            items.append(item)
+        return items, i
+    if major == 5:
+        result = {}
+        for _ in range(arg):
+            key, i = _cbor_item(data, i)
+            result[key], i = _cbor_item(data, i)
+        return result, i
+    raise ValueError("unsupported CBOR major type %d" % major)
+
+
+# 键定义与 src/Air780EGGNSS.h 中的 Air780EGLocationKey 一致：(键, 字段名, 定点倍数)
+LOCATION_FIELDS = (
+    (1, "latitude", 1e7),
+    (2, "longitude", 1e7),
+    (3, "altitude", 10),
+    (4, "speed", 10),
+    (5, "course", 10),
+    (6, "hdop", 10),
+    (7, "satellites", 1),
+)
+
+
+def decode_location(data: bytes) -> dict:
+    raw = cbor_loads(data)
+    flags = raw.get(0, 0)
+    location = {}
+    for key, name, scale in LOCATION_FIELDS:
+        value = raw.get(key, 0)
+        location[name] = value if scale == 1 else value / scale
+    location["is_gnss_valid"] = bool(flags & 0x01)
+    location["is_wifi_valid"] = bool(flags & 0x02)
+    location["is_lbs_valid"] = bool(flags & 0x04)
+    location["gps_time_valid"] = bool(flags & 0x08) and 8 in raw
+    if location["gps_time_valid"]:
+        t = datetime.datetime.fromtimestamp(raw[8], datetime.timezone.utc)
+        location["gps_time"] = t.strftime("%Y-%m-%d %H:%M:%S")
+    return location
+
+
+def main(argv):
+    if len(argv) == 3 and argv[1] == "--location":
+        print(json.dumps(decode_location(bytes.fromhex(argv[2])), ensure_ascii=False))
+        return 0
+    if len(argv) == 3 and argv[1] == "-f":
+        with open(argv[2], "rb") as f:
+            data = f.read()
+    elif len(argv) == 2:
+        data = bytes.fromhex(argv[1])
+    else:
+        print(__doc__)
+        return 1
+    sys.stdout.buffer.write(decode(data) + b"\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))